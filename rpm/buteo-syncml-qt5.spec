@@ -1,5 +1,5 @@
 Name: buteo-syncml-qt5
-Version: 0.5.13
+Version: 1.0.0
 Release: 1
 Summary: SyncML library for MeeGo sync
 License: LGPLv2+
@@ -13,6 +13,7 @@ BuildRequires: pkgconfig(Qt5Sql)
 BuildRequires: pkgconfig(Qt5Test)
 BuildRequires: pkgconfig(libwbxml2) >= 0.11.6
 BuildRequires: pkgconfig(sqlite3)
+BuildRequires: pkgconfig(zlib)
 BuildRequires: pkgconfig(openobex)
 BuildRequires: pkgconfig(buteosyncfw5) >= 0.6.24
 
@@ -0,0 +1,125 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef ASYNCSTORAGEPLUGIN_H
+#define ASYNCSTORAGEPLUGIN_H
+
+#include <QList>
+
+#include "StoragePlugin.h"
+
+namespace DataSync {
+
+class SyncItem;
+
+/*! \brief Receives results of asynchronous commits to a storage plugin
+ *
+ */
+class StorageCommitObserver
+{
+public:
+
+    /*! \brief Destructor
+     */
+    virtual ~StorageCommitObserver() {}
+
+    /*! \brief Called when an asynchronous commit has completed
+     * @param aStatuses List of status codes corresponding to each item or key
+     *                  of the commit
+     */
+    virtual void commitCompleted( const QList<StoragePlugin::StoragePluginStatus>& aStatuses ) = 0;
+
+};
+
+/*! \brief Optional interface of storage plugins that commit items in the background
+ *
+ * A StoragePlugin implementation that also inherits this interface is
+ * detected at run time, and items are then committed with the functions
+ * below instead of addItems(), replaceItems() and deleteItems(). Plugins
+ * that do not inherit it are committed synchronously as before.
+ *
+ * Only one commit is outstanding at a time. Its results must be reported to
+ * the observer exactly once, in the thread that started the commit, unless
+ * the commit is cancelled first. Items remain owned by the caller and stay
+ * valid until the results have been reported or the commit has been
+ * cancelled.
+ */
+class AsyncStoragePlugin
+{
+public:
+
+    /*! \brief Destructor
+     */
+    virtual ~AsyncStoragePlugin() {}
+
+    /*! \brief Adds new items asynchronously
+     *
+     * Works like StoragePlugin::addItems(), but may return before the items
+     * have been written.
+     * @param aItems List of items to add
+     * @param aObserver Observer to report results to
+     */
+    virtual void addItemsAsync( const QList<SyncItem*>& aItems, StorageCommitObserver& aObserver ) = 0;
+
+    /*! \brief Replaces existing items asynchronously
+     *
+     * Works like StoragePlugin::replaceItems(). See addItemsAsync().
+     * @param aItems List of items to replace
+     * @param aObserver Observer to report results to
+     */
+    virtual void replaceItemsAsync( const QList<SyncItem*>& aItems, StorageCommitObserver& aObserver ) = 0;
+
+    /*! \brief Deletes existing items asynchronously
+     *
+     * Works like StoragePlugin::deleteItems(). See addItemsAsync().
+     * @param aKeys List of items to delete
+     * @param aObserver Observer to report results to
+     */
+    virtual void deleteItemsAsync( const QList<SyncItemKey>& aKeys, StorageCommitObserver& aObserver ) = 0;
+
+    /*! \brief Cancels the outstanding commit of an observer
+     *
+     * Called when the session ends while a commit is outstanding. Results
+     * of the commit must not be reported to aObserver after this function
+     * returns, and the items of the commit must no longer be accessed, as
+     * they are deleted right after. The function may wait for a write in
+     * progress to finish. Items may have been partly written.
+     * @param aObserver Observer whose commit to cancel
+     */
+    virtual void cancelCommit( StorageCommitObserver& aObserver ) = 0;
+
+};
+
+}
+
+#endif  //  ASYNCSTORAGEPLUGIN_H
@@ -0,0 +1,143 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef BYTESLICE_H
+#define BYTESLICE_H
+
+#include <QByteArray>
+
+#include <cstring>
+
+namespace DataSync {
+
+/*! \brief Range of bytes in a shared buffer
+ *
+ * Refers to a part of a buffer, such as embedded XML inside a received
+ * message, without copying it. Buffer is kept alive as long as the slice
+ * exists, and the bytes are copied out only when the slice is converted to
+ * a QByteArray.
+ */
+class ByteSlice
+{
+public:
+
+    /*! \brief Constructs an empty slice
+     *
+     */
+    ByteSlice() : iOffset( 0 ), iLength( 0 ) { }
+
+    /*! \brief Constructs a slice covering a whole buffer
+     *
+     * @param aData Buffer
+     */
+    ByteSlice( const QByteArray& aData ) : iSource( aData ), iOffset( 0 ), iLength( aData.size() ) { }
+
+    /*! \brief Constructs a slice covering a copy of a string
+     *
+     * @param aData NUL-terminated string
+     */
+    ByteSlice( const char* aData ) : iSource( aData ), iOffset( 0 ), iLength( iSource.size() ) { }
+
+    /*! \brief Constructs a slice of a buffer
+     *
+     * @param aSource Buffer
+     * @param aOffset Offset of the first byte of the slice in aSource
+     * @param aLength Number of bytes in the slice
+     */
+    ByteSlice( const QByteArray& aSource, int aOffset, int aLength )
+     : iSource( aSource ), iOffset( aOffset ), iLength( aLength ) { }
+
+    /*! \brief Checks if the slice is empty
+     *
+     * @return True if the slice has no bytes
+     */
+    bool isEmpty() const { return iLength == 0; }
+
+    /*! \brief Returns the number of bytes in the slice
+     *
+     * @return Size
+     */
+    int size() const { return iLength; }
+
+    /*! \brief Returns the bytes of the slice
+     *
+     * Bytes are not NUL-terminated, and are valid as long as the slice exists.
+     *
+     * @return Pointer to the first byte
+     */
+    const char* constData() const { return iSource.constData() + iOffset; }
+
+    /*! \brief Returns the bytes of the slice as a QByteArray
+     *
+     * Bytes are copied, unless the slice covers its whole buffer.
+     *
+     * @return Bytes of the slice
+     */
+    QByteArray toByteArray() const
+    {
+        if( iOffset == 0 && iLength == iSource.size() ) {
+            return iSource;
+        }
+
+        return iSource.mid( iOffset, iLength );
+    }
+
+    /*! \brief Converts the slice to a QByteArray
+     *
+     * @return Bytes of the slice
+     */
+    operator QByteArray() const { return toByteArray(); }
+
+    bool operator==( const ByteSlice& aOther ) const
+    {
+        return iLength == aOther.iLength &&
+               ( iLength == 0 || std::memcmp( constData(), aOther.constData(), iLength ) == 0 );
+    }
+
+    bool operator!=( const ByteSlice& aOther ) const { return !( *this == aOther ); }
+
+    bool operator==( const QByteArray& aOther ) const { return *this == ByteSlice( aOther ); }
+
+    bool operator!=( const QByteArray& aOther ) const { return !( *this == aOther ); }
+
+private:
+
+    QByteArray  iSource;
+    int         iOffset;
+    int         iLength;
+
+};
+
+}
+
+#endif // BYTESLICE_H
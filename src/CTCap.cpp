@@ -33,8 +33,195 @@
 
 #include "CTCap.h"
 
+#include <QXmlStreamReader>
+
+#include "datatypes.h"
+#include "SyncMLLogging.h"
+
 using namespace DataSync;
 
+namespace {
+
+QString readString( QXmlStreamReader& aReader )
+{
+    return aReader.readElementText();
+}
+
+int readInt( QXmlStreamReader& aReader )
+{
+    return aReader.readElementText().toInt();
+}
+
+void skipUnknown( QXmlStreamReader& aReader )
+{
+    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << aReader.name();
+    aReader.skipCurrentElement();
+}
+
+void readParameter( QXmlStreamReader& aReader, CTCapParameter& aParameter )
+{
+    while( aReader.readNextStartElement() )
+    {
+        const QStringRef name = aReader.name();
+
+        if( name == QLatin1String( SYNCML_ELEMENT_PARAMNAME ) ) {
+            aParameter.iName = readString( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_DATATYPE ) ) {
+            aParameter.iType = readString( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_DISPLAYNAME ) ) {
+            aParameter.iDisplayName = readString( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_VALENUM ) ) {
+            aParameter.iValues.append( readString( aReader ) );
+        }
+        else {
+            skipUnknown( aReader );
+        }
+    }
+}
+
+void readProperty( QXmlStreamReader& aReader, CTCapProperty& aProperty )
+{
+    while( aReader.readNextStartElement() )
+    {
+        const QStringRef name = aReader.name();
+
+        if( name == QLatin1String( SYNCML_ELEMENT_PROPNAME ) ) {
+            aProperty.iName = readString( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_DATATYPE ) ) {
+            aProperty.iType = readString( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_MAXOCCUR ) ) {
+            aProperty.iMaxOccur = readInt( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_MAXSIZE ) ) {
+            aProperty.iSize = readInt( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_NOTRUNCATE ) ) {
+            aProperty.iNoTruncate = true;
+            aReader.skipCurrentElement();
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_DISPLAYNAME ) ) {
+            aProperty.iDisplayName = readString( aReader );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_VALENUM ) ) {
+            aProperty.iValues.append( readString( aReader ) );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_PROPPARAM ) ) {
+            CTCapParameter parameter;
+            readParameter( aReader, parameter );
+            aProperty.iParameters.append( parameter );
+        }
+        else {
+            skipUnknown( aReader );
+        }
+    }
+}
+
+void readCTCap( QXmlStreamReader& aReader, CTCap& aCTCap )
+{
+    while( aReader.readNextStartElement() )
+    {
+        const QStringRef name = aReader.name();
+
+        if( name == QLatin1String( SYNCML_ELEMENT_CTTYPE ) ) {
+            ContentFormat format = aCTCap.getFormat();
+            format.iType = readString( aReader );
+            aCTCap.setFormat( format );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_VERCT ) ) {
+            ContentFormat format = aCTCap.getFormat();
+            format.iVersion = readString( aReader );
+            aCTCap.setFormat( format );
+        }
+        else if( name == QLatin1String( SYNCML_ELEMENT_PROPERTY ) ) {
+            CTCapProperty property;
+            readProperty( aReader, property );
+            aCTCap.properties().append( property );
+        }
+        else {
+            skipUnknown( aReader );
+        }
+    }
+}
+
+// Reads CTCap elements wrapped in a CTCaps element. CT caps are appended
+// only if the whole document could be read.
+bool readCTCaps( const QByteArray& aDocument, QList<CTCap>& aCTCaps )
+{
+    QXmlStreamReader reader( aDocument );
+
+    // Namespace declarations of the enclosing DevInf element are not
+    // available
+    reader.setNamespaceProcessing( false );
+
+    QList<CTCap> ctCaps;
+
+    if( reader.readNextStartElement() )
+    {
+        while( reader.readNextStartElement() )
+        {
+            if( reader.name() == QLatin1String( SYNCML_ELEMENT_CTCAP ) ) {
+                CTCap ctCap;
+                readCTCap( reader, ctCap );
+                ctCaps.append( ctCap );
+            }
+            else {
+                skipUnknown( reader );
+            }
+        }
+    }
+
+    if( reader.hasError() )
+    {
+        qCWarning(lcSyncML) << "Could not decode CTCap:" << reader.errorString();
+        return false;
+    }
+
+    aCTCaps.append( ctCaps );
+    return true;
+}
+
+QByteArray wrapCTCaps( const QByteArray& aData )
+{
+    return "<" SYNCML_ELEMENT_CTCAPS ">" + aData + "</" SYNCML_ELEMENT_CTCAPS ">";
+}
+
+}
+
+bool DataSync::decodeCTCaps( const QList<QByteArray>& aData, QList<CTCap>& aCTCaps )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aData.isEmpty() ) {
+        return true;
+    }
+
+    QByteArray document;
+    foreach( const QByteArray& data, aData ) {
+        document.append( data );
+    }
+
+    if( readCTCaps( wrapCTCaps( document ), aCTCaps ) ) {
+        return true;
+    }
+
+    // A malformed element spoils the whole document, so decode the elements
+    // one by one to keep the valid ones
+    bool success = true;
+
+    foreach( const QByteArray& data, aData ) {
+        if( !readCTCaps( wrapCTCaps( data ), aCTCaps ) ) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
 CTCap::CTCap()
 {
 
@@ -35,6 +35,7 @@
 
 #include <QString>
 #include <QList>
+#include <QByteArray>
 
 #include "StorageContentFormatInfo.h"
 
@@ -113,6 +114,17 @@ private:
     QList<CTCapProperty>    iProperties;    /*!< Properties*/
 };
 
+/*! \brief Decodes SyncML 1.2 CTCap elements
+ *
+ * All elements are decoded in one pass of a single XML reader. Elements
+ * that cannot be decoded are skipped.
+ *
+ * @param aData CTCap elements
+ * @param aCTCaps List to append the decoded CT caps to
+ * @return True if all elements were decoded, otherwise false
+ */
+bool decodeCTCaps( const QList<QByteArray>& aData, QList<CTCap>& aCTCaps );
+
 }
 
 #endif // CTCAPS_H
@@ -97,6 +97,43 @@ void CommandHandler::handleSync( const SyncParams& aSyncParams,
 
 }
 
+void CommandHandler::startSync( const SyncParams& aSyncParams,
+                                SyncTarget& aTarget,
+                                StorageHandler& aStorageHandler,
+                                ResponseGenerator& aResponseGenerator,
+                                ConflictResolver& aConflictResolver,
+                                QMap<ItemId, ResponseStatusCode>& aResponses )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !aSyncParams.noResp ) {
+        aResponseGenerator.addStatus( aSyncParams, SUCCESS );
+    }
+
+    composeBatches( aSyncParams, aTarget, aStorageHandler, aResponseGenerator, aResponses );
+
+    aStorageHandler.startCommit( *aTarget.getPlugin(), resolveConflicts() ? &aConflictResolver : NULL );
+
+}
+
+void CommandHandler::finishSync( const SyncParams& aSyncParams,
+                                 SyncTarget& aTarget,
+                                 StorageHandler& aStorageHandler,
+                                 ResponseGenerator& aResponseGenerator,
+                                 QMap<ItemId, ResponseStatusCode>& aResponses,
+                                 bool aFastMapsSend )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<UIDMapping> newMappings;
+    processCommitResults( aStorageHandler.takeCommitResults(), aTarget, aSyncParams, aResponses, newMappings );
+
+    processResults( aSyncParams, aResponses, aResponseGenerator );
+
+    manageNewMappings( aTarget, newMappings, aResponseGenerator, aFastMapsSend );
+
+}
+
 void CommandHandler::rejectSync( const SyncParams& aSyncParams, ResponseGenerator& aResponseGenerator,
                                  ResponseStatusCode aResponseCode )
 {
@@ -181,7 +218,20 @@ void CommandHandler::handleStatus(StatusParams* aStatusParams )
     if ( aStatusParams->cmd == SYNCML_ELEMENT_ADD ||
          aStatusParams->cmd == SYNCML_ELEMENT_REPLACE ||
          aStatusParams->cmd == SYNCML_ELEMENT_DELETE ) {
-        emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef, aStatusParams->sourceRef );
+        // Status of several items of a command refers to each of them
+        bool acknowledged = false;
+
+        for( int i = 0; i < aStatusParams->items.count(); ++i ) {
+            if( !aStatusParams->items[i].source.isEmpty() ) {
+                emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef,
+                                       aStatusParams->items[i].source );
+                acknowledged = true;
+            }
+        }
+
+        if( !acknowledged ) {
+            emit itemAcknowledged( aStatusParams->msgRef, aStatusParams->cmdRef, aStatusParams->sourceRef );
+        }
     }
 
 }
@@ -477,7 +527,7 @@ void CommandHandler::composeBatches( const SyncParams& aSyncParams, SyncTarget&
 
                     if( aStorageHandler.buildingLargeObject() ) {
 
-                        if( aStorageHandler.appendLargeObjectData( item.data.toUtf8() ) ) {
+                        if( aStorageHandler.appendLargeObjectData( item.data ) ) {
                             aResponseGenerator.addPackage( new AlertPackage( NEXT_MESSAGE,
                                                                              aTarget.getSourceDatabase(),
                                                                              aTarget.getTargetDatabase() ) );
@@ -574,6 +624,16 @@ void CommandHandler::commitBatches( StorageHandler& aStorageHandler, ConflictRes
     results.unite( aStorageHandler.commitReplacedItems( *aTarget.getPlugin(), resolver ) );
     results.unite( aStorageHandler.commitDeletedItems( *aTarget.getPlugin(), resolver ) );
 
+    processCommitResults( results, aTarget, aSyncParams, aResponses, aNewMappings );
+}
+
+void CommandHandler::processCommitResults( const QMap<ItemId, CommitResult>& aResults,
+                                           SyncTarget& aTarget, const SyncParams& aSyncParams,
+                                           QMap<ItemId, ResponseStatusCode>& aResponses,
+                                           QList<UIDMapping>& aNewMappings )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
     // Process commit results and convert them to result codes
 
     for( int i = 0; i < aSyncParams.commands.count(); ++i ) {
@@ -591,11 +651,11 @@ void CommandHandler::commitBatches( StorageHandler& aStorageHandler, ConflictRes
 
             if( !aResponses.contains( id ) ) {
 
-                if( results.contains( id ) ) {
+                if( aResults.contains( id ) ) {
 
                     ResponseStatusCode statusCode = COMMAND_FAILED;
 
-                    const CommitResult& result = results.value( id );
+                    const CommitResult& result = aResults.value( id );
 
                     if( result.iStatus == COMMIT_ADDED || result.iStatus == COMMIT_INIT_ADD) {
 
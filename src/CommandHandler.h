@@ -111,6 +111,42 @@ public:
                      ConflictResolver& aConflictResolver,
                      bool aFastMapsSend);
 
+    /*! \brief Start processing SyncML SYNC command with asynchronous commits
+     *
+     * Items of the command are committed with StorageHandler::startCommit().
+     * Once the commit has finished, finishSync() must be called to generate
+     * statuses and mappings of the items.
+     *
+     * @param aSyncParams SYNC element data
+     * @param aTarget Target associated with the command
+     * @param aStorageHandler Storage handler to use in manipulating local database
+     * @param aResponseGenerator Response generator to use
+     * @param aConflictResolver Conflict resolver to use. Must exist until commit has finished
+     * @param aResponses Responses of items, to be passed to finishSync()
+     */
+    void startSync( const SyncParams& aSyncParams,
+                    SyncTarget& aTarget,
+                    StorageHandler& aStorageHandler,
+                    ResponseGenerator& aResponseGenerator,
+                    ConflictResolver& aConflictResolver,
+                    QMap<ItemId, ResponseStatusCode>& aResponses );
+
+    /*! \brief Finish processing SyncML SYNC command started with startSync()
+     *
+     * @param aSyncParams SYNC element data
+     * @param aTarget Target associated with the command
+     * @param aStorageHandler Storage handler that finished committing
+     * @param aResponseGenerator Response generator to use
+     * @param aResponses Responses of items, as filled in by startSync()
+     * @param aFastMapsSend True if possible mappings should be sent immediately
+     */
+    void finishSync( const SyncParams& aSyncParams,
+                     SyncTarget& aTarget,
+                     StorageHandler& aStorageHandler,
+                     ResponseGenerator& aResponseGenerator,
+                     QMap<ItemId, ResponseStatusCode>& aResponses,
+                     bool aFastMapsSend );
+
     /*! \brief Reject SyncML SYNC command
      *
      * @param aSyncParams SYNC element data
@@ -198,6 +234,11 @@ private: // functions
                         QMap<ItemId, ResponseStatusCode>& aResponses,
                         QList<UIDMapping>& aNewMappings );
 
+    void processCommitResults( const QMap<ItemId, CommitResult>& aResults,
+                               SyncTarget& aTarget, const SyncParams& aSyncParams,
+                               QMap<ItemId, ResponseStatusCode>& aResponses,
+                               QList<UIDMapping>& aNewMappings );
+
     void processResults( const SyncParams& aSyncParams, const QMap<ItemId, ResponseStatusCode>& aResponses,
                          ResponseGenerator& aResponseGenerator );
 
@@ -0,0 +1,62 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+
+#ifndef CONCURRENTFETCHSTORAGEPLUGIN_H
+#define CONCURRENTFETCHSTORAGEPLUGIN_H
+
+namespace DataSync {
+
+/*! \brief Optional interface of storage plugins that can be read from another thread
+ *
+ * Local changes are fetched from the storage in a background thread only if
+ * the StoragePlugin implementation also inherits this interface, which is
+ * detected at run time. By inheriting it the plugin declares that
+ * StoragePlugin::getSyncItems() may be called from a thread other than the
+ * one that created the plugin, while the plugin is being used from that
+ * thread. Calls to getSyncItems() are never made from more than one thread
+ * at a time. Items are fetched in the calling thread for other plugins.
+ */
+class ConcurrentFetchStoragePlugin
+{
+public:
+
+    /*! \brief Destructor
+     */
+    virtual ~ConcurrentFetchStoragePlugin() {}
+
+};
+
+}
+
+#endif  //  CONCURRENTFETCHSTORAGEPLUGIN_H
@@ -91,8 +91,8 @@ void ConflictResolver::removeLocalChange( const SyncItemKey& aLocalKey )
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     bool retval = false;
-    if (iLocalChanges.removed.contains( aLocalKey ))    
-        retval = iLocalChanges.removed.removeOne( aLocalKey );   
+    if (iLocalChanges.removed.removeOne( aLocalKey ))
+        retval = true;
     else
         retval = iLocalChanges.modified.removeOne( aLocalKey );
 }
@@ -103,15 +103,10 @@ void ConflictResolver::changeLocalModifyToLocalAdd( const SyncItemKey& aLocalKey
 
     /* Reason for this is that in the case of a conflict scenario if the remote is delete and local is
      * modify and if remote wins the mapping is lost in remote side so a replace returns with an error*/	    
-    for (int i = 0; i < iLocalChanges.modified.size(); ++i) {
-        qCDebug(lcSyncML) << "Key :" << aLocalKey << "Remote" << iLocalChanges.modified.at(i);
-        if (iLocalChanges.modified.at(i) == aLocalKey){
-            qCDebug(lcSyncML) << "Change from replace to add ";
-	    iLocalChanges.modified.removeAt(i);
-	    iLocalChanges.added.append(aLocalKey);
-	    break;
-        }
-    }	  
+    if( iLocalChanges.modified.removeOne( aLocalKey ) ) {
+        qCDebug(lcSyncML) << "Change from replace to add for key:" << aLocalKey;
+        iLocalChanges.added.append( aLocalKey );
+    }
 }
     
 void ConflictResolver::revertLocalChange( const SyncItemKey& aLocalKey, ConflictRevertPolicy policy ) 
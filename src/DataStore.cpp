@@ -33,6 +33,8 @@
 
 #include "DataStore.h"
 
+#include "SyncMLLogging.h"
+
 using namespace DataSync;
 
 Datastore::Datastore() : iSupportsHierarchicalSync( false )
@@ -85,10 +87,42 @@ QList<SyncTypes>& Datastore::syncCaps()
 
 const QList<CTCap>& Datastore::ctCaps() const
 {
+    decodeCTCaps();
     return iCTCaps;
 }
 
 QList<CTCap>& Datastore::ctCaps()
 {
+    decodeCTCaps();
     return iCTCaps;
 }
+
+void Datastore::addCTCapData( const QByteArray& aData )
+{
+    iCTCapData.append( aData );
+}
+
+const QList<QByteArray>& Datastore::ctCapData() const
+{
+    return iCTCapData;
+}
+
+const QList<CTCap>& Datastore::decodedCTCaps() const
+{
+    return iCTCaps;
+}
+
+void Datastore::decodeCTCaps() const
+{
+    if( iCTCapData.isEmpty() ) {
+        return;
+    }
+
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !DataSync::decodeCTCaps( iCTCapData, iCTCaps ) ) {
+        qCWarning(lcSyncML) << "Ignoring CTCaps of datastore" << iSourceURI << "that could not be decoded";
+    }
+
+    iCTCapData.clear();
+}
@@ -33,6 +33,8 @@
 #ifndef DATASTORE_H
 #define DATASTORE_H
 
+#include <QByteArray>
+
 #include "CTCap.h"
 #include "SyncMLGlobals.h"
 
@@ -104,24 +106,51 @@ public:
     QList<SyncTypes>& syncCaps();
 
     /*! \brief Access CT caps of this datastore
+     *
+     * CT caps added with addCTCapData() are decoded on first access.
      *
      * @return
      */
     const QList<CTCap>& ctCaps() const;
 
     /*! \brief Access CT caps of this datastore
+     *
+     * CT caps added with addCTCapData() are decoded on first access.
      *
      * @return
      */
     QList<CTCap>& ctCaps();
 
+    /*! \brief Adds a CT cap that is decoded only when CT caps are accessed
+     *
+     * @param aData SyncML 1.2 CTCap element
+     */
+    void addCTCapData( const QByteArray& aData );
+
+    /*! \brief Access CT caps of this datastore that have not been decoded yet
+     *
+     * @return SyncML 1.2 CTCap elements
+     */
+    const QList<QByteArray>& ctCapData() const;
+
+    /*! \brief Access CT caps of this datastore that have been decoded so far
+     *
+     * Unlike ctCaps(), does not decode CT caps added with addCTCapData().
+     *
+     * @return
+     */
+    const QList<CTCap>& decodedCTCaps() const;
+
 private:
 
+    void decodeCTCaps() const;
+
     QString                     iSourceURI;
     StorageContentFormatInfo    iFormatInfo;
     bool                        iSupportsHierarchicalSync;
     QList<SyncTypes>            iSyncCaps;
-    QList<CTCap>                iCTCaps;
+    mutable QList<CTCap>        iCTCaps;
+    mutable QList<QByteArray>   iCTCapData;
 };
 
 }
@@ -44,7 +44,9 @@ using namespace DataSync;
 
 DevInfHandler::DevInfHandler( const DeviceInfo& aDeviceInfo )
  : iLocalDeviceInfo( aDeviceInfo ), iLocalDevInfSent( false ),
-   iRemoteDevInfReceived( false )
+   iRemoteDevInfReceived( false ), iRemoteDevInfCached( false ),
+   iRemoteDevInfStale( false ), iRemoteDevInfRequested( false ),
+   iRemoteDevInfUpdated( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -64,6 +66,47 @@ const RemoteDeviceInfo& DevInfHandler::getRemoteDeviceInfo() const
     return iRemoteDevInfo;
 }
 
+const QByteArray& DevInfHandler::getRemoteDevInfHash() const
+{
+    return iRemoteDevInfHash;
+}
+
+void DevInfHandler::setCachedRemoteDeviceInfo( const RemoteDeviceInfo& aDevInfo, const QByteArray& aHash )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iRemoteDevInfo = aDevInfo;
+    iRemoteDevInfHash = aHash;
+    iRemoteDevInfCached = true;
+}
+
+void DevInfHandler::setRemoteDevInfStale()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iRemoteDevInfCached && !iRemoteDevInfStale )
+    {
+        qCDebug(lcSyncML) << "Stored remote device info is stale, requesting it again";
+        iRemoteDevInfStale = true;
+    }
+}
+
+void DevInfHandler::clearCachedRemoteDeviceInfo()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Keep using the device info for the rest of the session, but do not
+    // trust it to match what the remote device would send
+    iRemoteDevInfHash.clear();
+    iRemoteDevInfCached = false;
+    iRemoteDevInfStale = false;
+}
+
+bool DevInfHandler::remoteDevInfUpdated() const
+{
+    return iRemoteDevInfUpdated;
+}
+
 void DevInfHandler::composeLocalInitiatedDevInfExchange(
     const QList<StoragePlugin*>& aDataStores, const ProtocolVersion& aVersion,
     const Role& aRole, ResponseGenerator& aResponseGenerator )
@@ -72,16 +115,31 @@ void DevInfHandler::composeLocalInitiatedDevInfExchange(
 
     if( !iLocalDevInfSent )
     {
+        bool retrieve = remoteDevInfNeeded();
         DevInfPackage* devInf = new DevInfPackage( aDataStores, iLocalDeviceInfo,
-                                                   aVersion, aRole );
+                                                   aVersion, aRole, retrieve );
 
         aResponseGenerator.addPackage( devInf );
 
         iLocalDevInfSent = true;
+        iRemoteDevInfRequested = retrieve;
     }
 
 }
 
+void DevInfHandler::composeRemoteDevInfRequest( const ProtocolVersion& aVersion,
+                                                const Role& aRole,
+                                                ResponseGenerator& aResponseGenerator )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( remoteDevInfNeeded() )
+    {
+        aResponseGenerator.addPackage( new DevInfPackage( iLocalDeviceInfo, aVersion, aRole ) );
+        iRemoteDevInfRequested = true;
+    }
+}
+
 ResponseStatusCode DevInfHandler::handleGet( const CommandParams& aGet,
                                              const ProtocolVersion& aVersion,
                                              const QList<StoragePlugin*>& aDataStores,
@@ -108,18 +166,24 @@ ResponseStatusCode DevInfHandler::handleGet( const CommandParams& aGet,
     if( valid )
     {
 
-        // If we haven't yet received remote device info, send GET in addition to the
-        // RESULTS
+        // If we haven't yet received remote device info and it is not known
+        // from an earlier session, send GET in addition to the RESULTS
+        bool retrieve = remoteDevInfNeeded();
         DevInfPackage* devInf = new DevInfPackage( aResponseGenerator.getRemoteMsgId(),
                                                    aGet.cmdId,
                                                    aDataStores,
                                                    iLocalDeviceInfo,
                                                    aVersion,
                                                    aRole,
-                                                   !iRemoteDevInfReceived );
+                                                   retrieve );
 
         aResponseGenerator.addPackage( devInf );
 
+        if( retrieve )
+        {
+            iRemoteDevInfRequested = true;
+        }
+
         iLocalDevInfSent = true;
 
         status = SUCCESS;
@@ -150,8 +214,7 @@ ResponseStatusCode DevInfHandler::handlePut( const PutParams& aPut,
 
     if( valid )
     {
-        iRemoteDevInfo = aPut.devInf.devInfo;
-        iRemoteDevInfReceived = true;
+        setRemoteDeviceInfo( aPut.devInf );
 
         status = SUCCESS;
     }
@@ -183,8 +246,7 @@ ResponseStatusCode DevInfHandler::handleResults( const ResultsParams& aResults,
 
     if( valid )
     {
-        iRemoteDevInfo = aResults.devInf.devInfo;
-        iRemoteDevInfReceived = true;
+        setRemoteDeviceInfo( aResults.devInf );
         status = SUCCESS;
     }
     else
@@ -201,4 +263,45 @@ void DevInfHandler::reset()
 
     iLocalDevInfSent = false;
     iRemoteDevInfReceived = false;
+    iRemoteDevInfRequested = false;
+}
+
+bool DevInfHandler::remoteDevInfNeeded() const
+{
+    return !iRemoteDevInfReceived && !iRemoteDevInfRequested &&
+           ( !iRemoteDevInfCached || iRemoteDevInfStale );
+}
+
+void DevInfHandler::setRemoteDeviceInfo( const DevInfItemParams& aDevInf )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Device info is not parsed if it is found unchanged, in which case the
+    // cached one is kept
+    if( aDevInf.cached )
+    {
+        if( iRemoteDevInfCached && aDevInf.hash == iRemoteDevInfHash )
+        {
+            qCDebug(lcSyncML) << "Remote device info has not changed";
+        }
+        else
+        {
+            qCWarning(lcSyncML) << "Received remote device info was not parsed, keeping the previous one";
+        }
+
+        // Stale device info is stored again to renew its age
+        iRemoteDevInfUpdated = iRemoteDevInfStale;
+    }
+    else
+    {
+        // Stored device info needs updating unless it was parsed from the
+        // same document and is not stale
+        iRemoteDevInfUpdated = !iRemoteDevInfCached || iRemoteDevInfStale ||
+                               aDevInf.hash.isEmpty() || aDevInf.hash != iRemoteDevInfHash;
+        iRemoteDevInfo = aDevInf.devInfo;
+        iRemoteDevInfHash = aDevInf.hash;
+    }
+
+    iRemoteDevInfReceived = true;
+    iRemoteDevInfStale = false;
 }
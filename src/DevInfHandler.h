@@ -49,6 +49,7 @@ class ResponseGenerator;
 struct CommandParams;
 struct PutParams;
 struct ResultsParams;
+struct DevInfItemParams;
 
 /*! \brief Class that governs the exchange of device information in
  *         synchronization session
@@ -80,6 +81,43 @@ public:
      */
     const RemoteDeviceInfo& getRemoteDeviceInfo() const;
 
+    /*! \brief Retrieves the hash of the remote device info document
+     *
+     * @return Hash if known, otherwise empty
+     */
+    const QByteArray& getRemoteDevInfHash() const;
+
+    /*! \brief Sets remote device info stored in an earlier session
+     *
+     * Remote device info is not requested from the remote device when it is
+     * already known.
+     *
+     * @param aDevInfo Remote device info
+     * @param aHash Hash of the device info document it was parsed from
+     */
+    void setCachedRemoteDeviceInfo( const RemoteDeviceInfo& aDevInfo, const QByteArray& aHash );
+
+    /*! \brief Marks remote device info stored in an earlier session stale
+     *
+     * Stale remote device info is requested again from the remote device,
+     * for example on slow sync or when it has been stored for too long.
+     */
+    void setRemoteDevInfStale();
+
+    /*! \brief Forgets that remote device info was stored in an earlier session
+     *
+     * Used when remote device rejects local device info, in which case the
+     * stored remote device info cannot be trusted either.
+     */
+    void clearCachedRemoteDeviceInfo();
+
+    /*! \brief Checks if remote device info was updated by the last handled
+     *         PUT or RESULTS
+     *
+     * @return True if new remote device info was received and should be stored
+     */
+    bool remoteDevInfUpdated() const;
+
     /*! \brief Initiate a device info exchange with remote device
      *
      * @param aDataStores Data stores to use
@@ -92,6 +130,17 @@ public:
                                               const Role& aRole,
                                               ResponseGenerator& aResponseGenerator );
 
+    /*! \brief Request remote device info if it is stale and has not been
+     *         requested yet
+     *
+     * @param aVersion Protocol version in use
+     * @param aRole Role in use
+     * @param aResponseGenerator Response generator to use
+     */
+    void composeRemoteDevInfRequest( const ProtocolVersion& aVersion,
+                                     const Role& aRole,
+                                     ResponseGenerator& aResponseGenerator );
+
     /*! \brief Respond to device info requested by remote device
      *
      * @param aGet GET element data
@@ -136,10 +185,19 @@ private:
 
     friend class ::DevInfHandlerTest;
 
+    void setRemoteDeviceInfo( const DevInfItemParams& aDevInf );
+
+    bool remoteDevInfNeeded() const;
+
     DeviceInfo          iLocalDeviceInfo;
     RemoteDeviceInfo    iRemoteDevInfo;
+    QByteArray          iRemoteDevInfHash;
     bool                iLocalDevInfSent;
     bool                iRemoteDevInfReceived;
+    bool                iRemoteDevInfCached;
+    bool                iRemoteDevInfStale;
+    bool                iRemoteDevInfRequested;
+    bool                iRemoteDevInfUpdated;
 
 };
 
@@ -46,11 +46,21 @@ using namespace DataSync;
 DevInfPackage::DevInfPackage( const QList<StoragePlugin*>& aDataStores,
                               const DeviceInfo& aDeviceInfo,
                               const ProtocolVersion& aVersion,
-                              const Role& aRole )
+                              const Role& aRole,
+                              bool aRetrieveRemoteDevInf )
 : iMsgRef(0), iCmdRef(0), iDataStores( aDataStores ), iDeviceInfo( aDeviceInfo ),
-  iVersion( aVersion ), iRole( aRole ), iType( PUTGET )
+  iVersion( aVersion ), iRole( aRole )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aRetrieveRemoteDevInf )
+    {
+        iType = PUTGET;
+    }
+    else
+    {
+        iType = PUT;
+    }
 }
 
 DevInfPackage::DevInfPackage( int aMsgRef, int aCmdRef,
@@ -74,6 +84,15 @@ DevInfPackage::DevInfPackage( int aMsgRef, int aCmdRef,
     }
 }
 
+DevInfPackage::DevInfPackage( const DeviceInfo& aDeviceInfo,
+                              const ProtocolVersion& aVersion,
+                              const Role& aRole )
+: iMsgRef(0), iCmdRef(0), iDeviceInfo( aDeviceInfo ), iVersion( aVersion ),
+  iRole( aRole ), iType( GET )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
 DevInfPackage::~DevInfPackage()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -83,7 +102,16 @@ bool DevInfPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aW
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    if( iType == PUTGET )
+    if( iType == PUT )
+    {
+        // Compose PUT
+        SyncMLPut* put = new SyncMLPut( aMessage.getNextCmdId(), iDataStores,
+                                        iDeviceInfo, iVersion, iRole );
+
+        aSizeThreshold -= put->calculateSize(aWBXML, aVersion);
+        aMessage.addToBody( put );
+    }
+    else if( iType == PUTGET )
     {
         // Compose PUT
         SyncMLPut* put = new SyncMLPut( aMessage.getNextCmdId(), iDataStores,
@@ -99,6 +127,15 @@ bool DevInfPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aW
         aSizeThreshold -= get->calculateSize(aWBXML, aVersion);
         aMessage.addToBody( get );
     }
+    else if( iType == GET )
+    {
+        // Compose GET
+        SyncMLGet* get = new SyncMLGet( aMessage.getNextCmdId(), SYNCML_CONTTYPE_DEVINF_XML,
+                                        iVersion == SYNCML_1_1 ? SYNCML_DEVINF_PATH_11 : SYNCML_DEVINF_PATH_12 );
+
+        aSizeThreshold -= get->calculateSize(aWBXML, aVersion);
+        aMessage.addToBody( get );
+    }
     else if( iType == RESULTS )
     {
         // Compose RESULTS
@@ -56,17 +56,19 @@ public:
      *
      * This constructor should be used when local side is initiating device
      * info exchange. Local device info is sent with PUT, and remote device info
-     * is requested with GET.
+     * is requested with GET unless it is already known.
      *
      * @param aDataStores Datastores available to use in generation
      * @param aDeviceInfo Device info object
      * @param aVersion Protocol version to use
      * @param aRole Role in use
+     * @param aRetrieveRemoteDevInf True if GET should be issued to remote side
      */
     DevInfPackage( const QList<StoragePlugin*>& aDataStores,
                    const DeviceInfo& aDeviceInfo,
                    const ProtocolVersion& aVersion,
-                   const Role& aRole );
+                   const Role& aRole,
+                   bool aRetrieveRemoteDevInf );
 
     /*! \brief Construct device information package using RESULTS
      *
@@ -90,6 +92,20 @@ public:
                    const Role& aRole,
                    bool aRetrieveRemoteDevInf );
 
+    /*! \brief Construct device information package using GET only
+     *
+     * This constructor should be used when remote device info needs to be
+     * requested after local device info has already been exchanged, for
+     * example when the stored remote device info turns out to be stale.
+     *
+     * @param aDeviceInfo Device info object
+     * @param aVersion Protocol version to use
+     * @param aRole Role in use
+     */
+    DevInfPackage( const DeviceInfo& aDeviceInfo,
+                   const ProtocolVersion& aVersion,
+                   const Role& aRole );
+
     virtual ~DevInfPackage();
 
     virtual bool write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion );
@@ -100,7 +116,9 @@ private:
 
     enum Type
     {
+        PUT,
         PUTGET,
+        GET,
         RESULTS,
         RESULTSGET
     };
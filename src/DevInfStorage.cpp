@@ -0,0 +1,391 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "DevInfStorage.h"
+
+#include <QtSql>
+#include <QDataStream>
+
+#include "RemoteDeviceInfo.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+namespace {
+
+// Version of the serialized device information, stored along with it.
+// Device information of a different version is ignored.
+const quint32 DEVINF_FORMAT_VERSION = 2;
+
+void writeFormat( QDataStream& aStream, const ContentFormat& aFormat )
+{
+    aStream << aFormat.iType << aFormat.iVersion;
+}
+
+void readFormat( QDataStream& aStream, ContentFormat& aFormat )
+{
+    aStream >> aFormat.iType >> aFormat.iVersion;
+}
+
+void writeFormats( QDataStream& aStream, const QList<ContentFormat>& aFormats )
+{
+    aStream << static_cast<quint32>( aFormats.count() );
+
+    foreach( const ContentFormat& format, aFormats ) {
+        writeFormat( aStream, format );
+    }
+}
+
+void readFormats( QDataStream& aStream, QList<ContentFormat>& aFormats )
+{
+    quint32 count = 0;
+    aStream >> count;
+
+    for( quint32 i = 0; i < count && aStream.status() == QDataStream::Ok; ++i ) {
+        ContentFormat format;
+        readFormat( aStream, format );
+        aFormats.append( format );
+    }
+}
+
+void writeCTCap( QDataStream& aStream, const CTCap& aCTCap )
+{
+    writeFormat( aStream, aCTCap.getFormat() );
+    aStream << static_cast<quint32>( aCTCap.properties().count() );
+
+    foreach( const CTCapProperty& property, aCTCap.properties() ) {
+        aStream << property.iName << property.iType << static_cast<qint32>( property.iMaxOccur )
+                << static_cast<qint32>( property.iSize ) << property.iNoTruncate
+                << property.iDisplayName << property.iValues;
+
+        aStream << static_cast<quint32>( property.iParameters.count() );
+
+        foreach( const CTCapParameter& parameter, property.iParameters ) {
+            aStream << parameter.iName << parameter.iType << parameter.iDisplayName
+                    << parameter.iValues;
+        }
+    }
+}
+
+void readCTCap( QDataStream& aStream, CTCap& aCTCap )
+{
+    ContentFormat format;
+    readFormat( aStream, format );
+    aCTCap.setFormat( format );
+
+    quint32 propertyCount = 0;
+    aStream >> propertyCount;
+
+    for( quint32 i = 0; i < propertyCount && aStream.status() == QDataStream::Ok; ++i ) {
+        CTCapProperty property;
+        qint32 maxOccur = -1;
+        qint32 size = -1;
+
+        aStream >> property.iName >> property.iType >> maxOccur >> size >> property.iNoTruncate
+                >> property.iDisplayName >> property.iValues;
+        property.iMaxOccur = maxOccur;
+        property.iSize = size;
+
+        quint32 parameterCount = 0;
+        aStream >> parameterCount;
+
+        for( quint32 j = 0; j < parameterCount && aStream.status() == QDataStream::Ok; ++j ) {
+            CTCapParameter parameter;
+            aStream >> parameter.iName >> parameter.iType >> parameter.iDisplayName
+                    >> parameter.iValues;
+            property.iParameters.append( parameter );
+        }
+
+        aCTCap.properties().append( property );
+    }
+}
+
+QByteArray serialize( const RemoteDeviceInfo& aDevInfo )
+{
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    const DeviceInfo& deviceInfo = aDevInfo.deviceInfo();
+
+    stream << DEVINF_FORMAT_VERSION;
+    stream << deviceInfo.getDeviceID() << deviceInfo.getManufacturer() << deviceInfo.getModel()
+           << deviceInfo.getOEM() << deviceInfo.getFirmwareVersion()
+           << deviceInfo.getSoftwareVersion() << deviceInfo.getHardwareVersion()
+           << deviceInfo.getDeviceType();
+    stream << aDevInfo.getSupportsUTC() << aDevInfo.getSupportsLargeObjs()
+           << aDevInfo.getSupportsNumberOfChanges();
+
+    stream << static_cast<quint32>( aDevInfo.datastores().count() );
+
+    foreach( const Datastore& datastore, aDevInfo.datastores() ) {
+
+        stream << datastore.getSourceURI() << datastore.getSupportsHierarchicalSync();
+
+        const StorageContentFormatInfo& formatInfo = datastore.formatInfo();
+        writeFormat( stream, formatInfo.getPreferredRx() );
+        writeFormat( stream, formatInfo.getPreferredTx() );
+        writeFormats( stream, formatInfo.rx() );
+        writeFormats( stream, formatInfo.tx() );
+
+        stream << static_cast<quint32>( datastore.syncCaps().count() );
+        foreach( SyncTypes syncType, datastore.syncCaps() ) {
+            stream << static_cast<qint32>( syncType );
+        }
+
+        // CT caps that have not been decoded are stored as they were received
+        stream << static_cast<quint32>( datastore.decodedCTCaps().count() );
+        foreach( const CTCap& ctCap, datastore.decodedCTCaps() ) {
+            writeCTCap( stream, ctCap );
+        }
+
+        stream << datastore.ctCapData();
+    }
+
+    return data;
+}
+
+bool deserialize( const QByteArray& aData, RemoteDeviceInfo& aDevInfo )
+{
+    QDataStream stream( aData );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    quint32 version = 0;
+    stream >> version;
+
+    if( version != DEVINF_FORMAT_VERSION ) {
+        qCDebug(lcSyncML) << "Ignoring stored device info of version" << version;
+        return false;
+    }
+
+    QString deviceID, manufacturer, model, oem, firmwareVersion, softwareVersion,
+            hardwareVersion, deviceType;
+    bool utc = false;
+    bool largeObjs = false;
+    bool numberOfChanges = false;
+
+    stream >> deviceID >> manufacturer >> model >> oem >> firmwareVersion >> softwareVersion
+           >> hardwareVersion >> deviceType;
+    stream >> utc >> largeObjs >> numberOfChanges;
+
+    DeviceInfo& deviceInfo = aDevInfo.deviceInfo();
+    deviceInfo.setDeviceID( deviceID );
+    deviceInfo.setManufacturer( manufacturer );
+    deviceInfo.setModel( model );
+    deviceInfo.setOEM( oem );
+    deviceInfo.setFirmwareVersion( firmwareVersion );
+    deviceInfo.setSoftwareVersion( softwareVersion );
+    deviceInfo.setHardwareVersion( hardwareVersion );
+    deviceInfo.setDeviceType( deviceType );
+    aDevInfo.setSupportsUTC( utc );
+    aDevInfo.setSupportsLargeObjs( largeObjs );
+    aDevInfo.setSupportsNumberOfChanges( numberOfChanges );
+
+    quint32 datastoreCount = 0;
+    stream >> datastoreCount;
+
+    for( quint32 i = 0; i < datastoreCount && stream.status() == QDataStream::Ok; ++i ) {
+
+        Datastore datastore;
+        QString sourceURI;
+        bool hierarchicalSync = false;
+
+        stream >> sourceURI >> hierarchicalSync;
+        datastore.setSourceURI( sourceURI );
+        datastore.setSupportsHierarchicalSync( hierarchicalSync );
+
+        StorageContentFormatInfo& formatInfo = datastore.formatInfo();
+        ContentFormat format;
+        readFormat( stream, format );
+        formatInfo.setPreferredRx( format );
+        readFormat( stream, format );
+        formatInfo.setPreferredTx( format );
+        readFormats( stream, formatInfo.rx() );
+        readFormats( stream, formatInfo.tx() );
+
+        quint32 syncCapCount = 0;
+        stream >> syncCapCount;
+        for( quint32 j = 0; j < syncCapCount && stream.status() == QDataStream::Ok; ++j ) {
+            qint32 syncType = 0;
+            stream >> syncType;
+            datastore.syncCaps().append( static_cast<SyncTypes>( syncType ) );
+        }
+
+        quint32 ctCapCount = 0;
+        stream >> ctCapCount;
+        for( quint32 j = 0; j < ctCapCount && stream.status() == QDataStream::Ok; ++j ) {
+            CTCap ctCap;
+            readCTCap( stream, ctCap );
+            datastore.ctCaps().append( ctCap );
+        }
+
+        QList<QByteArray> ctCapData;
+        stream >> ctCapData;
+        foreach( const QByteArray& data, ctCapData ) {
+            datastore.addCTCapData( data );
+        }
+
+        aDevInfo.datastores().append( datastore );
+    }
+
+    if( stream.status() != QDataStream::Ok ) {
+        qCWarning(lcSyncML) << "Stored device info is corrupted";
+        return false;
+    }
+
+    return true;
+}
+
+}
+
+DevInfStorage::DevInfStorage( QSqlDatabase& aDbHandle, const QString& aRemoteDevice )
+ : iDbHandle( aDbHandle ), iRemoteDevice( aRemoteDevice )
+{
+
+}
+
+DevInfStorage::~DevInfStorage()
+{
+
+}
+
+bool DevInfStorage::devInf( RemoteDeviceInfo& aDevInfo, QByteArray& aHash, QDateTime& aUpdated )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    bool found = false;
+
+    if( createDevInfTable() )
+    {
+
+        const QString queryString( "SELECT hash, devinf, updated FROM remote_devinfs WHERE remote_device = :remote_device" );
+        QSqlQuery query( iDbHandle );
+
+        query.prepare( queryString );
+        query.bindValue( ":remote_device", iRemoteDevice );
+        query.exec();
+
+        if( query.lastError().isValid() )
+        {
+            qCWarning(lcSyncML) << "Query failed:" << query.lastError();
+        }
+        else if( query.next() )
+        {
+            RemoteDeviceInfo devInfo;
+
+            if( deserialize( query.value(1).toByteArray(), devInfo ) )
+            {
+                aDevInfo = devInfo;
+                aHash = query.value(0).toByteArray();
+                aUpdated = QDateTime::fromTime_t( query.value(2).toUInt() );
+                found = true;
+            }
+        }
+
+    }
+
+    return found;
+}
+
+void DevInfStorage::setDevInf( const RemoteDeviceInfo& aDevInfo, const QByteArray& aHash )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !createDevInfTable() )
+    {
+        return;
+    }
+
+    clearDevInf();
+
+    const QString insertQuery( "INSERT INTO remote_devinfs(remote_device, hash, devinf, updated) values(:remote_device, :hash, :devinf, :updated)" );
+
+    QSqlQuery query( iDbHandle );
+
+    query.prepare( insertQuery );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.bindValue( ":hash", aHash );
+    query.bindValue( ":devinf", serialize( aDevInfo ) );
+    query.bindValue( ":updated", QDateTime::currentDateTime().toTime_t() );
+    query.exec();
+
+    if( query.lastError().isValid() )
+    {
+        qCWarning(lcSyncML) << "Query failed: " << query.lastError();
+    }
+
+}
+
+void DevInfStorage::clearDevInf()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !createDevInfTable() )
+    {
+        return;
+    }
+
+    const QString deleteQuery( "DELETE FROM remote_devinfs WHERE remote_device = :remote_device" );
+
+    QSqlQuery query( iDbHandle );
+
+    query.prepare( deleteQuery );
+    query.bindValue( ":remote_device", iRemoteDevice );
+    query.exec();
+
+    if( query.lastError().isValid() )
+    {
+        qCWarning(lcSyncML) << "Query failed: " << query.lastError();
+    }
+}
+
+bool DevInfStorage::createDevInfTable()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const QString queryString = "CREATE TABLE IF NOT EXISTS remote_devinfs(id integer primary key autoincrement, remote_device varchar(512), hash varchar(64), devinf blob, updated integer)";
+    QSqlQuery query( iDbHandle );
+
+    query.prepare( queryString );
+    query.exec();
+
+    bool success = true;
+
+    if (query.lastError().isValid()) {
+        success = false;
+        qCWarning(lcSyncML) << "Query failed: " << query.lastError();
+    }
+
+    return success;
+}
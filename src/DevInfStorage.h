@@ -0,0 +1,109 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef DEVINFSTORAGE_H
+#define DEVINFSTORAGE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+
+class QSqlDatabase;
+
+namespace DataSync {
+
+class RemoteDeviceInfo;
+
+/*! \brief Class for storing device information received from remote devices
+ *
+ * Device information is stored together with a hash of the device
+ * information document it was parsed from, so that an unchanged document
+ * does not need to be parsed again, and device information does not need to
+ * be requested again in later sessions.
+ */
+class DevInfStorage
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aDbHandle Database handle to use
+     * @param aRemoteDevice Remote device to associate with
+     */
+    explicit DevInfStorage( QSqlDatabase& aDbHandle, const QString& aRemoteDevice );
+
+    /*! \brief Destructor
+     *
+     */
+    virtual ~DevInfStorage();
+
+    /*! \brief Retrieves device information from storage
+     *
+     * @param aDevInfo Device information to fill
+     * @param aHash Hash of the device information document to fill
+     * @param aUpdated Time when device information was last stored
+     * @return True if device information was found, otherwise false
+     */
+    bool devInf( RemoteDeviceInfo& aDevInfo, QByteArray& aHash, QDateTime& aUpdated );
+
+    /*! \brief Sets new device information to storage
+     *
+     * @param aDevInfo Device information to store
+     * @param aHash Hash of the device information document, may be empty
+     */
+    void setDevInf( const RemoteDeviceInfo& aDevInfo, const QByteArray& aHash );
+
+    /*! \brief Clears device information from storage
+     *
+     */
+    void clearDevInf();
+
+protected:
+
+    /*! \brief Ensure that database table exists for device information
+     *
+     * @return True on success, otherwise false
+     */
+    bool createDevInfTable();
+
+private:
+
+    QSqlDatabase&   iDbHandle;
+    QString         iRemoteDevice;
+
+};
+
+}
+
+#endif  //  DEVINFSTORAGE_H
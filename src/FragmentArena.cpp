@@ -0,0 +1,183 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "FragmentArena.h"
+
+#include <new>
+
+using namespace DataSync;
+
+struct FragmentArena::Block
+{
+    QAtomicInt  iRefs;
+    std::size_t iUsed;
+    std::size_t iCapacity;
+};
+
+namespace {
+
+const std::size_t ALIGNMENT = alignof( std::max_align_t );
+
+inline std::size_t aligned( std::size_t aSize )
+{
+    return ( aSize + ALIGNMENT - 1 ) & ~( ALIGNMENT - 1 );
+}
+
+// Every object is preceded by a pointer to the block it was allocated from
+const std::size_t OBJECT_HEADER_SIZE = aligned( sizeof( void* ) );
+
+}
+
+thread_local FragmentArena* FragmentArena::iActive = 0;
+QAtomicInt FragmentArena::iBlockCount;
+bool FragmentArena::iBypassed = false;
+
+FragmentArena::Scope::Scope( FragmentArena& aArena ) : iPrevious( iActive )
+{
+    iActive = &aArena;
+}
+
+FragmentArena::Scope::~Scope()
+{
+    iActive = iPrevious;
+}
+
+FragmentArena::FragmentArena() : iCurrentBlock( 0 )
+{
+}
+
+FragmentArena::~FragmentArena()
+{
+    beginMessage();
+}
+
+void FragmentArena::beginMessage()
+{
+    if( iCurrentBlock ) {
+        unref( iCurrentBlock );
+        iCurrentBlock = 0;
+    }
+}
+
+void* FragmentArena::allocate( std::size_t aSize )
+{
+    if( iActive && !iBypassed ) {
+        return iActive->allocateFromBlock( aSize );
+    }
+    else {
+        return allocateFromHeap( aSize );
+    }
+}
+
+void FragmentArena::release( void* aPtr )
+{
+    if( !aPtr ) {
+        return;
+    }
+
+    char* memory = static_cast<char*>( aPtr ) - OBJECT_HEADER_SIZE;
+    Block* block = *reinterpret_cast<Block**>( memory );
+
+    if( block ) {
+        unref( block );
+    }
+    else {
+        ::operator delete( memory );
+    }
+}
+
+void* FragmentArena::allocateFromBlock( std::size_t aSize )
+{
+    const std::size_t size = OBJECT_HEADER_SIZE + aligned( aSize );
+    const std::size_t capacity = BLOCK_SIZE - aligned( sizeof( Block ) );
+
+    if( size > capacity ) {
+        // Object does not fit in a block, give it a block of its own
+        return place( newBlock( size ), size );
+    }
+
+    if( !iCurrentBlock || iCurrentBlock->iCapacity - iCurrentBlock->iUsed < size ) {
+
+        if( iCurrentBlock ) {
+            unref( iCurrentBlock );
+        }
+
+        // Arena holds a reference to the current block, so that it is not
+        // freed while objects are still being allocated from it
+        iCurrentBlock = newBlock( capacity );
+        iCurrentBlock->iRefs.ref();
+    }
+
+    return place( iCurrentBlock, size );
+}
+
+void* FragmentArena::allocateFromHeap( std::size_t aSize )
+{
+    // Object is not placed in any block
+    char* memory = static_cast<char*>( ::operator new( OBJECT_HEADER_SIZE + aligned( aSize ) ) );
+    *reinterpret_cast<Block**>( memory ) = 0;
+    return memory + OBJECT_HEADER_SIZE;
+}
+
+FragmentArena::Block* FragmentArena::newBlock( std::size_t aCapacity )
+{
+    void* memory = ::operator new( aligned( sizeof( Block ) ) + aCapacity );
+
+    Block* block = new( memory ) Block;
+    block->iUsed = 0;
+    block->iCapacity = aCapacity;
+    iBlockCount.ref();
+
+    return block;
+}
+
+void* FragmentArena::place( Block* aBlock, std::size_t aSize )
+{
+    char* memory = reinterpret_cast<char*>( aBlock ) + aligned( sizeof( Block ) ) + aBlock->iUsed;
+
+    aBlock->iUsed += aSize;
+    aBlock->iRefs.ref();
+
+    *reinterpret_cast<Block**>( memory ) = aBlock;
+
+    return memory + OBJECT_HEADER_SIZE;
+}
+
+void FragmentArena::unref( Block* aBlock )
+{
+    if( !aBlock->iRefs.deref() ) {
+        aBlock->~Block();
+        ::operator delete( aBlock );
+        iBlockCount.deref();
+    }
+}
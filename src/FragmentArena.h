@@ -0,0 +1,173 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef FRAGMENTARENA_H
+#define FRAGMENTARENA_H
+
+#include <cstddef>
+
+#include <QAtomicInt>
+
+class SyncMLMessageParserTest;
+
+namespace DataSync {
+
+/*! \brief Block allocator for fragments of received messages
+ *
+ * Parsing a message creates a large number of small fragment, command and
+ * item objects which all live until the message has been processed. Instead
+ * of allocating each of them separately from the heap, they are placed one
+ * after another in larger blocks. A block is freed in one go when every
+ * object allocated from it has been deleted, so owners of fragments keep
+ * deleting them as usual.
+ *
+ * Each parser owns an arena and makes it active in its thread with Scope
+ * while it is parsing. Only objects created while an arena is active are
+ * placed in blocks; fragments that applications or other parts of the
+ * library create are allocated from the heap as before. A fragment kept
+ * after its message has been processed pins the block it was placed in,
+ * so at most one block per such fragment stays allocated.
+ */
+class FragmentArena
+{
+public:
+
+    /*! \brief Makes an arena active in the calling thread
+     *
+     * Arena that was active before is restored when the scope ends.
+     */
+    class Scope
+    {
+    public:
+
+        /*! \brief Constructor
+         *
+         * @param aArena Arena to allocate objects from
+         */
+        explicit Scope( FragmentArena& aArena );
+
+        /*! \brief Destructor
+         *
+         */
+        ~Scope();
+
+    private:
+
+        Scope( const Scope& );
+        Scope& operator=( const Scope& );
+
+        FragmentArena* iPrevious;
+
+    };
+
+    /*! \brief Constructor
+     *
+     */
+    FragmentArena();
+
+    /*! \brief Destructor
+     *
+     * Blocks that still contain objects are freed when the objects have
+     * been deleted.
+     */
+    ~FragmentArena();
+
+    /*! \brief Starts a new block for the objects of the next message
+     *
+     * Keeps objects of different messages in separate blocks, so that the
+     * blocks of a message are freed as soon as it has been processed.
+     */
+    void beginMessage();
+
+    /*! \brief Allocates memory for an object
+     *
+     * Memory is taken from the arena active in the calling thread, or from
+     * the heap if there is none.
+     *
+     * @param aSize Size of the object
+     * @return Pointer to the allocated memory
+     */
+    static void* allocate( std::size_t aSize );
+
+    /*! \brief Releases memory allocated with allocate()
+     *
+     * Can be called from any thread.
+     *
+     * @param aPtr Pointer to the memory, can be NULL
+     */
+    static void release( void* aPtr );
+
+private:
+
+    FragmentArena( const FragmentArena& );
+    FragmentArena& operator=( const FragmentArena& );
+
+    struct Block;
+
+    void* allocateFromBlock( std::size_t aSize );
+
+    static void* allocateFromHeap( std::size_t aSize );
+
+    static Block* newBlock( std::size_t aCapacity );
+
+    static void* place( Block* aBlock, std::size_t aSize );
+
+    static void unref( Block* aBlock );
+
+    static const std::size_t    BLOCK_SIZE = 16384;
+
+    Block*                      iCurrentBlock;
+
+    static thread_local FragmentArena*  iActive;
+    static QAtomicInt           iBlockCount;
+    static bool                 iBypassed;      ///< Allocate each object from the heap, for comparison
+
+    friend class ::SyncMLMessageParserTest;
+
+};
+
+}
+
+/*! \brief Declares operators new and delete that allocate objects of the
+ *         class from the active FragmentArena
+ *
+ * Placement new is declared as well, as class specific operator new would
+ * otherwise hide it from containers.
+ */
+#define FRAGMENT_ARENA_ALLOCATED \
+    static void* operator new( std::size_t aSize ) { return DataSync::FragmentArena::allocate( aSize ); } \
+    static void* operator new( std::size_t, void* aPtr ) { return aPtr; } \
+    static void operator delete( void* aPtr ) { DataSync::FragmentArena::release( aPtr ); } \
+    static void operator delete( void*, void* ) { }
+
+#endif // FRAGMENTARENA_H
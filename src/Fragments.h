@@ -34,7 +34,11 @@
 #ifndef FRAGMENTS_H
 #define FRAGMENTS_H
 
+#include <QStringList>
+
 #include "RemoteDeviceInfo.h"
+#include "FragmentArena.h"
+#include "ByteSlice.h"
 #include "datatypes.h"
 
 // @todo: StatusParams.nextAnchor
@@ -76,16 +80,22 @@ struct ItemParams
     QString         sourceParent;
     QString         targetParent;
     MetaParams      meta;
-    QString         data;
+    ByteSlice       data;       ///< Embedded XML refers to the received message
     bool            moreData;
 
     ItemParams() : moreData(false) {}
+
+    FRAGMENT_ARENA_ALLOCATED
 };
 
 struct DevInfItemParams
 {
     QString             source;
     RemoteDeviceInfo    devInfo;
+    QByteArray          hash;       ///< Hash of the DevInf element, empty if not available
+    bool                cached;     ///< DevInf matched the known hash and was not parsed
+
+    DevInfItemParams() : cached( false ) {}
 };
 
 struct CredParams
@@ -99,6 +109,8 @@ struct MapItemParams
 {
     QString         target;
     QString         source;
+
+    FRAGMENT_ARENA_ALLOCATED
 };
 
 struct ChalParams
@@ -131,6 +143,9 @@ struct Fragment {
 
     virtual ~Fragment() { }
 
+    // Fragments and their commands are allocated in blocks per message
+    FRAGMENT_ARENA_ALLOCATED
+
 };
 
 struct HeaderParams : public Fragment
@@ -162,9 +177,35 @@ struct StatusParams : public Fragment
     ChalParams          chal;
     QString             nextAnchor;
     QList<ItemParams>   items;
+    bool                compactRefs;    ///< Write references of items as TargetRef and SourceRef elements
 
     StatusParams() : Fragment( FRAGMENT_STATUS ), cmdId(-1), msgRef(-1),
-                     cmdRef(-1), data(SERVER_FAILURE), hasChal( false ) {}
+                     cmdRef(-1), data(SERVER_FAILURE), hasChal( false ),
+                     compactRefs( false ) {}
+
+    /*! \brief Sets the references of the status from parsed TargetRef and
+     *         SourceRef elements
+     *
+     * A status that refers to several items lists its references in items.
+     *
+     * @param aTargetRefs Values of TargetRef elements in order
+     * @param aSourceRefs Values of SourceRef elements in order
+     */
+    void setRefs( const QStringList& aTargetRefs, const QStringList& aSourceRefs )
+    {
+        if( aTargetRefs.count() <= 1 && aSourceRefs.count() <= 1 ) {
+            targetRef = aTargetRefs.value( 0 );
+            sourceRef = aSourceRefs.value( 0 );
+            return;
+        }
+
+        for( int i = 0; i < qMax( aTargetRefs.count(), aSourceRefs.count() ); ++i ) {
+            ItemParams item;
+            item.target = aTargetRefs.value( i );
+            item.source = aSourceRefs.value( i );
+            items.append( item );
+        }
+    }
 };
 
 struct PutParams : public Fragment
@@ -0,0 +1,136 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "ItemReferenceIndex.h"
+
+#include <QMap>
+
+using namespace DataSync;
+
+ItemReferenceIndex::ItemReferenceIndex()
+ : iCount( 0 )
+{
+}
+
+ItemReferenceIndex::~ItemReferenceIndex()
+{
+}
+
+void ItemReferenceIndex::insert( const ItemReference& aReference )
+{
+    QHash<SyncItemKey, ItemReference>& items = iCommands[CommandId( aReference.iMsgId, aReference.iCmdId )];
+
+    if( !items.contains( aReference.iKey ) ) {
+        ++iMessageCounts[aReference.iMsgId];
+        ++iCount;
+    }
+
+    items.insert( aReference.iKey, aReference );
+}
+
+bool ItemReferenceIndex::take( int aMsgId, int aCmdId, const SyncItemKey& aKey, ItemReference& aReference )
+{
+    QHash<CommandId, QHash<SyncItemKey, ItemReference> >::iterator command = iCommands.find( CommandId( aMsgId, aCmdId ) );
+
+    if( command == iCommands.end() ) {
+        return false;
+    }
+
+    QHash<SyncItemKey, ItemReference>::iterator item = command->find( aKey );
+
+    if( item == command->end() ) {
+        return false;
+    }
+
+    aReference = item.value();
+    command->erase( item );
+
+    if( command->isEmpty() ) {
+        iCommands.erase( command );
+    }
+
+    removed( aMsgId, 1 );
+
+    return true;
+}
+
+QList<ItemReference> ItemReferenceIndex::takeCommand( int aMsgId, int aCmdId )
+{
+    QHash<SyncItemKey, ItemReference> items = iCommands.take( CommandId( aMsgId, aCmdId ) );
+
+    QMap<int, ItemReference> ordered;
+    QHash<SyncItemKey, ItemReference>::const_iterator i;
+    for( i = items.constBegin(); i != items.constEnd(); ++i ) {
+        ordered.insert( i.value().iItemIndex, i.value() );
+    }
+
+    removed( aMsgId, items.count() );
+
+    return ordered.values();
+}
+
+int ItemReferenceIndex::count() const
+{
+    return iCount;
+}
+
+int ItemReferenceIndex::count( int aMsgId ) const
+{
+    return iMessageCounts.value( aMsgId, 0 );
+}
+
+void ItemReferenceIndex::clear()
+{
+    iCommands.clear();
+    iMessageCounts.clear();
+    iCount = 0;
+}
+
+void ItemReferenceIndex::removed( int aMsgId, int aCount )
+{
+    if( aCount == 0 ) {
+        return;
+    }
+
+    QHash<int, int>::iterator message = iMessageCounts.find( aMsgId );
+
+    if( message != iMessageCounts.end() ) {
+        message.value() -= aCount;
+
+        if( message.value() <= 0 ) {
+            iMessageCounts.erase( message );
+        }
+    }
+
+    iCount -= aCount;
+}
@@ -0,0 +1,141 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+#ifndef ITEMREFERENCEINDEX_H
+#define ITEMREFERENCEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+#include "SyncAgentConsts.h"
+#include "SyncItemKey.h"
+
+namespace DataSync
+{
+
+/*! \brief Structure to hold reference to an item
+ *
+ */
+struct ItemReference {
+    int iMsgId;                         /*!<Message ID related to the item*/
+    int iCmdId;                         /*!<Command ID related to the item*/
+    int iItemIndex;                     /*!<Index of the item in the command*/
+    SyncItemKey iKey;                   /*!<Key of the item*/
+    ModificationType iModificationType; /*!<Type of modification related to the item*/
+    QString iLocalDatabase;             /*!<Local database related to the item*/
+    QString iRemoteDatabase;            /*!<Remote database related to the item*/
+    QString iMimeType;                  /*!<MIME type of the item*/
+
+};
+
+/*! \brief Keeps track of items sent to remote side that are waiting for status
+ *
+ * References are indexed by message id, command id and item key, so that
+ * statuses can be matched to items in constant time regardless of how many
+ * items are outstanding. Number of outstanding items is also tracked per
+ * message.
+ */
+class ItemReferenceIndex
+{
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    ItemReferenceIndex();
+
+    /*! \brief Destructor
+     *
+     */
+    ~ItemReferenceIndex();
+
+    /*! \brief Adds a reference to an item
+     *
+     * A command is expected to refer to an item only once. If a reference
+     * with the same message id, command id and key exists, it is replaced.
+     *
+     * @param aReference Reference to add
+     */
+    void insert( const ItemReference& aReference );
+
+    /*! \brief Removes the reference to an item of a command
+     *
+     * @param aMsgId Message id of the item
+     * @param aCmdId Command id of the item
+     * @param aKey Key of the item
+     * @param aReference On success, the removed reference
+     * @return True if reference was found, otherwise false
+     */
+    bool take( int aMsgId, int aCmdId, const SyncItemKey& aKey, ItemReference& aReference );
+
+    /*! \brief Removes references to all items of a command
+     *
+     * @param aMsgId Message id of the command
+     * @param aCmdId Command id of the command
+     * @return Removed references, ordered by item index
+     */
+    QList<ItemReference> takeCommand( int aMsgId, int aCmdId );
+
+    /*! \brief Returns the number of outstanding references
+     *
+     * @return Number of references
+     */
+    int count() const;
+
+    /*! \brief Returns the number of outstanding references of a message
+     *
+     * @param aMsgId Message id
+     * @return Number of references
+     */
+    int count( int aMsgId ) const;
+
+    /*! \brief Removes all references
+     *
+     */
+    void clear();
+
+private:
+
+    typedef QPair<int, int> CommandId;
+
+    void removed( int aMsgId, int aCount );
+
+    QHash<CommandId, QHash<SyncItemKey, ItemReference> > iCommands;      ///< References by command and item key
+    QHash<int, int>                                         iMessageCounts; ///< Outstanding references by message
+    int                                                     iCount;         ///< Total number of references
+
+};
+
+}
+
+#endif // ITEMREFERENCEINDEX_H
@@ -0,0 +1,180 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "LocalChanges.h"
+
+using namespace DataSync;
+
+LocalChangeList::LocalChangeList()
+ : iBase( 0 )
+{
+}
+
+LocalChangeList::LocalChangeList( const QList<SyncItemKey>& aKeys )
+ : iBase( 0 )
+{
+    *this = aKeys;
+}
+
+LocalChangeList& LocalChangeList::operator=( const QList<SyncItemKey>& aKeys )
+{
+    clear();
+
+    iKeys = aKeys;
+    iIndex.reserve( aKeys.count() );
+
+    for( int i = 0; i < aKeys.count(); ++i ) {
+        iLive.append( true );
+        iIndex.insert( aKeys[i], i );
+    }
+
+    return *this;
+}
+
+void LocalChangeList::append( const SyncItemKey& aKey )
+{
+    iIndex.insert( aKey, iBase + iKeys.count() );
+    iKeys.append( aKey );
+    iLive.append( true );
+}
+
+bool LocalChangeList::contains( const SyncItemKey& aKey ) const
+{
+    return iIndex.contains( aKey );
+}
+
+bool LocalChangeList::removeOne( const SyncItemKey& aKey )
+{
+    QMultiHash<SyncItemKey, int>::iterator i = iIndex.find( aKey );
+
+    if( i == iIndex.end() ) {
+        return false;
+    }
+
+    // Same item may in theory have been listed several times, in which case
+    // the earliest one is removed like QList::removeOne() would do
+    QMultiHash<SyncItemKey, int>::iterator earliest = i;
+    for( ++i; i != iIndex.end() && i.key() == aKey; ++i ) {
+        if( i.value() < earliest.value() ) {
+            earliest = i;
+        }
+    }
+
+    iLive[earliest.value() - iBase] = false;
+    iIndex.erase( earliest );
+
+    trimFront();
+
+    // Compact once holes outnumber items, which keeps removals amortized
+    // constant time and the memory use bounded
+    if( iKeys.count() > 2 * iIndex.count() ) {
+        compact();
+    }
+
+    return true;
+}
+
+const SyncItemKey& LocalChangeList::first() const
+{
+    // Holes are never left at the front of the list
+    return iKeys.first();
+}
+
+void LocalChangeList::removeFirst()
+{
+    QMultiHash<SyncItemKey, int>::iterator i = iIndex.find( iKeys.first() );
+
+    while( i != iIndex.end() && i.value() != iBase ) {
+        ++i;
+    }
+
+    if( i != iIndex.end() ) {
+        iIndex.erase( i );
+    }
+
+    iKeys.removeFirst();
+    iLive.removeFirst();
+    ++iBase;
+
+    trimFront();
+}
+
+int LocalChangeList::count() const
+{
+    return iIndex.count();
+}
+
+int LocalChangeList::size() const
+{
+    return iIndex.count();
+}
+
+bool LocalChangeList::isEmpty() const
+{
+    return iIndex.isEmpty();
+}
+
+void LocalChangeList::clear()
+{
+    iKeys.clear();
+    iLive.clear();
+    iIndex.clear();
+    iBase = 0;
+}
+
+QList<SyncItemKey> LocalChangeList::toList( int aMaxCount ) const
+{
+    QList<SyncItemKey> keys;
+
+    for( int i = 0; i < iKeys.count() && ( aMaxCount < 0 || keys.count() < aMaxCount ); ++i ) {
+        if( iLive[i] ) {
+            keys.append( iKeys[i] );
+        }
+    }
+
+    return keys;
+}
+
+void LocalChangeList::trimFront()
+{
+    while( !iLive.isEmpty() && !iLive.first() ) {
+        iKeys.removeFirst();
+        iLive.removeFirst();
+        ++iBase;
+    }
+}
+
+void LocalChangeList::compact()
+{
+    *this = toList();
+}
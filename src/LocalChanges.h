@@ -34,15 +34,123 @@
 #define LOCALCHANGES_H
 
 #include <QList>
+#include <QMultiHash>
 #include "SyncItemKey.h"
 
 namespace DataSync {
 
+/*! \brief Ordered list of locally changed items
+ *
+ * Keeps the items in the order they were discovered in, which is also the
+ * order they are sent to the remote side in. Next to the ordered list, a hash
+ * index is maintained so that checking whether an item has been changed and
+ * removing an item from the middle of the list run in constant time.
+ * Removed items are left as holes in the list and compacted away lazily.
+ */
+class LocalChangeList
+{
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    LocalChangeList();
+
+    /*! \brief Constructor
+     *
+     * @param aKeys Keys of the changed items, in send order
+     */
+    LocalChangeList( const QList<SyncItemKey>& aKeys );
+
+    /*! \brief Replaces the contents of the list
+     *
+     * @param aKeys Keys of the changed items, in send order
+     * @return Reference to this list
+     */
+    LocalChangeList& operator=( const QList<SyncItemKey>& aKeys );
+
+    /*! \brief Appends an item to the end of the list
+     *
+     * @param aKey Key of the item
+     */
+    void append( const SyncItemKey& aKey );
+
+    /*! \brief Checks if the list contains an item
+     *
+     * @param aKey Key of the item
+     * @return True if item is in the list, otherwise false
+     */
+    bool contains( const SyncItemKey& aKey ) const;
+
+    /*! \brief Removes the first occurrence of an item from the list
+     *
+     * @param aKey Key of the item
+     * @return True if item was removed, otherwise false
+     */
+    bool removeOne( const SyncItemKey& aKey );
+
+    /*! \brief Returns the first item of the list
+     *
+     * The list must not be empty.
+     *
+     * @return Key of the first item
+     */
+    const SyncItemKey& first() const;
+
+    /*! \brief Removes the first item of the list
+     *
+     * The list must not be empty.
+     */
+    void removeFirst();
+
+    /*! \brief Returns the number of items in the list
+     *
+     * @return Number of items
+     */
+    int count() const;
+
+    /*! \brief Returns the number of items in the list
+     *
+     * @return Number of items
+     */
+    int size() const;
+
+    /*! \brief Checks if the list is empty
+     *
+     * @return True if list is empty, otherwise false
+     */
+    bool isEmpty() const;
+
+    /*! \brief Removes all items from the list
+     *
+     */
+    void clear();
+
+    /*! \brief Returns the items of the list in order
+     *
+     * @param aMaxCount Maximum number of items to return, -1 for all
+     * @return Keys of the items
+     */
+    QList<SyncItemKey> toList( int aMaxCount = -1 ) const;
+
+private:
+
+    void trimFront();
+
+    void compact();
+
+    QList<SyncItemKey>          iKeys;      ///< Items in order, removed ones as holes
+    QList<bool>                 iLive;      ///< Whether the entry in iKeys is still in the list
+    QMultiHash<SyncItemKey, int> iIndex;    ///< Item keys to sequence numbers
+    int                         iBase;      ///< Sequence number of the first entry in iKeys
+
+};
+
 struct LocalChanges
 {
-    QList<SyncItemKey> added;
-    QList<SyncItemKey> modified;
-    QList<SyncItemKey> removed;
+    LocalChangeList added;
+    LocalChangeList modified;
+    LocalChangeList removed;
 };
 
 }
@@ -44,11 +44,22 @@
 #include "SyncMLReplace.h"
 #include "SyncMLDelete.h"
 #include "SyncMLItem.h"
+#include "MessageSizer.h"
 #include "SyncAgentConsts.h"
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
+namespace {
+
+// Maximum number of attempts to size a large object chunk to fit a message
+const int MAX_PACKING_ATTEMPTS = 4;
+
+// Command id used for prepared commands until they are written
+const int PREPARED_CMDID = 1;
+
+}
+
 
 
 LocalChangesPackage::LocalChangesPackage( const SyncTarget& aSyncTarget,
@@ -61,7 +72,10 @@ LocalChangesPackage::LocalChangesPackage( const SyncTarget& aSyncTarget,
     iLocalChanges( aLocalChanges ),
     iRole( aRole ),
     iMaxChangesPerMessage(aMaxChangesPerMessage),
-    iPrefetcher( aLocalChanges.added + aLocalChanges.modified,
+    iExactPacking( false ),
+    iMultiItemCommands( false ),
+    iWrittenItem( 0 ),
+    iPrefetcher( aLocalChanges.added.toList() + aLocalChanges.modified.toList(),
                  *aSyncTarget.getPlugin(),
                  aMaxChangesPerMessage )
 {
@@ -79,6 +93,36 @@ LocalChangesPackage::~LocalChangesPackage()
 
     delete iLargeObjectState.iItem;
     iLargeObjectState.iItem = 0;
+
+    delete iWrittenItem;
+    iWrittenItem = 0;
+
+    foreach( const PreparedCommand& prepared, iPreparedCommands ) {
+        delete prepared.iItem;
+        delete prepared.iObject;
+    }
+    iPreparedCommands.clear();
+}
+
+bool LocalChangesPackage::setExactPacking( bool aExact )
+{
+    iExactPacking = aExact;
+    return true;
+}
+
+void LocalChangesPackage::setMultiItemCommands( bool aEnabled )
+{
+    iMultiItemCommands = aEnabled;
+}
+
+void LocalChangesPackage::setPrefetching( bool aBackground, qint64 aMemoryBudget )
+{
+    iPrefetcher.setMemoryBudget( aMemoryBudget );
+
+    if( aBackground )
+    {
+        iPrefetcher.startBackgroundFetching();
+    }
 }
 
 bool LocalChangesPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion )
@@ -88,13 +132,28 @@ bool LocalChangesPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, b
 
     int remainingBytes = aSizeThreshold;
 
+    // Commands of the previous message cannot be extended
+    iCommandGroup = CommandGroup();
+
     SyncMLSync* sync = new SyncMLSync( aMessage.getNextCmdId(),
                                        iSyncTarget.getTargetDatabase(),
                                        iSyncTarget.getSourceDatabase() );
 
 
     sync->addNumberOfChanges( iNumberOfChanges );
-    remainingBytes -= sync->calculateSize(aWBXML, aVersion);
+
+    int syncSize = -1;
+
+    if( iExactPacking ) {
+        MessageSizer sizer( aWBXML, aVersion );
+        syncSize = sizer.appendSize( aMessage.getBody(), *sync );
+    }
+
+    if( syncSize < 0 ) {
+        syncSize = sync->calculateSize(aWBXML, aVersion);
+    }
+
+    remainingBytes -= syncSize;
 
     int itemsThatCanBeSent = iMaxChangesPerMessage;
 
@@ -120,11 +179,102 @@ bool LocalChangesPackage::write( SyncMLMessage& aMessage, int& aSizeThreshold, b
         iPrefetcher.setBatchSizeHint( iMaxChangesPerMessage - itemsThatCanBeSent );
         QTimer::singleShot( 0, &iPrefetcher, SLOT(prefetch()) );
     }
+    else
+    {
+        PrefetchStatistics statistics = iPrefetcher.statistics();
+        qCDebug(lcSyncML) << "Prefetch hits:" << statistics.iHits << "stalls:" << statistics.iStalls
+                          << "stall time:" << statistics.iStallTime << "ms";
+        emit prefetchStatistics( iSyncTarget.getSourceDatabase(), statistics.iHits,
+                                 statistics.iStalls, statistics.iStallTime );
+    }
 
     return allWritten;
 
 }
 
+void LocalChangesPackage::prepare( int aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    discardPreparedCommands();
+
+    // Chunks of a large object depend on the space left in the actual
+    // message, and items are grouped to commands as they are written
+    if( iLargeObjectState.iItem || iMultiItemCommands ) {
+        return;
+    }
+
+    MessageSizer sizer( aWBXML, aVersion );
+
+    SyncMLSync sync( PREPARED_CMDID, iSyncTarget.getTargetDatabase(), iSyncTarget.getSourceDatabase() );
+    sync.addNumberOfChanges( iNumberOfChanges );
+
+    int remainingBytes = aSizeThreshold - sync.calculateSize( aWBXML, aVersion );
+    QList<SyncItemKey> keys = iLocalChanges.added.toList( iMaxChangesPerMessage );
+    int addedCount = keys.count();
+    if( addedCount < iMaxChangesPerMessage ) {
+        keys += iLocalChanges.modified.toList( iMaxChangesPerMessage - addedCount );
+    }
+    int changeCount = keys.count();
+
+    // Only added and modified items are worth preparing, as they require
+    // retrieving and encoding item data. Items are prepared in the order
+    // write() processes them in, with the command id left to be filled in
+    for( int i = 0; i < changeCount && i < iMaxChangesPerMessage && remainingBytes > 0; ++i )
+    {
+        PreparedCommand prepared;
+        prepared.iKey = keys[i];
+        prepared.iCommand = ( i < addedCount ) ? SYNCML_ADD : SYNCML_REPLACE;
+
+        const SyncItem* item = iPrefetcher.peekItem( prepared.iKey );
+
+        // Leave failures to be reported when the item is written. Large
+        // objects may need to be split, which is decided at write time
+        if( !item || item->getSize() > iLargeObjectThreshold ) {
+            break;
+        }
+
+        prepared.iObject = newCommand( prepared.iCommand, PREPARED_CMDID );
+        processItem( prepared.iKey, *prepared.iObject, remainingBytes, prepared.iCommand, prepared.iMimeType );
+        prepared.iItem = iWrittenItem;
+        iWrittenItem = 0;
+
+        // Encode the contents of the command now, while waiting for the
+        // response. They are written as encoded here when the command is
+        // sent, and only the command itself is encoded again once its CmdID
+        // is known. Only the native encoders write kept encodings, which for
+        // WbXML is the case with exact packing
+        if( !aWBXML || iExactPacking ) {
+            const QList<SyncMLCmdObject*>& children = prepared.iObject->getChildren();
+
+            for( int c = 0; c < children.count(); ++c ) {
+                sizer.elementSize( *children[c] );
+            }
+        }
+
+        prepared.iSize = iExactPacking ? sizer.elementSize( *prepared.iObject ) : -1;
+        prepared.iExactSize = ( prepared.iSize >= 0 );
+
+        if( !prepared.iExactSize ) {
+            prepared.iSize = prepared.iObject->calculateSize( aWBXML, aVersion );
+        }
+
+        prepared.iWBXML = aWBXML;
+        prepared.iVersion = aVersion;
+
+        if( prepared.iSize > remainingBytes ) {
+            iPrefetcher.returnItem( prepared.iKey, prepared.iItem );
+            delete prepared.iObject;
+            break;
+        }
+
+        remainingBytes -= prepared.iSize;
+        iPreparedCommands.append( prepared );
+    }
+
+    qCDebug(lcSyncML) << "Prepared" << iPreparedCommands.count() << "commands for the next message";
+}
+
 bool LocalChangesPackage::processAddedItems( SyncMLMessage& aMessage,
                                              SyncMLSync& aSyncElement,
                                              int& aSizeThreshold ,
@@ -142,18 +292,26 @@ bool LocalChangesPackage::processAddedItems( SyncMLMessage& aMessage,
     {
 
         int cmdId = aMessage.getNextCmdId();
-        SyncMLAdd* add = new SyncMLAdd(cmdId);
         SyncItemKey key = iLocalChanges.added.first();
 
         QString mimeType;
-        bool processed = processItem( key, *add, remainingBytes, SYNCML_ADD, mimeType );
+        bool processed = false;
 
-        remainingBytes -= add->calculateSize(aWBXML, aVersion);
-        aSyncElement.addChild( add );
+        // First command of an otherwise empty message is always written
+        bool force = aMessage.getBody().getChildren().isEmpty() &&
+                     aItemsThatCanBeSent == iMaxChangesPerMessage;
+
+        int itemIndex = 0;
+
+        if( !writeCommand( aMessage, aSyncElement, SYNCML_ADD, cmdId, itemIndex, key, remainingBytes,
+                           force, aWBXML, aVersion, mimeType, processed ) )
+        {
+            break;
+        }
 
         if (processed)
         {
-            emit newItemWritten( aMessage.getMsgId(), cmdId, key, MOD_ITEM_ADDED,
+            emit newItemWritten( aMessage.getMsgId(), cmdId, itemIndex, key, MOD_ITEM_ADDED,
                                  iSyncTarget.getSourceDatabase(), iSyncTarget.getTargetDatabase(),
                                  mimeType );
             aItemsThatCanBeSent--;
@@ -196,18 +354,26 @@ bool LocalChangesPackage::processModifiedItems( SyncMLMessage& aMessage,
            remainingBytes > 0 )
     {
         int cmdId = aMessage.getNextCmdId();
-        SyncMLReplace* replace = new SyncMLReplace( cmdId );
         SyncItemKey key = iLocalChanges.modified.first();
 
         QString mimeType;
-        bool processed = processItem( key, *replace, remainingBytes, SYNCML_REPLACE, mimeType );
+        bool processed = false;
+
+        // First command of an otherwise empty message is always written
+        bool force = aMessage.getBody().getChildren().isEmpty() &&
+                     aItemsThatCanBeSent == iMaxChangesPerMessage;
+
+        int itemIndex = 0;
 
-        remainingBytes -= replace->calculateSize(aWBXML, aVersion);
-        aSyncElement.addChild( replace );
+        if( !writeCommand( aMessage, aSyncElement, SYNCML_REPLACE, cmdId, itemIndex, key, remainingBytes,
+                           force, aWBXML, aVersion, mimeType, processed ) )
+        {
+            break;
+        }
 
         if (processed)
         {
-            emit newItemWritten( aMessage.getMsgId(), cmdId, key, MOD_ITEM_MODIFIED,
+            emit newItemWritten( aMessage.getMsgId(), cmdId, itemIndex, key, MOD_ITEM_MODIFIED,
                                  iSyncTarget.getSourceDatabase(), iSyncTarget.getTargetDatabase(),
                                  mimeType );
             aItemsThatCanBeSent--;
@@ -249,20 +415,28 @@ bool LocalChangesPackage::processRemovedItems( SyncMLMessage& aMessage,
            remainingBytes > 0 )
     {
         int cmdId = aMessage.getNextCmdId();
-        SyncMLDelete* del = new SyncMLDelete(cmdId);
         SyncItemKey key = iLocalChanges.removed.first();
 
         // @todo: we cannot know the mime type in the case of deleted items. In overall it's bad
         // that we're using mimetype here, we should be able to handle identification of used
         // storage purely on the db uri's.
         QString mimeType;
-        bool processed = processItem( key, *del, remainingBytes, SYNCML_DELETE, mimeType );
+        bool processed = false;
 
-        remainingBytes -= del->calculateSize(aWBXML, aVersion);
-        aSyncElement.addChild( del );
+        // First command of an otherwise empty message is always written
+        bool force = aMessage.getBody().getChildren().isEmpty() &&
+                     aItemsThatCanBeSent == iMaxChangesPerMessage;
+
+        int itemIndex = 0;
+
+        if( !writeCommand( aMessage, aSyncElement, SYNCML_DELETE, cmdId, itemIndex, key, remainingBytes,
+                           force, aWBXML, aVersion, mimeType, processed ) )
+        {
+            break;
+        }
 
         if (processed) {
-            emit newItemWritten( aMessage.getMsgId(), cmdId, key, MOD_ITEM_DELETED,
+            emit newItemWritten( aMessage.getMsgId(), cmdId, itemIndex, key, MOD_ITEM_DELETED,
                                  iSyncTarget.getSourceDatabase(), iSyncTarget.getTargetDatabase(), mimeType );
             aItemsThatCanBeSent--;
             iLocalChanges.removed.removeFirst();
@@ -286,6 +460,318 @@ bool LocalChangesPackage::processRemovedItems( SyncMLMessage& aMessage,
     return processed;
 }
 
+bool LocalChangesPackage::writeCommand( SyncMLMessage& aMessage,
+                                        SyncMLSync& aSyncElement,
+                                        SyncMLCommand aCommand,
+                                        int& aCmdId,
+                                        int& aItemIndex,
+                                        const SyncItemKey& aItemKey,
+                                        int& aSizeThreshold,
+                                        bool aForce,
+                                        bool aWBXML,
+                                        const ProtocolVersion& aVersion,
+                                        QString& aMimeType,
+                                        bool& aProcessed )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    aItemIndex = 0;
+
+    if( !iMultiItemCommands || aCommand == SYNCML_DELETE )
+    {
+        return writeSingleCommand( aMessage, aSyncElement, aCommand, aCmdId, aItemKey, aSizeThreshold,
+                                   aForce, aWBXML, aVersion, aMimeType, aProcessed );
+    }
+
+    // Only items that are written whole can share a command. Type and
+    // version of the item decide whether it can share the previous one
+    QString type;
+    QString version;
+    bool groupable = false;
+
+    if( !iLargeObjectState.iItem )
+    {
+        const SyncItem* item = iPrefetcher.peekItem( aItemKey );
+
+        if( item )
+        {
+            type = item->getType();
+            version = item->getVersion();
+            groupable = ( item->getSize() <= iLargeObjectThreshold );
+        }
+    }
+
+    if( groupable && iCommandGroup.iObject && iCommandGroup.iCommand == aCommand &&
+        iCommandGroup.iMimeType == type && iCommandGroup.iVersion == version )
+    {
+        aMessage.releaseCmdId( aCmdId );
+
+        if( !appendToGroup( aItemKey, aSizeThreshold, aWBXML, aVersion, aMimeType ) )
+        {
+            return false;
+        }
+
+        aCmdId = iCommandGroup.iCmdId;
+        aItemIndex = iCommandGroup.iItemCount++;
+        aProcessed = true;
+        return true;
+    }
+
+    iCommandGroup = CommandGroup();
+
+    if( !writeSingleCommand( aMessage, aSyncElement, aCommand, aCmdId, aItemKey, aSizeThreshold,
+                             aForce, aWBXML, aVersion, aMimeType, aProcessed ) )
+    {
+        return false;
+    }
+
+    if( groupable && aProcessed )
+    {
+        // Following items of the same kind are added to this command
+        iCommandGroup.iObject = static_cast<SyncMLLocalChange*>( aSyncElement.getChildren().last() );
+        iCommandGroup.iCommand = aCommand;
+        iCommandGroup.iCmdId = aCmdId;
+        iCommandGroup.iMimeType = type;
+        iCommandGroup.iVersion = version;
+        iCommandGroup.iItemCount = 1;
+    }
+
+    return true;
+}
+
+bool LocalChangesPackage::appendToGroup( const SyncItemKey& aItemKey,
+                                         int& aSizeThreshold,
+                                         bool aWBXML,
+                                         const ProtocolVersion& aVersion,
+                                         QString& aMimeType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    SyncMLItem* itemObject = new SyncMLItem();
+    buildItem( aItemKey, 0, *itemObject, aSizeThreshold, iCommandGroup.iCommand, aMimeType );
+
+    int size = -1;
+
+    if( iExactPacking )
+    {
+        MessageSizer sizer( aWBXML, aVersion );
+        size = sizer.appendSize( *iCommandGroup.iObject, *itemObject );
+    }
+
+    if( size < 0 )
+    {
+        size = itemObject->calculateSize( aWBXML, aVersion );
+    }
+
+    if( iExactPacking && size > aSizeThreshold )
+    {
+        rollbackItem( aItemKey, LargeObjectState() );
+        delete itemObject;
+        return false;
+    }
+
+    commitItem();
+
+    aSizeThreshold -= size;
+    iCommandGroup.iObject->addChild( itemObject );
+
+    return true;
+}
+
+bool LocalChangesPackage::writeSingleCommand( SyncMLMessage& aMessage,
+                                              SyncMLSync& aSyncElement,
+                                              SyncMLCommand aCommand,
+                                              int aCmdId,
+                                              const SyncItemKey& aItemKey,
+                                              int& aSizeThreshold,
+                                              bool aForce,
+                                              bool aWBXML,
+                                              const ProtocolVersion& aVersion,
+                                              QString& aMimeType,
+                                              bool& aProcessed )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( writePreparedCommand( aSyncElement, aCommand, aCmdId, aItemKey, aSizeThreshold,
+                              aForce, aWBXML, aVersion, aMimeType ) )
+    {
+        aProcessed = true;
+        return true;
+    }
+
+    if( !iExactPacking )
+    {
+        SyncMLLocalChange* command = newCommand( aCommand, aCmdId );
+        aProcessed = processItem( aItemKey, *command, aSizeThreshold, aCommand, aMimeType );
+        commitItem();
+
+        aSizeThreshold -= command->calculateSize( aWBXML, aVersion );
+        aSyncElement.addChild( command );
+        return true;
+    }
+
+    MessageSizer sizer( aWBXML, aVersion );
+    int dataThreshold = aSizeThreshold;
+
+    for( int attempt = 1; ; ++attempt )
+    {
+        // Checkpoint: the command is built, measured and then either added
+        // to the message or rolled back as if it had never been written
+        LargeObjectState checkpoint = iLargeObjectState;
+
+        SyncMLLocalChange* command = newCommand( aCommand, aCmdId );
+        aProcessed = processItem( aItemKey, *command, dataThreshold, aCommand, aMimeType );
+
+        int size = sizer.elementSize( *command );
+
+        if( size < 0 )
+        {
+            // Command cannot be measured exactly, settle for the estimate
+            size = command->calculateSize( aWBXML, aVersion );
+        }
+
+        // A smaller chunk of a large object may still fit
+        bool chunkable = checkpoint.iItem || iLargeObjectState.iItem ||
+                         ( iWrittenItem && iWrittenItem->getSize() > iLargeObjectThreshold );
+        int nextDataThreshold = dataThreshold - ( size - aSizeThreshold );
+        bool retry = chunkable && nextDataThreshold > 0 && attempt < MAX_PACKING_ATTEMPTS;
+
+        if( size <= aSizeThreshold || ( aForce && !retry ) )
+        {
+            commitItem();
+
+            aSizeThreshold -= size;
+            aSyncElement.addChild( command );
+            return true;
+        }
+
+        rollbackItem( aItemKey, checkpoint );
+        delete command;
+
+        if( !retry )
+        {
+            break;
+        }
+
+        qCDebug(lcSyncML) << "Command exceeded message size by" << size - aSizeThreshold
+                          << "bytes, retrying with chunk of" << nextDataThreshold << "bytes";
+        dataThreshold = nextDataThreshold;
+    }
+
+    aMessage.releaseCmdId( aCmdId );
+
+    return false;
+}
+
+bool LocalChangesPackage::writePreparedCommand( SyncMLSync& aSyncElement,
+                                                SyncMLCommand aCommand,
+                                                int aCmdId,
+                                                const SyncItemKey& aItemKey,
+                                                int& aSizeThreshold,
+                                                bool aForce,
+                                                bool aWBXML,
+                                                const ProtocolVersion& aVersion,
+                                                QString& aMimeType )
+{
+    if( iPreparedCommands.isEmpty() )
+    {
+        return false;
+    }
+
+    const PreparedCommand& prepared = iPreparedCommands.first();
+
+    if( prepared.iKey != aItemKey || prepared.iCommand != aCommand ||
+        prepared.iWBXML != aWBXML || prepared.iVersion != aVersion ||
+        ( iExactPacking && !prepared.iExactSize ) )
+    {
+        // Next message is not what was prepared for
+        qCDebug(lcSyncML) << "Discarding prepared commands";
+        discardPreparedCommands();
+        return false;
+    }
+
+    prepared.iObject->setCmdId( aCmdId );
+
+    int size = 0;
+
+    if( iExactPacking )
+    {
+        // Only the value of CmdID has changed since the command was measured
+        size = prepared.iSize + QString::number( aCmdId ).length() -
+               QString::number( PREPARED_CMDID ).length();
+
+        if( size > aSizeThreshold && !aForce )
+        {
+            discardPreparedCommands();
+            return false;
+        }
+    }
+    else
+    {
+        size = prepared.iObject->calculateSize( aWBXML, aVersion );
+    }
+
+    aMimeType = prepared.iMimeType;
+    aSizeThreshold -= size;
+    aSyncElement.addChild( prepared.iObject );
+    delete prepared.iItem;
+
+    iPreparedCommands.removeFirst();
+
+    return true;
+}
+
+void LocalChangesPackage::discardPreparedCommands()
+{
+    // Items go back to the prefetcher to be written as if they had never
+    // been prepared
+    foreach( const PreparedCommand& prepared, iPreparedCommands ) {
+        if( prepared.iItem ) {
+            iPrefetcher.returnItem( prepared.iKey, prepared.iItem );
+        }
+        delete prepared.iObject;
+    }
+
+    iPreparedCommands.clear();
+}
+
+SyncMLLocalChange* LocalChangesPackage::newCommand( SyncMLCommand aCommand, int aCmdId ) const
+{
+    if( aCommand == SYNCML_ADD ) {
+        return new SyncMLAdd( aCmdId );
+    }
+    else if( aCommand == SYNCML_REPLACE ) {
+        return new SyncMLReplace( aCmdId );
+    }
+    else {
+        return new SyncMLDelete( aCmdId );
+    }
+}
+
+void LocalChangesPackage::commitItem()
+{
+    delete iWrittenItem;
+    iWrittenItem = 0;
+}
+
+void LocalChangesPackage::rollbackItem( const SyncItemKey& aItemKey, const LargeObjectState& aCheckpoint )
+{
+    if( !aCheckpoint.iItem )
+    {
+        // Item was retrieved for the rolled back command, give it back so
+        // that it is written in the next message
+        SyncItem* item = iWrittenItem ? iWrittenItem : iLargeObjectState.iItem;
+
+        if( item )
+        {
+            iPrefetcher.returnItem( aItemKey, item );
+        }
+    }
+
+    iWrittenItem = 0;
+    iLargeObjectState = aCheckpoint;
+}
+
 bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                                        SyncMLLocalChange& aParent,
                                        int aSizeThreshold,
@@ -294,13 +780,27 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    bool processed = false;
-
     SyncMLItem* itemObject = new SyncMLItem();
+    bool processed = buildItem( aItemKey, &aParent, *itemObject, aSizeThreshold, aCommand, aMimeType );
+    aParent.addChild( itemObject );
+
+    return processed;
+}
+
+bool LocalChangesPackage::buildItem( const SyncItemKey& aItemKey,
+                                     SyncMLLocalChange* aParent,
+                                     SyncMLItem& aItemObject,
+                                     int aSizeThreshold,
+                                     SyncMLCommand aCommand,
+                                     QString& aMimeType )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    bool processed = false;
 
     if( aCommand == SYNCML_ADD ) {
 
-        itemObject->insertSource( aItemKey );
+        aItemObject.insertSource( aItemKey );
 
     }
     else {
@@ -309,14 +809,14 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
             SyncItemKey remoteKey = iSyncTarget.mapToRemoteUID( aItemKey );
 
             if( !remoteKey.isEmpty() ) {
-                itemObject->insertTarget( remoteKey );
+                aItemObject.insertTarget( remoteKey );
             }
             else {
                 qCWarning(lcSyncML) << "Could not find mapping to for local uid: " << aItemKey;
             }
         }
         else {
-            itemObject->insertSource( aItemKey );
+            aItemObject.insertSource( aItemKey );
         }
 
     }
@@ -346,13 +846,17 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
 
             aMimeType = item->getType();
 
-            aParent.addMimeMetadata( item->getType() );
             qint64 size = item->getSize();
 
-            QString version = item->getVersion();
+            // Metadata of items in a multi-item command is in the command
+            if( aParent ) {
+                aParent->addMimeMetadata( item->getType() );
 
-            if ( !version.isEmpty()) {
-                aParent.addVersionMetadata(version);
+                QString version = item->getVersion();
+
+                if ( !version.isEmpty()) {
+                    aParent->addVersionMetadata(version);
+                }
             }
 
             if( !item->getParentKey()->isEmpty() )
@@ -365,16 +869,16 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
 
                     if( !remoteKey.isEmpty() )
                     {
-                        itemObject->insertTargetParent( remoteKey );
+                        aItemObject.insertTargetParent( remoteKey );
                     }
                     else
                     {
-                        itemObject->insertSourceParent( *parentKey );
+                        aItemObject.insertSourceParent( *parentKey );
                     }
                 }
                 else if( iRole == ROLE_CLIENT )
                 {
-                    itemObject->insertSourceParent( *parentKey );
+                    aItemObject.insertSourceParent( *parentKey );
                 }
                 // no else
 
@@ -397,8 +901,8 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                         // consecutive package of a single message should
                         // not have size in header
                         //aParent.addSizeMetadata( size );
-                        itemObject->insertData( data );
-                        itemObject->insertMoreData();
+                        aItemObject.insertData( data );
+                        aItemObject.insertMoreData();
                         iLargeObjectState.iOffset += aSizeThreshold;
                     }
                     else
@@ -406,13 +910,13 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                         qCDebug(lcSyncML) << "Writing last chunk of" << dataLeft << "bytes";
                         // This is the last chunk
                         item->read( iLargeObjectState.iOffset, dataLeft, data );
-                        itemObject->insertData( data );
+                        aItemObject.insertData( data );
 
                         iLargeObjectState.iItem = 0;
                         iLargeObjectState.iSize = 0;
                         iLargeObjectState.iOffset = 0;
 
-                        delete item;
+                        iWrittenItem = item;
                         item = 0;
                         processed = true;
                     }
@@ -421,9 +925,9 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                     qCDebug(lcSyncML) << "Writing item" << aItemKey << "as normal object, size:" << size;
                     QByteArray data;
                     item->read( 0, size, data );
-                    itemObject->insertData( data );
+                    aItemObject.insertData( data );
 
-                    delete item;
+                    iWrittenItem = item;
                     item = 0;
                     processed = true;
 
@@ -441,9 +945,11 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                     // Need to send more chunks after this one
                     QByteArray data;
                     item->read( iLargeObjectState.iOffset, aSizeThreshold, data );
-                    aParent.addSizeMetadata( size );
-                    itemObject->insertData( data );
-                    itemObject->insertMoreData();
+                    if( aParent ) {
+                        aParent->addSizeMetadata( size );
+                    }
+                    aItemObject.insertData( data );
+                    aItemObject.insertMoreData();
                     iLargeObjectState.iOffset += aSizeThreshold;
                 }
 
@@ -453,9 +959,9 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
                 qCDebug(lcSyncML) << "Writing item" << aItemKey << "as normal object, size:" << size;
                 QByteArray data;
                 item->read( 0, size, data );
-                itemObject->insertData( data );
+                aItemObject.insertData( data );
 
-                delete item;
+                iWrittenItem = item;
                 item = 0;
                 processed = true;
             }
@@ -468,7 +974,5 @@ bool LocalChangesPackage::processItem( const SyncItemKey& aItemKey,
         }
     }
 
-    aParent.addChild( itemObject );
-
     return processed;
 }
@@ -48,6 +48,7 @@ namespace DataSync {
 
 class SyncMLSync;
 class SyncMLLocalChange;
+class SyncMLItem;
 class SyncTarget;
 class SyncItem;
 
@@ -83,6 +84,30 @@ public:
 
     virtual bool write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion );
 
+    virtual bool setExactPacking( bool aExact );
+
+    virtual void prepare( int aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion );
+
+    /*! \brief Sets whether consecutive items can share a command
+     *
+     * When enabled, consecutive added or modified items of the same type
+     * and version are written as items of a single Add or Replace command,
+     * which carries their metadata only once. Large objects are always
+     * written in commands of their own.
+     *
+     * @param aEnabled True to enable multi-item commands, false to disable
+     */
+    void setMultiItemCommands( bool aEnabled );
+
+    /*! \brief Sets how items are prefetched from the storage
+     *
+     * @param aBackground True to fetch items in a background thread. Items are
+     *                    fetched in the background only if the storage plugin
+     *                    inherits ConcurrentFetchStoragePlugin
+     * @param aMemoryBudget Maximum number of bytes of items fetched in advance, 0 for no limit
+     */
+    void setPrefetching( bool aBackground, qint64 aMemoryBudget );
+
 signals:
 
     /*! \brief Signal that has been emitted when item has been added to an outgoing message
@@ -91,17 +116,27 @@ signals:
      *
      * @param aMsgId Message Id of the message where the item was written
      * @param aCmdId Command Id of the command where the item was written
+     * @param aItemIndex Index of the item in the command where it was written
      * @param aKey Key of the written item
      * @param aModificationType Type of modification to the item
      * @param aLocalDatabase Local database where item exists
      * @param aRemoteDatabase Remote database to which item is being sent
      * @param aMimeType Mime type of the item
      */
-    void newItemWritten( int aMsgId, int aCmdId, SyncItemKey aKey,
+    void newItemWritten( int aMsgId, int aCmdId, int aItemIndex, SyncItemKey aKey,
                          ModificationType aModificationType,
                          QString aLocalDatabase, QString aRemoteDatabase,
                          QString aMimeType );
 
+    /*! \brief Signal that is emitted when all local changes have been written
+     *
+     * @param aLocalDatabase Local database whose changes were written
+     * @param aHits Number of items that had been prefetched when needed
+     * @param aStalls Number of items that had to be waited for
+     * @param aStallTime Total time spent waiting for items, in milliseconds
+     */
+    void prefetchStatistics( QString aLocalDatabase, int aHits, int aStalls, qint64 aStallTime );
+
 protected:
 
 private:
@@ -114,6 +149,33 @@ private:
         LargeObjectState() : iItem( 0 ), iSize(0), iOffset(0) {}
     };
 
+    // Command built by prepare() that has not been written yet. Contents of
+    // the command may already be encoded, see SyncMLCmdObject::setEncoding()
+    struct PreparedCommand
+    {
+        SyncItemKey         iKey;
+        SyncMLCommand       iCommand;
+        SyncMLLocalChange*  iObject;
+        SyncItem*           iItem;
+        QString             iMimeType;
+        int                 iSize;
+        bool                iExactSize;
+        bool                iWBXML;
+        ProtocolVersion     iVersion;
+    };
+
+    // Command that items of the same kind are being added to
+    struct CommandGroup
+    {
+        SyncMLLocalChange*  iObject;
+        SyncMLCommand       iCommand;
+        int                 iCmdId;
+        QString             iMimeType;
+        QString             iVersion;
+        int                 iItemCount;
+        CommandGroup() : iObject( 0 ), iCommand( SYNCML_ADD ), iCmdId( 0 ), iItemCount( 0 ) {}
+    };
+
     bool processAddedItems( SyncMLMessage& aMessage,
                             SyncMLSync& aSyncElement,
                             int& aSizeThreshold,
@@ -135,12 +197,68 @@ private:
                               bool aWBXML,
                               const ProtocolVersion& aVersion);
 
+    bool writeCommand( SyncMLMessage& aMessage,
+                       SyncMLSync& aSyncElement,
+                       SyncMLCommand aCommand,
+                       int& aCmdId,
+                       int& aItemIndex,
+                       const SyncItemKey& aItemKey,
+                       int& aSizeThreshold,
+                       bool aForce,
+                       bool aWBXML,
+                       const ProtocolVersion& aVersion,
+                       QString& aMimeType,
+                       bool& aProcessed );
+
+    bool appendToGroup( const SyncItemKey& aItemKey,
+                        int& aSizeThreshold,
+                        bool aWBXML,
+                        const ProtocolVersion& aVersion,
+                        QString& aMimeType );
+
+    bool writeSingleCommand( SyncMLMessage& aMessage,
+                             SyncMLSync& aSyncElement,
+                             SyncMLCommand aCommand,
+                             int aCmdId,
+                             const SyncItemKey& aItemKey,
+                             int& aSizeThreshold,
+                             bool aForce,
+                             bool aWBXML,
+                             const ProtocolVersion& aVersion,
+                             QString& aMimeType,
+                             bool& aProcessed );
+
+    bool writePreparedCommand( SyncMLSync& aSyncElement,
+                               SyncMLCommand aCommand,
+                               int aCmdId,
+                               const SyncItemKey& aItemKey,
+                               int& aSizeThreshold,
+                               bool aForce,
+                               bool aWBXML,
+                               const ProtocolVersion& aVersion,
+                               QString& aMimeType );
+
+    void discardPreparedCommands();
+
+    SyncMLLocalChange* newCommand( SyncMLCommand aCommand, int aCmdId ) const;
+
+    void commitItem();
+
+    void rollbackItem( const SyncItemKey& aItemKey, const LargeObjectState& aCheckpoint );
+
     bool processItem( const SyncItemKey& aItemKey,
                       SyncMLLocalChange& aParent,
                       int aSizeThreshold,
                       SyncMLCommand aCommand,
                       QString& aMimeType );
 
+    bool buildItem( const SyncItemKey& aItemKey,
+                    SyncMLLocalChange* aParent,
+                    SyncMLItem& aItemObject,
+                    int aSizeThreshold,
+                    SyncMLCommand aCommand,
+                    QString& aMimeType );
+
     int                     iLargeObjectThreshold;
     int                     iNumberOfChanges;
     const SyncTarget&       iSyncTarget;
@@ -148,7 +266,12 @@ private:
     LargeObjectState        iLargeObjectState;
     Role                    iRole;
     int 					iMaxChangesPerMessage;
+    bool                    iExactPacking;
+    bool                    iMultiItemCommands;
+    SyncItem*               iWrittenItem;
     SyncItemPrefetcher      iPrefetcher;
+    QList<PreparedCommand>  iPreparedCommands;
+    CommandGroup            iCommandGroup;
 
     friend class ::LocalChangesPackageTest;
 
@@ -72,6 +72,34 @@ public:
      */
     virtual bool write( SyncMLMessage& aMessage, int& aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion ) = 0;
 
+    /*! \brief Sets whether the package should be written with exact sizes
+     *
+     * With exact packing, aSizeThreshold of write() is the exact number of
+     * encoded bytes left in the message, and the package must not use more,
+     * rolling back commands that do not fit. Packages that only estimate the
+     * size of what they write do not support exact packing, and are given a
+     * threshold with a safety margin instead.
+     *
+     * @param aExact True to enable exact packing, false to disable it
+     * @return True if the package supports exact packing, otherwise false
+     */
+    virtual bool setExactPacking( bool aExact ) { Q_UNUSED( aExact ); return false; }
+
+    /*! \brief Prepares content for the next write() in advance
+     *
+     * Called while waiting for the response to the previous message, so that
+     * work that does not depend on the response can be done before write()
+     * is called. What is prepared must not be visible to the remote party
+     * or to the storages until it is actually written, and write() must
+     * produce the same output whether or not the package was prepared.
+     *
+     * @param aSizeThreshold Estimated number of bytes the next write() can use
+     * @param aWBXML True if the next message is likely to be WbXML encoded
+     * @param aVersion Protocol version in use
+     */
+    virtual void prepare( int aSizeThreshold, bool aWBXML, const ProtocolVersion& aVersion )
+    { Q_UNUSED( aSizeThreshold ); Q_UNUSED( aWBXML ); Q_UNUSED( aVersion ); }
+
 protected:
 
 private:
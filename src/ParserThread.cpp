@@ -0,0 +1,166 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "ParserThread.h"
+
+#include <QBuffer>
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+ParserThread::ParserThread( QObject* aParent )
+ : QThread( aParent ), iParser( new SyncMLMessageParser )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iParser->moveToThread( this );
+
+    // Fragments are collected in the parser thread as soon as they have been
+    // signalled, before the parser continues
+    connect( iParser, SIGNAL(fragmentsAvailable()),
+             this, SLOT(collectAvailableFragments()), Qt::DirectConnection );
+    connect( iParser, SIGNAL(parsingComplete(bool)),
+             this, SLOT(collectFragments(bool)), Qt::DirectConnection );
+    connect( iParser, SIGNAL(parsingError(DataSync::ParserError)),
+             this, SIGNAL(parsingError(DataSync::ParserError)), Qt::DirectConnection );
+}
+
+ParserThread::~ParserThread()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    quit();
+    wait();
+
+    // Parser is deleted by the thread after it has run
+    delete iParser;
+    iParser = 0;
+
+    while( !iCompleted.isEmpty() ) {
+        qDeleteAll( iCompleted.dequeue() );
+    }
+}
+
+QList<DataSync::Fragment*> ParserThread::takeFragments()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMutexLocker locker( &iMutex );
+
+    if( iCompleted.isEmpty() ) {
+        return QList<DataSync::Fragment*>();
+    }
+
+    return iCompleted.dequeue();
+}
+
+QList<DataSync::Fragment*> ParserThread::takeAvailableFragments()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    return takeFragments();
+}
+
+void ParserThread::parseResponse( QIODevice *aDevice, bool aIsNewPacket )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Contents of a buffer are shared instead of copied
+    QBuffer* buffer = qobject_cast<QBuffer*>( aDevice );
+    const QByteArray data = buffer ? buffer->data().mid( static_cast<int>( buffer->pos() ) )
+                                   : aDevice->readAll();
+
+    QMetaObject::invokeMethod( iParser, "parseMessage", Qt::QueuedConnection,
+                               Q_ARG( QByteArray, data ), Q_ARG( bool, aIsNewPacket ) );
+}
+
+void ParserThread::parseChunk( const QByteArray& aData, bool aFirstChunk, bool aLastChunk )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMetaObject::invokeMethod( iParser, "parseChunk", Qt::QueuedConnection,
+                               Q_ARG( QByteArray, aData ), Q_ARG( bool, aFirstChunk ),
+                               Q_ARG( bool, aLastChunk ) );
+}
+
+void ParserThread::cancelStream()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMetaObject::invokeMethod( iParser, "cancelStream", Qt::QueuedConnection );
+}
+
+void ParserThread::setKnownDevInfHash( const QByteArray& aHash )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMetaObject::invokeMethod( iParser, "setKnownDevInfHash", Qt::QueuedConnection,
+                               Q_ARG( QByteArray, aHash ) );
+}
+
+void ParserThread::run()
+{
+    qCDebug(lcSyncML) << "Starting parser thread...";
+
+    exec();
+
+    delete iParser;
+    iParser = 0;
+
+    qCDebug(lcSyncML) << "Stopping parser thread...";
+}
+
+void ParserThread::collectAvailableFragments()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    {
+        QMutexLocker locker( &iMutex );
+        iCompleted.enqueue( iParser->takeAvailableFragments() );
+    }
+
+    emit fragmentsAvailable();
+}
+
+void ParserThread::collectFragments( bool aLastMessageInPackage )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    {
+        QMutexLocker locker( &iMutex );
+        iCompleted.enqueue( iParser->takeFragments() );
+    }
+
+    emit parsingComplete( aLastMessageInPackage );
+}
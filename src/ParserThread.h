@@ -0,0 +1,172 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef PARSERTHREAD_H
+#define PARSERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QQueue>
+
+#include "SyncMLMessageParser.h"
+
+class QIODevice;
+
+namespace DataSync {
+
+/*! \brief Thread for parsing incoming messages
+ *
+ * Runs a SyncMLMessageParser in a thread of its own, so that parsing a
+ * large message does not block the event loop the transport runs in.
+ * Provides the same slots, signals and fragment retrieval functions as
+ * SyncMLMessageParser, and can be used in place of it. Slots must be
+ * called in the thread that created the object, and signals are emitted in
+ * the parser thread.
+ *
+ * Fragments completed by the parser are queued in the order they were
+ * signalled. Each parsingComplete() and fragmentsAvailable() signal
+ * corresponds to one call of takeFragments() or takeAvailableFragments(),
+ * so the parser may already be working on the next message while the
+ * fragments of the previous one are being processed.
+ */
+class ParserThread : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aParent Parent object
+     */
+    explicit ParserThread( QObject* aParent = 0 );
+
+    /*! \brief Destructor
+     *
+     * Stops the thread if it is running
+     */
+    virtual ~ParserThread();
+
+    /*! \brief Retrieves the fragments of a parsed message
+     *
+     * Ownership of the fragments is transferred.
+     * @return Fragments of the message the oldest parsingComplete() was
+     *         emitted for
+     */
+    QList<DataSync::Fragment*> takeFragments();
+
+    /*! \brief Retrieves the fragments completed so far while parsing a message
+     *         incrementally
+     *
+     * Ownership of the fragments is transferred.
+     * @return Fragments the oldest fragmentsAvailable() was emitted for
+     */
+    QList<DataSync::Fragment*> takeAvailableFragments();
+
+public slots:
+
+    /*! \brief Parse incoming data in the parser thread
+     *
+     * Contents of the device are read before returning, so the device can be
+     * reused as soon as this function returns.
+     *
+     * @param aDevice QIODevice from which to retrieve data
+     * @param aIsNewPacket To indicate if the packet is a newly received or a
+     * purged one
+     */
+    void parseResponse( QIODevice *aDevice, bool aIsNewPacket );
+
+    /*! \brief Parse a chunk of incoming XML data in the parser thread
+     *
+     * @param aData Chunk of the message
+     * @param aFirstChunk True if this is the first chunk of a new message
+     * @param aLastChunk True if this is the last chunk of the message
+     */
+    void parseChunk( const QByteArray& aData, bool aFirstChunk, bool aLastChunk );
+
+    /*! \brief Abandon the message being parsed incrementally
+     *
+     * Chunks passed earlier are parsed before the message is abandoned.
+     */
+    void cancelStream();
+
+    /*! \brief Sets the hash of remote device info that is already known
+     *
+     * @param aHash Hash of the DevInf element
+     */
+    void setKnownDevInfHash( const QByteArray& aHash );
+
+signals:
+
+    /*! \brief Emitted when fragments have been completed while parsing a
+     *         message incrementally
+     */
+    void fragmentsAvailable();
+
+    /*! \brief Emitted when parsing of a message has been completed
+     *
+     * @param aLastMessageInPackage True if the parsed message contained
+     *        Final element
+     */
+    void parsingComplete( bool aLastMessageInPackage );
+
+    /*! \brief Emitted when error occurred during parsing of a message
+     *
+     * @param aEvent Occurred error
+     */
+    void parsingError( DataSync::ParserError aEvent );
+
+protected:
+
+    /*! \brief Thread function
+     *
+     */
+    virtual void run();
+
+private slots:
+
+    void collectAvailableFragments();
+
+    void collectFragments( bool aLastMessageInPackage );
+
+private:
+
+    SyncMLMessageParser*                iParser;
+    QMutex                              iMutex;
+    QQueue<QList<DataSync::Fragment*> > iCompleted;
+
+};
+
+}
+
+#endif // PARSERTHREAD_H
@@ -68,6 +68,12 @@ bool RequestListener::start( Transport* aTransport )
     connect( iTransport, SIGNAL(readXMLData(QIODevice *, bool)) ,
              &iParser, SLOT(parseResponse(QIODevice *, bool)) );
 
+    connect( iTransport, SIGNAL(readXMLChunk(QByteArray, bool, bool)) ,
+             &iParser, SLOT(parseChunk(QByteArray, bool, bool)) );
+
+    connect( iTransport, SIGNAL(chunksCancelled()) ,
+             &iParser, SLOT(cancelStream()) );
+
     connect( &iParser, SIGNAL(parsingComplete(bool)),
              this, SLOT(parsingComplete(bool)) );
 
@@ -87,6 +93,10 @@ void RequestListener::stop()
     disconnect( &iParser, 0, this, 0 );
     disconnect( iTransport, SIGNAL(readXMLData(QIODevice *, bool)) ,
              &iParser, SLOT(parseResponse(QIODevice *, bool)) );
+    disconnect( iTransport, SIGNAL(readXMLChunk(QByteArray, bool, bool)) ,
+             &iParser, SLOT(parseChunk(QByteArray, bool, bool)) );
+    disconnect( iTransport, SIGNAL(chunksCancelled()) ,
+             &iParser, SLOT(cancelStream()) );
     if( iTransport )
     {
         disconnect( iTransport, 0, this, 0 );
@@ -39,16 +39,71 @@
 #include "SyncMLMessage.h"
 #include "SyncMLStatus.h"
 #include "SyncMLAlert.h"
+#include "MessageSizer.h"
 #include "datatypes.h"
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
+namespace {
+
+// Exact size of the message, or its estimate if it cannot be encoded natively
+int exactMessageSize( const MessageSizer& aSizer, const SyncMLMessage& aMessage,
+                      bool aWbXML, const ProtocolVersion& aVersion )
+{
+    int size = aSizer.messageSize( aMessage );
+    return size >= 0 ? size : aMessage.calculateSize( aWbXML, aVersion );
+}
+
+// Lists the references of a status in its items
+void moveRefsToItems( StatusParams& aParams )
+{
+    if( aParams.items.isEmpty() ) {
+        ItemParams item;
+        item.target = aParams.targetRef;
+        item.source = aParams.sourceRef;
+        aParams.items.append( item );
+        aParams.targetRef.clear();
+        aParams.sourceRef.clear();
+    }
+}
+
+bool hasRefs( const StatusParams& aParams )
+{
+    return !aParams.items.isEmpty() || !aParams.targetRef.isEmpty() || !aParams.sourceRef.isEmpty();
+}
+
+// Merges the status of further items of a command to the status of its
+// previous items, if they only differ by the items they refer to
+bool mergeStatus( StatusParams& aTo, StatusParams& aFrom )
+{
+    if( aTo.msgRef != aFrom.msgRef || aTo.cmdRef != aFrom.cmdRef ||
+        aTo.cmd != aFrom.cmd || aTo.data != aFrom.data ||
+        aTo.cmd == SYNCML_ELEMENT_SYNCHDR ||
+        aTo.hasChal || aFrom.hasChal ||
+        !aTo.chal.meta.type.isEmpty() || !aFrom.chal.meta.type.isEmpty() ||
+        !aTo.nextAnchor.isEmpty() || !aFrom.nextAnchor.isEmpty() ||
+        !hasRefs( aTo ) || !hasRefs( aFrom ) ) {
+        return false;
+    }
+
+    moveRefsToItems( aTo );
+    moveRefsToItems( aFrom );
+    aTo.items.append( aFrom.items );
+
+    return true;
+}
+
+}
+
 ResponseGenerator::ResponseGenerator()
  : iMaxMsgSize( 0 ),
    iMsgId( 0 ),
    iRemoteMsgId( 0 ),
-   iIgnoreStatuses( false )
+   iIgnoreStatuses( false ),
+   iUseWbXMLStringTable( false ),
+   iExactPacking( false ),
+   iCompactStatuses( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -77,6 +132,21 @@ void ResponseGenerator::setRemoteMsgId( int aRemoteMsgId )
     iRemoteMsgId = aRemoteMsgId;
 }
 
+void ResponseGenerator::setUseWbXMLStringTable( bool aUse )
+{
+    iUseWbXMLStringTable = aUse;
+}
+
+void ResponseGenerator::setExactPacking( bool aExact )
+{
+    iExactPacking = aExact;
+}
+
+void ResponseGenerator::setCompactStatuses( bool aCompact )
+{
+    iCompactStatuses = aCompact;
+}
+
 int ResponseGenerator::getRemoteMsgId() const
 {
     return iRemoteMsgId;
@@ -96,11 +166,30 @@ SyncMLMessage* ResponseGenerator::generateNextMessage( int aMaxSize, const Proto
 
     iHeaderParams.msgID = getNextMsgId();
     SyncMLMessage* message = new SyncMLMessage( iHeaderParams, aVersion );
-    int messageSize = message->calculateSize(useWbXml, aVersion);
+
+    // With string table, the size of the message is not the sum of the sizes
+    // of its commands, so remaining bytes are resolved from the message
+    bool stringTable = useWbXml && iUseWbXMLStringTable;
+
+    if( stringTable ) {
+        message->enableWbXMLStringTable();
+    }
+
+    MessageSizer sizer( useWbXml, aVersion );
+
+    if( iExactPacking ) {
+        message->enableExactPacking();
+    }
+
+    int messageSize = iExactPacking ? exactMessageSize( sizer, *message, useWbXml, aVersion )
+                                    : message->calculateSize(useWbXml, aVersion);
 
     qCDebug(lcSyncML) << "useWbxml"<<useWbXml;
 
-    int overhead = qMax( static_cast<int>( MAXMSGOVERHEADRATIO * aMaxSize), MINMSGOVERHEADBYTES );
+    // Exactly packed messages are encoded with the encoder that resolved
+    // their size, so no overhead needs to be reserved
+    int overhead = iExactPacking ? 0
+                                 : qMax( static_cast<int>( MAXMSGOVERHEADRATIO * aMaxSize), MINMSGOVERHEADBYTES );
     int messageSizeThreshold = aMaxSize - overhead;
 
     int remainingBytes = messageSizeThreshold - messageSize;
@@ -111,12 +200,38 @@ SyncMLMessage* ResponseGenerator::generateNextMessage( int aMaxSize, const Proto
         params->cmdId = message->getNextCmdId();
         SyncMLStatus* statusObject = new SyncMLStatus( *params );
 
+        if( iExactPacking ) {
+
+            int size = sizer.appendSize( message->getBody(), *statusObject );
+
+            if( size < 0 ) {
+                size = statusObject->calculateSize(useWbXml, aVersion);
+            }
+
+            // Roll back a status that does not fit, unless it is the first
+            // one. It is written to the next message instead
+            if( size > remainingBytes && !message->getBody().getChildren().isEmpty() ) {
+                message->releaseCmdId( params->cmdId );
+                delete statusObject;
+                break;
+            }
+
+            remainingBytes -= size;
+        }
+
         delete params;
         iStatuses.removeFirst();
 
         message->addToBody( statusObject );
 
-        remainingBytes -= statusObject->calculateSize(useWbXml, aVersion);
+        if( !iExactPacking ) {
+            if( stringTable ) {
+                remainingBytes = messageSizeThreshold - message->calculateSize(useWbXml, aVersion);
+            }
+            else {
+                remainingBytes -= statusObject->calculateSize(useWbXml, aVersion);
+            }
+        }
 
         if( remainingBytes < 0 ) {
             break;
@@ -128,7 +243,40 @@ SyncMLMessage* ResponseGenerator::generateNextMessage( int aMaxSize, const Proto
 
         Package* package = iPackages.first();
 
-        if( package->write( *message, remainingBytes, useWbXml, aVersion ) ) {
+        bool written = false;
+
+        if( iExactPacking && package->setExactPacking( true ) ) {
+            // Package accounts for the exact size of each command it writes
+            written = package->write( *message, remainingBytes, useWbXml, aVersion );
+        }
+        else if( iExactPacking ) {
+
+            // Package only estimates its size, leave a margin for that. The
+            // commands it wrote are then measured, which also encodes them
+            // for sending
+            int threshold = remainingBytes - static_cast<int>( MAXMSGOVERHEADRATIO * remainingBytes );
+            int firstCommand = message->getBody().getChildren().count();
+
+            written = package->write( *message, threshold, useWbXml, aVersion );
+
+            int size = sizer.childrenSize( message->getBody(), firstCommand );
+
+            if( size >= 0 ) {
+                remainingBytes -= size;
+            }
+            else {
+                remainingBytes = messageSizeThreshold - exactMessageSize( sizer, *message, useWbXml, aVersion );
+            }
+        }
+        else {
+            written = package->write( *message, remainingBytes, useWbXml, aVersion );
+
+            if( stringTable ) {
+                remainingBytes = messageSizeThreshold - message->calculateSize(useWbXml, aVersion);
+            }
+        }
+
+        if( written ) {
             delete package;
             iPackages.removeFirst();
         }
@@ -147,6 +295,37 @@ SyncMLMessage* ResponseGenerator::generateNextMessage( int aMaxSize, const Proto
 
 }
 
+void ResponseGenerator::prepareNextMessage( int aMaxSize, const ProtocolVersion& aVersion,
+                                            bool aWbXML )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iPackages.isEmpty() ) {
+        return;
+    }
+
+    bool useWbXml = false;
+
+    if( aMaxSize <= MSGSIZETHRESHOLD)
+    {
+        useWbXml = aWbXML;
+    }
+
+    SyncMLMessage message( iHeaderParams, aVersion );
+
+    int overhead = iExactPacking ? 0
+                                 : qMax( static_cast<int>( MAXMSGOVERHEADRATIO * aMaxSize), MINMSGOVERHEADBYTES );
+    int threshold = aMaxSize - overhead - message.calculateSize( useWbXml, aVersion );
+
+    Package* package = iPackages.first();
+
+    if( iExactPacking ) {
+        package->setExactPacking( true );
+    }
+
+    package->prepare( threshold, useWbXml, aVersion );
+}
+
 void ResponseGenerator::addPackage( Package* aPackage )
 {
     iPackages.append( aPackage );
@@ -186,6 +365,20 @@ void ResponseGenerator::addStatus( StatusParams* aParams )
             // Status for SyncHdr is always in the beginning
             iStatuses.prepend( aParams );
         }
+        else if( iCompactStatuses )
+        {
+            aParams->compactRefs = true;
+
+            if( !iStatuses.isEmpty() && mergeStatus( *iStatuses.last(), *aParams ) )
+            {
+                delete aParams;
+                aParams = 0;
+            }
+            else
+            {
+                iStatuses.append( aParams );
+            }
+        }
         else
         {
             iStatuses.append( aParams );
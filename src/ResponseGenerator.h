@@ -84,6 +84,43 @@ public:
      */
     void setRemoteMsgId( int aRemoteMsgId );
 
+    /*! \brief Sets whether generated WbXML messages should use a string table
+     *
+     * Strings that repeat in a message are then placed in a string table when
+     * that makes the message smaller, and the savings are taken into account
+     * when filling the message.
+     *
+     * @param aUse True to use string table, otherwise false
+     */
+    void setUseWbXMLStringTable( bool aUse );
+
+    /*! \brief Sets whether messages are filled using exact encoded sizes
+     *
+     * By default a share of every message is left unused, as sizes of
+     * commands are only estimated. With exact packing the encoded size of
+     * every command is resolved as it is added, and commands that would not
+     * fit are rolled back to the next message, so messages are filled up to
+     * the maximum size. Such messages are encoded with the native encoders
+     * that resolved their sizes.
+     *
+     * @param aExact True to use exact packing, otherwise false
+     */
+    void setExactPacking( bool aExact );
+
+    /*! \brief Sets whether statuses of several items are written compactly
+     *
+     * By default a status of several items refers to each of them with an
+     * Item element. With compact statuses the items are referred to with
+     * TargetRef and SourceRef elements instead, and statuses added for
+     * further items of the same command with the same status code are merged
+     * to the status queued before them. Whether the remote party accepts
+     * compact statuses is not checked. A remote party that does not support
+     * several references in a Status will reject such statuses.
+     *
+     * @param aCompact True to write compact statuses, otherwise false
+     */
+    void setCompactStatuses( bool aCompact );
+
     /*! \brief Get remote message id
      *
      * Remote message id is used when status elements are generated, as they require
@@ -104,6 +141,21 @@ public:
     SyncMLMessage* generateNextMessage( int aMaxSize, const ProtocolVersion& aVersion,
                                         bool aWbXML = false );
 
+    /*! \brief Prepares the first package of the queue for the next message
+     *
+     * Meant to be called while waiting for a response, so that the next
+     * message can be generated faster once the response has been processed.
+     * Statuses of the response are not known yet, so the package prepares for
+     * all the space left after the message header. Whatever does not fit in
+     * the actual message is discarded when the message is generated.
+     *
+     * @param aMaxSize Maximum size of the message
+     * @param aVersion Protocol version to use
+     * @param aWbXML If generated message will be converted to WbXML
+     */
+    void prepareNextMessage( int aMaxSize, const ProtocolVersion& aVersion,
+                             bool aWbXML = false );
+
     /*! \brief Add package to package queue for sending
      *
      * @param aPackage Package. Ownership IS transferred
@@ -231,6 +283,9 @@ private:
     QList<Package*>         iPackages;
 
     bool                    iIgnoreStatuses;
+    bool                    iUseWbXMLStringTable;
+    bool                    iExactPacking;
+    bool                    iCompactStatuses;
 
 };
 }
@@ -33,6 +33,8 @@
 
 #include "SessionHandler.h"
 
+#include <QTimer>
+
 #include "ChangeLog.h"
 #include "SyncAgentConfig.h"
 #include "SyncAgentConfigProperties.h"
@@ -45,11 +47,34 @@
 #include "ConflictResolver.h"
 #include "AuthHelper.h"
 #include "StorageProvider.h"
+#include "ParserThread.h"
+#include "DevInfStorage.h"
 
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
+/*! \brief Sync element whose items are being committed to local database
+ *
+ */
+struct SessionHandler::PendingSync
+{
+    PendingSync( const QSharedPointer<SyncParams>& aParams, SyncTarget* aTarget,
+                 ConflictResolutionPolicy aPolicy, bool aFastMapsSend )
+     : iParams( aParams ), iTarget( aTarget ),
+       iConflictResolver( *aTarget->getLocalChanges(), aPolicy ),
+       iFastMapsSend( aFastMapsSend ), iWaiting( false )
+    {
+    }
+
+    QSharedPointer<SyncParams>          iParams;            ///< Sync element
+    SyncTarget*                         iTarget;            ///< Target of the Sync element
+    ConflictResolver                    iConflictResolver;  ///< Resolves conflicts of the items
+    QMap<ItemId, ResponseStatusCode>    iResponses;         ///< Responses to the items
+    bool                                iFastMapsSend;      ///< Send mappings immediately
+    bool                                iWaiting;           ///< Commit did not finish right away
+};
+
 SessionHandler::SessionHandler( const SyncAgentConfig* aConfig,
                                 const Role& aRole,
                                 QObject* aParent ) :
@@ -57,6 +82,7 @@ SessionHandler::SessionHandler( const SyncAgentConfig* aConfig,
     iDatabaseHandler( aConfig->getDatabaseFilePath() ),
     iCommandHandler( aRole ),
     iDevInfHandler( aConfig->getDeviceInfo() ),
+    iParserThread( 0 ),
     iConfig(aConfig),
     iSyncState( NOT_PREPARED ),
     iSyncWithoutInitPhase( false ),
@@ -65,6 +91,10 @@ SessionHandler::SessionHandler( const SyncAgentConfig* aConfig,
     iProcessing( false ),
     iProtocolVersion( SYNCML_1_2 ),
     iRemoteReportedBusy(false),
+    iMessagePipelining( false ),
+    iPendingSync( 0 ),
+    iPendingEndOfMessage( false ),
+    iPendingFinal( false ),
     iRole( aRole )
 
 {
@@ -87,9 +117,22 @@ SessionHandler::~SessionHandler()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    // Outstanding commit uses the conflict resolver of the pending sync and
+    // the storage plugin, so it is cancelled before they are released
+    iStorageHandler.cancelCommit();
+
     // Make sure that all allocated objects are released.
+    delete iPendingSync;
+    iPendingSync = 0;
+
+    qDeleteAll( iPendingFragments );
+    iPendingFragments.clear();
+
     releaseStoragesAndTargets();
 
+    delete iParserThread;
+    iParserThread = 0;
+
 }
 
 bool SessionHandler::prepareSync()
@@ -138,13 +181,49 @@ bool SessionHandler::prepareSync()
     params().setLocalMaxMsgSize( localMaxMsgSize );
     params().setRemoteMaxMsgSize( localMaxMsgSize );
 
+    if( getConfig()->getAgentProperty( WBXMLSTRINGTABLEPROP ).toInt() > 0 )
+    {
+        qCDebug(lcSyncML) << "Using string table in outgoing WbXML messages";
+        iResponseGenerator.setUseWbXMLStringTable( true );
+    }
+
+    if( getConfig()->getAgentProperty( EXACTPACKINGPROP ).toInt() > 0 )
+    {
+        qCDebug(lcSyncML) << "Filling outgoing messages using exact sizes";
+        iResponseGenerator.setExactPacking( true );
+    }
+
+    if( getConfig()->getAgentProperty( COMPACTSTATUSESPROP ).toInt() > 0 )
+    {
+        qCDebug(lcSyncML) << "Writing compact statuses of multiple items";
+        iResponseGenerator.setCompactStatuses( true );
+    }
+
+    if( getConfig()->getAgentProperty( MESSAGEPIPELININGPROP ).toInt() > 0 )
+    {
+        qCDebug(lcSyncML) << "Preparing outgoing messages while waiting for responses";
+        iMessagePipelining = true;
+    }
+
+    // Parse large messages without blocking the event loop of the transport
+    if( !iParserThread && getConfig()->getAgentProperty( THREADEDPARSINGPROP ).toInt() > 0 )
+    {
+        qCDebug(lcSyncML) << "Parsing incoming messages in a separate thread";
+        iParserThread = new ParserThread;
+        iParserThread->start();
+    }
+
     // Set up transport
     Transport& transport = getTransport();
 
     connect( &transport, SIGNAL(sendEvent(DataSync::TransportStatusEvent, QString )),
              this, SLOT(setTransportStatus(DataSync::TransportStatusEvent , QString )));
     connect( &transport, SIGNAL(readXMLData(QIODevice *, bool)) ,
-             &iParser, SLOT(parseResponse(QIODevice *, bool)));
+             messageParser(), SLOT(parseResponse(QIODevice *, bool)));
+    connect( &transport, SIGNAL(readXMLChunk(QByteArray, bool, bool)) ,
+             messageParser(), SLOT(parseChunk(QByteArray, bool, bool)));
+    connect( &transport, SIGNAL(chunksCancelled()) ,
+             messageParser(), SLOT(cancelStream()));
     connect( &transport, SIGNAL(readSANData(QIODevice *)) ,
              this, SLOT(SANPackageReceived(QIODevice *)));
     connect( this, SIGNAL(purgeAndResendBuffer()) ,
@@ -173,8 +252,15 @@ void SessionHandler::abortSync( SyncState aSyncState, const QString& aDescriptio
 
         // If we are processing a message, we must wait until the whole message has been processed
         // (and in server mode response has been sent). If we are not processing a message, we can
-        // abort right away.
-        if( !iProcessing ) {
+        // abort right away. Neither is there reason to wait for a storage plugin to finish a
+        // commit, as it may never do so.
+        if( iPendingSync && iPendingSync->iWaiting ) {
+            qCDebug(lcSyncML) << "Cancelling outstanding commit";
+            iPendingEndOfMessage = false;
+            iProcessing = false;
+            exitSync();
+        }
+        else if( !iProcessing ) {
             exitSync();
         }
     }
@@ -269,11 +355,45 @@ void SessionHandler::handleParsingComplete( bool aLastMessageInPackage )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    QList<DataSync::Fragment*> fragments = iParser.takeFragments();
+    QList<DataSync::Fragment*> fragments = iParserThread ? iParserThread->takeFragments()
+                                                         : iParser.takeFragments();
 
     processMessage( fragments, aLastMessageInPackage );
 }
 
+void SessionHandler::handleFragmentsAvailable()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<DataSync::Fragment*> fragments = iParserThread ? iParserThread->takeAvailableFragments()
+                                                         : iParser.takeAvailableFragments();
+
+    if( iSessionClosed )
+    {
+        qDeleteAll( fragments );
+        return;
+    }
+
+    qCDebug(lcSyncML) << "Processing" << fragments.count() << "fragments of a message still being received";
+    iProcessing = true;
+
+    processFragments( fragments );
+
+    // Processing continues once local commits have finished
+    if( iPendingSync )
+    {
+        return;
+    }
+
+    iProcessing = false;
+
+    // Sync may have been aborted while processing
+    if( iSyncFinished )
+    {
+        exitSync();
+    }
+}
+
 void SessionHandler::processMessage( QList<Fragment*>& aFragments, bool aLastMessageInPackage )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -281,8 +401,44 @@ void SessionHandler::processMessage( QList<Fragment*>& aFragments, bool aLastMes
     qCDebug(lcSyncML) << "Beginning to process received message...";
     iProcessing = true;
 
+    processFragments( aFragments );
+
+    // Rest of the message is processed once local commits have finished
+    if( iPendingSync )
+    {
+        qCDebug(lcSyncML) << "Waiting for local commits to finish before completing message";
+        iPendingEndOfMessage = true;
+        iPendingFinal = aLastMessageInPackage;
+        return;
+    }
+
+    if( aLastMessageInPackage )
+    {
+        handleFinal();
+    }
+
+    iProcessing = false;
+    qCDebug(lcSyncML) << "Received message processed";
+
+    handleEndOfMessage();
+
+}
+
+void SessionHandler::processFragments( QList<Fragment*>& aFragments )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
     while( !aFragments.isEmpty() )
     {
+        // Items of a Sync element are being committed. Remaining fragments
+        // are processed in order once the commit has finished
+        if( iPendingSync )
+        {
+            iPendingFragments.append( aFragments );
+            aFragments.clear();
+            break;
+        }
+
         DataSync::Fragment* fragment = aFragments.takeFirst();
 
         if( fragment->fragmentType == Fragment::FRAGMENT_HEADER )
@@ -340,17 +496,6 @@ void SessionHandler::processMessage( QList<Fragment*>& aFragments, bool aLastMes
             Q_ASSERT(0);
         }
     }
-
-    if( aLastMessageInPackage )
-    {
-        handleFinal();
-    }
-
-    iProcessing = false;
-    qCDebug(lcSyncML) << "Received message processed";
-
-    handleEndOfMessage();
-
 }
 
 void SessionHandler::handleParserErrors( DataSync::ParserError aError )
@@ -525,10 +670,23 @@ void SessionHandler::handleStatusElement( StatusParams* aStatusParams )
                     target->revertSyncMode();
                 }
 
+                // Remote device info may have changed along with the
+                // remote database
+                getDevInfHandler().setRemoteDevInfStale();
+                getDevInfHandler().composeRemoteDevInfRequest( getProtocolVersion(), iRole,
+                                                               getResponseGenerator() );
+
             }
 
         }
         else {
+
+            // Remote device that rejects local device info cannot be trusted
+            // to still have the device info stored for it
+            if( aStatusParams->cmd == SYNCML_ELEMENT_PUT && aStatusParams->data >= BAD_REQUEST ) {
+                dropRemoteDevInf();
+            }
+
             iCommandHandler.handleStatus( aStatusParams );
         }
 
@@ -577,9 +735,6 @@ void SessionHandler::handleSyncElement( SyncParams* aSyncParams )
         policy = confValue;
     }
 
-    ConflictResolver conflictResolver( *target->getLocalChanges(),
-                                       policy );
-
     bool fastMapsSend = false;
 
     int configValue = getConfig()->getAgentProperty( FASTMAPSSENDPROP ).toInt();
@@ -589,10 +744,105 @@ void SessionHandler::handleSyncElement( SyncParams* aSyncParams )
         fastMapsSend = true;
     }
 
-    iCommandHandler.handleSync( *aSyncParams, *target, iStorageHandler,
-                                iResponseGenerator, conflictResolver,
-                                fastMapsSend );
+    iPendingSync = new PendingSync( params, target, policy, fastMapsSend );
+
+    iCommandHandler.startSync( *aSyncParams, *target, iStorageHandler,
+                               iResponseGenerator, iPendingSync->iConflictResolver,
+                               iPendingSync->iResponses );
+
+    if( iStorageHandler.commitInProgress() )
+    {
+        qCDebug(lcSyncML) << "Waiting for items to be committed to" << target->getSourceDatabase();
+        iPendingSync->iWaiting = true;
+    }
+    else
+    {
+        finishPendingSync();
+    }
+
+}
+
+void SessionHandler::finishPendingSync()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iCommandHandler.finishSync( *iPendingSync->iParams, *iPendingSync->iTarget, iStorageHandler,
+                                iResponseGenerator, iPendingSync->iResponses,
+                                iPendingSync->iFastMapsSend );
 
+    delete iPendingSync;
+    iPendingSync = 0;
+}
+
+void SessionHandler::handleCommitFinished()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Commits that finish before StorageHandler::startCommit() returns are
+    // handled directly in handleSyncElement()
+    if( !iPendingSync || !iPendingSync->iWaiting )
+    {
+        return;
+    }
+
+    finishPendingSync();
+
+    // Plugin may still be reporting the results, so continue from the event loop
+    QTimer::singleShot( 0, this, SLOT(resumeProcessing()) );
+}
+
+void SessionHandler::resumeProcessing()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iPendingSync )
+    {
+        return;
+    }
+
+    QList<Fragment*> fragments = iPendingFragments;
+    iPendingFragments.clear();
+
+    if( iSessionClosed )
+    {
+        qDeleteAll( fragments );
+        return;
+    }
+
+    qCDebug(lcSyncML) << "Resuming processing of" << fragments.count() << "fragments";
+    iProcessing = true;
+
+    processFragments( fragments );
+
+    if( iPendingSync )
+    {
+        return;
+    }
+
+    if( iPendingEndOfMessage )
+    {
+        iPendingEndOfMessage = false;
+
+        if( iPendingFinal )
+        {
+            handleFinal();
+        }
+
+        iProcessing = false;
+        qCDebug(lcSyncML) << "Received message processed";
+
+        handleEndOfMessage();
+    }
+    else
+    {
+        iProcessing = false;
+
+        // Sync may have been aborted while waiting
+        if( iSyncFinished )
+        {
+            exitSync();
+        }
+    }
 }
 
 void SessionHandler::handleAlertElement( CommandParams* aAlertParams )
@@ -672,6 +922,11 @@ void SessionHandler::handlePutElement( DataSync::PutParams* aPutParams )
     else if( aPutParams->meta.type == SYNCML_CONTTYPE_DEVINF_XML )
     {
         code = getDevInfHandler().handlePut( *aPutParams, getProtocolVersion() );
+
+        if( code == SUCCESS && getDevInfHandler().remoteDevInfUpdated() )
+        {
+            storeRemoteDevInf();
+        }
     }
     else
     {
@@ -702,6 +957,11 @@ void SessionHandler::handleResultsElement(DataSync::ResultsParams* aResults)
     else if( aResults->meta.type == SYNCML_CONTTYPE_DEVINF_XML )
     {
         code = getDevInfHandler().handleResults( *aResults, getProtocolVersion() );
+
+        if( code == SUCCESS && getDevInfHandler().remoteDevInfUpdated() )
+        {
+            storeRemoteDevInf();
+        }
     }
     else
     {
@@ -799,10 +1059,31 @@ void SessionHandler::sendNextMessage()
         clearEMITags();
     }
 
+    // Work on the next message once control returns to the event loop, so
+    // that it is done while the response to this one is on its way
+    if( iMessagePipelining && !iResponseGenerator.packageQueueEmpty() )
+    {
+        QTimer::singleShot( 0, this, SLOT(prepareNextMessage()) );
+    }
+
     qCDebug(lcSyncML) << "Next message sent";
 
 }
 
+void SessionHandler::prepareNextMessage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iSessionClosed || iProcessing )
+    {
+        return;
+    }
+
+    iResponseGenerator.prepareNextMessage( params().remoteMaxMsgSize(),
+                                           getProtocolVersion(),
+                                           getTransport().usesWbXML() );
+}
+
 ProtocolVersion SessionHandler::getProtocolVersion() const
 {
     return iProtocolVersion;
@@ -845,6 +1126,16 @@ void SessionHandler::exitSync()
         // and before event about sync exiting reaches user.
         getResponseGenerator().clearPackageQueue();
 
+        // Stop an outstanding commit before its storage is released, and
+        // with it the Sync element and fragments waiting for the commit
+        iStorageHandler.cancelCommit();
+
+        delete iPendingSync;
+        iPendingSync = 0;
+
+        qDeleteAll( iPendingFragments );
+        iPendingFragments.clear();
+
         // Release storages
     	releaseStoragesAndTargets();
 
@@ -882,10 +1173,13 @@ void DataSync::SessionHandler::connectSignals()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    connect( &iParser, SIGNAL(parsingComplete(bool)),
+    connect( messageParser(), SIGNAL(parsingComplete(bool)),
              this, SLOT(handleParsingComplete(bool)), Qt::QueuedConnection );
 
-    connect( &iParser, SIGNAL( parsingError(DataSync::ParserError)),
+    connect( messageParser(), SIGNAL(fragmentsAvailable()),
+             this, SLOT(handleFragmentsAvailable()), Qt::QueuedConnection );
+
+    connect( messageParser(), SIGNAL( parsingError(DataSync::ParserError)),
             this, SLOT(handleParserErrors(DataSync::ParserError)));
 
     connect( &iCommandHandler, SIGNAL( itemAcknowledged( int, int, SyncItemKey ) ),
@@ -894,6 +1188,21 @@ void DataSync::SessionHandler::connectSignals()
     connect( &iStorageHandler, SIGNAL( itemProcessed( DataSync::ModificationType, DataSync::ModifiedDatabase,QString ,QString, int ) ),
              this, SIGNAL( itemProcessed( DataSync::ModificationType, DataSync::ModifiedDatabase,QString ,QString, int) ) );
 
+    connect( &iStorageHandler, SIGNAL( commitFinished() ),
+             this, SLOT( handleCommitFinished() ) );
+
+}
+
+QObject* SessionHandler::messageParser()
+{
+    if( iParserThread )
+    {
+        return iParserThread;
+    }
+    else
+    {
+        return &iParser;
+    }
 }
 
 ResponseStatusCode SessionHandler::handleInformativeAlert( const CommandParams& aAlertParams )
@@ -971,6 +1280,10 @@ void SessionHandler::composeLocalChanges()
 
     int largeObjectThreshold = qMax( static_cast<int>( MAXMSGOVERHEADRATIO * params().remoteMaxMsgSize()), MINMSGOVERHEADBYTES );
 
+    bool multiItemCommands = getConfig()->getAgentProperty( MULTIITEMCOMMANDSPROP ).toInt() > 0;
+    bool backgroundPrefetching = getConfig()->getAgentProperty( BACKGROUNDPREFETCHINGPROP ).toInt() > 0;
+    qint64 prefetchMemoryBudget = qMax( getConfig()->getAgentProperty( PREFETCHMEMORYBUDGETPROP ).toLongLong(), Q_INT64_C( 0 ) );
+
     const QList<SyncTarget*>& targets = getSyncTargets();
     foreach( const SyncTarget* syncTarget, targets ) {
         const LocalChanges* localChanges = syncTarget->getLocalChanges();
@@ -979,10 +1292,15 @@ void SessionHandler::composeLocalChanges()
                                                                             largeObjectThreshold,
                                                                             iRole,
                                                                             maxChangesPerMessage );
+        localChangesPackage->setMultiItemCommands( multiItemCommands );
+        localChangesPackage->setPrefetching( backgroundPrefetching, prefetchMemoryBudget );
         iResponseGenerator.addPackage(localChangesPackage);
 
-        connect( localChangesPackage, SIGNAL( newItemWritten( int, int, SyncItemKey, ModificationType, QString, QString, QString ) ),
-                 this, SLOT( newItemReference( int, int, SyncItemKey, ModificationType, QString, QString, QString ) ) );
+        connect( localChangesPackage, SIGNAL( newItemWritten( int, int, int, SyncItemKey, ModificationType, QString, QString, QString ) ),
+                 this, SLOT( newItemReference( int, int, int, SyncItemKey, ModificationType, QString, QString, QString ) ) );
+
+        connect( localChangesPackage, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ),
+                 this, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ) );
 
     }
 
@@ -1008,6 +1326,8 @@ void SessionHandler::setupSession( HeaderParams& aHeaderParams )
     params().setLocalDeviceName( aHeaderParams.targetDevice );
     params().setRemoteDeviceName( aHeaderParams.sourceDevice );
 
+    loadRemoteDevInf();
+
     QString verDTD;
     QString verProto;
 
@@ -1061,6 +1381,8 @@ void SessionHandler::setupSession( const QString& aSessionId )
         params().setRemoteDeviceName( SYNCML_UNKNOWN_DEVICE );
     }
 
+    loadRemoteDevInf();
+
     setProtocolVersion( getConfig()->getProtocolVersion() );
 
     if( getConfig()->extensionEnabled( SYNCWITHOUTINITPHASEEXTENSION ) ) {
@@ -1100,6 +1422,81 @@ void SessionHandler::setupSession( const QString& aSessionId )
 
 }
 
+void SessionHandler::loadRemoteDevInf()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const QString& remoteDevice = params().remoteDeviceName();
+
+    if( remoteDevice.isEmpty() || remoteDevice == SYNCML_UNKNOWN_DEVICE )
+    {
+        return;
+    }
+
+    DevInfStorage storage( iDatabaseHandler.getDbHandle(), remoteDevice );
+    RemoteDeviceInfo devInf;
+    QByteArray hash;
+    QDateTime updated;
+
+    if( storage.devInf( devInf, hash, updated ) )
+    {
+        qCDebug(lcSyncML) << "Using stored device info of" << remoteDevice;
+        getDevInfHandler().setCachedRemoteDeviceInfo( devInf, hash );
+
+        int maxAge = getConfig()->getAgentProperty( DEVINFMAXAGEPROP ).toInt();
+
+        if( maxAge > 0 && updated.secsTo( QDateTime::currentDateTime() ) > maxAge )
+        {
+            getDevInfHandler().setRemoteDevInfStale();
+        }
+
+        // Unchanged device info does not need to be parsed again
+        QMetaObject::invokeMethod( messageParser(), "setKnownDevInfHash",
+                                   Q_ARG( QByteArray, hash ) );
+    }
+}
+
+void SessionHandler::storeRemoteDevInf()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const QString& remoteDevice = params().remoteDeviceName();
+
+    if( remoteDevice.isEmpty() || remoteDevice == SYNCML_UNKNOWN_DEVICE )
+    {
+        return;
+    }
+
+    qCDebug(lcSyncML) << "Storing device info of" << remoteDevice;
+
+    DevInfStorage storage( iDatabaseHandler.getDbHandle(), remoteDevice );
+    storage.setDevInf( getDevInfHandler().getRemoteDeviceInfo(),
+                       getDevInfHandler().getRemoteDevInfHash() );
+}
+
+void SessionHandler::dropRemoteDevInf()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    getDevInfHandler().clearCachedRemoteDeviceInfo();
+
+    // Parse the next device info received even if it matches the stored one
+    QMetaObject::invokeMethod( messageParser(), "setKnownDevInfHash",
+                               Q_ARG( QByteArray, QByteArray() ) );
+
+    const QString& remoteDevice = params().remoteDeviceName();
+
+    if( remoteDevice.isEmpty() || remoteDevice == SYNCML_UNKNOWN_DEVICE )
+    {
+        return;
+    }
+
+    qCDebug(lcSyncML) << "Dropping stored device info of" << remoteDevice;
+
+    DevInfStorage storage( iDatabaseHandler.getDbHandle(), remoteDevice );
+    storage.clearDevInf();
+}
+
 void SessionHandler::saveSession()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -1287,7 +1684,7 @@ DatabaseHandler& SessionHandler::getDatabaseHandler()
     return iDatabaseHandler;
 }
 
-void SessionHandler::newItemReference( int aMsgId, int aCmdId, SyncItemKey aKey,
+void SessionHandler::newItemReference( int aMsgId, int aCmdId, int aItemIndex, SyncItemKey aKey,
                                        ModificationType aModificationType,
                                        QString aLocalDatabase, QString aRemoteDatabase,
                                        QString aMimeType )
@@ -1298,13 +1695,14 @@ void SessionHandler::newItemReference( int aMsgId, int aCmdId, SyncItemKey aKey,
 
     reference.iMsgId = aMsgId;
     reference.iCmdId = aCmdId;
+    reference.iItemIndex = aItemIndex;
     reference.iKey = aKey;
     reference.iModificationType = aModificationType;
     reference.iLocalDatabase = aLocalDatabase;
     reference.iRemoteDatabase = aRemoteDatabase;
     reference.iMimeType = aMimeType;
 
-    iItemReferences.append( reference );
+    iItemReferences.insert( reference );
 
     qCDebug(lcSyncML) << "Adding reference to item:" << aKey;
 }
@@ -1315,22 +1713,31 @@ void SessionHandler::processItemStatus( int aMsgRef, int aCmdRef, SyncItemKey aK
 
     quint32 count = iItemReferences.count();
 
-    for( int i = 0; i < iItemReferences.count(); ++i ) {
+    QList<ItemReference> references;
 
-        const ItemReference& reference = iItemReferences[i];
+    if( aKey.isEmpty() ) {
+        references = iItemReferences.takeCommand( aMsgRef, aCmdRef );
+    }
+    else {
+        ItemReference reference;
+        if( iItemReferences.take( aMsgRef, aCmdRef, aKey, reference ) ) {
+            references.append( reference );
+        }
+    }
 
-        if( reference.iMsgId == aMsgRef &&
-            reference.iCmdId == aCmdRef &&
-            reference.iKey == aKey ) {
+    for( int i = 0; i < references.count(); ++i ) {
 
-            emit itemProcessed( reference.iModificationType, MOD_REMOTE_DATABASE, reference.iLocalDatabase,
-                                reference.iMimeType, count );
-            iItemReferences.removeAt( i );
+        const ItemReference& reference = references[i];
 
-            break;
+        qCDebug(lcSyncML) << "Item" << reference.iItemIndex << "of command" << aCmdRef
+                          << "acknowledged:" << reference.iKey;
 
-        }
+        emit itemProcessed( reference.iModificationType, MOD_REMOTE_DATABASE, reference.iLocalDatabase,
+                            reference.iMimeType, count );
+    }
 
+    if( !references.isEmpty() && iItemReferences.count( aMsgRef ) == 0 ) {
+        qCDebug(lcSyncML) << "All items of message" << aMsgRef << "acknowledged";
     }
 
 }
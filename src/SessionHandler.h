@@ -47,6 +47,7 @@
 #include "ResponseGenerator.h"
 #include "SyncMLMessageParser.h"
 #include "DevInfHandler.h"
+#include "ItemReferenceIndex.h"
 
 class ServerSessionHandlerTest;
 class ClientSessionHandlerTest;
@@ -58,20 +59,7 @@ namespace DataSync
 class SyncAgentConfig;
 class SyncMode;
 class SyncTarget;
-
-/*! \brief Structure to hold reference to an item
- *
- */
-struct ItemReference {
-    int iMsgId;                         /*!<Message ID related to the item*/
-    int iCmdId;                         /*!<Command ID related to the item*/
-    SyncItemKey iKey;                   /*!<Key of the item*/
-    ModificationType iModificationType; /*!<Type of modification related to the item*/
-    QString iLocalDatabase;             /*!<Local database related to the item*/
-    QString iRemoteDatabase;            /*!<Remote database related to the item*/
-    QString iMimeType;                  /*!<MIME type of the item*/
-
-};
+class ParserThread;
 
 /*! \brief SessionHandler handles all control flow and session related tasks of SyncML protocol.
  * SessionHandler contains the base case for the execution flow for the syncml session. What
@@ -173,6 +161,15 @@ signals:
      */
     void storageAccquired (QString aMimeType);
 
+    /*! \brief A signal that informs how well items were prefetched from a storage
+     *
+     * @param aLocalDatabase Identifier of the local database
+     * @param aHits Number of items that had been prefetched when needed
+     * @param aStalls Number of items that had to be waited for
+     * @param aStallTime Total time spent waiting for items, in milliseconds
+     */
+    void prefetchStatistics( QString aLocalDatabase, int aHits, int aStalls, qint64 aStallTime );
+
     /*! \brief A signal that requests storage to resend the same buffer
      * after removing any illegal XML characters from the IODevice
      */
@@ -193,6 +190,26 @@ protected slots:
      */
     void handleParsingComplete( bool aLastMessageInPackage );
 
+    /*! \brief Slot for processing fragments that have been completed while
+     *         the rest of the message is still being received
+     */
+    void handleFragmentsAvailable();
+
+    /*! \brief Slot for preparing the next message while waiting for the
+     *         response to the previous one
+     */
+    void prepareNextMessage();
+
+    /*! \brief Slot for finishing a Sync element once its items have been
+     *         committed to local database
+     */
+    void handleCommitFinished();
+
+    /*! \brief Slot for processing the fragments received while waiting for
+     *         items to be committed to local database
+     */
+    void resumeProcessing();
+
     /*! \brief A slot handler for handling parser errors
      *
      *  @param aError Occurred error
@@ -267,22 +284,25 @@ protected slots:
      *
      * @param aMsgId Message id of the item
      * @param aCmdId Command id of the item
+     * @param aItemIndex Index of the item in the command
      * @param aKey Key of the item
      * @param aModificationType Type of modification to the item
      * @param aLocalDatabase Local database where item exists
      * @param aRemoteDatabase Remote database to which item is being sent
      * @param aMimeType Mime type of the item
      */
-    void newItemReference( int aMsgId, int aCmdId, SyncItemKey aKey,
+    void newItemReference( int aMsgId, int aCmdId, int aItemIndex, SyncItemKey aKey,
                            ModificationType aModificationType,
                            QString aLocalDatabase, QString aRemoteDatabase,
                            QString aMimeType );
 
     /*! \brief Should be called when remote side has responded to item reference
+     *
+     * A status without an item reference applies to all items of the command.
      *
      * @param aMsgRef Message reference of the item
      * @param aCmdRef Command reference of the item
-     * @param aKey Key of the item
+     * @param aKey Key of the item, or empty for all items of the command
      */
     void processItemStatus( int aMsgRef, int aCmdRef, SyncItemKey aKey );
 
@@ -340,6 +360,12 @@ protected:
      */
     void processMessage( QList<Fragment*>& aFragments, bool aLastMessageInPackage );
 
+    /*! \brief Process fragments of a message sent by remote device
+     *
+     * @param aFragments Protocol fragments. Ownership is transferred.
+     */
+    void processFragments( QList<Fragment*>& aFragments );
+
     /*! \brief Sets current state of the sync
      *
      * @param aSyncState New status to set
@@ -383,6 +409,22 @@ protected:
      */
     void setupSession( const QString& aSessionId );
 
+    /*! \brief Loads device info stored for the remote device in an earlier
+     *         session
+     *
+     */
+    void loadRemoteDevInf();
+
+    /*! \brief Stores device info received from the remote device
+     *
+     */
+    void storeRemoteDevInf();
+
+    /*! \brief Removes device info stored for the remote device
+     *
+     */
+    void dropRemoteDevInf();
+
     /*! \brief Saves current session (anchors etc) to change log
      *
      */
@@ -588,8 +630,17 @@ private: // functions
      */
     void connectSignals();
 
+    /**
+     * \brief Returns the object incoming messages are passed to for parsing
+     */
+    QObject* messageParser();
+
     ResponseStatusCode handleInformativeAlert( const CommandParams& aAlertParams );
 
+    void finishPendingSync();
+
+    struct PendingSync;
+
 private: // data
     DatabaseHandler                     iDatabaseHandler;           ///< Handler for database operations
     SessionAuthentication               iSessionAuth;               ///< Handles authentication of the session
@@ -599,6 +650,7 @@ private: // data
     DevInfHandler                       iDevInfHandler;             ///< Handles device info related things
     ResponseGenerator                   iResponseGenerator;         ///< Response generator object
     SyncMLMessageParser                 iParser;                    ///< XML parser
+    ParserThread*                       iParserThread;              ///< Thread for parsing, if enabled
     const DataSync::SyncAgentConfig*    iConfig;                    ///< A pointer to configuration
     QList<StoragePlugin*>               iStorages;                  ///< A list of reserved storages
     QList<SyncTarget*>                  iSyncTargets;               ///< A list of sync targets
@@ -606,12 +658,17 @@ private: // data
     QString                             iLocalNextAnchor;           ///< Local NEXT anchor of this session
     QString                             iSyncError;                 ///< Human-readable description upon sync abort
     bool                                iSyncWithoutInitPhase;      ///< Perform synchronization without init phase
-    QList<ItemReference>                iItemReferences;            ///< Keeps track which status refers to which item in which database
+    ItemReferenceIndex                  iItemReferences;            ///< Keeps track which status refers to which item in which database
     bool                                iSyncFinished;              ///< Set to true when sync has ended
     bool                                iSessionClosed;             ///< Set to true when Session tearing down started.
     bool                                iProcessing;                ///< Set to true when we are processing a message
     ProtocolVersion                     iProtocolVersion;           ///< Protocol version in use in current session
     bool                                iRemoteReportedBusy;        ///< indicates that server reported busy
+    bool                                iMessagePipelining;         ///< Prepare next message while waiting for response
+    PendingSync*                        iPendingSync;               ///< Sync element whose items are being committed
+    QList<Fragment*>                    iPendingFragments;          ///< Fragments received while items are being committed
+    bool                                iPendingEndOfMessage;       ///< Message ended while items are being committed
+    bool                                iPendingFinal;              ///< Message that ended contained Final element
     Role                                iRole;                      ///< Role in use
     ///< A quick way to get the response a remote party sent to the last "cmd" command we sent
     QMap<QString, ResponseStatusCode>     cmdRespMap;
@@ -45,7 +45,11 @@ using namespace DataSync;
 
 StorageHandler::StorageHandler() :
     iLargeObject( NULL ),
-    iLargeObjectSize(0)
+    iLargeObjectSize(0),
+    iCommitPlugin( NULL ),
+    iAsyncCommitPlugin( NULL ),
+    iCommitResolver( NULL ),
+    iCommitStage( COMMIT_STAGE_NONE )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -56,6 +60,12 @@ StorageHandler::~StorageHandler()
 
     qDeleteAll(iAddList);
     qDeleteAll(iReplaceList);
+
+    // Items of an outstanding commit may still be in use by the plugin, so
+    // they are leaked instead of being freed under it
+    if( commitInProgress() ) {
+        qCWarning(lcSyncML) << "Storage handler destroyed while a commit is in progress";
+    }
     
     delete iLargeObject;
     iLargeObject = NULL;
@@ -68,7 +78,7 @@ bool StorageHandler::addItem( const ItemId& aItemId,
                               const QString& aType,
                               const QString& aFormat,
                               const QString& aVersion,
-                              const QString& aData )
+                              const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -93,7 +103,7 @@ bool StorageHandler::addItem( const ItemId& aItemId,
     newItem->setFormat( aFormat );
     newItem->setVersion( aVersion );
 
-    if( !newItem->write( 0, aData.toUtf8() ) ) {
+    if( !newItem->write( 0, aData ) ) {
         delete newItem;
         qCCritical(lcSyncML) << "Could not write to item";
         return false;
@@ -112,7 +122,7 @@ bool StorageHandler::replaceItem( const ItemId& aItemId,
                                   const QString& aType,
                                   const QString& aFormat,
                                   const QString& aVersion,
-                                  const QString& aData )
+                                  const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -141,7 +151,7 @@ bool StorageHandler::replaceItem( const ItemId& aItemId,
     item->setFormat( aFormat );
     item->setVersion( aVersion );
 
-    if( !item->write( 0, aData.toUtf8() ) ) {
+    if( !item->write( 0, aData ) ) {
         delete item;
         qCCritical(lcSyncML) << "Could not write to item";
         return false;
@@ -284,7 +294,7 @@ bool StorageHandler::matchesLargeObject( const QString& aKey )
 
 }
 
-bool StorageHandler::appendLargeObjectData( const QString& aData )
+bool StorageHandler::appendLargeObjectData( const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -293,7 +303,7 @@ bool StorageHandler::appendLargeObjectData( const QString& aData )
         return false;
     }
 
-    if( iLargeObject->write( iLargeObject->getSize(), aData.toUtf8() ) ) {
+    if( iLargeObject->write( iLargeObject->getSize(), aData ) ) {
         return true;
     }
     else {
@@ -445,19 +455,242 @@ QMap<ItemId, CommitResult> StorageHandler::commitAddedItems( StoragePlugin& aPlu
     QMap<ItemId, CommitResult> results = resolveConflicts (aConflictResolver, iAddList, COMMIT_INIT_ADD);    
     QList<ItemId> addIds = iAddList.keys();
     QList<SyncItem*> addItems = iAddList.values();
+    iAddList.clear();
 
     qCDebug(lcSyncML) << "Committing" << addItems.count() << "added items";
 
     QList<StoragePlugin::StoragePluginStatus> addStatus = aPlugin.addItems( addItems );
 
-    for( int i = 0; i < addStatus.count(); ++i ) {
+    processAddResults( aPlugin, addIds, addItems, addStatus, results );
+
+    return results;
+}
+
+QMap<ItemId, CommitResult> StorageHandler::commitReplacedItems( StoragePlugin& aPlugin,
+                                                                ConflictResolver* aConflictResolver )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMap<ItemId, CommitResult> results = resolveConflicts (aConflictResolver, iReplaceList, COMMIT_INIT_REPLACE);
+
+    QList<ItemId> replaceIds = iReplaceList.keys();
+    QList<SyncItem*> replaceItems = iReplaceList.values();
+    iReplaceList.clear();
+
+    qCDebug(lcSyncML) << "Committing" << replaceItems.count() << "replaced items";
+
+    QList<StoragePlugin::StoragePluginStatus> replaceStatus = aPlugin.replaceItems( replaceItems );
+
+    processReplaceResults( aPlugin, replaceIds, replaceItems, replaceStatus, results );
+
+    return results;
+
+}
+
+QMap<ItemId, CommitResult> StorageHandler::commitDeletedItems( StoragePlugin& aPlugin,
+                                                               ConflictResolver* aConflictResolver )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMap<ItemId, CommitResult> results = resolveConflicts (aConflictResolver, iDeleteList, COMMIT_INIT_DELETE);
+    QList<ItemId> deleteIds = iDeleteList.keys();
+    QList<SyncItemKey> deleteItems = iDeleteList.values();
+    iDeleteList.clear();
+
+    qCDebug(lcSyncML) << "Committing" << deleteItems.count() << "deleted items";
+
+    QList<StoragePlugin::StoragePluginStatus> deleteStatus = aPlugin.deleteItems( deleteItems );
+
+    processDeleteResults( aPlugin, deleteIds, deleteItems, deleteStatus, results );
 
-        CommitResult& result = results[addIds[i]];
-        result.iItemKey = *addItems[i]->getKey();
+    return results;
+
+}
+
+void StorageHandler::startCommit( StoragePlugin& aPlugin, ConflictResolver* aConflictResolver )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    Q_ASSERT( iCommitStage == COMMIT_STAGE_NONE );
+
+    iCommitPlugin = &aPlugin;
+    iAsyncCommitPlugin = dynamic_cast<AsyncStoragePlugin*>( &aPlugin );
+    iCommitResolver = aConflictResolver;
+    iCommitResults.clear();
+
+    commitNextStage();
+}
+
+void StorageHandler::cancelCommit()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !commitInProgress() ) {
+        return;
+    }
+
+    qCDebug(lcSyncML) << "Cancelling commit";
+
+    // Synchronous commits never remain in progress, so the plugin is an
+    // asynchronous one. Once it returns, items of the commit are not used
+    if( iAsyncCommitPlugin ) {
+        iAsyncCommitPlugin->cancelCommit( *this );
+    }
+
+    qDeleteAll( iCommitItems );
+    iCommitItems.clear();
+    iCommitIds.clear();
+    iCommitKeys.clear();
+    iStageResults.clear();
+    iCommitResults.clear();
+
+    iCommitStage = COMMIT_STAGE_NONE;
+    iCommitPlugin = NULL;
+    iAsyncCommitPlugin = NULL;
+    iCommitResolver = NULL;
+}
+
+bool StorageHandler::commitInProgress() const
+{
+    return iCommitStage != COMMIT_STAGE_NONE;
+}
+
+QMap<ItemId, CommitResult> StorageHandler::takeCommitResults()
+{
+    QMap<ItemId, CommitResult> results = iCommitResults;
+    iCommitResults.clear();
+    return results;
+}
+
+void StorageHandler::commitCompleted( const QList<StoragePlugin::StoragePluginStatus>& aStatuses )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    switch( iCommitStage )
+    {
+        case COMMIT_STAGE_ADD:
+        {
+            processAddResults( *iCommitPlugin, iCommitIds, iCommitItems, aStatuses, iStageResults );
+            break;
+        }
+        case COMMIT_STAGE_REPLACE:
+        {
+            processReplaceResults( *iCommitPlugin, iCommitIds, iCommitItems, aStatuses, iStageResults );
+            break;
+        }
+        case COMMIT_STAGE_DELETE:
+        {
+            processDeleteResults( *iCommitPlugin, iCommitIds, iCommitKeys, aStatuses, iStageResults );
+            break;
+        }
+        default:
+        {
+            qCWarning(lcSyncML) << "Unexpected commit results from storage plugin";
+            return;
+        }
+    }
+
+    iCommitResults.unite( iStageResults );
+    iStageResults.clear();
+    iCommitIds.clear();
+    iCommitItems.clear();
+    iCommitKeys.clear();
+
+    commitNextStage();
+}
+
+void StorageHandler::commitNextStage()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Stages follow each other in the same order as with synchronous commits,
+    // so that each request to the plugin is started only after the previous
+    // one has completed
+    switch( iCommitStage )
+    {
+        case COMMIT_STAGE_NONE:
+        {
+            iCommitStage = COMMIT_STAGE_ADD;
+            iStageResults = resolveConflicts( iCommitResolver, iAddList, COMMIT_INIT_ADD );
+            iCommitIds = iAddList.keys();
+            iCommitItems = iAddList.values();
+            iAddList.clear();
+
+            qCDebug(lcSyncML) << "Starting to commit" << iCommitItems.count() << "added items";
+
+            if( iAsyncCommitPlugin ) {
+                iAsyncCommitPlugin->addItemsAsync( iCommitItems, *this );
+            }
+            else {
+                commitCompleted( iCommitPlugin->addItems( iCommitItems ) );
+            }
+            break;
+        }
+        case COMMIT_STAGE_ADD:
+        {
+            iCommitStage = COMMIT_STAGE_REPLACE;
+            iStageResults = resolveConflicts( iCommitResolver, iReplaceList, COMMIT_INIT_REPLACE );
+            iCommitIds = iReplaceList.keys();
+            iCommitItems = iReplaceList.values();
+            iReplaceList.clear();
+
+            qCDebug(lcSyncML) << "Starting to commit" << iCommitItems.count() << "replaced items";
+
+            if( iAsyncCommitPlugin ) {
+                iAsyncCommitPlugin->replaceItemsAsync( iCommitItems, *this );
+            }
+            else {
+                commitCompleted( iCommitPlugin->replaceItems( iCommitItems ) );
+            }
+            break;
+        }
+        case COMMIT_STAGE_REPLACE:
+        {
+            iCommitStage = COMMIT_STAGE_DELETE;
+            iStageResults = resolveConflicts( iCommitResolver, iDeleteList, COMMIT_INIT_DELETE );
+            iCommitIds = iDeleteList.keys();
+            iCommitKeys = iDeleteList.values();
+            iDeleteList.clear();
+
+            qCDebug(lcSyncML) << "Starting to commit" << iCommitKeys.count() << "deleted items";
+
+            if( iAsyncCommitPlugin ) {
+                iAsyncCommitPlugin->deleteItemsAsync( iCommitKeys, *this );
+            }
+            else {
+                commitCompleted( iCommitPlugin->deleteItems( iCommitKeys ) );
+            }
+            break;
+        }
+        case COMMIT_STAGE_DELETE:
+        default:
+        {
+            iCommitStage = COMMIT_STAGE_NONE;
+            iCommitPlugin = NULL;
+            iAsyncCommitPlugin = NULL;
+            iCommitResolver = NULL;
+
+            qCDebug(lcSyncML) << "Commit finished";
+            emit commitFinished();
+            break;
+        }
+    }
+}
+
+void StorageHandler::processAddResults( StoragePlugin& aPlugin, const QList<ItemId>& aIds, const QList<SyncItem*>& aItems,
+                                        const QList<StoragePlugin::StoragePluginStatus>& aStatuses,
+                                        QMap<ItemId, CommitResult>& aResults )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    for( int i = 0; i < aStatuses.count(); ++i ) {
+
+        CommitResult& result = aResults[aIds[i]];
+        result.iItemKey = *aItems[i]->getKey();
         
-        qCDebug(lcSyncML) << "Item" << addIds[i].iCmdId << "/" << addIds[i].iItemIndex << "committed";
+        qCDebug(lcSyncML) << "Item" << aIds[i].iCmdId << "/" << aIds[i].iItemIndex << "committed";
 
-        switch( addStatus[i] )
+        switch( aStatuses[i] )
         {
 
             case StoragePlugin::STATUS_OK:
@@ -466,7 +699,7 @@ QMap<ItemId, CommitResult> StorageHandler::commitAddedItems( StoragePlugin& aPlu
                 result.iStatus = COMMIT_ADDED;
                 
 		emit itemProcessed( MOD_ITEM_ADDED, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() , addItems[i]->getType(), addItems.count() );
+                                    aPlugin.getSourceURI() , aItems[i]->getType(), aItems.count() );
 
                 break;
             }
@@ -476,52 +709,39 @@ QMap<ItemId, CommitResult> StorageHandler::commitAddedItems( StoragePlugin& aPlu
                 result.iStatus = COMMIT_DUPLICATE;
 
                 emit itemProcessed( MOD_ITEM_ADDED, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() , addItems[i]->getType(), addItems.count() );
+                                    aPlugin.getSourceURI() , aItems[i]->getType(), aItems.count() );
 
                 break;
             }
             default:
             {
-                result.iStatus = generalStatus( addStatus[i] );
+                result.iStatus = generalStatus( aStatuses[i] );
 
                 emit itemProcessed( MOD_ITEM_ERROR, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() , addItems[i]->getType(), addItems.count() );
+                                    aPlugin.getSourceURI() , aItems[i]->getType(), aItems.count() );
 
                 break;
             }
 
         }
 
-        results.insert( addIds[i], result );
-
     }
 
-    qDeleteAll( addItems );
-    iAddList.clear();
-
-    return results;
+    qDeleteAll( aItems );
 }
 
-QMap<ItemId, CommitResult> StorageHandler::commitReplacedItems( StoragePlugin& aPlugin,
-                                                                ConflictResolver* aConflictResolver )
+void StorageHandler::processReplaceResults( StoragePlugin& aPlugin, const QList<ItemId>& aIds, const QList<SyncItem*>& aItems,
+                                            const QList<StoragePlugin::StoragePluginStatus>& aStatuses,
+                                            QMap<ItemId, CommitResult>& aResults )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    QMap<ItemId, CommitResult> results = resolveConflicts (aConflictResolver, iReplaceList, COMMIT_INIT_REPLACE);
-
-    QList<ItemId> replaceIds = iReplaceList.keys();
-    QList<SyncItem*> replaceItems = iReplaceList.values();
-
-    qCDebug(lcSyncML) << "Committing" << replaceItems.count() << "replaced items";
-
-    QList<StoragePlugin::StoragePluginStatus> replaceStatus = aPlugin.replaceItems( replaceItems );
-
-    for( int i = 0; i < replaceStatus.count(); ++i ) {
+    for( int i = 0; i < aStatuses.count(); ++i ) {
 
-        CommitResult& result = results[replaceIds[i]];
-        qCDebug(lcSyncML) << "Item" << replaceIds[i].iCmdId << "/" << replaceIds[i].iItemIndex << "committed";
+        CommitResult& result = aResults[aIds[i]];
+        qCDebug(lcSyncML) << "Item" << aIds[i].iCmdId << "/" << aIds[i].iItemIndex << "committed";
 
-        switch( replaceStatus[i] )
+        switch( aStatuses[i] )
         {
 
             case StoragePlugin::STATUS_OK:
@@ -530,7 +750,7 @@ QMap<ItemId, CommitResult> StorageHandler::commitReplacedItems( StoragePlugin& a
                 result.iStatus = COMMIT_REPLACED;
 
                 emit itemProcessed( MOD_ITEM_MODIFIED, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() , replaceItems[i]->getType(), replaceItems.count() );
+                                    aPlugin.getSourceURI() , aItems[i]->getType(), aItems.count() );
 
                 break;
             }
@@ -540,16 +760,16 @@ QMap<ItemId, CommitResult> StorageHandler::commitReplacedItems( StoragePlugin& a
                 result.iStatus = COMMIT_DUPLICATE;
 
                 emit itemProcessed( MOD_ITEM_MODIFIED, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() , replaceItems[i]->getType(), replaceItems.count() );
+                                    aPlugin.getSourceURI() , aItems[i]->getType(), aItems.count() );
 
                 break;
             }
             default:
             {
-                result.iStatus = generalStatus( replaceStatus[i] );
+                result.iStatus = generalStatus( aStatuses[i] );
 
                 emit itemProcessed( MOD_ITEM_ERROR, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() , replaceItems[i]->getType(), replaceItems.count() );
+                                    aPlugin.getSourceURI() , aItems[i]->getType(), aItems.count() );
 
                 break;
             }
@@ -558,33 +778,22 @@ QMap<ItemId, CommitResult> StorageHandler::commitReplacedItems( StoragePlugin& a
 
     }
 
-    qDeleteAll( iReplaceList );
-    iReplaceList.clear();
-
-    return results;
-
+    qDeleteAll( aItems );
 }
 
-QMap<ItemId, CommitResult> StorageHandler::commitDeletedItems( StoragePlugin& aPlugin,
-                                                               ConflictResolver* aConflictResolver )
+void StorageHandler::processDeleteResults( StoragePlugin& aPlugin, const QList<ItemId>& aIds, const QList<SyncItemKey>& aKeys,
+                                           const QList<StoragePlugin::StoragePluginStatus>& aStatuses,
+                                           QMap<ItemId, CommitResult>& aResults )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    QMap<ItemId, CommitResult> results = resolveConflicts (aConflictResolver, iDeleteList, COMMIT_INIT_DELETE);
-    QList<ItemId> deleteIds = iDeleteList.keys();
-    QList<SyncItemKey> deleteItems = iDeleteList.values();
-
-    qCDebug(lcSyncML) << "Committing" << deleteItems.count() << "deleted items";
-
-    QList<StoragePlugin::StoragePluginStatus> deleteStatus = aPlugin.deleteItems( deleteItems );
-
-    for( int i = 0; i < deleteStatus.count(); ++i ) {
+    for( int i = 0; i < aStatuses.count(); ++i ) {
 
-        CommitResult& result = results[deleteIds[i]];
+        CommitResult& result = aResults[aIds[i]];
 
-        qCDebug(lcSyncML) << "Item" << deleteIds[i].iCmdId << "/" << deleteIds[i].iItemIndex << "committed";
+        qCDebug(lcSyncML) << "Item" << aIds[i].iCmdId << "/" << aIds[i].iItemIndex << "committed";
 
-        switch( deleteStatus[i] )
+        switch( aStatuses[i] )
         {
 
             case StoragePlugin::STATUS_OK:
@@ -593,7 +802,7 @@ QMap<ItemId, CommitResult> StorageHandler::commitDeletedItems( StoragePlugin& aP
                 result.iStatus = COMMIT_DELETED;
 
                 emit itemProcessed( MOD_ITEM_DELETED, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() ,aPlugin.getFormatInfo().getPreferredRx().iType, deleteItems.count() );
+                                    aPlugin.getSourceURI() ,aPlugin.getFormatInfo().getPreferredRx().iType, aKeys.count() );
 
                 break;
             }
@@ -603,16 +812,16 @@ QMap<ItemId, CommitResult> StorageHandler::commitDeletedItems( StoragePlugin& aP
                 result.iStatus = COMMIT_NOT_DELETED;
 
                 emit itemProcessed( MOD_ITEM_DELETED, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() ,aPlugin.getFormatInfo().getPreferredRx().iType, deleteItems.count() );
+                                    aPlugin.getSourceURI() ,aPlugin.getFormatInfo().getPreferredRx().iType, aKeys.count() );
 
                 break;
             }
             default:
             {
-                result.iStatus = generalStatus( deleteStatus[i] );
+                result.iStatus = generalStatus( aStatuses[i] );
 
                 emit itemProcessed( MOD_ITEM_ERROR, MOD_LOCAL_DATABASE,
-                                    aPlugin.getSourceURI() ,aPlugin.getFormatInfo().getPreferredRx().iType, deleteItems.count() );
+                                    aPlugin.getSourceURI() ,aPlugin.getFormatInfo().getPreferredRx().iType, aKeys.count() );
 
                 break;
             }
@@ -621,10 +830,6 @@ QMap<ItemId, CommitResult> StorageHandler::commitDeletedItems( StoragePlugin& aP
 
     }
 
-    iDeleteList.clear();
-
-    return results;
-
 }
 
 CommitStatus StorageHandler::generalStatus( StoragePlugin::StoragePluginStatus aStatus ) const
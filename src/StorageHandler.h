@@ -41,6 +41,7 @@
 #include "SyncAgentConsts.h"
 #include "SyncItemKey.h"
 #include "StoragePlugin.h"
+#include "AsyncStoragePlugin.h"
 
 namespace DataSync {
 
@@ -125,7 +126,7 @@ struct ItemId
 /*! \brief Utility class for storing items into local database
  *
  */
-class StorageHandler : public QObject
+class StorageHandler : public QObject, public StorageCommitObserver
 {
     Q_OBJECT;
 public:
@@ -149,7 +150,7 @@ public:
      * @param aType MIME type of the item
      * @param aFormat Format of the item
      * @param aVersion Version of the item
-     * @param aData Data of the item
+     * @param aData UTF-8 encoded data of the item
      *
      */
     bool addItem( const ItemId& aItemId,
@@ -159,7 +160,7 @@ public:
                   const QString& aType,
                   const QString& aFormat,
                   const QString& aVersion,
-                  const QString& aData);
+                  const QByteArray& aData);
 
     /*! \brief Replaces an existing item in local database
      *
@@ -170,7 +171,7 @@ public:
      * @param aType MIME type of the item
      * @param aFormat Format of the item
      * @param aVersion Version of the item
-     * @param aData Data of the item
+     * @param aData UTF-8 encoded data of the item
      */
     bool replaceItem( const ItemId& aItemId,
                       StoragePlugin& aPlugin,
@@ -179,7 +180,7 @@ public:
                       const QString& aType,
                       const QString& aFormat,
                       const QString& aVersion,
-                      const QString& aData);
+                      const QByteArray& aData);
 
     /*! \brief Deletes an existing item in local database
      *
@@ -245,10 +246,10 @@ public:
      *
      * Automatically aborts large object if false is returned
      *
-     * @param aData Data to append
+     * @param aData UTF-8 encoded data to append
      * @return True if append was successful, otherwise false
      */
-    bool appendLargeObjectData( const QString& aData );
+    bool appendLargeObjectData( const QByteArray& aData );
 
     /*! \brief Finishes the large object being composed
      *
@@ -306,6 +307,47 @@ public:
     QMap<ItemId, CommitResult> commitDeletedItems( StoragePlugin& aPlugin,
                                                    ConflictResolver* aConflictResolver );
 
+    /*! \brief Starts committing added, replaced and deleted items to local database
+     *
+     * Items are committed in the same order as with the commit functions
+     * above. If the plugin implements AsyncStoragePlugin, its asynchronous
+     * API is used. Signal commitFinished() is emitted when all items have
+     * been committed, after which results can be retrieved with
+     * takeCommitResults(). With plugins that only implement the synchronous
+     * API, the signal is emitted before this function returns.
+     *
+     * @param aPlugin Local storage plugin
+     * @param aConflictResolver If conflict resolution is to be done, conflict resolver.
+     *        Otherwise NULL
+     */
+    void startCommit( StoragePlugin& aPlugin, ConflictResolver* aConflictResolver );
+
+    /*! \brief Returns true if a commit started with startCommit() is in progress
+     *
+     * @return True if commit is in progress, otherwise false
+     */
+    bool commitInProgress() const;
+
+    /*! \brief Cancels a commit started with startCommit()
+     *
+     * Must be called before the storage plugin of the commit is released.
+     * Plugin stops reporting results, and items that were not committed
+     * yet are discarded. commitFinished() is not emitted.
+     */
+    void cancelCommit();
+
+    /*! \brief Returns and clears the results of the last commit started with startCommit()
+     *
+     * @return Commit results
+     */
+    QMap<ItemId, CommitResult> takeCommitResults();
+
+    /*! \brief Called by storage plugin when an asynchronous commit has completed
+     *
+     * @param aStatuses List of status codes corresponding to each item of the commit
+     */
+    virtual void commitCompleted( const QList<StoragePlugin::StoragePluginStatus>& aStatuses );
+
 signals:
 
     /*! \brief Signal indicating that an item has been processed
@@ -319,8 +361,36 @@ signals:
     void itemProcessed( DataSync::ModificationType aModificationType,
                         DataSync::ModifiedDatabase aModifiedDatabase,
                         const QString aDatabase,const QString aMimeType, int aCommittedItems);
+
+    /*! \brief Signal indicating that a commit started with startCommit() has finished
+     *
+     */
+    void commitFinished();
+
 private:
 
+    enum CommitStage
+    {
+        COMMIT_STAGE_NONE,
+        COMMIT_STAGE_ADD,
+        COMMIT_STAGE_REPLACE,
+        COMMIT_STAGE_DELETE
+    };
+
+    void commitNextStage();
+
+    void processAddResults( StoragePlugin& aPlugin, const QList<ItemId>& aIds, const QList<SyncItem*>& aItems,
+                            const QList<StoragePlugin::StoragePluginStatus>& aStatuses,
+                            QMap<ItemId, CommitResult>& aResults );
+
+    void processReplaceResults( StoragePlugin& aPlugin, const QList<ItemId>& aIds, const QList<SyncItem*>& aItems,
+                                const QList<StoragePlugin::StoragePluginStatus>& aStatuses,
+                                QMap<ItemId, CommitResult>& aResults );
+
+    void processDeleteResults( StoragePlugin& aPlugin, const QList<ItemId>& aIds, const QList<SyncItemKey>& aKeys,
+                               const QList<StoragePlugin::StoragePluginStatus>& aStatuses,
+                               QMap<ItemId, CommitResult>& aResults );
+
     CommitStatus generalStatus( StoragePlugin::StoragePluginStatus aStatus ) const;
 
     QMap<ItemId, SyncItem*>    iAddList;
@@ -331,6 +401,16 @@ private:
     qint64                     iLargeObjectSize;
     QString                    iLargeObjectKey;
 
+    StoragePlugin*             iCommitPlugin;
+    AsyncStoragePlugin*        iAsyncCommitPlugin;
+    ConflictResolver*          iCommitResolver;
+    CommitStage                iCommitStage;
+    QList<ItemId>              iCommitIds;
+    QList<SyncItem*>           iCommitItems;
+    QList<SyncItemKey>         iCommitKeys;
+    QMap<ItemId, CommitResult> iStageResults;
+    QMap<ItemId, CommitResult> iCommitResults;
+
     friend class StorageHandlerTest;
 };
 
@@ -272,6 +272,14 @@ void SyncAgent::receiveItemProcessed( DataSync::ModificationType aModificationTy
 
 }
 
+void SyncAgent::receivePrefetchStatistics( const QString aLocalDatabase, int aHits,
+                                           int aStalls, qint64 aStallTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iResults.addPrefetchStatistics( aLocalDatabase, aHits, aStalls, aStallTime );
+}
+
 void SyncAgent::finishSync( DataSync::SyncState aState, const QString& aErrorString )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -359,6 +367,10 @@ bool SyncAgent::startClientInitiatedSession( const SyncAgentConfig& aConfig )
              DataSync::ModifiedDatabase,QString,QString,int ) ),
              Qt::QueuedConnection );
 
+    connect( handler, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ),
+             this, SLOT( receivePrefetchStatistics( QString, int, int, qint64 ) ),
+             Qt::QueuedConnection );
+
     qCDebug(lcSyncML) << "SyncAgent: Everything OK, starting synchronization...";
 
     // * Begin synchronization session
@@ -396,6 +408,10 @@ bool SyncAgent::startServerInitiatedSession( const SyncAgentConfig& aConfig )
              DataSync::ModifiedDatabase,QString,QString,int ) ),
              Qt::QueuedConnection );
 
+    connect( handler, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ),
+             this, SLOT( receivePrefetchStatistics( QString, int, int, qint64 ) ),
+             Qt::QueuedConnection );
+
     qCDebug(lcSyncML) << "SyncAgent: Everything OK, starting synchronization...";
 
     // * Begin synchronization session
@@ -514,6 +530,10 @@ void SyncAgent::listenEvent()
                  DataSync::ModifiedDatabase,QString,QString,int ) ),
                  Qt::QueuedConnection );
 
+        connect( handler, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ),
+                 this, SLOT( receivePrefetchStatistics( QString, int, int, qint64 ) ),
+                 Qt::QueuedConnection );
+
         qCDebug(lcSyncML) << "SyncAgent: Everything OK, starting synchronization...";
 
         // * Begin synchronization session
@@ -545,6 +565,10 @@ void SyncAgent::listenEvent()
                  DataSync::ModifiedDatabase,QString,QString,int ) ),
                  Qt::QueuedConnection );
 
+        connect( handler, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ),
+                 this, SLOT( receivePrefetchStatistics( QString, int, int, qint64 ) ),
+                 Qt::QueuedConnection );
+
         qCDebug(lcSyncML) << "SyncAgent: Everything OK, starting synchronization...";
 
         // * Begin synchronization session
@@ -576,6 +600,10 @@ void SyncAgent::listenEvent()
                  DataSync::ModifiedDatabase,QString,QString,int ) ),
                  Qt::QueuedConnection );
 
+        connect( handler, SIGNAL( prefetchStatistics( QString, int, int, qint64 ) ),
+                 this, SLOT( receivePrefetchStatistics( QString, int, int, qint64 ) ),
+                 Qt::QueuedConnection );
+
         qCDebug(lcSyncML) << "SyncAgent: Everything OK, starting synchronization...";
 
         // * Begin synchronization session
@@ -724,6 +724,9 @@ private slots:
                                const QString aDatabase,
                                const QString aMimeType, int aCommittedItems );
 
+    void receivePrefetchStatistics( const QString aLocalDatabase, int aHits,
+                                    int aStalls, qint64 aStallTime );
+
 
     void listenEvent();
 
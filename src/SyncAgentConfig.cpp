@@ -489,6 +489,69 @@ bool SyncAgentConfig::parseAgentProps( QXmlStreamReader& aReader )
                 qCDebug(lcSyncML) << "Found agent property" << OMITDATAUPDATESTATUSPROP <<":" << omitDataUpdateStatus;
                 setAgentProperty( OMITDATAUPDATESTATUSPROP, omitDataUpdateStatus );
             }
+            else if( aReader.name() == THREADEDPARSINGPROP )
+            {
+                aReader.readNext();
+                QString threadedParsing = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << THREADEDPARSINGPROP <<":" << threadedParsing;
+                setAgentProperty( THREADEDPARSINGPROP, threadedParsing );
+            }
+            else if( aReader.name() == WBXMLSTRINGTABLEPROP )
+            {
+                aReader.readNext();
+                QString stringTable = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << WBXMLSTRINGTABLEPROP <<":" << stringTable;
+                setAgentProperty( WBXMLSTRINGTABLEPROP, stringTable );
+            }
+            else if( aReader.name() == EXACTPACKINGPROP )
+            {
+                aReader.readNext();
+                QString exactPacking = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << EXACTPACKINGPROP <<":" << exactPacking;
+                setAgentProperty( EXACTPACKINGPROP, exactPacking );
+            }
+            else if( aReader.name() == MESSAGEPIPELININGPROP )
+            {
+                aReader.readNext();
+                QString pipelining = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << MESSAGEPIPELININGPROP <<":" << pipelining;
+                setAgentProperty( MESSAGEPIPELININGPROP, pipelining );
+            }
+            else if( aReader.name() == MULTIITEMCOMMANDSPROP )
+            {
+                aReader.readNext();
+                QString multiItemCommands = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << MULTIITEMCOMMANDSPROP <<":" << multiItemCommands;
+                setAgentProperty( MULTIITEMCOMMANDSPROP, multiItemCommands );
+            }
+            else if( aReader.name() == COMPACTSTATUSESPROP )
+            {
+                aReader.readNext();
+                QString compactStatuses = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << COMPACTSTATUSESPROP <<":" << compactStatuses;
+                setAgentProperty( COMPACTSTATUSESPROP, compactStatuses );
+            }
+            else if( aReader.name() == BACKGROUNDPREFETCHINGPROP )
+            {
+                aReader.readNext();
+                QString backgroundPrefetching = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << BACKGROUNDPREFETCHINGPROP <<":" << backgroundPrefetching;
+                setAgentProperty( BACKGROUNDPREFETCHINGPROP, backgroundPrefetching );
+            }
+            else if( aReader.name() == PREFETCHMEMORYBUDGETPROP )
+            {
+                aReader.readNext();
+                QString prefetchMemoryBudget = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << PREFETCHMEMORYBUDGETPROP <<":" << prefetchMemoryBudget;
+                setAgentProperty( PREFETCHMEMORYBUDGETPROP, prefetchMemoryBudget );
+            }
+            else if( aReader.name() == DEVINFMAXAGEPROP )
+            {
+                aReader.readNext();
+                QString devInfMaxAge = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found agent property" << DEVINFMAXAGEPROP <<":" << devInfMaxAge;
+                setAgentProperty( DEVINFMAXAGEPROP, devInfMaxAge );
+            }
 
         }
         else if( aReader.tokenType() == QXmlStreamReader::EndElement &&
@@ -563,6 +626,34 @@ bool SyncAgentConfig::parseTransportProps( QXmlStreamReader& aReader )
                 qCDebug(lcSyncML) << "Found transport property" << HTTPPROXYPORTPROP <<":" << proxyPort;
                 setTransportProperty( HTTPPROXYPORTPROP, proxyPort );
             }
+            else if( aReader.name() == HTTPCONTENTENCODINGPROP )
+            {
+                aReader.readNext();
+                QString contentEncoding = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << HTTPCONTENTENCODINGPROP <<":" << contentEncoding;
+                setTransportProperty( HTTPCONTENTENCODINGPROP, contentEncoding );
+            }
+            else if( aReader.name() == WBXMLNATIVEDECODINGPROP )
+            {
+                aReader.readNext();
+                QString nativeDecoding = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << WBXMLNATIVEDECODINGPROP <<":" << nativeDecoding;
+                setTransportProperty( WBXMLNATIVEDECODINGPROP, nativeDecoding );
+            }
+            else if( aReader.name() == WBXMLNATIVEENCODINGPROP )
+            {
+                aReader.readNext();
+                QString nativeEncoding = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << WBXMLNATIVEENCODINGPROP <<":" << nativeEncoding;
+                setTransportProperty( WBXMLNATIVEENCODINGPROP, nativeEncoding );
+            }
+            else if( aReader.name() == INCREMENTALPARSINGPROP )
+            {
+                aReader.readNext();
+                QString incrementalParsing = aReader.text().toString();
+                qCDebug(lcSyncML) << "Found transport property" << INCREMENTALPARSINGPROP <<":" << incrementalParsing;
+                setTransportProperty( INCREMENTALPARSINGPROP, incrementalParsing );
+            }
 
         }
         else if( aReader.tokenType() == QXmlStreamReader::EndElement &&
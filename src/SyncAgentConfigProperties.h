@@ -52,6 +52,46 @@ const QString FASTMAPSSENDPROP( "fast-maps-send" );
 // (as client) when there are no changes on the server side
 const QString OMITDATAUPDATESTATUSPROP( "omit-data-update-status" );
 
+// Property to control whether incoming messages are parsed in a thread of
+// their own instead of the thread running the session
+const QString THREADEDPARSINGPROP( "threaded-parsing" );
+
+// Property to control whether strings that repeat in outgoing WbXML messages
+// are placed in a string table
+const QString WBXMLSTRINGTABLEPROP( "wbxml-string-table" );
+
+// Property to control whether outgoing messages are filled using exact
+// encoded sizes instead of estimates
+const QString EXACTPACKINGPROP( "exact-message-packing" );
+
+// Property to control whether the next outgoing message is prepared while
+// waiting for the response to the previous one
+const QString MESSAGEPIPELININGPROP( "message-pipelining" );
+
+// Property to control whether consecutive local changes of the same type
+// are sent as items of a single command
+const QString MULTIITEMCOMMANDSPROP( "multi-item-commands" );
+
+// Property to control whether statuses of several items refer to them with
+// TargetRef and SourceRef elements instead of Item elements. Remote device
+// info is not consulted, so statuses are sent this way to any peer. Peers
+// that do not support several references in a Status will reject them, so
+// this should only be enabled for peers known to accept them
+const QString COMPACTSTATUSESPROP( "compact-statuses" );
+
+// Property to control whether local changes are fetched from storage in a
+// background thread ahead of sending them. Applies only to storage plugins
+// that inherit ConcurrentFetchStoragePlugin
+const QString BACKGROUNDPREFETCHINGPROP( "background-prefetching" );
+
+// Property to control the maximum number of bytes of local changes kept
+// fetched ahead of sending them. 0 means no limit
+const QString PREFETCHMEMORYBUDGETPROP( "prefetch-memory-budget" );
+
+// Property to control the maximum age in seconds of stored remote device
+// info before it is requested again. 0 means no limit
+const QString DEVINFMAXAGEPROP( "devinf-max-age" );
+
 // Property to control the maximum transfer unit of OBEX over BT
 const QString OBEXMTUBTPROP( "obex-mtu-bt" );
 
@@ -75,6 +115,22 @@ const QString HTTPPROXYHOSTPROP( "http-proxy-host" );
 // Property to control the port of http proxy
 const QString HTTPPROXYPORTPROP( "http-proxy-port" );
 
+// Property to control compression of HTTP requests and responses. Supported
+// values are "gzip" and "deflate", anything else disables compression
+const QString HTTPCONTENTENCODINGPROP( "http-content-encoding" );
+
+// Property to control whether incoming WbXML messages are decoded directly
+// to protocol fragments instead of converting them first to XML
+const QString WBXMLNATIVEDECODINGPROP( "wbxml-native-decoding" );
+
+// Property to control whether outgoing WbXML messages are encoded directly
+// from protocol objects instead of using libwbxml2
+const QString WBXMLNATIVEENCODINGPROP( "wbxml-native-encoding" );
+
+// Property to control whether incoming XML messages are parsed while they
+// are still being received
+const QString INCREMENTALPARSINGPROP( "incremental-parsing" );
+
 // Property to control EMI tags extension
 const QString EMITAGSEXTENSION( "emi-tags" );
 
@@ -33,17 +33,51 @@
 
 #include "SyncItemPrefetcher.h"
 
+#include <QThread>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
 #include "SyncItem.h"
 #include "StoragePlugin.h"
+#include "ConcurrentFetchStoragePlugin.h"
 
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
+// Fetches taking longer than this make the background thread request
+// fewer items at a time, so that the first of them become available sooner
+const qint64 SLOWFETCHTHRESHOLD = 100;
+
+namespace DataSync
+{
+
+/*! \brief Thread that runs the background fetching of SyncItemPrefetcher
+ *
+ */
+class PrefetchThread : public QThread
+{
+public:
+    PrefetchThread( SyncItemPrefetcher& aPrefetcher ) : iPrefetcher( aPrefetcher ) { }
+
+protected:
+    virtual void run()
+    {
+        iPrefetcher.fetchInBackground();
+    }
+
+private:
+    SyncItemPrefetcher& iPrefetcher;
+};
+
+}
+
 SyncItemPrefetcher::SyncItemPrefetcher( const QList<SyncItemKey>& aItemIds,
                                         StoragePlugin& aStoragePlugin,
                                         int aInitialBatchSizeHint )
- : iStoragePlugin( aStoragePlugin ), iItemIdList( aItemIds )
+ : iStoragePlugin( aStoragePlugin ), iItemIdList( aItemIds ), iMemoryBudget( 0 ),
+   iFetchedBytes( 0 ), iObservedBytes( 0 ), iObservedItems( 0 ), iFetchThread( NULL ),
+   iFetchBatchSize( 1 ), iStopping( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     iDefaultBatchSizeHint = aInitialBatchSizeHint;
@@ -54,6 +88,18 @@ SyncItemPrefetcher::~SyncItemPrefetcher()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    if( iFetchThread )
+    {
+        iMutex.lock();
+        iStopping = true;
+        iFetchCondition.wakeAll();
+        iMutex.unlock();
+
+        iFetchThread->wait();
+        delete iFetchThread;
+        iFetchThread = NULL;
+    }
+
     qDeleteAll( iFetchedItems.values() );
     iFetchedItems.clear();
 }
@@ -64,10 +110,74 @@ void SyncItemPrefetcher::setBatchSizeHint( int aBatchSizeHint )
     iBatchSizeHint = aBatchSizeHint;
 }
 
+void SyncItemPrefetcher::setMemoryBudget( qint64 aBytes )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMutexLocker locker( &iMutex );
+    iMemoryBudget = aBytes;
+    iFetchCondition.wakeAll();
+}
+
+bool SyncItemPrefetcher::startBackgroundFetching()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iFetchThread )
+    {
+        return true;
+    }
+
+    if( !dynamic_cast<ConcurrentFetchStoragePlugin*>( &iStoragePlugin ) )
+    {
+        qCWarning(lcSyncML) << "Storage plugin does not support fetching items from another thread,"
+                            << "prefetching items in the foreground";
+        return false;
+    }
+
+    qCDebug(lcSyncML) << "Starting background item prefetching";
+
+    iFetchBatchSize = qMax( iDefaultBatchSizeHint / 4, 1 );
+    iFetchThread = new PrefetchThread( *this );
+    iFetchThread->start();
+
+    return true;
+}
+
+PrefetchStatistics SyncItemPrefetcher::statistics() const
+{
+    QMutexLocker locker( &iMutex );
+    return iStatistics;
+}
+
 SyncItem* SyncItemPrefetcher::getItem( const SyncItemKey& aItemId )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    if( iFetchThread )
+    {
+        QMutexLocker locker( &iMutex );
+
+        if( iFetchedItems.contains( aItemId ) )
+        {
+            ++iStatistics.iHits;
+            return takeItem( aItemId );
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if( !waitForItem( aItemId ) )
+        {
+            return NULL;
+        }
+
+        ++iStatistics.iStalls;
+        iStatistics.iStallTime += timer.elapsed();
+
+        return takeItem( aItemId );
+    }
+
     if(!iBatchSizeHint)
     {
         iBatchSizeHint = iDefaultBatchSizeHint - iFetchedItems.count();
@@ -77,14 +187,61 @@ SyncItem* SyncItemPrefetcher::getItem( const SyncItemKey& aItemId )
     {
         // Prefetch hit: return item immediately
         qCDebug(lcSyncML) << "Item" << aItemId << "found from prefetched items";
-        return iFetchedItems.take( aItemId );
+        ++iStatistics.iHits;
+        return takeItem( aItemId );
     }
     else
     {
         // Prefetch miss: fetch more items
         qCDebug(lcSyncML) << "Item" << aItemId << "not found from prefetched items";
-        prefetch();
-        return iFetchedItems.take( aItemId );
+
+        QElapsedTimer timer;
+        timer.start();
+
+        fetchItem( aItemId );
+
+        ++iStatistics.iStalls;
+        iStatistics.iStallTime += timer.elapsed();
+
+        return takeItem( aItemId );
+    }
+}
+
+const SyncItem* SyncItemPrefetcher::peekItem( const SyncItemKey& aItemId )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iFetchThread )
+    {
+        QMutexLocker locker( &iMutex );
+
+        if( !iFetchedItems.contains( aItemId ) && !waitForItem( aItemId ) )
+        {
+            return NULL;
+        }
+
+        return iFetchedItems.value( aItemId );
+    }
+
+    if( !iFetchedItems.contains( aItemId ) )
+    {
+        fetchItem( aItemId );
+    }
+
+    return iFetchedItems.value( aItemId );
+}
+
+void SyncItemPrefetcher::returnItem( const SyncItemKey& aItemId, SyncItem* aItem )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMutexLocker locker( &iMutex );
+
+    iFetchedItems.insert( aItemId, aItem );
+
+    if( aItem )
+    {
+        iFetchedBytes += aItem->getSize();
     }
 }
 
@@ -92,59 +249,250 @@ void SyncItemPrefetcher::prefetch()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
+    if( iFetchThread )
+    {
+        // Background thread decides by itself how far to fetch
+        QMutexLocker locker( &iMutex );
+        iFetchCondition.wakeOne();
+        return;
+    }
+
     qCDebug(lcSyncML) << "Item prefetcher waking...";
 
     if( iFetchedItems.count() < iBatchSizeHint )
     {
 
         qCDebug(lcSyncML) << "Prefetch cache not full";
-        int batchSize = qMin( iBatchSizeHint, iItemIdList.size() );
+        int batchSize = budgetedBatchSize( qMin( iBatchSizeHint, iItemIdList.size() ) );
 
         if( batchSize > 0 )
         {
-            qCDebug(lcSyncML) << "Requesting" << batchSize << "items";
-            QList<SyncItemKey> nextItemIds = iItemIdList.mid( 0, batchSize );
-            QList<SyncItem*> nextItems = iStoragePlugin.getSyncItems( nextItemIds );
+            fetchNextBatch( batchSize );
+        }
+        else
+        {
+            qCDebug(lcSyncML) << "No more items remaining or memory budget in use, skipping item request";
+        }
+    }
+    else
+    {
+        qCDebug(lcSyncML) << "Prefetch cache is already full";
+    }
 
-            if( nextItems.count() != nextItemIds.count() )
-            {
-                // We cannot trust the ordering nor the integrity of the items returned by the backend, so just
-                // free them
-                qCWarning(lcSyncML) << "Asked for" << nextItemIds.count() << "items, got" << nextItems.count() << "items";
-                qDeleteAll( nextItems );
-                nextItems.clear();
-            }
+    qCDebug(lcSyncML) << iFetchedItems.count() << "items in prefetch cache," << iItemIdList.count() << "items still to fetch";
 
-            for ( int i = 0; i < nextItemIds.count(); ++i )
-            {
-                SyncItem* item = 0;
+    qCDebug(lcSyncML) << "Item prefetcher going to sleep...";
+}
 
-                for( int a = 0; a < nextItems.count(); ++a )
-                {
-                    if( nextItems[a] && nextItems[a]->getKey() == nextItemIds[i] )
-                    {
-                        item = nextItems[a];
-                        nextItems.removeAt( a );
-                    }
-                }
+void SyncItemPrefetcher::fetchNextBatch( int aBatchSize )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-                iFetchedItems.insert( nextItemIds[i], item );
+    qCDebug(lcSyncML) << "Requesting" << aBatchSize << "items";
+    QList<SyncItemKey> nextItemIds = iItemIdList.mid( 0, aBatchSize );
+    QList<SyncItem*> nextItems = iStoragePlugin.getSyncItems( nextItemIds );
 
+    storeItems( nextItemIds, nextItems );
+
+    iItemIdList = iItemIdList.mid( aBatchSize );
+}
+
+int SyncItemPrefetcher::budgetedBatchSize( int aMaxSize ) const
+{
+    if( iMemoryBudget <= 0 || aMaxSize <= 0 )
+    {
+        return aMaxSize;
+    }
+
+    if( iObservedItems == 0 )
+    {
+        // Nothing known about item sizes yet, start with a single item
+        return 1;
+    }
+
+    qint64 averageSize = qMax( iObservedBytes / iObservedItems, Q_INT64_C( 1 ) );
+    qint64 available = iMemoryBudget - iFetchedBytes;
+
+    if( available < averageSize )
+    {
+        return 0;
+    }
+
+    return static_cast<int>( qMin( available / averageSize, static_cast<qint64>( aMaxSize ) ) );
+}
+
+void SyncItemPrefetcher::storeItems( const QList<SyncItemKey>& aItemIds, QList<SyncItem*>& aItems )
+{
+    if( aItems.count() != aItemIds.count() )
+    {
+        // We cannot trust the ordering nor the integrity of the items returned by the backend, so just
+        // free them
+        qCWarning(lcSyncML) << "Asked for" << aItemIds.count() << "items, got" << aItems.count() << "items";
+        qDeleteAll( aItems );
+        aItems.clear();
+    }
+
+    for ( int i = 0; i < aItemIds.count(); ++i )
+    {
+        SyncItem* item = 0;
+
+        for( int a = 0; a < aItems.count(); ++a )
+        {
+            if( aItems[a] && aItems[a]->getKey() == aItemIds[i] )
+            {
+                item = aItems[a];
+                aItems.removeAt( a );
             }
+        }
 
-            iItemIdList = iItemIdList.mid( batchSize );
+        if( item )
+        {
+            qint64 size = item->getSize();
+            iFetchedBytes += size;
+            iObservedBytes += size;
+            ++iObservedItems;
         }
-        else
+
+        iFetchedItems.insert( aItemIds[i], item );
+
+    }
+}
+
+SyncItem* SyncItemPrefetcher::takeItem( const SyncItemKey& aItemId )
+{
+    SyncItem* item = iFetchedItems.take( aItemId );
+
+    if( item )
+    {
+        iFetchedBytes -= item->getSize();
+    }
+
+    return item;
+}
+
+void SyncItemPrefetcher::fetchItem( const SyncItemKey& aItemId )
+{
+    prefetch();
+
+    if( iMemoryBudget > 0 && !iFetchedItems.contains( aItemId ) &&
+        iItemIdList.contains( aItemId ) )
+    {
+        // Memory budget did not allow a batch, fetch the item alone
+        iItemIdList.removeOne( aItemId );
+        iItemIdList.prepend( aItemId );
+        fetchNextBatch( 1 );
+    }
+}
+
+bool SyncItemPrefetcher::waitForItem( const SyncItemKey& aItemId )
+{
+    // Called with iMutex locked
+
+    if( !iFetching.contains( aItemId ) )
+    {
+        int index = iItemIdList.indexOf( aItemId );
+
+        if( index < 0 )
         {
-            qCDebug(lcSyncML) << "No more items remaining, skipping item request";
+            qCDebug(lcSyncML) << "Item" << aItemId << "is not known to prefetcher";
+            return false;
         }
+
+        // Make sure the item is the next one to be fetched
+        iItemIdList.move( index, 0 );
     }
-    else
+
+    qCDebug(lcSyncML) << "Waiting for item" << aItemId << "to be fetched";
+
+    iWantedItem = aItemId;
+    iFetchCondition.wakeOne();
+
+    while( !iFetchedItems.contains( aItemId ) && !iStopping )
     {
-        qCDebug(lcSyncML) << "Prefetch cache is already full";
+        iItemCondition.wait( &iMutex );
     }
 
-    qCDebug(lcSyncML) << iFetchedItems.count() << "items in prefetch cache," << iItemIdList.count() << "items still to fetch";
+    iWantedItem.clear();
 
-    qCDebug(lcSyncML) << "Item prefetcher going to sleep...";
+    return iFetchedItems.contains( aItemId );
+}
+
+void SyncItemPrefetcher::fetchInBackground()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QMutexLocker locker( &iMutex );
+
+    while( !iStopping )
+    {
+        int batchSize = 0;
+
+        if( !iWantedItem.isNull() && !iFetchedItems.contains( iWantedItem ) &&
+            !iFetching.contains( iWantedItem ) )
+        {
+            // Wanted item is at the front of the list, fetch it regardless of budget
+            batchSize = qMax( budgetedBatchSize( qMin( iFetchBatchSize, iItemIdList.size() ) ), 1 );
+        }
+        else
+        {
+            int room = iDefaultBatchSizeHint - iFetchedItems.count() - iFetching.count();
+            batchSize = budgetedBatchSize( qMin( qMin( iFetchBatchSize, room ), iItemIdList.size() ) );
+        }
+
+        if( batchSize <= 0 || iItemIdList.isEmpty() )
+        {
+            iFetchCondition.wait( &iMutex );
+            continue;
+        }
+
+        QList<SyncItemKey> nextItemIds = iItemIdList.mid( 0, batchSize );
+        iItemIdList = iItemIdList.mid( batchSize );
+
+        for( int i = 0; i < nextItemIds.count(); ++i )
+        {
+            iFetching.insert( nextItemIds[i] );
+        }
+
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        QList<SyncItem*> nextItems = iStoragePlugin.getSyncItems( nextItemIds );
+        qint64 elapsed = timer.elapsed();
+
+        locker.relock();
+
+        for( int i = 0; i < nextItemIds.count(); ++i )
+        {
+            iFetching.remove( nextItemIds[i] );
+        }
+
+        storeItems( nextItemIds, nextItems );
+        adaptFetchBatchSize( nextItemIds.count(), elapsed );
+
+        qCDebug(lcSyncML) << "Fetched" << nextItemIds.count() << "items in" << elapsed << "ms,"
+                          << iFetchedItems.count() << "items in prefetch cache,"
+                          << iItemIdList.count() << "items still to fetch";
+
+        iItemCondition.wakeAll();
+    }
+
+    iItemCondition.wakeAll();
+}
+
+void SyncItemPrefetcher::adaptFetchBatchSize( int aItemCount, qint64 aElapsed )
+{
+    int maxBatchSize = qMax( iDefaultBatchSizeHint, 1 );
+
+    if( aElapsed > SLOWFETCHTHRESHOLD && iFetchBatchSize > 1 )
+    {
+        iFetchBatchSize = qMax( iFetchBatchSize / 2, 1 );
+        qCDebug(lcSyncML) << "Slow item fetch, decreasing fetch batch size to" << iFetchBatchSize;
+    }
+    else if( aElapsed < SLOWFETCHTHRESHOLD / 2 && aItemCount >= iFetchBatchSize &&
+             iFetchBatchSize < maxBatchSize )
+    {
+        iFetchBatchSize = qMin( iFetchBatchSize * 2, maxBatchSize );
+        qCDebug(lcSyncML) << "Fast item fetch, increasing fetch batch size to" << iFetchBatchSize;
+    }
 }
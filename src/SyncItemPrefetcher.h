@@ -36,6 +36,9 @@
 #include <QObject>
 #include <QList>
 #include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
 
 #include "SyncItemKey.h"
 
@@ -46,6 +49,19 @@ namespace DataSync
 
 class StoragePlugin;
 class SyncItem;
+class PrefetchThread;
+
+/*! \brief Statistics of item prefetching
+ *
+ */
+struct PrefetchStatistics
+{
+    int     iHits;      /*!<Number of items that had been fetched when requested*/
+    int     iStalls;    /*!<Number of items that had to be waited for*/
+    qint64  iStallTime; /*!<Total time spent waiting for items, in milliseconds*/
+
+    PrefetchStatistics() : iHits( 0 ), iStalls( 0 ), iStallTime( 0 ) { }
+};
 
 /*! \brief Class that prefetches items from storage plugin based on
  *         batch size hint to increase performance when sending items
@@ -53,6 +69,11 @@ class SyncItem;
  * This class takes advantage on that the order of items requested from
  * storage plugin is known (aItemIds). Items are fetched in advance based
  * on current batch size hint.
+ *
+ * Optionally items can be fetched in a background thread, which runs
+ * ahead of the requests as far as batch size hint and memory budget allow.
+ * The background thread adapts the number of items it requests at a time
+ * to how long the storage plugin takes to return them.
  */
 class SyncItemPrefetcher : public QObject
 {
@@ -90,6 +111,54 @@ public:
      */
     SyncItem* getItem( const SyncItemKey& aItemId );
 
+    /*! \brief Look at an item without retrieving it
+     *
+     * Item is fetched like with getItem() if it has not been fetched yet,
+     * but it is kept to be retrieved with getItem() later. Peeking is not
+     * counted to the statistics, the item is counted when it is retrieved.
+     *
+     * @param aItemId Id of the item to look at
+     * @return Item, or NULL if it could not be fetched. Ownership is NOT
+     *         transferred, and the item is valid until it is retrieved
+     */
+    const SyncItem* peekItem( const SyncItemKey& aItemId );
+
+    /*! \brief Return an item retrieved with getItem() that was not used
+     *
+     * Item is handed out again by the next getItem() call for it.
+     *
+     * @param aItemId Id of the item
+     * @param aItem Item. Ownership IS transferred
+     */
+    void returnItem( const SyncItemKey& aItemId, SyncItem* aItem );
+
+    /*! \brief Sets the maximum number of bytes of items kept fetched in advance
+     *
+     * Sizes of items are determined with SyncItem::getSize(). An item that
+     * is requested is always fetched, even if it exceeds the budget.
+     *
+     * @param aBytes Memory budget in bytes, 0 for no limit
+     */
+    void setMemoryBudget( qint64 aBytes );
+
+    /*! \brief Starts fetching items in a background thread
+     *
+     * Should be called before any items are retrieved. getSyncItems() of the
+     * storage plugin is called from the background thread from then on, so
+     * the plugin must declare support for that by inheriting
+     * ConcurrentFetchStoragePlugin. Items of other plugins continue to be
+     * fetched in the calling thread.
+     *
+     * @return True if background fetching was started, otherwise false
+     */
+    bool startBackgroundFetching();
+
+    /*! \brief Returns statistics of prefetching
+     *
+     * @return Statistics
+     */
+    PrefetchStatistics statistics() const;
+
 public slots:
 
     /*! \brief Slot that should be invoked when prefetching can be done
@@ -99,12 +168,44 @@ public slots:
 
 private:
 
+    void fetchNextBatch( int aBatchSize );
+
+    int budgetedBatchSize( int aMaxSize ) const;
+
+    void storeItems( const QList<SyncItemKey>& aItemIds, QList<SyncItem*>& aItems );
+
+    SyncItem* takeItem( const SyncItemKey& aItemId );
+
+    void fetchItem( const SyncItemKey& aItemId );
+
+    bool waitForItem( const SyncItemKey& aItemId );
+
+    void fetchInBackground();
+
+    void adaptFetchBatchSize( int aItemCount, qint64 aElapsed );
+
     StoragePlugin&                  iStoragePlugin;
     int                             iBatchSizeHint;
     int                             iDefaultBatchSizeHint;
     QList<SyncItemKey>              iItemIdList;
     QHash<SyncItemKey, SyncItem*>   iFetchedItems;
 
+    qint64                          iMemoryBudget;      ///< Maximum bytes of items fetched in advance, 0 for no limit
+    qint64                          iFetchedBytes;      ///< Bytes of items currently fetched
+    qint64                          iObservedBytes;     ///< Bytes of all items fetched so far
+    int                             iObservedItems;     ///< Number of all items fetched so far
+    PrefetchStatistics              iStatistics;        ///< Hits and stalls so far
+
+    PrefetchThread*                 iFetchThread;       ///< Background thread, if started
+    mutable QMutex                  iMutex;             ///< Guards state shared with the background thread
+    QWaitCondition                  iFetchCondition;    ///< Wakes the background thread
+    QWaitCondition                  iItemCondition;     ///< Signals that items have been fetched
+    QSet<SyncItemKey>               iFetching;          ///< Items being fetched by the background thread
+    SyncItemKey                     iWantedItem;        ///< Item that is being waited for
+    int                             iFetchBatchSize;    ///< Items requested at a time by the background thread
+    bool                            iStopping;          ///< Background thread should exit
+
+    friend class PrefetchThread;
 
     friend class ::SyncItemPrefetcherTest;
 
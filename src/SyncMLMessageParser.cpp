@@ -34,17 +34,81 @@
 #include "SyncMLMessageParser.h"
 
 #include <QXmlStreamWriter>
+#include <QBuffer>
+#include <QCryptographicHash>
 
 #include "RemoteDeviceInfo.h"
+#include "WbXMLMessageDecoder.h"
 #include "SyncMLLogging.h"
 
 using namespace DataSync;
 
+namespace {
+
+// Number of UTF-16 code units the UTF-8 sequence starting with byte aByte
+// decodes to. Continuation bytes count as zero.
+inline int utf16Units( char aByte )
+{
+    const quint8 byte = static_cast<quint8>( aByte );
+
+    if( byte < 0x80 ) {
+        return 1;
+    }
+    else if( ( byte & 0xC0 ) == 0x80 ) {
+        return 0;
+    }
+    else if( byte >= 0xF0 ) {
+        return 2;
+    }
+    else {
+        return 1;
+    }
+}
+
+// Reads the element aReader is positioned at up to its end element,
+// re-serializing it if aSerialize is set
+QByteArray readElement( QXmlStreamReader& aReader, bool aSerialize )
+{
+    QByteArray buffer;
+    QXmlStreamWriter writer( &buffer );
+    writer.setAutoFormatting( false );
+
+    int depth = 0;
+
+    while( true ) {
+
+        if( aSerialize ) {
+            writer.writeCurrentToken( aReader );
+        }
+
+        if( aReader.isStartElement() ) {
+            ++depth;
+        }
+        else if( aReader.isEndElement() && --depth == 0 ) {
+            break;
+        }
+
+        if( aReader.atEnd() ) {
+            break;
+        }
+
+        aReader.readNext();
+    }
+
+    return buffer;
+}
+
+}
+
 
 SyncMLMessageParser::SyncMLMessageParser()
  : iLastMessageInPackage( false ), iError( PARSER_ERROR_LAST ),
    iSyncHdrFound( false ), iSyncBodyFound( false ),
-   iIsNewPacket( false )
+   iIsNewPacket( false ), iElement( ELEMENT_UNKNOWN ), iStreaming( false ), iScanPos( 0 ), iScanTagStart( 0 ),
+   iScanState( SCAN_TEXT ), iScanDepth( 0 ), iScanBrackets( 0 ), iScanQuote( 0 ),
+   iScanInBody( false ), iStreamInBody( false ), iStreamBlocked( false ),
+   iFragmentsReleased( false ), iAvailableFragments( 0 ),
+   iInputStart( 0 ), iInputStartOffset( 0 ), iInputPos( 0 ), iInputOffset( 0 )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -71,6 +135,17 @@ QList<DataSync::Fragment*> SyncMLMessageParser::takeFragments()
 
     QList<DataSync::Fragment*> fragments = iFragments;
     iFragments.clear();
+    iAvailableFragments = 0;
+    return fragments;
+}
+
+QList<DataSync::Fragment*> SyncMLMessageParser::takeAvailableFragments()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<DataSync::Fragment*> fragments = iFragments.mid( 0, iAvailableFragments );
+    iFragments.erase( iFragments.begin(), iFragments.begin() + iAvailableFragments );
+    iAvailableFragments = 0;
     return fragments;
 }
 
@@ -80,24 +155,479 @@ void SyncMLMessageParser::parseResponse( QIODevice *aDevice, bool aIsNewPacket )
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     iIsNewPacket = aIsNewPacket;
+
+    // Fragments of this message are kept apart from the ones of the
+    // previous message, which may still be processed
+    FragmentArena::Scope arenaScope( iFragmentArena );
+    iFragmentArena.beginMessage();
+
     if( aDevice->bytesAvailable() == 0 ) {
         qCCritical(lcSyncML) << "Zero-sized message detected, aborting parsing";
         emit parsingError( PARSER_ERROR_INVALID_DATA );
     }
+    else if( isWbXML( aDevice ) )
+    {
+        qCDebug(lcSyncML) << "Beginning to decode incoming WbXML message...";
+
+        decodeWbXML( aDevice->readAll() );
+
+        qCDebug(lcSyncML) << "Incoming WbXML message decoded";
+    }
     else
     {
 
         qCDebug(lcSyncML) << "Beginning to parse incoming message...";
 
+        // Message buffered in memory can be referred to directly when
+        // capturing embedded XML
+        QBuffer* buffer = qobject_cast<QBuffer*>( aDevice );
+
+        if( buffer ) {
+            resetInput( buffer->data(), static_cast<int>( buffer->pos() ), 0 );
+        }
+        else {
+            resetInput( QByteArray(), 0, 0 );
+        }
+
         iReader.setDevice( aDevice );
         iReader.setNamespaceProcessing( false );
         startParsing();
 
+        resetInput( QByteArray(), 0, 0 );
+
         qCDebug(lcSyncML) << "Incoming message parsed";
     }
 
 }
 
+void SyncMLMessageParser::parseMessage( const QByteArray& aData, bool aIsNewPacket )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QByteArray data( aData );
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+
+    parseResponse( &buffer, aIsNewPacket );
+}
+
+void SyncMLMessageParser::setKnownDevInfHash( const QByteArray& aHash )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iKnownDevInfHash = aHash;
+}
+
+bool SyncMLMessageParser::isWbXML( QIODevice* aDevice ) const
+{
+    // XML documents begin with '<', byte order mark or whitespace, while
+    // WbXML documents begin with the WbXML version byte
+    QByteArray version = aDevice->peek( 1 );
+
+    return !version.isEmpty() && version.at( 0 ) >= 0x01 && version.at( 0 ) <= 0x03;
+}
+
+void SyncMLMessageParser::decodeWbXML( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qDeleteAll(iFragments);
+    iFragments.clear();
+    iAvailableFragments = 0;
+    iFragmentsReleased = false;
+
+    WbXMLMessageDecoder decoder;
+    iError = decoder.decode( aData );
+    iFragments = decoder.takeFragments();
+    iLastMessageInPackage = decoder.lastMessageInPackage();
+
+    if( iError != PARSER_ERROR_LAST )
+    {
+        emit parsingError( iError );
+    }
+    else
+    {
+        emit parsingComplete( iLastMessageInPackage );
+    }
+}
+
+void SyncMLMessageParser::parseChunk( const QByteArray& aData, bool aFirstChunk, bool aLastChunk )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    FragmentArena::Scope arenaScope( iFragmentArena );
+
+    if( aFirstChunk ) {
+        qCDebug(lcSyncML) << "Beginning to parse incoming message incrementally...";
+        beginStream();
+    }
+    else if( !iStreaming ) {
+        qCWarning(lcSyncML) << "Ignoring chunk received outside of a message";
+        return;
+    }
+
+    // After an error the rest of the message is ignored. Error is reported
+    // only after the last chunk, so that the transport has the whole message
+    // available if it is purged and parsed again.
+    if( iError == PARSER_ERROR_LAST ) {
+
+        iStreamData.append( aData );
+
+        int length = aLastChunk ? iStreamData.size() : scanStream();
+
+        if( length > 0 ) {
+            const QByteArray data = iStreamData.left( length );
+            appendInput( data );
+            iReader.addData( data );
+            iStreamData.remove( 0, length );
+            iScanPos -= length;
+            iScanTagStart -= length;
+        }
+
+        parseStream();
+    }
+
+    if( aLastChunk ) {
+
+        if( iError == PARSER_ERROR_LAST && iStreamInBody ) {
+            qCCritical(lcSyncML) << "Incomplete SyncML message";
+            iError = PARSER_ERROR_INCOMPLETE_DATA;
+        }
+
+        iStreaming = false;
+        iStreamData.clear();
+        resetInput( QByteArray(), 0, 0 );
+        finishParsing();
+
+        qCDebug(lcSyncML) << "Incoming message parsed";
+    }
+}
+
+void SyncMLMessageParser::cancelStream()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !iStreaming ) {
+        return;
+    }
+
+    qCDebug(lcSyncML) << "Cancelling incremental parsing, fragments released:" << iFragmentsReleased;
+
+    qDeleteAll(iFragments);
+    iFragments.clear();
+    iAvailableFragments = 0;
+    iFragmentsReleased = false;
+
+    iReader.clear();
+
+    iStreaming = false;
+    iStreamData.clear();
+    resetInput( QByteArray(), 0, 0 );
+    iStreamInBody = false;
+    iStreamBlocked = false;
+}
+
+void SyncMLMessageParser::beginStream()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qDeleteAll(iFragments);
+    iFragments.clear();
+    iLastMessageInPackage = false;
+
+    iFragmentArena.beginMessage();
+
+    iSyncHdrFound = false;
+    iSyncBodyFound = false;
+
+    iError = PARSER_ERROR_LAST;
+    iIsNewPacket = true;
+
+    iReader.clear();
+    iReader.setNamespaceProcessing( false );
+
+    iStreaming = true;
+    iStreamData.clear();
+    resetInput( QByteArray(), 0, 0 );
+    iScanPos = 0;
+    iScanTagStart = 0;
+    iScanState = SCAN_TEXT;
+    iScanDepth = 0;
+    iScanBrackets = 0;
+    iScanQuote = 0;
+    iScanInBody = false;
+    iStreamInBody = false;
+    iStreamBlocked = false;
+    iFragmentsReleased = false;
+    iAvailableFragments = 0;
+}
+
+int SyncMLMessageParser::scanStream()
+{
+    // Element handlers expect that the elements they read are complete, so
+    // only data up to the end of the last complete header, body command or
+    // top-level markup can be passed on to the reader. Markup characters are
+    // ASCII, so scanning bytes is enough for UTF-8 and other ASCII
+    // compatible encodings. Scan state is kept between chunks so that each
+    // byte is scanned only once.
+
+    int length = 0;
+    const char* data = iStreamData.constData();
+    const int size = iStreamData.size();
+
+    for( ; iScanPos < size; ++iScanPos ) {
+
+        const char c = data[iScanPos];
+        bool markupEnd = false;
+
+        switch( iScanState )
+        {
+            case SCAN_TEXT:
+            {
+                if( c == '<' ) {
+                    iScanTagStart = iScanPos;
+                    iScanState = SCAN_MARKUP;
+                }
+                break;
+            }
+            case SCAN_MARKUP:
+            {
+                if( c == '/' ) {
+                    iScanState = SCAN_END_TAG;
+                }
+                else if( c == '?' ) {
+                    iScanState = SCAN_PI;
+                }
+                else if( c == '!' ) {
+                    iScanState = SCAN_DECLARATION;
+                }
+                else {
+                    iScanState = SCAN_START_TAG;
+                }
+                break;
+            }
+            case SCAN_START_TAG:
+            {
+                if( c == '"' || c == '\'' ) {
+                    iScanQuote = c;
+                    iScanState = SCAN_QUOTED;
+                }
+                else if( c == '>' ) {
+                    markupEnd = true;
+
+                    if( data[iScanPos - 1] != '/' ) {
+
+                        if( iScanDepth == 1 ) {
+                            // Element name ends at whitespace or at the end of the tag
+                            int nameEnd = iScanTagStart + 1;
+                            while( nameEnd < iScanPos && data[nameEnd] != '/' &&
+                                   !QChar::isSpace( static_cast<uchar>( data[nameEnd] ) ) ) {
+                                ++nameEnd;
+                            }
+
+                            QByteArray name = iStreamData.mid( iScanTagStart + 1, nameEnd - iScanTagStart - 1 );
+                            iScanInBody = ( name.mid( name.indexOf( ':' ) + 1 ) == SYNCML_ELEMENT_SYNCBODY );
+                        }
+
+                        ++iScanDepth;
+                    }
+                }
+                break;
+            }
+            case SCAN_QUOTED:
+            {
+                if( c == iScanQuote ) {
+                    iScanState = SCAN_START_TAG;
+                }
+                break;
+            }
+            case SCAN_END_TAG:
+            {
+                if( c == '>' ) {
+                    markupEnd = true;
+                    --iScanDepth;
+                }
+                break;
+            }
+            case SCAN_DECLARATION:
+            {
+                const QByteArray markup = iStreamData.mid( iScanTagStart, iScanPos - iScanTagStart + 1 );
+
+                if( markup == "<!--" ) {
+                    iScanState = SCAN_COMMENT;
+                }
+                else if( markup == "<![CDATA[" ) {
+                    iScanState = SCAN_CDATA;
+                }
+                else if( !QByteArray( "<!--" ).startsWith( markup ) &&
+                         !QByteArray( "<![CDATA[" ).startsWith( markup ) ) {
+                    if( c == '>' ) {
+                        markupEnd = true;
+                    }
+                    else {
+                        iScanBrackets = ( c == '[' ) ? 1 : 0;
+                        iScanState = SCAN_DOCTYPE;
+                    }
+                }
+                break;
+            }
+            case SCAN_DOCTYPE:
+            {
+                if( c == '[' ) {
+                    ++iScanBrackets;
+                }
+                else if( c == ']' ) {
+                    --iScanBrackets;
+                }
+                else if( c == '>' && iScanBrackets <= 0 ) {
+                    markupEnd = true;
+                }
+                break;
+            }
+            case SCAN_COMMENT:
+            {
+                markupEnd = ( c == '>' && iScanPos - 2 >= iScanTagStart + 4 &&
+                              data[iScanPos - 1] == '-' && data[iScanPos - 2] == '-' );
+                break;
+            }
+            case SCAN_CDATA:
+            {
+                markupEnd = ( c == '>' && iScanPos - 2 >= iScanTagStart + 9 &&
+                              data[iScanPos - 1] == ']' && data[iScanPos - 2] == ']' );
+                break;
+            }
+            case SCAN_PI:
+            {
+                markupEnd = ( c == '>' && iScanPos - 1 >= iScanTagStart + 2 &&
+                              data[iScanPos - 1] == '?' );
+                break;
+            }
+        }
+
+        if( markupEnd ) {
+            iScanState = SCAN_TEXT;
+
+            // Safe to parse if we are not inside header or a body command
+            if( iScanDepth <= 1 || ( iScanDepth == 2 && iScanInBody ) ) {
+                length = iScanPos + 1;
+            }
+        }
+    }
+
+    return length;
+}
+
+void SyncMLMessageParser::parseStream()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Anything after the end of the document is ignored
+    if( iReader.tokenType() == QXmlStreamReader::EndDocument ) {
+        return;
+    }
+
+    while( iError == PARSER_ERROR_LAST ) {
+
+        readNext();
+
+        if( iReader.error() == QXmlStreamReader::PrematureEndOfDocumentError ) {
+            // Rest of the message has not been received yet
+            break;
+        }
+
+        QXmlStreamReader::TokenType token = iReader.tokenType();
+        switch( token )
+        {
+            case QXmlStreamReader::StartElement:
+            {
+                if( iStreamInBody ) {
+                    readBodyElement( iElement );
+                    releaseFragments();
+                }
+                else if( iElement == ELEMENT_SYNCHDR ) {
+                    readHeader();
+                    releaseFragments();
+                }
+                else if( iElement == ELEMENT_SYNCBODY ) {
+                    if( iSyncBodyFound ) {
+                        qCCritical(lcSyncML) << "Invalid SyncML message, multiple SyncBody elements found";
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    else {
+                        iSyncBodyFound = true;
+                        iStreamInBody = true;
+                    }
+                }
+                else if( iElement != ELEMENT_SYNCML ) {
+                    qCCritical(lcSyncML) << "Unexpected element in SyncML message:" << iReader.name();
+                    iError = PARSER_ERROR_UNEXPECTED_DATA;
+                }
+                break;
+            }
+            case QXmlStreamReader::EndElement:
+            {
+                if( iStreamInBody && iElement == ELEMENT_SYNCBODY ) {
+                    iStreamInBody = false;
+                }
+                break;
+            }
+            case QXmlStreamReader::StartDocument:
+            case QXmlStreamReader::Characters:
+            case QXmlStreamReader::DTD:
+            case QXmlStreamReader::Comment:
+            {
+                break;
+            }
+            case QXmlStreamReader::EndDocument:
+            {
+                return;
+            }
+            case QXmlStreamReader::Invalid:
+            case QXmlStreamReader::NoToken:
+            case QXmlStreamReader::EntityReference:
+            case QXmlStreamReader::ProcessingInstruction:
+            {
+                qCCritical(lcSyncML) << "Unexpected token in SyncML message" << iReader.tokenType();
+                iError = PARSER_ERROR_UNEXPECTED_DATA;
+                break;
+            }
+        }
+    }
+}
+
+void SyncMLMessageParser::releaseFragments()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Only leading Status and Map fragments are released before the whole
+    // message has been parsed. Sync and other commands are kept until the end,
+    // as a DevInf fragment later in the message must still be processed before them.
+    if( iStreamBlocked || iError != PARSER_ERROR_LAST ) {
+        return;
+    }
+
+    int available = iAvailableFragments;
+
+    while( available < iFragments.count() ) {
+
+        Fragment::FragmentType type = iFragments[available]->fragmentType;
+
+        if( type != Fragment::FRAGMENT_HEADER && type != Fragment::FRAGMENT_STATUS &&
+            type != Fragment::FRAGMENT_MAP ) {
+            iStreamBlocked = true;
+            break;
+        }
+
+        ++available;
+    }
+
+    if( available > iAvailableFragments ) {
+        iAvailableFragments = available;
+        iFragmentsReleased = true;
+        emit fragmentsAvailable();
+    }
+}
+
 void SyncMLMessageParser::startParsing()
 {
 
@@ -112,9 +642,13 @@ void SyncMLMessageParser::startParsing()
 
     iError = PARSER_ERROR_LAST;
 
+    iStreaming = false;
+    iFragmentsReleased = false;
+    iAvailableFragments = 0;
+
     while( shouldContinue() ) {
 
-        iReader.readNext();
+        readNext();
 
         QXmlStreamReader::TokenType token = iReader.tokenType();
         switch( token )
@@ -129,13 +663,12 @@ void SyncMLMessageParser::startParsing()
             }
             case QXmlStreamReader::StartElement:
             {
-                QStringRef name = iReader.name();
-                if( name == SYNCML_ELEMENT_SYNCHDR ) {
+                if( iElement == ELEMENT_SYNCHDR ) {
                     readHeader();
-                } else if( name == SYNCML_ELEMENT_SYNCBODY ) {
+                } else if( iElement == ELEMENT_SYNCBODY ) {
                     readBody();
-                } else if( name != SYNCML_ELEMENT_SYNCML ){
-                    qCCritical(lcSyncML) << "Unexpected element in SyncML message:" << name;
+                } else if( iElement != ELEMENT_SYNCML ){
+                    qCCritical(lcSyncML) << "Unexpected element in SyncML message:" << iReader.name();
                     iError = PARSER_ERROR_UNEXPECTED_DATA;
                 }
                 break;
@@ -160,11 +693,21 @@ void SyncMLMessageParser::startParsing()
         }
     }
 
+    finishParsing();
+}
+
+void SyncMLMessageParser::finishParsing()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
     if( iError != PARSER_ERROR_LAST )
     {
         qCCritical(lcSyncML) << "Error while parsing SyncML document:" << iError;
-        // Check if the parsing error happened due to invalid XML characters
-        if( iIsNewPacket && ( QXmlStreamReader::PrematureEndOfDocumentError  == iReader.error()
+        // Check if the parsing error happened due to invalid XML characters.
+        // Message cannot be purged and parsed again if some of its fragments
+        // have already been processed
+        if( iIsNewPacket && !iFragmentsReleased &&
+            ( QXmlStreamReader::PrematureEndOfDocumentError  == iReader.error()
                 || QXmlStreamReader::NotWellFormedError == iReader.error() ) )
         {
             // Change error here to Invalid character found error
@@ -201,41 +744,14 @@ void SyncMLMessageParser::readBody()
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_SYNCBODY ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_SYNCBODY ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if( name == SYNCML_ELEMENT_STATUS) {
-                readStatus();
-            } else if (name == SYNCML_ELEMENT_SYNC) {
-                readSync();
-            } else if (name == SYNCML_ELEMENT_PUT) {
-                readPut();
-            } else if (name == SYNCML_ELEMENT_RESULTS) {
-                readResults();
-            } else if (name == SYNCML_ELEMENT_MAP ) {
-                readMap();
-            }else if (name == SYNCML_ELEMENT_FINAL) {
-                iLastMessageInPackage = true;
-            } else {
-                CommandParams* command = new CommandParams();
-
-                if( readCommand( name, *command ) ) {
-                    iFragments.append( command );
-                }
-                else {
-                    delete command;
-                    command = 0;
-                    qCWarning(lcSyncML) << "UNKNOWN  TOKEN TYPE in BODY:NOT HANDLED BY PARSER" << name;
-                }
-
-            }
-
+            readBodyElement( iElement );
         }
 
     }
@@ -247,6 +763,47 @@ void SyncMLMessageParser::readBody()
 
 }
 
+void SyncMLMessageParser::readBodyElement( ElementToken aElement )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    switch( aElement )
+    {
+        case ELEMENT_STATUS:
+            readStatus();
+            break;
+        case ELEMENT_SYNC:
+            readSync();
+            break;
+        case ELEMENT_PUT:
+            readPut();
+            break;
+        case ELEMENT_RESULTS:
+            readResults();
+            break;
+        case ELEMENT_MAP:
+            readMap();
+            break;
+        case ELEMENT_FINAL:
+            iLastMessageInPackage = true;
+            break;
+        default:
+        {
+            CommandParams* command = new CommandParams();
+
+            if( readCommand( aElement, *command ) ) {
+                iFragments.append( command );
+            }
+            else {
+                delete command;
+                command = 0;
+                qCWarning(lcSyncML) << "UNKNOWN  TOKEN TYPE in BODY:NOT HANDLED BY PARSER" << iReader.name();
+            }
+            break;
+        }
+    }
+}
+
 void SyncMLMessageParser::readHeader()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -264,47 +821,48 @@ void SyncMLMessageParser::readHeader()
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
+        readNext();
 
-        QStringRef name = iReader.name();
-
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_SYNCHDR ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_SYNCHDR ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if (name == SYNCML_ELEMENT_VERDTD) {
-                header->verDTD = readString();
-            }
-            else if (name == SYNCML_ELEMENT_VERPROTO) {
-                header->verProto = readString();
-            }
-            else if (name == SYNCML_ELEMENT_SESSIONID) {
-                header->sessionID = readString();
-            }
-            else if (name == SYNCML_ELEMENT_MSGID) {
-                header->msgID = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_TARGET) {
-                header->targetDevice = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCE) {
-                header->sourceDevice = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_RESPURI) {
-                header->respURI = readString();
-            }
-            else if (name == SYNCML_ELEMENT_NORESP) {
-                header->noResp = true;
-            }
-            else if (name == SYNCML_ELEMENT_CRED) {
-                readCred( header->cred );
-            }
-            else if (name == SYNCML_ELEMENT_META) {
-                readMeta( header->meta );
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in HEADER:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_VERDTD:
+                    header->verDTD = readString();
+                    break;
+                case ELEMENT_VERPROTO:
+                    header->verProto = readString();
+                    break;
+                case ELEMENT_SESSIONID:
+                    header->sessionID = readString();
+                    break;
+                case ELEMENT_MSGID:
+                    header->msgID = readInt();
+                    break;
+                case ELEMENT_TARGET:
+                    header->targetDevice = readURI();
+                    break;
+                case ELEMENT_SOURCE:
+                    header->sourceDevice = readURI();
+                    break;
+                case ELEMENT_RESPURI:
+                    header->respURI = readString();
+                    break;
+                case ELEMENT_NORESP:
+                    header->noResp = true;
+                    break;
+                case ELEMENT_CRED:
+                    readCred( header->cred );
+                    break;
+                case ELEMENT_META:
+                    readMeta( header->meta );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in HEADER:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
     }
@@ -324,14 +882,14 @@ void SyncMLMessageParser::readChal( ChalParams& aParams )
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
+        readNext();
 
-        if( iReader.isEndElement() && iReader.name() == SYNCML_ELEMENT_CHAL ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_CHAL ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if( iReader.name() == SYNCML_ELEMENT_META ) {
+            if( iElement == ELEMENT_META ) {
                 readMeta( aParams.meta );
             }
             else {
@@ -347,58 +905,63 @@ void SyncMLMessageParser::readStatus()
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     StatusParams *status = new StatusParams();
+    QStringList targetRefs;
+    QStringList sourceRefs;
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_STATUS ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_STATUS ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-
-            if(name == SYNCML_ELEMENT_CMDID) {
-                status->cmdId = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_MSGREF) {
-                status->msgRef = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_CMDREF) {
-                status->cmdRef = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_CMD) {
-                status->cmd = readString();
-            }
-            else if (name == SYNCML_ELEMENT_TARGETREF) {
-                status->targetRef = readString();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCEREF) {
-                status->sourceRef = readString();
-            }
-            else if (name == SYNCML_ELEMENT_DATA) {
-                status->data = (ResponseStatusCode)readInt();
-                qCDebug(lcSyncML) << iStatusCodeMap[status->data] << ":" << status->data;
-            }
-            else if (name == SYNCML_ELEMENT_ITEM) {
-                ItemParams item;
-                readItem( item );
-                status->items.append( item );
-            }
-            else if (name == SYNCML_ELEMENT_CHAL) {
-                status->hasChal = true;
-                readChal( status->chal );
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in STATUS:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_CMDID:
+                    status->cmdId = readInt();
+                    break;
+                case ELEMENT_MSGREF:
+                    status->msgRef = readInt();
+                    break;
+                case ELEMENT_CMDREF:
+                    status->cmdRef = readInt();
+                    break;
+                case ELEMENT_CMD:
+                    status->cmd = readString();
+                    break;
+                case ELEMENT_TARGETREF:
+                    targetRefs.append( readString() );
+                    break;
+                case ELEMENT_SOURCEREF:
+                    sourceRefs.append( readString() );
+                    break;
+                case ELEMENT_DATA:
+                    status->data = (ResponseStatusCode)readInt();
+                    qCDebug(lcSyncML) << iStatusCodeMap[status->data] << ":" << status->data;
+                    break;
+                case ELEMENT_ITEM:
+                {
+                    ItemParams item;
+                    readItem( item );
+                    status->items.append( item );
+                    break;
+                }
+                case ELEMENT_CHAL:
+                    status->hasChal = true;
+                    readChal( status->chal );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in STATUS:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
-         }
+        }
 
     }
 
+    status->setRefs( targetRefs, sourceRefs );
+
     iFragments.append(status);
 }
 
@@ -410,45 +973,45 @@ void SyncMLMessageParser::readSync()
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_SYNC ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_SYNC ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-
-            if (name == SYNCML_ELEMENT_CMDID) {
-                sync->cmdId = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_NORESP) {
-                sync->noResp = true;
-            }
-            else if (name == SYNCML_ELEMENT_META) {
-                readMeta( sync->meta );
-            }
-            else if (name == SYNCML_ELEMENT_TARGET) {
-                sync->target = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCE) {
-                sync->source = readURI();
-            }
-            else if( name == SYNCML_ELEMENT_NUMOFCHANGES ) {
-                sync->numberOfChanges = readInt();
-            }
-            else {
-                CommandParams command;
-                if( readCommand( name, command ) ) {
-                    sync->commands.append(command);
-                }
-                else {
-                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in SYNC:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_CMDID:
+                    sync->cmdId = readInt();
+                    break;
+                case ELEMENT_NORESP:
+                    sync->noResp = true;
+                    break;
+                case ELEMENT_META:
+                    readMeta( sync->meta );
+                    break;
+                case ELEMENT_TARGET:
+                    sync->target = readURI();
+                    break;
+                case ELEMENT_SOURCE:
+                    sync->source = readURI();
+                    break;
+                case ELEMENT_NUMOFCHANGES:
+                    sync->numberOfChanges = readInt();
+                    break;
+                default:
+                {
+                    CommandParams command;
+                    if( readCommand( iElement, command ) ) {
+                        sync->commands.append(command);
+                    }
+                    else {
+                        qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in SYNC:NOT HANDLED BY PARSER" << iReader.name();
+                    }
+                    break;
                 }
-
             }
-
         }
 
     }
@@ -465,36 +1028,38 @@ void SyncMLMessageParser::readMap()
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_MAP ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_MAP ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if( name == SYNCML_ELEMENT_CMDID) {
-                map->cmdId = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_TARGET) {
-                map->target = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCE) {
-                map->source = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_META) {
-                readMeta( map->meta );
-            }
-            else if (name == SYNCML_ELEMENT_MAPITEM) {
-                MapItemParams item;
-                readMapItem( item );
-                map->mapItems.append( item );
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in MAP:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_CMDID:
+                    map->cmdId = readInt();
+                    break;
+                case ELEMENT_TARGET:
+                    map->target = readURI();
+                    break;
+                case ELEMENT_SOURCE:
+                    map->source = readURI();
+                    break;
+                case ELEMENT_META:
+                    readMeta( map->meta );
+                    break;
+                case ELEMENT_MAPITEM:
+                {
+                    MapItemParams item;
+                    readMapItem( item );
+                    map->mapItems.append( item );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in MAP:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
@@ -509,24 +1074,24 @@ void SyncMLMessageParser::readMapItem( MapItemParams& aParams )
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_MAPITEM ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_MAPITEM ) {
             break;
         }
         if( iReader.isStartElement() ) {
-            if (name == SYNCML_ELEMENT_TARGET) {
-                aParams.target = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCE) {
-                aParams.source = readURI();
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in MAPITEM:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_TARGET:
+                    aParams.target = readURI();
+                    break;
+                case ELEMENT_SOURCE:
+                    aParams.source = readURI();
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in MAPITEM:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
@@ -542,49 +1107,38 @@ void SyncMLMessageParser::readPut()
     while( shouldContinue() )
     {
 
-        iReader.readNext();
+        readNext();
 
-        QStringRef name = iReader.name();
-
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_PUT )
+        if( iReader.isEndElement() && iElement == ELEMENT_PUT )
         {
             break;
         }
 
         if( iReader.isStartElement() )
         {
-            if (name == SYNCML_ELEMENT_CMDID)
-            {
-                put->cmdId = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_NORESP)
-            {
-                put->noResp = true;
-            }
-            else if (name == SYNCML_ELEMENT_META)
-            {
-                readMeta( put->meta );
-            }
-            else if (name == SYNCML_ELEMENT_ITEM)
+            switch( iElement )
             {
-                readDevInfItem( put->devInf );
-            }
-            else
-            {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in PUT:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_CMDID:
+                    put->cmdId = readInt();
+                    break;
+                case ELEMENT_NORESP:
+                    put->noResp = true;
+                    break;
+                case ELEMENT_META:
+                    readMeta( put->meta );
+                    break;
+                case ELEMENT_ITEM:
+                    readDevInfItem( put->devInf );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in PUT:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
     }
 
     // Ensure that the PUT fragment is kept next only to the HEADER, or RESULTS fragment.
-    if( iFragments.count() > 0 )
-    {
-        iFragments.insert( 1, put );
-    }
-    else
-    {
-        iFragments.append(put);
-    }
+    insertDevInfFragment( put );
 }
 
 void SyncMLMessageParser::readResults()
@@ -595,194 +1149,209 @@ void SyncMLMessageParser::readResults()
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
+        readNext();
 
-        QStringRef name = iReader.name();
-
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_RESULTS ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_RESULTS ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-
-            if (name == SYNCML_ELEMENT_CMDID) {
-                results->cmdId = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_MSGREF) {
-                results->msgRef = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_CMDREF) {
-                results->cmdRef = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_META) {
-                readMeta( results->meta );
-            }
-            else if (name == SYNCML_ELEMENT_TARGETREF) {
-                results->targetRef = readString();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCEREF) {
-                results->sourceRef = readString();
-            }
-            else if (name == SYNCML_ELEMENT_ITEM) {
-                readDevInfItem( results->devInf );
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in RESULTS:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_CMDID:
+                    results->cmdId = readInt();
+                    break;
+                case ELEMENT_MSGREF:
+                    results->msgRef = readInt();
+                    break;
+                case ELEMENT_CMDREF:
+                    results->cmdRef = readInt();
+                    break;
+                case ELEMENT_META:
+                    readMeta( results->meta );
+                    break;
+                case ELEMENT_TARGETREF:
+                    results->targetRef = readString();
+                    break;
+                case ELEMENT_SOURCEREF:
+                    results->sourceRef = readString();
+                    break;
+                case ELEMENT_ITEM:
+                    readDevInfItem( results->devInf );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in RESULTS:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
 
     // Ensure that the RESULTS fragment is kept next only to the HEADER, or PUT fragment.
-    if( iFragments.count() > 0 )
+    insertDevInfFragment( results );
+
+}
+
+void SyncMLMessageParser::insertDevInfFragment( Fragment* aFragment )
+{
+    // When parsing incrementally, the header may have been taken already. In
+    // that case the fragment goes first among the remaining fragments.
+    int index = 0;
+
+    if( !iFragments.isEmpty() && iFragments.first()->fragmentType == Fragment::FRAGMENT_HEADER )
     {
-        iFragments.insert(1, results);
+        index = 1;
     }
-    else
+
+    iFragments.insert( index, aFragment );
+
+    if( index < iAvailableFragments )
     {
-        iFragments.append(results);
+        ++iAvailableFragments;
     }
-
 }
 
-bool SyncMLMessageParser::readCommand( const QStringRef& aName, CommandParams& aCommand )
+bool SyncMLMessageParser::readCommand( ElementToken aElement, CommandParams& aCommand )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     bool found = true;
 
-    if( aName == SYNCML_ELEMENT_ALERT ) {
-        aCommand.commandType = CommandParams::COMMAND_ALERT;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_ALERT );
-    }
-    else if (aName == SYNCML_ELEMENT_ADD) {
-        aCommand.commandType = CommandParams::COMMAND_ADD;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_ADD );
-    }
-    else if (aName == SYNCML_ELEMENT_REPLACE) {
-        aCommand.commandType = CommandParams::COMMAND_REPLACE;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_REPLACE );
-    }
-    else if (aName == SYNCML_ELEMENT_DELETE) {
-        aCommand.commandType = CommandParams::COMMAND_DELETE;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_DELETE );
-    }
-    else if (aName == SYNCML_ELEMENT_GET) {
-        aCommand.commandType = CommandParams::COMMAND_GET;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_GET );
-    }
-    else if (aName == SYNCML_ELEMENT_COPY) {
-        aCommand.commandType = CommandParams::COMMAND_COPY;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_COPY );
-    }
-    else if (aName == SYNCML_ELEMENT_MOVE) {
-        aCommand.commandType = CommandParams::COMMAND_MOVE;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_MOVE );
-    }
-    else if (aName == SYNCML_ELEMENT_EXEC ) {
-        aCommand.commandType = CommandParams::COMMAND_EXEC;
-        readLeafCommand( aCommand, SYNCML_ELEMENT_EXEC );
-    }
-    else if (aName == SYNCML_ELEMENT_ATOMIC) {
-        aCommand.commandType = CommandParams::COMMAND_ATOMIC;
-        readContainerCommand( aCommand, SYNCML_ELEMENT_ATOMIC );
-    }
-    else if (aName == SYNCML_ELEMENT_SEQUENCE) {
-        aCommand.commandType = CommandParams::COMMAND_SEQUENCE;
-        readContainerCommand( aCommand, SYNCML_ELEMENT_SEQUENCE );
-    }
-    else {
-        found = false;
+    switch( aElement )
+    {
+        case ELEMENT_ALERT:
+            aCommand.commandType = CommandParams::COMMAND_ALERT;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_ADD:
+            aCommand.commandType = CommandParams::COMMAND_ADD;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_REPLACE:
+            aCommand.commandType = CommandParams::COMMAND_REPLACE;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_DELETE:
+            aCommand.commandType = CommandParams::COMMAND_DELETE;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_GET:
+            aCommand.commandType = CommandParams::COMMAND_GET;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_COPY:
+            aCommand.commandType = CommandParams::COMMAND_COPY;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_MOVE:
+            aCommand.commandType = CommandParams::COMMAND_MOVE;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_EXEC:
+            aCommand.commandType = CommandParams::COMMAND_EXEC;
+            readLeafCommand( aCommand, aElement );
+            break;
+        case ELEMENT_ATOMIC:
+            aCommand.commandType = CommandParams::COMMAND_ATOMIC;
+            readContainerCommand( aCommand, aElement );
+            break;
+        case ELEMENT_SEQUENCE:
+            aCommand.commandType = CommandParams::COMMAND_SEQUENCE;
+            readContainerCommand( aCommand, aElement );
+            break;
+        default:
+            found = false;
+            break;
     }
 
     return found;
 }
 
-void SyncMLMessageParser::readLeafCommand( CommandParams& aParams, const QString& aCommand )
+void SyncMLMessageParser::readLeafCommand( CommandParams& aParams, ElementToken aCommand )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == aCommand ) {
+        if( iReader.isEndElement() && iElement == aCommand ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-
-            if( name == SYNCML_ELEMENT_CMDID ) {
-                aParams.cmdId = readInt();
-            }
-            else if( name == SYNCML_ELEMENT_NORESP ) {
-                aParams.noResp = true;
-            }
-            else if (name == SYNCML_ELEMENT_DATA) {
-                aParams.data = readString();
-            }
-            else if( name == SYNCML_ELEMENT_CORRELATOR ) {
-                aParams.correlator = readString();
-            }
-            else if( name == SYNCML_ELEMENT_META ) {
-                readMeta( aParams.meta );
-            }
-            else if( name == SYNCML_ELEMENT_ITEM ) {
-                ItemParams item;
-                readItem( item );
-                aParams.items.append( item );
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in COMMAND:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_CMDID:
+                    aParams.cmdId = readInt();
+                    break;
+                case ELEMENT_NORESP:
+                    aParams.noResp = true;
+                    break;
+                case ELEMENT_DATA:
+                    aParams.data = readString();
+                    break;
+                case ELEMENT_CORRELATOR:
+                    aParams.correlator = readString();
+                    break;
+                case ELEMENT_META:
+                    readMeta( aParams.meta );
+                    break;
+                case ELEMENT_ITEM:
+                {
+                    ItemParams item;
+                    readItem( item );
+                    aParams.items.append( item );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in COMMAND:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
 
 }
 
-void SyncMLMessageParser::readContainerCommand( CommandParams& aParams, const QString& aCommand )
+void SyncMLMessageParser::readContainerCommand( CommandParams& aParams, ElementToken aCommand )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == aCommand ) {
+        if( iReader.isEndElement() && iElement == aCommand ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-
-            if( name == SYNCML_ELEMENT_CMDID ) {
-                aParams.cmdId = readInt();
-            }
-            else if( name == SYNCML_ELEMENT_NORESP ) {
-                aParams.noResp = true;
-            }
-            else if( name == SYNCML_ELEMENT_META ) {
-                readMeta( aParams.meta );
-            }
-            else {
-                CommandParams command;
-
-                if( readCommand( name, command ) )
+            switch( iElement )
+            {
+                case ELEMENT_CMDID:
+                    aParams.cmdId = readInt();
+                    break;
+                case ELEMENT_NORESP:
+                    aParams.noResp = true;
+                    break;
+                case ELEMENT_META:
+                    readMeta( aParams.meta );
+                    break;
+                default:
                 {
-                    aParams.subCommands.append(command);
-                }
-                else {
-                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in COMMAND:NOT HANDLED BY PARSER" << name;
-                }
+                    CommandParams command;
 
+                    if( readCommand( iElement, command ) )
+                    {
+                        aParams.subCommands.append(command);
+                    }
+                    else {
+                        qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in COMMAND:NOT HANDLED BY PARSER" << iReader.name();
+                    }
+                    break;
+                }
             }
-
         }
 
     }
@@ -795,23 +1364,24 @@ void SyncMLMessageParser::readCred( CredParams& aParams )
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_CRED ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_CRED ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if( name == SYNCML_ELEMENT_META ) {
-                readMeta( aParams.meta );
-            }
-            else if( name == SYNCML_ELEMENT_DATA ) {
-                aParams.data = readString();
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in CRED:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_META:
+                    readMeta( aParams.meta );
+                    break;
+                case ELEMENT_DATA:
+                    aParams.data = readString();
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in CRED:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
     }
@@ -824,49 +1394,49 @@ void SyncMLMessageParser::readMeta( MetaParams& aParams )
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_META ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_META ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if (name == SYNCML_ELEMENT_FORMAT) {
-                aParams.format = readString();
-            }
-            else if (name == SYNCML_ELEMENT_SIZE) {
-                aParams.size = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_TYPE) {
-                aParams.type = readString();
-            }
-            else if (name == SYNCML_ELEMENT_ANCHOR) {
-                readAnchor( aParams.anchor );
-            }
-            else if (name == SYNCML_ELEMENT_VERSION) {
-                aParams.version = readString();
-            }
-            else if (name == SYNCML_ELEMENT_NEXTNONCE) {
-                aParams.nextNonce = readString();
-            }
-            else if (name == SYNCML_ELEMENT_MAXMSGSIZE) {
-                aParams.maxMsgSize = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_MAXOBJSIZE) {
-                aParams.maxObjSize = readInt();
-            }
-            else if (name == SYNCML_ELEMENT_EMI) {
-                aParams.EMI.append( readString() );
-            }
-            else if (name == SYNCML_ELEMENT_MARK) {
-                aParams.mark = readString();
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in META:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_FORMAT:
+                    aParams.format = readString();
+                    break;
+                case ELEMENT_SIZE:
+                    aParams.size = readInt();
+                    break;
+                case ELEMENT_TYPE:
+                    aParams.type = readString();
+                    break;
+                case ELEMENT_ANCHOR:
+                    readAnchor( aParams.anchor );
+                    break;
+                case ELEMENT_VERSION:
+                    aParams.version = readString();
+                    break;
+                case ELEMENT_NEXTNONCE:
+                    aParams.nextNonce = readString();
+                    break;
+                case ELEMENT_MAXMSGSIZE:
+                    aParams.maxMsgSize = readInt();
+                    break;
+                case ELEMENT_MAXOBJSIZE:
+                    aParams.maxObjSize = readInt();
+                    break;
+                case ELEMENT_EMI:
+                    aParams.EMI.append( readString() );
+                    break;
+                case ELEMENT_MARK:
+                    aParams.mark = readString();
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in META:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
@@ -879,25 +1449,25 @@ void SyncMLMessageParser::readAnchor( AnchorParams& aParams )
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_ANCHOR ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_ANCHOR ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if (name == SYNCML_ELEMENT_NEXT) {
-                aParams.next = readString();
-            }
-            else if (name == SYNCML_ELEMENT_LAST) {
-                aParams.last = readString();
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in ANCHOR:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_NEXT:
+                    aParams.next = readString();
+                    break;
+                case ELEMENT_LAST:
+                    aParams.last = readString();
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in ANCHOR:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
     }
 
@@ -910,28 +1480,39 @@ void SyncMLMessageParser::readDevInfItem( DevInfItemParams& aParams )
 
     while( shouldContinue() )
     {
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_ITEM )
+        if( iReader.isEndElement() && iElement == ELEMENT_ITEM )
         {
             break;
         }
 
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_SOURCE )
-            {
-                aParams.source = readURI();
-            }
-            else if( name == SYNCML_ELEMENT_DEVINF )
-            {
-                readDevInf( aParams );
-            }
-            else
+            switch( iElement )
             {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_SOURCE:
+                    aParams.source = readURI();
+                    break;
+                case ELEMENT_DEVINF:
+                {
+                    aParams.hash = rawElementHash();
+
+                    if( !aParams.hash.isEmpty() && aParams.hash == iKnownDevInfHash )
+                    {
+                        qCDebug(lcSyncML) << "DevInf has not changed, skipping it";
+                        readElement( iReader, false );
+                        aParams.cached = true;
+                    }
+                    else
+                    {
+                        readDevInf( aParams );
+                    }
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
 
@@ -947,95 +1528,87 @@ void SyncMLMessageParser::readDevInf( DevInfItemParams& aParams )
 
     while( shouldContinue() )
     {
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_DEVINF )
+        if( iReader.isEndElement() && iElement == ELEMENT_DEVINF )
         {
             break;
         }
 
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_VERDTD )
+            switch( iElement )
             {
-                dtd = readString();
-
-                if( dtd != SYNCML_DTD_VERSION_1_1 &&
-                    dtd != SYNCML_DTD_VERSION_1_2 )
+                case ELEMENT_VERDTD:
                 {
-                    qCCritical(lcSyncML) << "Unrecognized DevInf verDTD:" << dtd;
-                    iError = PARSER_ERROR_INVALID_DATA;
-                }
+                    dtd = readString();
 
-            }
-            else if( name == SYNCML_ELEMENT_MAN )
-            {
-                aParams.devInfo.deviceInfo().setManufacturer( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_MOD )
-            {
-                aParams.devInfo.deviceInfo().setModel( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_OEM )
-            {
-                aParams.devInfo.deviceInfo().setOEM( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_FWVERSION )
-            {
-                aParams.devInfo.deviceInfo().setFirmwareVersion( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_SWVERSION )
-            {
-                aParams.devInfo.deviceInfo().setSoftwareVersion( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_HWVERSION )
-            {
-                aParams.devInfo.deviceInfo().setHardwareVersion( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_DEVID )
-            {
-                aParams.devInfo.deviceInfo().setDeviceID( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_DEVTYPE )
-            {
-                aParams.devInfo.deviceInfo().setDeviceType( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_UTC )
-            {
-                aParams.devInfo.setSupportsUTC( true );
-            }
-            else if( name == SYNCML_ELEMENT_SUPPORTLARGEOBJS )
-            {
-                aParams.devInfo.setSupportsLargeObjs( true );
-            }
-            else if( name == SYNCML_ELEMENT_SUPPORTNUMBEROFCHANGES )
-            {
-                aParams.devInfo.setSupportsNumberOfChanges( true );
-            }
-            else if( name == SYNCML_ELEMENT_DATASTORE )
-            {
-                Datastore newDatastore;
-                readDataStore( newDatastore, dtd );
-                aParams.devInfo.datastores().append( newDatastore );
-            }
-            else if( name == SYNCML_ELEMENT_CTCAP )
-            {
-                // CTCap element resides under DevInf only 1.1, in 1.2 it's under
-                // DataStore
-                if( dtd == SYNCML_DTD_VERSION_1_1 )
+                    if( dtd != SYNCML_DTD_VERSION_1_1 &&
+                        dtd != SYNCML_DTD_VERSION_1_2 )
+                    {
+                        qCCritical(lcSyncML) << "Unrecognized DevInf verDTD:" << dtd;
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    break;
+                }
+                case ELEMENT_MAN:
+                    aParams.devInfo.deviceInfo().setManufacturer( readString() );
+                    break;
+                case ELEMENT_MOD:
+                    aParams.devInfo.deviceInfo().setModel( readString() );
+                    break;
+                case ELEMENT_OEM:
+                    aParams.devInfo.deviceInfo().setOEM( readString() );
+                    break;
+                case ELEMENT_FWVERSION:
+                    aParams.devInfo.deviceInfo().setFirmwareVersion( readString() );
+                    break;
+                case ELEMENT_SWVERSION:
+                    aParams.devInfo.deviceInfo().setSoftwareVersion( readString() );
+                    break;
+                case ELEMENT_HWVERSION:
+                    aParams.devInfo.deviceInfo().setHardwareVersion( readString() );
+                    break;
+                case ELEMENT_DEVID:
+                    aParams.devInfo.deviceInfo().setDeviceID( readString() );
+                    break;
+                case ELEMENT_DEVTYPE:
+                    aParams.devInfo.deviceInfo().setDeviceType( readString() );
+                    break;
+                case ELEMENT_UTC:
+                    aParams.devInfo.setSupportsUTC( true );
+                    break;
+                case ELEMENT_SUPPORTLARGEOBJS:
+                    aParams.devInfo.setSupportsLargeObjs( true );
+                    break;
+                case ELEMENT_SUPPORTNUMBEROFCHANGES:
+                    aParams.devInfo.setSupportsNumberOfChanges( true );
+                    break;
+                case ELEMENT_DATASTORE:
                 {
-                    readCTCap11( aParams.devInfo.datastores() );
+                    Datastore newDatastore;
+                    readDataStore( newDatastore, dtd );
+                    aParams.devInfo.datastores().append( newDatastore );
+                    break;
                 }
-                else
+                case ELEMENT_CTCAP:
                 {
-                    qCCritical(lcSyncML) << SYNCML_ELEMENT_CTCAP << "under DevInf allowed only for DS 1.1";
-                    iError = PARSER_ERROR_INVALID_DATA;
+                    // CTCap element resides under DevInf only 1.1, in 1.2 it's under
+                    // DataStore
+                    if( dtd == SYNCML_DTD_VERSION_1_1 )
+                    {
+                        readCTCap11( aParams.devInfo.datastores() );
+                    }
+                    else
+                    {
+                        qCCritical(lcSyncML) << SYNCML_ELEMENT_CTCAP << "under DevInf allowed only for DS 1.1";
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    break;
                 }
-            }
-            else{
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
     }
@@ -1048,69 +1621,73 @@ void SyncMLMessageParser::readDataStore( Datastore& aDatastore, const QString& a
 
     while( shouldContinue() )
     {
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_DATASTORE )
+        if( iReader.isEndElement() && iElement == ELEMENT_DATASTORE )
         {
             break;
         }
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_SOURCEREF )
-            {
-                QString URI = readString();
-                qCDebug(lcSyncML) << "URI of the new datastore instance:" << URI;
-                aDatastore.setSourceURI( URI );
-            }
-            else if( name == SYNCML_ELEMENT_RX_PREF )
-            {
-                ContentFormat rxPref;
-                readContentFormat( rxPref, SYNCML_ELEMENT_RX_PREF );
-                aDatastore.formatInfo().setPreferredRx( rxPref );
-            }
-            else if( name == SYNCML_ELEMENT_RX )
+            switch( iElement )
             {
-                ContentFormat rx;
-                readContentFormat( rx, SYNCML_ELEMENT_RX );
-                aDatastore.formatInfo().rx().append( rx );
-            }
-            else if( name == SYNCML_ELEMENT_TX_PREF )
-            {
-                ContentFormat txPref;
-                readContentFormat( txPref, SYNCML_ELEMENT_TX_PREF );
-                aDatastore.formatInfo().setPreferredTx( txPref );
-            }
-            else if( name == SYNCML_ELEMENT_TX )
-            {
-                ContentFormat tx;
-                readContentFormat( tx, SYNCML_ELEMENT_TX );
-                aDatastore.formatInfo().tx().append( tx );
-            }
-            else if( name == SYNCML_ELEMENT_SYNCCAP )
-            {
-                readSyncCaps( aDatastore );
-            }
-            else if( name == SYNCML_ELEMENT_CTCAP )
-            {
-                readCTCap12( aDatastore );
-            }
-            else if( name == SYNCML_ELEMENT_SUPPORTHIERARCHICALSYNC )
-            {
-                if( aDTD == SYNCML_DTD_VERSION_1_2 )
+                case ELEMENT_SOURCEREF:
                 {
-                    aDatastore.setSupportsHierarchicalSync( true );
+                    QString URI = readString();
+                    qCDebug(lcSyncML) << "URI of the new datastore instance:" << URI;
+                    aDatastore.setSourceURI( URI );
+                    break;
                 }
-                else
+                case ELEMENT_RX_PREF:
                 {
-                    qCCritical(lcSyncML) << SYNCML_ELEMENT_SUPPORTHIERARCHICALSYNC << "under DevInf allowed only for DS 1.2";
-                    iError = PARSER_ERROR_INVALID_DATA;
+                    ContentFormat rxPref;
+                    readContentFormat( rxPref, ELEMENT_RX_PREF );
+                    aDatastore.formatInfo().setPreferredRx( rxPref );
+                    break;
                 }
-            }
-            else
-            {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_RX:
+                {
+                    ContentFormat rx;
+                    readContentFormat( rx, ELEMENT_RX );
+                    aDatastore.formatInfo().rx().append( rx );
+                    break;
+                }
+                case ELEMENT_TX_PREF:
+                {
+                    ContentFormat txPref;
+                    readContentFormat( txPref, ELEMENT_TX_PREF );
+                    aDatastore.formatInfo().setPreferredTx( txPref );
+                    break;
+                }
+                case ELEMENT_TX:
+                {
+                    ContentFormat tx;
+                    readContentFormat( tx, ELEMENT_TX );
+                    aDatastore.formatInfo().tx().append( tx );
+                    break;
+                }
+                case ELEMENT_SYNCCAP:
+                    readSyncCaps( aDatastore );
+                    break;
+                case ELEMENT_CTCAP:
+                    readCTCap12( aDatastore );
+                    break;
+                case ELEMENT_SUPPORTHIERARCHICALSYNC:
+                {
+                    if( aDTD == SYNCML_DTD_VERSION_1_2 )
+                    {
+                        aDatastore.setSupportsHierarchicalSync( true );
+                    }
+                    else
+                    {
+                        qCCritical(lcSyncML) << SYNCML_ELEMENT_SUPPORTHIERARCHICALSYNC << "under DevInf allowed only for DS 1.2";
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
 
@@ -1118,35 +1695,32 @@ void SyncMLMessageParser::readDataStore( Datastore& aDatastore, const QString& a
 
 }
 
-void SyncMLMessageParser::readContentFormat( ContentFormat& aFormat, const QString& aEndElement )
+void SyncMLMessageParser::readContentFormat( ContentFormat& aFormat, ElementToken aEndElement )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     while( shouldContinue() )
     {
-        iReader.readNext();
+        readNext();
 
-        QStringRef name = iReader.name();
-
-        if( iReader.isEndElement() && name == aEndElement )
+        if( iReader.isEndElement() && iElement == aEndElement )
         {
             break;
         }
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_CTTYPE )
-            {
-                aFormat.iType = readString();
-            }
-            else if( name == SYNCML_ELEMENT_VERCT )
-            {
-                aFormat.iVersion = readString();
-            }
-            else
+            switch( iElement )
             {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_CTTYPE:
+                    aFormat.iType = readString();
+                    break;
+                case ELEMENT_VERCT:
+                    aFormat.iVersion = readString();
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
@@ -1159,24 +1733,22 @@ void SyncMLMessageParser::readSyncCaps( Datastore& aDatastore )
 
     while( shouldContinue() )
     {
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_SYNCCAP )
+        if( iReader.isEndElement() && iElement == ELEMENT_SYNCCAP )
         {
             break;
         }
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_SYNCTYPE )
+            if( iElement == ELEMENT_SYNCTYPE )
             {
                 int syncType = readInt();
                 aDatastore.syncCaps().append( static_cast<SyncTypes>( syncType ) );
             }
             else
             {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
             }
         }
     }
@@ -1192,17 +1764,15 @@ void SyncMLMessageParser::readCTCap11( QList<Datastore>& aDataStores )
 
     while( shouldContinue() )
     {
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_CTCAP )
+        if( iReader.isEndElement() && iElement == ELEMENT_CTCAP )
         {
             break;
         }
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_CTTYPE )
+            if( iElement == ELEMENT_CTTYPE )
             {
                 QString type = readString();
 
@@ -1229,61 +1799,67 @@ void SyncMLMessageParser::readCTCap11( QList<Datastore>& aDataStores )
                 }
 
             }
-            else
+            else if( !currentCap )
             {
-                if( !currentCap )
-                {
-                    qCCritical(lcSyncML) << "Cannot process" << name <<"as no" << SYNCML_ELEMENT_CTTYPE << "was found!";
-                    iError = PARSER_ERROR_INVALID_DATA;
-                }
-                else if( name == SYNCML_ELEMENT_PROPNAME )
-                {
-                    CTCapProperty newProp;
-                    newProp.iName = readString();
-                    currentCap->properties().append( newProp );
-                }
-                else if( name == SYNCML_ELEMENT_VALENUM )
-                {
-                    QString val = readString();
-                    currentCap->properties().last().iValues.append( val );
-                }
-                else if( name == SYNCML_ELEMENT_DATATYPE )
-                {
-                    QString type = readString();
-                    currentCap->properties().last().iType = type;
-                }
-                else if( name == SYNCML_ELEMENT_SIZE )
-                {
-                    int size = readInt();
-                    currentCap->properties().last().iSize = size;
-                }
-                else if( name == SYNCML_ELEMENT_DISPLAYNAME )
-                {
-                    QString displayName = readString();
-                    currentCap->properties().last().iDisplayName = displayName;
-                }
-                else if( name == SYNCML_ELEMENT_PARAMNAME )
+                qCCritical(lcSyncML) << "Cannot process" << iReader.name() <<"as no" << SYNCML_ELEMENT_CTTYPE << "was found!";
+                iError = PARSER_ERROR_INVALID_DATA;
+            }
+            else
+            {
+                switch( iElement )
                 {
-                    // In SyncML 1.1, parameter names (for example TYPE) are not conveyed, instead
-                    // parameter values (for example WORK). So we must create an anonymous parameter
-                    // that includes all the allowed parameter values
-                    QString paramName = readString();
-                    if( currentCap->properties().last().iParameters.isEmpty() )
+                    case ELEMENT_PROPNAME:
                     {
-                        CTCapParameter newParam;
-                        newParam.iValues.append( paramName );
-                        currentCap->properties().last().iParameters.append( newParam );
+                        CTCapProperty newProp;
+                        newProp.iName = readString();
+                        currentCap->properties().append( newProp );
+                        break;
                     }
-                    else
+                    case ELEMENT_VALENUM:
                     {
-                        currentCap->properties().last().iParameters.last().iValues.append( paramName );
+                        QString val = readString();
+                        currentCap->properties().last().iValues.append( val );
+                        break;
                     }
-                            \
-
-                }
-                else
-                {
-                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                    case ELEMENT_DATATYPE:
+                    {
+                        QString type = readString();
+                        currentCap->properties().last().iType = type;
+                        break;
+                    }
+                    case ELEMENT_SIZE:
+                    {
+                        int size = readInt();
+                        currentCap->properties().last().iSize = size;
+                        break;
+                    }
+                    case ELEMENT_DISPLAYNAME:
+                    {
+                        QString displayName = readString();
+                        currentCap->properties().last().iDisplayName = displayName;
+                        break;
+                    }
+                    case ELEMENT_PARAMNAME:
+                    {
+                        // In SyncML 1.1, parameter names (for example TYPE) are not conveyed, instead
+                        // parameter values (for example WORK). So we must create an anonymous parameter
+                        // that includes all the allowed parameter values
+                        QString paramName = readString();
+                        if( currentCap->properties().last().iParameters.isEmpty() )
+                        {
+                            CTCapParameter newParam;
+                            newParam.iValues.append( paramName );
+                            currentCap->properties().last().iParameters.append( newParam );
+                        }
+                        else
+                        {
+                            currentCap->properties().last().iParameters.last().iValues.append( paramName );
+                        }
+                        break;
+                    }
+                    default:
+                        qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                        break;
                 }
 
             }
@@ -1326,49 +1902,67 @@ void SyncMLMessageParser::readCTCap12( Datastore& aDatastore )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    CTCap cap;
+    // CTCaps are rarely needed and can be large, so they are captured as XML
+    // and decoded only when accessed. Prefixed elements would lose their
+    // namespace declarations when captured, and without the original bytes
+    // capturing would mean re-serializing, so they are decoded right away.
+    if( iReader.prefix().isEmpty() && rawInputAvailable() )
+    {
+        aDatastore.addCTCapData( readRawElement() );
+    }
+    else
+    {
+        CTCap cap;
+        readCTCap12( cap );
+        aDatastore.ctCaps().append( cap );
+    }
+}
+
+void SyncMLMessageParser::readCTCap12( CTCap& aCTCap )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
     while( shouldContinue() )
     {
-        iReader.readNext();
+        readNext();
 
-        QStringRef name = iReader.name();
-
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_CTCAP )
+        if( iReader.isEndElement() && iElement == ELEMENT_CTCAP )
         {
             break;
         }
 
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_CTTYPE )
-            {
-                ContentFormat format = cap.getFormat();
-                format.iType = readString();
-                cap.setFormat( format );
-
-            }
-            else if( name == SYNCML_ELEMENT_VERCT )
-            {
-                ContentFormat format = cap.getFormat();
-                format.iVersion = readString();
-                cap.setFormat( format );
-            }
-            else if( name == SYNCML_ELEMENT_PROPERTY )
-            {
-                CTCapProperty newProperty;
-                readCTCap12Property( newProperty );
-                cap.properties().append( newProperty );
-            }
-            else
+            switch( iElement )
             {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_CTTYPE:
+                {
+                    ContentFormat format = aCTCap.getFormat();
+                    format.iType = readString();
+                    aCTCap.setFormat( format );
+                    break;
+                }
+                case ELEMENT_VERCT:
+                {
+                    ContentFormat format = aCTCap.getFormat();
+                    format.iVersion = readString();
+                    aCTCap.setFormat( format );
+                    break;
+                }
+                case ELEMENT_PROPERTY:
+                {
+                    CTCapProperty newProperty;
+                    readCTCap12Property( newProperty );
+                    aCTCap.properties().append( newProperty );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
 
     }
-
-    aDatastore.ctCaps().append( cap );
 }
 
 void SyncMLMessageParser::readCTCap12Property( CTCapProperty& aProperty )
@@ -1377,55 +1971,48 @@ void SyncMLMessageParser::readCTCap12Property( CTCapProperty& aProperty )
 
     while( shouldContinue() )
     {
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_PROPERTY )
+        if( iReader.isEndElement() && iElement == ELEMENT_PROPERTY )
         {
             break;
         }
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_PROPNAME )
-            {
-                aProperty.iName = readString();
-            }
-            else if( name == SYNCML_ELEMENT_DATATYPE )
-            {
-                aProperty.iType = readString();
-            }
-            else if( name == SYNCML_ELEMENT_MAXOCCUR )
-            {
-                aProperty.iMaxOccur = readInt();
-            }
-            else if( name == SYNCML_ELEMENT_MAXSIZE )
-            {
-                aProperty.iSize = readInt();
-            }
-            else if( name == SYNCML_ELEMENT_NOTRUNCATE )
-            {
-                aProperty.iNoTruncate = true;
-            }
-            else if( name == SYNCML_ELEMENT_DISPLAYNAME )
+            switch( iElement )
             {
-                aProperty.iDisplayName = readString();
-            }
-            else if( name == SYNCML_ELEMENT_VALENUM )
-            {
-                aProperty.iValues.append( readString() );
-            }
-            else if( name == SYNCML_ELEMENT_PROPPARAM )
-            {
-                CTCapParameter newParam;
-                readCTCap12Parameter( newParam );
-                aProperty.iParameters.append( newParam );
-            }
-            else
-            {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_PROPNAME:
+                    aProperty.iName = readString();
+                    break;
+                case ELEMENT_DATATYPE:
+                    aProperty.iType = readString();
+                    break;
+                case ELEMENT_MAXOCCUR:
+                    aProperty.iMaxOccur = readInt();
+                    break;
+                case ELEMENT_MAXSIZE:
+                    aProperty.iSize = readInt();
+                    break;
+                case ELEMENT_NOTRUNCATE:
+                    aProperty.iNoTruncate = true;
+                    break;
+                case ELEMENT_DISPLAYNAME:
+                    aProperty.iDisplayName = readString();
+                    break;
+                case ELEMENT_VALENUM:
+                    aProperty.iValues.append( readString() );
+                    break;
+                case ELEMENT_PROPPARAM:
+                {
+                    CTCapParameter newParam;
+                    readCTCap12Parameter( newParam );
+                    aProperty.iParameters.append( newParam );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
@@ -1438,38 +2025,33 @@ void SyncMLMessageParser::readCTCap12Parameter( CTCapParameter& aParameter )
 
     while( shouldContinue() )
     {
-        iReader.readNext();
+        readNext();
 
-        QStringRef name = iReader.name();
-
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_PROPPARAM )
+        if( iReader.isEndElement() && iElement == ELEMENT_PROPPARAM )
         {
             break;
         }
 
         if( iReader.isStartElement() )
         {
-            if( name == SYNCML_ELEMENT_PARAMNAME )
-            {
-                aParameter.iName = readString();
-            }
-            else if( name == SYNCML_ELEMENT_DATATYPE )
-            {
-                aParameter.iType = readString();
-            }
-            else if( name == SYNCML_ELEMENT_DISPLAYNAME )
-            {
-                aParameter.iDisplayName = readString();
-            }
-            else if( name == SYNCML_ELEMENT_VALENUM )
-            {
-                aParameter.iValues.append( readString() );
-            }
-            else
+            switch( iElement )
             {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << name;
+                case ELEMENT_PARAMNAME:
+                    aParameter.iName = readString();
+                    break;
+                case ELEMENT_DATATYPE:
+                    aParameter.iType = readString();
+                    break;
+                case ELEMENT_DISPLAYNAME:
+                    aParameter.iDisplayName = readString();
+                    break;
+                case ELEMENT_VALENUM:
+                    aParameter.iValues.append( readString() );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
-
         }
 
     }
@@ -1482,38 +2064,39 @@ void SyncMLMessageParser::readItem( ItemParams& aParams )
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
-        if( iReader.isEndElement() && name == SYNCML_ELEMENT_ITEM ) {
+        if( iReader.isEndElement() && iElement == ELEMENT_ITEM ) {
             break;
         }
 
         if( iReader.isStartElement() ) {
-            if (name == SYNCML_ELEMENT_META) {
-                readMeta( aParams.meta );
-            }
-            else if (name == SYNCML_ELEMENT_TARGET) {
-                aParams.target = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_SOURCE) {
-                aParams.source = readURI();
-            }
-            else if( name == SYNCML_ELEMENT_TARGETPARENT ) {
-                aParams.targetParent = readURI();
-            }
-            else if( name == SYNCML_ELEMENT_SOURCEPARENT ) {
-                aParams.sourceParent = readURI();
-            }
-            else if (name == SYNCML_ELEMENT_DATA) {
-                aParams.data = readMixed();
-            }
-            else if (name == SYNCML_ELEMENT_MOREDATA) {
-                aParams.moreData = true;
-            }
-            else {
-                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in ITEM:NOT HANDLED BY PARSER" << name;
+            switch( iElement )
+            {
+                case ELEMENT_META:
+                    readMeta( aParams.meta );
+                    break;
+                case ELEMENT_TARGET:
+                    aParams.target = readURI();
+                    break;
+                case ELEMENT_SOURCE:
+                    aParams.source = readURI();
+                    break;
+                case ELEMENT_TARGETPARENT:
+                    aParams.targetParent = readURI();
+                    break;
+                case ELEMENT_SOURCEPARENT:
+                    aParams.sourceParent = readURI();
+                    break;
+                case ELEMENT_DATA:
+                    aParams.data = readMixed();
+                    break;
+                case ELEMENT_MOREDATA:
+                    aParams.moreData = true;
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in ITEM:NOT HANDLED BY PARSER" << iReader.name();
+                    break;
             }
         }
     }
@@ -1528,19 +2111,17 @@ QString SyncMLMessageParser::readURI()
 
     while( shouldContinue() ) {
 
-        iReader.readNext();
-
-        QStringRef name = iReader.name();
+        readNext();
 
         if( iReader.isEndElement() &&
-            ( name == SYNCML_ELEMENT_TARGET ||
-              name == SYNCML_ELEMENT_SOURCE ||
-              name == SYNCML_ELEMENT_TARGETPARENT ||
-              name == SYNCML_ELEMENT_SOURCEPARENT ) ){
+            ( iElement == ELEMENT_TARGET ||
+              iElement == ELEMENT_SOURCE ||
+              iElement == ELEMENT_TARGETPARENT ||
+              iElement == ELEMENT_SOURCEPARENT ) ){
             break;
         }
 
-        if( iReader.isStartElement() && name == SYNCML_ELEMENT_LOCURI ) {
+        if( iReader.isStartElement() && iElement == ELEMENT_LOCURI ) {
             uri = readString();
             continue;
         }
@@ -1579,11 +2160,11 @@ QString SyncMLMessageParser::readString()
     return string;
 }
 
-QString SyncMLMessageParser::readMixed()
+ByteSlice SyncMLMessageParser::readMixed()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     QString text;
-    QString xml;
+    ByteSlice xml;
 
     while( shouldContinue() )
     {
@@ -1592,27 +2173,12 @@ QString SyncMLMessageParser::readMixed()
 
         if( iReader.isStartElement() )
         {
-            QString elementName = iReader.name().toString();
-
-            QByteArray buffer;
-            QXmlStreamWriter writer( &buffer );
-            writer.setAutoFormatting( false );
-
-            while( !(iReader.isEndElement() && iReader.name() == elementName ) )
-            {
-                writer.writeCurrentToken( iReader );
-                iReader.readNext();
-            }
-
-            writer.writeCurrentToken( iReader );
-
-            xml = QString::fromUtf8( buffer.constData() );
+            xml = readRawElement();
             break;
-
         }
         else if( iReader.isCharacters() )
         {
-            text.append( iReader.text().toString() );
+            text.append( iReader.text() );
         }
         else if( iReader.isEndElement() )
         {
@@ -1623,7 +2189,7 @@ QString SyncMLMessageParser::readMixed()
     if( xml.isEmpty() )
     {
         qCDebug(lcSyncML) << "Text was found:" << text.size() << "bytes";
-        return text;
+        return text.toUtf8();
     }
     else
     {
@@ -1632,6 +2198,373 @@ QString SyncMLMessageParser::readMixed()
     }
 }
 
+ByteSlice SyncMLMessageParser::readRawElement()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Embedded XML is handed out as a slice of the original bytes of the
+    // message whenever they can be located, so that it does not need to be
+    // re-serialized or copied
+    const QByteArray name = iReader.qualifiedName().toUtf8();
+    int start = -1;
+    int tagEnd = -1;
+
+    if( rawInputAvailable() ) {
+        start = rawElementStart( name, tagEnd );
+    }
+
+    if( start < 0 ) {
+        qCDebug(lcSyncML) << "Original bytes of embedded XML not available, re-serializing";
+        return readElement( iReader, true );
+    }
+
+    readElement( iReader, false );
+
+    const char* data = iInput.constData();
+    const int end = inputPosition( iReader.characterOffset() );
+
+    // Reader may have looked ahead past the end tag, so it is searched
+    // backwards from the current position
+    int close = end - 1;
+    while( close > tagEnd && data[close] != '>' ) {
+        --close;
+    }
+
+    if( close == tagEnd && data[tagEnd - 1] == '/' ) {
+        // Empty element tag
+        return ByteSlice( iInput, start, close + 1 - start );
+    }
+
+    int open = close - 1;
+    while( open > tagEnd && data[open] != '<' ) {
+        --open;
+    }
+
+    const QByteArray endTag = QByteArray( "</" ) + name;
+
+    if( close > tagEnd && open > tagEnd &&
+        QByteArray::fromRawData( data + open, close - open ).startsWith( endTag ) &&
+        QByteArray::fromRawData( data + open + endTag.size(), close - open - endTag.size() ).trimmed().isEmpty() ) {
+        return ByteSlice( iInput, start, close + 1 - start );
+    }
+
+    // End of the element could not be located, read it again from the
+    // original bytes
+    qCWarning(lcSyncML) << "Could not locate end of embedded XML, re-serializing";
+
+    QXmlStreamReader reader( QByteArray::fromRawData( data + start, iInput.size() - start ) );
+    reader.setNamespaceProcessing( false );
+
+    while( !reader.atEnd() && !reader.isStartElement() ) {
+        reader.readNext();
+    }
+
+    return readElement( reader, true );
+}
+
+QByteArray SyncMLMessageParser::rawElementHash()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Hash is calculated from the original bytes of the element, which are
+    // located without reading the element. Element must not contain
+    // elements of the same name.
+    if( !rawInputAvailable() ) {
+        return QByteArray();
+    }
+
+    const QByteArray name = iReader.qualifiedName().toUtf8();
+    int tagEnd = -1;
+    const int start = rawElementStart( name, tagEnd );
+
+    if( start < 0 ) {
+        return QByteArray();
+    }
+
+    int end = tagEnd;
+
+    if( iInput.at( tagEnd - 1 ) != '/' ) {
+
+        const int close = iInput.indexOf( "</" + name, tagEnd );
+        end = ( close < 0 ) ? -1 : iInput.indexOf( '>', close );
+
+        if( end < 0 ) {
+            return QByteArray();
+        }
+    }
+
+    const QByteArray element = QByteArray::fromRawData( iInput.constData() + start, end + 1 - start );
+
+    return QCryptographicHash::hash( element, QCryptographicHash::Sha1 ).toHex();
+}
+
+bool SyncMLMessageParser::rawInputAvailable() const
+{
+    // Byte positions are valid only for UTF-8 messages
+    const QStringRef encoding = iReader.documentEncoding();
+
+    return !iInput.isEmpty() &&
+           ( encoding.isEmpty() || encoding.compare( QLatin1String( "UTF-8" ), Qt::CaseInsensitive ) == 0 );
+}
+
+int SyncMLMessageParser::rawElementStart( const QByteArray& aName, int& aTagEnd )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    const int end = inputPosition( iReader.characterOffset() );
+
+    if( end < 0 ) {
+        return -1;
+    }
+
+    // Reader may have looked ahead past the start tag, so a few of the
+    // preceding tags are tried
+    const char* data = iInput.constData();
+    const int size = iInput.size();
+    int tries = 0;
+
+    for( int i = end - 1; i >= iInputStart && tries < 3; --i ) {
+
+        if( data[i] != '<' ) {
+            continue;
+        }
+
+        ++tries;
+
+        const int nameEnd = i + 1 + aName.size();
+
+        if( nameEnd >= size || qstrncmp( data + i + 1, aName.constData(), aName.size() ) != 0 ) {
+            continue;
+        }
+
+        const char delimiter = data[nameEnd];
+
+        if( delimiter != '>' && delimiter != '/' && delimiter != ' ' && delimiter != '\t' &&
+            delimiter != '\r' && delimiter != '\n' ) {
+            continue;
+        }
+
+        // Find end of the tag, skipping quoted attribute values
+        char quote = 0;
+        int j = nameEnd;
+
+        for( ; j < end; ++j ) {
+            if( quote ) {
+                if( data[j] == quote ) {
+                    quote = 0;
+                }
+            }
+            else if( data[j] == '"' || data[j] == '\'' ) {
+                quote = data[j];
+            }
+            else if( data[j] == '>' ) {
+                break;
+            }
+        }
+
+        if( j < end ) {
+            aTagEnd = j;
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void SyncMLMessageParser::resetInput( const QByteArray& aInput, int aStart, qint64 aOffset )
+{
+    // Byte order mark is not reported as a character by the reader
+    if( aOffset == 0 && aInput.size() >= aStart + 3 &&
+        qstrncmp( aInput.constData() + aStart, "\xEF\xBB\xBF", 3 ) == 0 ) {
+        aStart += 3;
+    }
+
+    iInput = aInput;
+    iInputStart = aStart;
+    iInputStartOffset = aOffset;
+    iInputPos = aStart;
+    iInputOffset = aOffset;
+}
+
+void SyncMLMessageParser::appendInput( const QByteArray& aInput )
+{
+    // Character offsets continue from the end of the previous input
+    qint64 offset = iInputOffset;
+    const char* data = iInput.constData();
+
+    for( int i = iInputPos; i < iInput.size(); ++i ) {
+        offset += utf16Units( data[i] );
+    }
+
+    resetInput( aInput, 0, offset );
+}
+
+int SyncMLMessageParser::inputPosition( qint64 aOffset )
+{
+    // Offsets are asked mostly in increasing order, so the cursor is moved
+    // forward from where it was left
+    if( aOffset < iInputOffset ) {
+        iInputPos = iInputStart;
+        iInputOffset = iInputStartOffset;
+    }
+
+    const char* data = iInput.constData();
+    const int size = iInput.size();
+
+    while( iInputOffset < aOffset && iInputPos < size ) {
+        iInputOffset += utf16Units( data[iInputPos++] );
+    }
+
+    while( iInputPos < size && utf16Units( data[iInputPos] ) == 0 ) {
+        ++iInputPos;
+    }
+
+    return ( iInputOffset == aOffset ) ? iInputPos : -1;
+}
+
+namespace {
+
+// FNV-1a hash of an element name, evaluated at compile time for the element
+// constants
+constexpr quint32 elementHash( const char* aName, quint32 aHash = 2166136261u )
+{
+    return *aName ? elementHash( aName + 1, ( aHash ^ static_cast<quint8>( *aName ) ) * 16777619u ) : aHash;
+}
+
+quint32 elementHash( const QStringRef& aName )
+{
+    quint32 hash = 2166136261u;
+    const QChar* name = aName.unicode();
+
+    for( int i = 0; i < aName.size(); ++i ) {
+        hash = ( hash ^ name[i].unicode() ) * 16777619u;
+    }
+
+    return hash;
+}
+
+}
+
+#define ELEMENT_TOKEN( aName, aToken ) \
+    case elementHash( aName ): \
+        return aElement == QLatin1String( aName ) ? aToken : ELEMENT_UNKNOWN;
+
+SyncMLMessageParser::ElementToken SyncMLMessageParser::elementToken( const QStringRef& aElement )
+{
+    // Two element names with the same hash would not compile, as the case
+    // labels would be duplicates. Comparing against QLatin1String does not
+    // allocate, so unknown elements are rejected without copying the name.
+    switch( elementHash( aElement ) )
+    {
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SYNCML, ELEMENT_SYNCML )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SYNCHDR, ELEMENT_SYNCHDR )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SYNCBODY, ELEMENT_SYNCBODY )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_VERDTD, ELEMENT_VERDTD )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_VERPROTO, ELEMENT_VERPROTO )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SESSIONID, ELEMENT_SESSIONID )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MSGID, ELEMENT_MSGID )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_TARGET, ELEMENT_TARGET )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SOURCE, ELEMENT_SOURCE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_TARGETPARENT, ELEMENT_TARGETPARENT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SOURCEPARENT, ELEMENT_SOURCEPARENT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_LOCURI, ELEMENT_LOCURI )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_RESPURI, ELEMENT_RESPURI )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_NORESP, ELEMENT_NORESP )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CRED, ELEMENT_CRED )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CHAL, ELEMENT_CHAL )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_META, ELEMENT_META )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_FINAL, ELEMENT_FINAL )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CMDID, ELEMENT_CMDID )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MSGREF, ELEMENT_MSGREF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CMDREF, ELEMENT_CMDREF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CMD, ELEMENT_CMD )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_TARGETREF, ELEMENT_TARGETREF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SOURCEREF, ELEMENT_SOURCEREF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DATA, ELEMENT_DATA )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_ITEM, ELEMENT_ITEM )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MOREDATA, ELEMENT_MOREDATA )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CORRELATOR, ELEMENT_CORRELATOR )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_NUMOFCHANGES, ELEMENT_NUMOFCHANGES )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_STATUS, ELEMENT_STATUS )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SYNC, ELEMENT_SYNC )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_PUT, ELEMENT_PUT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_RESULTS, ELEMENT_RESULTS )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAP, ELEMENT_MAP )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAPITEM, ELEMENT_MAPITEM )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_ALERT, ELEMENT_ALERT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_ADD, ELEMENT_ADD )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_REPLACE, ELEMENT_REPLACE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DELETE, ELEMENT_DELETE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_GET, ELEMENT_GET )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_COPY, ELEMENT_COPY )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MOVE, ELEMENT_MOVE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_EXEC, ELEMENT_EXEC )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_ATOMIC, ELEMENT_ATOMIC )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SEQUENCE, ELEMENT_SEQUENCE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_FORMAT, ELEMENT_FORMAT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SIZE, ELEMENT_SIZE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_TYPE, ELEMENT_TYPE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_ANCHOR, ELEMENT_ANCHOR )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_NEXT, ELEMENT_NEXT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_LAST, ELEMENT_LAST )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_VERSION, ELEMENT_VERSION )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_NEXTNONCE, ELEMENT_NEXTNONCE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAXMSGSIZE, ELEMENT_MAXMSGSIZE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAXOBJSIZE, ELEMENT_MAXOBJSIZE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_EMI, ELEMENT_EMI )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MARK, ELEMENT_MARK )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DEVINF, ELEMENT_DEVINF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAN, ELEMENT_MAN )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MOD, ELEMENT_MOD )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_OEM, ELEMENT_OEM )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_FWVERSION, ELEMENT_FWVERSION )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SWVERSION, ELEMENT_SWVERSION )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_HWVERSION, ELEMENT_HWVERSION )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DEVID, ELEMENT_DEVID )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DEVTYPE, ELEMENT_DEVTYPE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_UTC, ELEMENT_UTC )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SUPPORTLARGEOBJS, ELEMENT_SUPPORTLARGEOBJS )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SUPPORTNUMBEROFCHANGES, ELEMENT_SUPPORTNUMBEROFCHANGES )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SUPPORTHIERARCHICALSYNC, ELEMENT_SUPPORTHIERARCHICALSYNC )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DATASTORE, ELEMENT_DATASTORE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_RX_PREF, ELEMENT_RX_PREF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_RX, ELEMENT_RX )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_TX_PREF, ELEMENT_TX_PREF )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_TX, ELEMENT_TX )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SYNCCAP, ELEMENT_SYNCCAP )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_SYNCTYPE, ELEMENT_SYNCTYPE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CTCAP, ELEMENT_CTCAP )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_CTTYPE, ELEMENT_CTTYPE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_VERCT, ELEMENT_VERCT )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_PROPERTY, ELEMENT_PROPERTY )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_PROPNAME, ELEMENT_PROPNAME )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_PROPPARAM, ELEMENT_PROPPARAM )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_PARAMNAME, ELEMENT_PARAMNAME )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_VALENUM, ELEMENT_VALENUM )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DATATYPE, ELEMENT_DATATYPE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_DISPLAYNAME, ELEMENT_DISPLAYNAME )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAXOCCUR, ELEMENT_MAXOCCUR )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_MAXSIZE, ELEMENT_MAXSIZE )
+        ELEMENT_TOKEN( SYNCML_ELEMENT_NOTRUNCATE, ELEMENT_NOTRUNCATE )
+        default:
+            return ELEMENT_UNKNOWN;
+    }
+}
+
+#undef ELEMENT_TOKEN
+
+void SyncMLMessageParser::readNext()
+{
+    iReader.readNext();
+
+    if( iReader.isStartElement() || iReader.isEndElement() ) {
+        iElement = elementToken( iReader.name() );
+    }
+    else {
+        iElement = ELEMENT_UNKNOWN;
+    }
+}
+
 bool SyncMLMessageParser::shouldContinue() const
 {
     if( iError == PARSER_ERROR_LAST && !iReader.atEnd() )
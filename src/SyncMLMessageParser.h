@@ -82,9 +82,22 @@ public:
      */
     QList<DataSync::Fragment*> takeFragments();
 
+    /*! \brief Retrieves the fragments completed so far while parsing a message
+     *         incrementally
+     *
+     * Ownership of the fragments is transferred. Fragments that were not yet
+     * available are retrieved with takeFragments() when parsing of the
+     * message has been completed.
+     * @return Completed fragments in the order they should be processed
+     */
+    QList<DataSync::Fragment*> takeAvailableFragments();
+
 public slots:
 
 	/*! \brief Parse incoming data
+	 *
+	 * Data can be either XML or WbXML. WbXML data is decoded directly with
+	 * WbXMLMessageDecoder.
 	 *
 	 * @param aDevice QIODevice from which to retrieve data
 	 * @param aIsNewPacket To indicate if the packet is a newly received or a
@@ -92,8 +105,56 @@ public slots:
 	 */
     void parseResponse( QIODevice *aDevice, bool aIsNewPacket );
 
+    /*! \brief Parse incoming data held in memory
+     *
+     * Same as parseResponse(), for data that is not available through a
+     * QIODevice, such as a message passed from another thread.
+     *
+     * @param aData Message to parse
+     * @param aIsNewPacket To indicate if the packet is a newly received or a
+     * purged one
+     */
+    void parseMessage( const QByteArray& aData, bool aIsNewPacket );
+
+    /*! \brief Sets the hash of remote device info that is already known
+     *
+     * DevInf element with this hash is not parsed again. Instead, its item is
+     * marked as cached.
+     *
+     * @param aHash Hash of the DevInf element, as reported in DevInfItemParams
+     */
+    void setKnownDevInfHash( const QByteArray& aHash );
+
+    /*! \brief Parse a chunk of incoming XML data
+     *
+     * Allows parsing a message while it is still being received. Whenever
+     * leading Status or Map fragments of the message have been completed,
+     * fragmentsAvailable() is emitted. parsingComplete() or
+     * parsingError() is emitted after the last chunk has been parsed.
+     *
+     * @param aData Chunk of the message
+     * @param aFirstChunk True if this is the first chunk of a new message
+     * @param aLastChunk True if this is the last chunk of the message
+     */
+    void parseChunk( const QByteArray& aData, bool aFirstChunk, bool aLastChunk );
+
+    /*! \brief Abandon the message being parsed incrementally
+     *
+     * Should be invoked when the rest of the message will not be received.
+     * Fragments that have not been released are discarded, and no signals are
+     * emitted for the message.
+     */
+    void cancelStream();
+
 signals:
 
+    /*! \brief Emitted when fragments have been completed while parsing a
+     *         message incrementally
+     *
+     * Completed fragments can be retrieved with takeAvailableFragments().
+     */
+    void fragmentsAvailable();
+
     /*! \brief Emitted when parsing of a message has been completed
      *
      * @param aLastMessageInPackage True if the parsed message contained
@@ -108,12 +169,130 @@ signals:
     void parsingError( DataSync::ParserError aEvent );
 
 private:
+
+    /*! \brief Tokens of the elements handled by the parser
+     *
+     * Element names are mapped to tokens once per start and end tag, so that
+     * the read functions can dispatch with a switch instead of comparing
+     * strings.
+     */
+    enum ElementToken
+    {
+        ELEMENT_UNKNOWN,
+        ELEMENT_SYNCML,
+        ELEMENT_SYNCHDR,
+        ELEMENT_SYNCBODY,
+        ELEMENT_VERDTD,
+        ELEMENT_VERPROTO,
+        ELEMENT_SESSIONID,
+        ELEMENT_MSGID,
+        ELEMENT_TARGET,
+        ELEMENT_SOURCE,
+        ELEMENT_TARGETPARENT,
+        ELEMENT_SOURCEPARENT,
+        ELEMENT_LOCURI,
+        ELEMENT_RESPURI,
+        ELEMENT_NORESP,
+        ELEMENT_CRED,
+        ELEMENT_CHAL,
+        ELEMENT_META,
+        ELEMENT_FINAL,
+        ELEMENT_CMDID,
+        ELEMENT_MSGREF,
+        ELEMENT_CMDREF,
+        ELEMENT_CMD,
+        ELEMENT_TARGETREF,
+        ELEMENT_SOURCEREF,
+        ELEMENT_DATA,
+        ELEMENT_ITEM,
+        ELEMENT_MOREDATA,
+        ELEMENT_CORRELATOR,
+        ELEMENT_NUMOFCHANGES,
+        ELEMENT_STATUS,
+        ELEMENT_SYNC,
+        ELEMENT_PUT,
+        ELEMENT_RESULTS,
+        ELEMENT_MAP,
+        ELEMENT_MAPITEM,
+        ELEMENT_ALERT,
+        ELEMENT_ADD,
+        ELEMENT_REPLACE,
+        ELEMENT_DELETE,
+        ELEMENT_GET,
+        ELEMENT_COPY,
+        ELEMENT_MOVE,
+        ELEMENT_EXEC,
+        ELEMENT_ATOMIC,
+        ELEMENT_SEQUENCE,
+        ELEMENT_FORMAT,
+        ELEMENT_SIZE,
+        ELEMENT_TYPE,
+        ELEMENT_ANCHOR,
+        ELEMENT_NEXT,
+        ELEMENT_LAST,
+        ELEMENT_VERSION,
+        ELEMENT_NEXTNONCE,
+        ELEMENT_MAXMSGSIZE,
+        ELEMENT_MAXOBJSIZE,
+        ELEMENT_EMI,
+        ELEMENT_MARK,
+        ELEMENT_DEVINF,
+        ELEMENT_MAN,
+        ELEMENT_MOD,
+        ELEMENT_OEM,
+        ELEMENT_FWVERSION,
+        ELEMENT_SWVERSION,
+        ELEMENT_HWVERSION,
+        ELEMENT_DEVID,
+        ELEMENT_DEVTYPE,
+        ELEMENT_UTC,
+        ELEMENT_SUPPORTLARGEOBJS,
+        ELEMENT_SUPPORTNUMBEROFCHANGES,
+        ELEMENT_SUPPORTHIERARCHICALSYNC,
+        ELEMENT_DATASTORE,
+        ELEMENT_RX_PREF,
+        ELEMENT_RX,
+        ELEMENT_TX_PREF,
+        ELEMENT_TX,
+        ELEMENT_SYNCCAP,
+        ELEMENT_SYNCTYPE,
+        ELEMENT_CTCAP,
+        ELEMENT_CTTYPE,
+        ELEMENT_VERCT,
+        ELEMENT_PROPERTY,
+        ELEMENT_PROPNAME,
+        ELEMENT_PROPPARAM,
+        ELEMENT_PARAMNAME,
+        ELEMENT_VALENUM,
+        ELEMENT_DATATYPE,
+        ELEMENT_DISPLAYNAME,
+        ELEMENT_MAXOCCUR,
+        ELEMENT_MAXSIZE,
+        ELEMENT_NOTRUNCATE
+    };
+
+    static ElementToken elementToken( const QStringRef& aElement );
+
+    void readNext();
+
+    bool isWbXML( QIODevice* aDevice ) const;
+    void decodeWbXML( const QByteArray& aData );
     void startParsing();
+    void finishParsing();
+
+    void beginStream();
+    int scanStream();
+    void parseStream();
+    void releaseFragments();
 
 	void readHeader();
 
 	void readBody();
 
+    void readBodyElement( ElementToken aElement );
+
+    void insertDevInfFragment( Fragment* aFragment );
+
 	void readStatus();
 
 	void readSync();
@@ -126,11 +305,11 @@ private:
 
     void readMapItem( MapItemParams& aParams );
 
-    bool readCommand( const QStringRef& aName, CommandParams& aCommand );
+    bool readCommand( ElementToken aElement, CommandParams& aCommand );
 
-    void readLeafCommand( CommandParams& aParams, const QString& aCommand );
+    void readLeafCommand( CommandParams& aParams, ElementToken aCommand );
 
-    void readContainerCommand( CommandParams& aParams, const QString& aCommand );
+    void readContainerCommand( CommandParams& aParams, ElementToken aCommand );
 
     void readChal( ChalParams& aParams );
 
@@ -148,7 +327,7 @@ private:
 
     void readDataStore( Datastore& aDatastore, const QString& aDTD );
 
-    void readContentFormat( ContentFormat& aFormat, const QString& aEndElement );
+    void readContentFormat( ContentFormat& aFormat, ElementToken aEndElement );
 
     void readSyncCaps( Datastore& aDatastore );
 
@@ -156,6 +335,8 @@ private:
 
     void readCTCap12( Datastore& aDatastore );
 
+    void readCTCap12( CTCap& aCTCap );
+
     void readCTCap12Property( CTCapProperty& aProperty );
 
     void readCTCap12Parameter( CTCapParameter& aParameter );
@@ -166,7 +347,21 @@ private:
 
 	QString readString();
 
-    QString readMixed();
+    ByteSlice readMixed();
+
+    ByteSlice readRawElement();
+
+    QByteArray rawElementHash();
+
+    bool rawInputAvailable() const;
+
+    int rawElementStart( const QByteArray& aName, int& aTagEnd );
+
+    void resetInput( const QByteArray& aInput, int aStart, qint64 aOffset );
+
+    void appendInput( const QByteArray& aInput );
+
+    int inputPosition( qint64 aOffset );
 
     bool shouldContinue() const;
 
@@ -181,7 +376,47 @@ private:
     bool                        iSyncHdrFound;
     bool                        iSyncBodyFound;
     bool                        iIsNewPacket;
-
+    ElementToken                iElement;
+    QByteArray                  iKnownDevInfHash;
+
+    enum ScanState
+    {
+        SCAN_TEXT,
+        SCAN_MARKUP,
+        SCAN_START_TAG,
+        SCAN_QUOTED,
+        SCAN_END_TAG,
+        SCAN_DECLARATION,
+        SCAN_DOCTYPE,
+        SCAN_COMMENT,
+        SCAN_CDATA,
+        SCAN_PI
+    };
+
+    bool                        iStreaming;
+    QByteArray                  iStreamData;
+    int                         iScanPos;
+    int                         iScanTagStart;
+    ScanState                   iScanState;
+    int                         iScanDepth;
+    int                         iScanBrackets;
+    char                        iScanQuote;
+    bool                        iScanInBody;
+    bool                        iStreamInBody;
+    bool                        iStreamBlocked;
+    bool                        iFragmentsReleased;
+    int                         iAvailableFragments;
+
+    // Raw bytes of the message for capturing embedded XML, and a cursor
+    // mapping character offsets of the reader to byte positions in them
+    QByteArray                  iInput;
+    int                         iInputStart;
+    qint64                      iInputStartOffset;
+    int                         iInputPos;
+    qint64                      iInputOffset;
+
+    // Fragments created while parsing are placed in blocks of this arena
+    FragmentArena               iFragmentArena;
 
     friend class ::SyncMLMessageParserTest;
 };
@@ -131,3 +131,14 @@ void SyncResults::addProcessedItem( DataSync::ModificationType aModificationType
     }
 
 }
+
+void SyncResults::addPrefetchStatistics( const QString& aDatabase, int aHits, int aStalls, qint64 aStallTime )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    DatabaseResults& results = iResults[aDatabase];
+
+    results.iPrefetchHits += aHits;
+    results.iPrefetchStalls += aStalls;
+    results.iPrefetchStallTime += aStallTime;
+}
@@ -53,8 +53,13 @@ struct DatabaseResults {
     int     iRemoteItemsModified;   /*!<The number of items updated in the remote database*/
     int     iRemoteItemsDeleted;    /*!<The number of items deleted from the remote database*/
 
+    int     iPrefetchHits;          /*!<The number of sent items that had been prefetched when needed*/
+    int     iPrefetchStalls;        /*!<The number of sent items that had to be waited for*/
+    qint64  iPrefetchStallTime;     /*!<Time spent waiting for items to be fetched, in milliseconds*/
+
     DatabaseResults() : iLocalItemsAdded( 0 ), iLocalItemsModified( 0 ), iLocalItemsDeleted( 0 ),
-                        iRemoteItemsAdded( 0 ), iRemoteItemsModified( 0 ), iRemoteItemsDeleted( 0 ) { }
+                        iRemoteItemsAdded( 0 ), iRemoteItemsModified( 0 ), iRemoteItemsDeleted( 0 ),
+                        iPrefetchHits( 0 ), iPrefetchStalls( 0 ), iPrefetchStallTime( 0 ) { }
 
 };
 
@@ -132,6 +137,15 @@ public:
                            DataSync::ModifiedDatabase aModifiedDatabase,
                            const QString& aDatabase );
 
+    /*! \brief Adds item prefetching statistics to database results
+     *
+     * @param aDatabase Identifier of the database that items were fetched from
+     * @param aHits Number of items that had been prefetched when needed
+     * @param aStalls Number of items that had to be waited for
+     * @param aStallTime Time spent waiting for items, in milliseconds
+     */
+    void addPrefetchStatistics( const QString& aDatabase, int aHits, int aStalls, qint64 aStallTime );
+
 private:
 
     SyncState                       iState;
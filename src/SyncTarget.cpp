@@ -48,6 +48,7 @@ SyncTarget::SyncTarget( ChangeLog* aChangeLog, StoragePlugin* aPlugin,
     iPlugin( aPlugin ),
     iSyncMode( aSyncMode ),
     iLocalNextAnchor( aLocalNextAnchor ),
+    iUIDMappingHoles( 0 ),
     iReverted( false ),
     iLocalChangesDiscovered( false )
 {
@@ -167,9 +168,9 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
 
     bool success = false;
 
-    iLocalChanges.added.clear();
-    iLocalChanges.modified.clear();
-    iLocalChanges.removed.clear();
+    QList<SyncItemKey> added;
+    QList<SyncItemKey> modified;
+    QList<SyncItemKey> removed;
 
     qCDebug(lcSyncML) << "Analyzing local changes";
     qCDebug(lcSyncML) << "Sync Type getting Local Changes " << iSyncMode.toSyncMLCode();
@@ -185,7 +186,7 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
             qCDebug(lcSyncML) << "Slow sync mode";
 
             if (iPlugin != NULL) {
-                success = iPlugin->getAll( iLocalChanges.added );
+                success = iPlugin->getAll( added );
             }
         }
 	else if( iSyncMode.syncType() == TYPE_REFRESH ) {
@@ -194,7 +195,7 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
             if( aRole == ROLE_CLIENT && direction == DIRECTION_FROM_CLIENT ) {
                 qCDebug(lcSyncML) << "We need to send all changes as a client";
                 if (iPlugin != NULL) {
-                    success = iPlugin->getAll( iLocalChanges.added );
+                    success = iPlugin->getAll( added );
                 }
             }
         }
@@ -209,13 +210,13 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
                 if( time.toString().isEmpty() )
                 {
                     qCDebug(lcSyncML) << "Getting All modifications for a 1st time fast sync req";
-                    success = iPlugin->getAll( iLocalChanges.added );
+                    success = iPlugin->getAll( added );
                 }
                 else
                 {
-                    success = iPlugin->getModifications( iLocalChanges.added,
-                                                      iLocalChanges.modified,
-                                                      iLocalChanges.removed,
+                    success = iPlugin->getModifications( added,
+                                                      modified,
+                                                      removed,
                                                       time );
                 }
             }
@@ -228,6 +229,10 @@ bool SyncTarget::discoverLocalChanges( const Role& aRole )
         success = true;
     }
 
+    iLocalChanges.added = added;
+    iLocalChanges.modified = modified;
+    iLocalChanges.removed = removed;
+
     qCDebug(lcSyncML) << "Number of items added: " << iLocalChanges.added.count();
     qCDebug(lcSyncML) << "Number of items modified: " << iLocalChanges.modified.count();
     qCDebug(lcSyncML) << "Number of items deleted: " << iLocalChanges.removed.count();
@@ -256,6 +261,8 @@ StoragePlugin* SyncTarget::getPlugin() const
 void SyncTarget::addUIDMapping( const UIDMapping& aMapping )
 {
     iUIDMappings.append( aMapping );
+    iLiveUIDMappings.append( true );
+    indexUIDMapping( iUIDMappings.count() - 1 );
 }
 
 
@@ -263,26 +270,66 @@ void SyncTarget::removeUIDMapping( const SyncItemKey& aLocalKey )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    for( int i = 0; i < iUIDMappings.count(); ++i ) {
-        if( iUIDMappings[i].iLocalUID == aLocalKey ) {
-            iUIDMappings.removeAt( i );
-            break;
+    QHash<SyncItemKey, int>::iterator position = iLocalUIDPositions.find( aLocalKey );
+
+    if( position == iLocalUIDPositions.end() ) {
+        return;
+    }
+
+    // Removed mapping is left as a hole, so that the positions of the
+    // others stay valid
+    int removedPosition = position.value();
+    const UIDMapping& removed = iUIDMappings.at( removedPosition );
+    iLiveUIDMappings[removedPosition] = false;
+    ++iUIDMappingHoles;
+
+    // Another mapping of either UID takes the place of the removed one. The
+    // list is searched only if there is one, which is rarely the case
+    QHash<SyncItemKey, int>::iterator localDuplicates = iLocalUIDDuplicates.find( aLocalKey );
+
+    if( localDuplicates == iLocalUIDDuplicates.end() ) {
+        iLocalUIDPositions.erase( position );
+    }
+    else {
+        position.value() = findUIDMapping( removedPosition + 1, aLocalKey, true );
+
+        if( --localDuplicates.value() == 0 ) {
+            iLocalUIDDuplicates.erase( localDuplicates );
         }
     }
+
+    QHash<QString, int>::iterator remoteDuplicates = iRemoteUIDDuplicates.find( removed.iRemoteUID );
+
+    if( remoteDuplicates == iRemoteUIDDuplicates.end() ) {
+        iLocalUIDs.remove( removed.iRemoteUID );
+    }
+    else {
+        // Earlier mappings of the remote UID have another local UID, as the
+        // first mapping of the local UID was removed. If the removed mapping
+        // was the first one of the remote UID, the next one takes its place
+        QHash<QString, SyncItemKey>::iterator localUID = iLocalUIDs.find( removed.iRemoteUID );
+
+        if( localUID.value() == aLocalKey ) {
+            int next = findUIDMapping( removedPosition + 1, removed.iRemoteUID, false );
+            localUID.value() = iUIDMappings.at( next ).iLocalUID;
+        }
+
+        if( --remoteDuplicates.value() == 0 ) {
+            iRemoteUIDDuplicates.erase( remoteDuplicates );
+        }
+    }
+
+    // Compact once holes outnumber mappings, which keeps memory use bounded
+    if( iUIDMappingHoles > iUIDMappings.count() / 2 ) {
+        compactUIDMappings();
+    }
 }
 
 SyncItemKey SyncTarget::mapToLocalUID( const QString& aRemoteKey ) const
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    SyncItemKey localUID;
-
-    for( int i = 0; i < iUIDMappings.count(); ++i ) {
-        if( iUIDMappings[i].iRemoteUID == aRemoteKey ) {
-            localUID = iUIDMappings[i].iLocalUID;
-            break;
-        }
-    }
+    SyncItemKey localUID = iLocalUIDs.value( aRemoteKey );
 
     if( localUID.isEmpty() ) {
         qCDebug(lcSyncML) << "Warning: no existing mapping found for remote key" << aRemoteKey;
@@ -295,30 +342,109 @@ QString SyncTarget::mapToRemoteUID( const SyncItemKey& aLocalUID ) const
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    QString remoteUID;
+    QHash<SyncItemKey, int>::const_iterator position = iLocalUIDPositions.constFind( aLocalUID );
 
-    for( int i = 0; i < iUIDMappings.count(); ++i ) {
-        if( iUIDMappings[i].iLocalUID == aLocalUID ) {
-            remoteUID = iUIDMappings[i].iRemoteUID;
-            break;
-        }
+    if( position == iLocalUIDPositions.constEnd() ) {
+        return QString();
     }
-    return remoteUID;
+
+    return iUIDMappings.at( position.value() ).iRemoteUID;
 }
 
 void SyncTarget::loadUIDMappings()
 {
+    clearUIDMappings();
+
     iUIDMappings = iChangeLog->getMaps();
+
+    iLocalUIDs.reserve( iUIDMappings.count() );
+    iLocalUIDPositions.reserve( iUIDMappings.count() );
+
+    for( int i = 0; i < iUIDMappings.count(); ++i ) {
+        iLiveUIDMappings.append( true );
+        indexUIDMapping( i );
+    }
 }
 
 const QList<UIDMapping>& SyncTarget::getUIDMappings() const
 {
+    compactUIDMappings();
     return iUIDMappings;
 }
 
 void SyncTarget::clearUIDMappings()
 {
     iUIDMappings.clear();
+    iLiveUIDMappings.clear();
+    iUIDMappingHoles = 0;
+    iLocalUIDs.clear();
+    iLocalUIDPositions.clear();
+    iRemoteUIDDuplicates.clear();
+    iLocalUIDDuplicates.clear();
+}
+
+void SyncTarget::indexUIDMapping( int aPosition )
+{
+    const UIDMapping& mapping = iUIDMappings.at( aPosition );
+
+    // The first of duplicate mappings is the one that lookups return
+    if( iLocalUIDs.contains( mapping.iRemoteUID ) ) {
+        ++iRemoteUIDDuplicates[mapping.iRemoteUID];
+    }
+    else {
+        iLocalUIDs.insert( mapping.iRemoteUID, mapping.iLocalUID );
+    }
+
+    if( iLocalUIDPositions.contains( mapping.iLocalUID ) ) {
+        ++iLocalUIDDuplicates[mapping.iLocalUID];
+    }
+    else {
+        iLocalUIDPositions.insert( mapping.iLocalUID, aPosition );
+    }
+}
+
+int SyncTarget::findUIDMapping( int aFrom, const QString& aUID, bool aLocal ) const
+{
+    // Finds the next mapping of a local UID, or of a remote UID
+    for( int i = aFrom; i < iUIDMappings.count(); ++i ) {
+        if( iLiveUIDMappings.at( i ) &&
+            ( aLocal ? iUIDMappings.at( i ).iLocalUID : iUIDMappings.at( i ).iRemoteUID ) == aUID ) {
+            return i;
+        }
+    }
+
+    Q_ASSERT( false );
+    return -1;
+}
+
+void SyncTarget::compactUIDMappings() const
+{
+    if( iUIDMappingHoles == 0 ) {
+        return;
+    }
+
+    QList<UIDMapping> mappings;
+    QList<bool> live;
+    mappings.reserve( iUIDMappings.count() - iUIDMappingHoles );
+    live.reserve( iUIDMappings.count() - iUIDMappingHoles );
+
+    for( int i = 0; i < iUIDMappings.count(); ++i ) {
+        if( iLiveUIDMappings.at( i ) ) {
+            const UIDMapping& mapping = iUIDMappings.at( i );
+            QHash<SyncItemKey, int>::iterator position = iLocalUIDPositions.find( mapping.iLocalUID );
+
+            if( position.value() == i ) {
+                position.value() = mappings.count();
+            }
+
+            mappings.append( mapping );
+            live.append( true );
+        }
+    }
+
+    iUIDMappings = mappings;
+    iLiveUIDMappings = live;
+    iUIDMappingHoles = 0;
 }
 
 void SyncTarget::saveSession( DatabaseHandler& aDbHandler, const QDateTime& aSyncEndTime )
@@ -328,7 +454,7 @@ void SyncTarget::saveSession( DatabaseHandler& aDbHandler, const QDateTime& aSyn
     iChangeLog->setLastLocalAnchor( iLocalNextAnchor );
     iChangeLog->setLastRemoteAnchor( iRemoteNextAnchor );
     iChangeLog->setLastSyncTime( aSyncEndTime );
-    iChangeLog->setMaps( iUIDMappings );
+    iChangeLog->setMaps( getUIDMappings() );
 
     if( !iChangeLog->save( aDbHandler.getDbHandle() ) ) {
         qCWarning(lcSyncML) << "Could not save information to persistent storage!";
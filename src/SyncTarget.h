@@ -34,6 +34,8 @@
 #ifndef SYNCTARGET_H
 #define SYNCTARGET_H
 
+#include <QHash>
+
 #include "SyncMode.h"
 #include "SyncAgentConsts.h"
 #include "SyncMLGlobals.h"
@@ -240,6 +242,12 @@ protected:
 
 private:
 
+    void indexUIDMapping( int aPosition );
+
+    int findUIDMapping( int aFrom, const QString& aUID, bool aLocal ) const;
+
+    void compactUIDMappings() const;
+
     ChangeLog*          iChangeLog;
 
     StoragePlugin*      iPlugin;
@@ -251,7 +259,13 @@ private:
     QString             iRemoteNextAnchor;
 
     LocalChanges        iLocalChanges;
-    QList<UIDMapping>   iUIDMappings;
+    mutable QList<UIDMapping>       iUIDMappings;       ///< Mappings in order, removed ones as holes
+    mutable QList<bool>             iLiveUIDMappings;   ///< Whether the entry in iUIDMappings is still a mapping
+    mutable int                     iUIDMappingHoles;   ///< Number of removed entries in iUIDMappings
+    QHash<QString, SyncItemKey>     iLocalUIDs;         ///< Local UIDs indexed by remote UID
+    mutable QHash<SyncItemKey, int> iLocalUIDPositions; ///< Position of the first mapping of each local UID
+    QHash<QString, int>             iRemoteUIDDuplicates;   ///< Number of further mappings of a remote UID, if any
+    QHash<SyncItemKey, int>         iLocalUIDDuplicates;    ///< Number of further mappings of a local UID, if any
 
     bool                iReverted;
     bool                iLocalChangesDiscovered;
@@ -0,0 +1,2202 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "WbXMLMessageDecoder.h"
+
+#include "WbXMLTokens.h"
+#include "RemoteDeviceInfo.h"
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+namespace {
+
+// Element tags are formed as ( language << 16 ) | ( code page << 8 ) | token
+enum ElementTag
+{
+    TAG_UNKNOWN = -1,
+
+    // SyncML, code page 0
+    TAG_ADD = 0x0005,
+    TAG_ALERT = 0x0006,
+    TAG_ATOMIC = 0x0008,
+    TAG_CHAL = 0x0009,
+    TAG_CMD = 0x000A,
+    TAG_CMDID = 0x000B,
+    TAG_CMDREF = 0x000C,
+    TAG_COPY = 0x000D,
+    TAG_CRED = 0x000E,
+    TAG_DATA = 0x000F,
+    TAG_DELETE = 0x0010,
+    TAG_EXEC = 0x0011,
+    TAG_FINAL = 0x0012,
+    TAG_GET = 0x0013,
+    TAG_ITEM = 0x0014,
+    TAG_LOCURI = 0x0017,
+    TAG_MAP = 0x0018,
+    TAG_MAPITEM = 0x0019,
+    TAG_META = 0x001A,
+    TAG_MSGID = 0x001B,
+    TAG_MSGREF = 0x001C,
+    TAG_NORESP = 0x001D,
+    TAG_PUT = 0x001F,
+    TAG_REPLACE = 0x0020,
+    TAG_RESPURI = 0x0021,
+    TAG_RESULTS = 0x0022,
+    TAG_SEQUENCE = 0x0024,
+    TAG_SESSIONID = 0x0025,
+    TAG_SOURCE = 0x0027,
+    TAG_SOURCEREF = 0x0028,
+    TAG_STATUS = 0x0029,
+    TAG_SYNC = 0x002A,
+    TAG_SYNCBODY = 0x002B,
+    TAG_SYNCHDR = 0x002C,
+    TAG_SYNCML = 0x002D,
+    TAG_TARGET = 0x002E,
+    TAG_TARGETREF = 0x002F,
+    TAG_VERDTD = 0x0031,
+    TAG_VERPROTO = 0x0032,
+    TAG_NUMBEROFCHANGES = 0x0033,
+    TAG_MOREDATA = 0x0034,
+    TAG_SOURCEPARENT = 0x0039,
+    TAG_TARGETPARENT = 0x003A,
+    TAG_MOVE = 0x003B,
+    TAG_CORRELATOR = 0x003C,
+
+    // MetInf, code page 1
+    TAG_ANCHOR = 0x0105,
+    TAG_EMI = 0x0106,
+    TAG_FORMAT = 0x0107,
+    TAG_LAST = 0x010A,
+    TAG_MARK = 0x010B,
+    TAG_MAXMSGSIZE = 0x010C,
+    TAG_NEXT = 0x010F,
+    TAG_NEXTNONCE = 0x0110,
+    TAG_SIZE = 0x0112,
+    TAG_TYPE = 0x0113,
+    TAG_VERSION = 0x0114,
+    TAG_MAXOBJSIZE = 0x0115,
+
+    // DevInf, code page 0
+    TAG_DEVINF_CTCAP = 0x10005,
+    TAG_DEVINF_CTTYPE = 0x10006,
+    TAG_DEVINF_DATASTORE = 0x10007,
+    TAG_DEVINF_DATATYPE = 0x10008,
+    TAG_DEVINF_DEVID = 0x10009,
+    TAG_DEVINF_DEVINF = 0x1000A,
+    TAG_DEVINF_DEVTYP = 0x1000B,
+    TAG_DEVINF_DISPLAYNAME = 0x1000C,
+    TAG_DEVINF_FWV = 0x1000F,
+    TAG_DEVINF_HWV = 0x10010,
+    TAG_DEVINF_MAN = 0x10011,
+    TAG_DEVINF_MOD = 0x10015,
+    TAG_DEVINF_OEM = 0x10016,
+    TAG_DEVINF_PARAMNAME = 0x10017,
+    TAG_DEVINF_PROPNAME = 0x10018,
+    TAG_DEVINF_RX = 0x10019,
+    TAG_DEVINF_RX_PREF = 0x1001A,
+    // Size in DevInf 1.1, MaxSize in DevInf 1.2
+    TAG_DEVINF_SIZE = 0x1001C,
+    TAG_DEVINF_SOURCEREF = 0x1001D,
+    TAG_DEVINF_SWV = 0x1001E,
+    TAG_DEVINF_SYNCCAP = 0x1001F,
+    TAG_DEVINF_SYNCTYPE = 0x10020,
+    TAG_DEVINF_TX = 0x10021,
+    TAG_DEVINF_TX_PREF = 0x10022,
+    TAG_DEVINF_VALENUM = 0x10023,
+    TAG_DEVINF_VERCT = 0x10024,
+    TAG_DEVINF_VERDTD = 0x10025,
+    TAG_DEVINF_UTC = 0x10028,
+    TAG_DEVINF_SUPPORTNUMBEROFCHANGES = 0x10029,
+    TAG_DEVINF_SUPPORTLARGEOBJS = 0x1002A,
+    TAG_DEVINF_PROPERTY = 0x1002B,
+    TAG_DEVINF_PROPPARAM = 0x1002C,
+    TAG_DEVINF_MAXOCCUR = 0x1002D,
+    TAG_DEVINF_NOTRUNCATE = 0x1002E,
+    TAG_DEVINF_SUPPORTHIERARCHICALSYNC = 0x10034
+};
+
+struct DocumentHeader
+{
+    quint32     publicId;
+    QByteArray  publicIdString;
+    quint32     charset;
+    QByteArray  stringTable;
+
+    DocumentHeader() : publicId( 0 ), charset( 0 ) { }
+};
+
+bool readByte( const QByteArray& aData, int& aPos, quint8& aByte )
+{
+    if( aPos >= aData.size() ) {
+        return false;
+    }
+
+    aByte = static_cast<quint8>( aData.at( aPos++ ) );
+    return true;
+}
+
+bool readMultiByteInt( const QByteArray& aData, int& aPos, quint32& aValue )
+{
+    // mb_u_int32 is at most 5 bytes long, continuation is signaled with the highest bit
+    aValue = 0;
+
+    for( int i = 0; i < 5; ++i ) {
+        quint8 byte = 0;
+
+        if( !readByte( aData, aPos, byte ) ) {
+            return false;
+        }
+
+        aValue = ( aValue << 7 ) | ( byte & 0x7F );
+
+        if( !( byte & 0x80 ) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool readInlineString( const QByteArray& aData, int& aPos, QByteArray& aString )
+{
+    int end = aData.indexOf( '\0', aPos );
+
+    if( end < 0 ) {
+        return false;
+    }
+
+    aString = aData.mid( aPos, end - aPos );
+    aPos = end + 1;
+    return true;
+}
+
+bool readTableString( const QByteArray& aTable, quint32 aOffset, QByteArray& aString )
+{
+    if( aOffset >= static_cast<quint32>( aTable.size() ) ) {
+        return false;
+    }
+
+    int end = aTable.indexOf( '\0', aOffset );
+
+    if( end < 0 ) {
+        end = aTable.size();
+    }
+
+    aString = aTable.mid( aOffset, end - aOffset );
+    return true;
+}
+
+bool readDocumentHeader( const QByteArray& aData, int& aPos, DocumentHeader& aHeader )
+{
+    quint8 version = 0;
+    quint32 publicIdIndex = 0;
+    quint32 tableLength = 0;
+
+    if( !readByte( aData, aPos, version ) ||
+        version < WBXML_VERSION_11 || version > WBXML_VERSION_13 ) {
+        return false;
+    }
+
+    if( !readMultiByteInt( aData, aPos, aHeader.publicId ) ) {
+        return false;
+    }
+
+    if( aHeader.publicId == WBXML_PUBLICID_STRING &&
+        !readMultiByteInt( aData, aPos, publicIdIndex ) ) {
+        return false;
+    }
+
+    if( !readMultiByteInt( aData, aPos, aHeader.charset ) ||
+        !readMultiByteInt( aData, aPos, tableLength ) ||
+        tableLength > static_cast<quint32>( aData.size() - aPos ) ) {
+        return false;
+    }
+
+    aHeader.stringTable = aData.mid( aPos, tableLength );
+    aPos += tableLength;
+
+    if( aHeader.publicId == WBXML_PUBLICID_STRING &&
+        !readTableString( aHeader.stringTable, publicIdIndex, aHeader.publicIdString ) ) {
+        return false;
+    }
+
+    return true;
+}
+
+QString escapeText( const QString& aText )
+{
+    QString escaped;
+    escaped.reserve( aText.size() );
+
+    for( int i = 0; i < aText.size(); ++i ) {
+        const QChar c = aText.at( i );
+
+        if( c == QLatin1Char( '<' ) ) {
+            escaped.append( QLatin1String( "&lt;" ) );
+        }
+        else if( c == QLatin1Char( '>' ) ) {
+            escaped.append( QLatin1String( "&gt;" ) );
+        }
+        else if( c == QLatin1Char( '&' ) ) {
+            escaped.append( QLatin1String( "&amp;" ) );
+        }
+        else if( c == QLatin1Char( '"' ) ) {
+            escaped.append( QLatin1String( "&quot;" ) );
+        }
+        else {
+            escaped.append( c );
+        }
+    }
+
+    return escaped;
+}
+
+}
+
+WbXMLMessageDecoder::WbXMLMessageDecoder()
+ : iPos( 0 ), iCharset( 0 ), iLanguage( LANGUAGE_SYNCML ), iPage( WBXML_PAGE_SYNCML ),
+   iTokenType( TOKEN_NONE ), iTag( TAG_UNKNOWN ), iTextIsOpaque( false ),
+   iPendingEnd( false ), iAtEnd( true ), iLastMessageInPackage( false ),
+   iError( PARSER_ERROR_LAST ), iSyncHdrFound( false ), iSyncBodyFound( false )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+WbXMLMessageDecoder::~WbXMLMessageDecoder()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qDeleteAll(iFragments);
+    iFragments.clear();
+}
+
+bool WbXMLMessageDecoder::isSyncMLDocument( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    int pos = 0;
+    DocumentHeader header;
+
+    if( !readDocumentHeader( aData, pos, header ) ) {
+        return false;
+    }
+
+    switch( header.publicId )
+    {
+        case WBXML_PUBLICID_SYNCML_10:
+        case WBXML_PUBLICID_DEVINF_10:
+        case WBXML_PUBLICID_SYNCML_11:
+        case WBXML_PUBLICID_DEVINF_11:
+        case WBXML_PUBLICID_SYNCML_12:
+        case WBXML_PUBLICID_METINF_12:
+        case WBXML_PUBLICID_DEVINF_12:
+        {
+            return true;
+        }
+        case WBXML_PUBLICID_STRING:
+        {
+            // For example "-//SYNCML//DTD SyncML 1.2//EN"
+            return header.publicIdString.toUpper().contains( "SYNCML" );
+        }
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+ParserError WbXMLMessageDecoder::decode( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    qDeleteAll(iFragments);
+    iFragments.clear();
+    iLastMessageInPackage = false;
+
+    iSyncHdrFound = false;
+    iSyncBodyFound = false;
+
+    iLanguage = LANGUAGE_SYNCML;
+
+    if( openDocument( aData ) ) {
+        startDecoding();
+    }
+
+    if( iError != PARSER_ERROR_LAST ) {
+        qCCritical(lcSyncML) << "Error while decoding WbXML SyncML document:" << iError;
+    }
+    else if( !iSyncHdrFound || !iSyncBodyFound ) {
+        qCCritical(lcSyncML) << "Malformed SyncML document, missing either SyncHdr or SyncBody";
+        iError = PARSER_ERROR_INCOMPLETE_DATA;
+    }
+
+    iData.clear();
+    iStringTable.clear();
+
+    return iError;
+}
+
+QList<DataSync::Fragment*> WbXMLMessageDecoder::takeFragments()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<DataSync::Fragment*> fragments = iFragments;
+    iFragments.clear();
+    return fragments;
+}
+
+bool WbXMLMessageDecoder::lastMessageInPackage() const
+{
+    return iLastMessageInPackage;
+}
+
+bool WbXMLMessageDecoder::openDocument( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iData = aData;
+    iPos = 0;
+    iPage = WBXML_PAGE_SYNCML;
+    iTokenType = TOKEN_NONE;
+    iTag = TAG_UNKNOWN;
+    iTextIsOpaque = false;
+    iText.clear();
+    iPendingEnd = false;
+    iElementStack.clear();
+    iAtEnd = false;
+    iError = PARSER_ERROR_LAST;
+
+    DocumentHeader header;
+
+    if( !readDocumentHeader( iData, iPos, header ) ) {
+        setInvalid( "Invalid WbXML document header" );
+        return false;
+    }
+
+    iCharset = header.charset;
+    iStringTable = header.stringTable;
+
+    return true;
+}
+
+void WbXMLMessageDecoder::readNext()
+{
+    iTokenType = TOKEN_NONE;
+    iTextIsOpaque = false;
+    iText.clear();
+
+    if( iAtEnd ) {
+        return;
+    }
+
+    // Elements without content have no END token, report the end of such
+    // element as a separate token like QXmlStreamReader does
+    if( iPendingEnd ) {
+        iPendingEnd = false;
+        iTokenType = TOKEN_END_ELEMENT;
+        iTag = iElementStack.takeLast();
+        return;
+    }
+
+    while( iTokenType == TOKEN_NONE && !iAtEnd ) {
+
+        quint8 token = 0;
+
+        if( !readByte( iData, iPos, token ) ) {
+            iAtEnd = true;
+            break;
+        }
+
+        switch( token )
+        {
+            case WBXML_SWITCH_PAGE:
+            {
+                quint8 page = 0;
+
+                if( readByte( iData, iPos, page ) ) {
+                    iPage = page;
+                }
+                else {
+                    setInvalid( "Truncated code page switch in WbXML document" );
+                }
+                break;
+            }
+            case WBXML_END:
+            {
+                if( !iElementStack.isEmpty() ) {
+                    iTokenType = TOKEN_END_ELEMENT;
+                    iTag = iElementStack.takeLast();
+                }
+                else {
+                    setInvalid( "Unbalanced END token in WbXML document" );
+                }
+                break;
+            }
+            case WBXML_ENTITY:
+            case WBXML_STR_I:
+            case WBXML_STR_T:
+            case WBXML_OPAQUE:
+            {
+                if( readElementText( token ) ) {
+                    iTokenType = TOKEN_TEXT;
+                }
+                else {
+                    setInvalid( "Invalid text in WbXML document" );
+                }
+                break;
+            }
+            case WBXML_PI:
+            {
+                // Processing instructions have the same structure as attributes
+                if( !skipAttributes() ) {
+                    setInvalid( "Invalid processing instruction in WbXML document" );
+                }
+                break;
+            }
+            case WBXML_EXT_I_0:
+            case WBXML_EXT_I_1:
+            case WBXML_EXT_I_2:
+            {
+                QByteArray extension;
+
+                if( !readInlineString( iData, iPos, extension ) ) {
+                    setInvalid( "Invalid extension in WbXML document" );
+                }
+                break;
+            }
+            case WBXML_EXT_T_0:
+            case WBXML_EXT_T_1:
+            case WBXML_EXT_T_2:
+            {
+                quint32 extension = 0;
+
+                if( !readMultiByteInt( iData, iPos, extension ) ) {
+                    setInvalid( "Invalid extension in WbXML document" );
+                }
+                break;
+            }
+            case WBXML_EXT_0:
+            case WBXML_EXT_1:
+            case WBXML_EXT_2:
+            {
+                break;
+            }
+            default:
+            {
+                readElementTag( token );
+                break;
+            }
+        }
+    }
+}
+
+bool WbXMLMessageDecoder::isStartElement() const
+{
+    return iTokenType == TOKEN_START_ELEMENT;
+}
+
+bool WbXMLMessageDecoder::isEndElement() const
+{
+    return iTokenType == TOKEN_END_ELEMENT;
+}
+
+bool WbXMLMessageDecoder::atEnd() const
+{
+    return iAtEnd;
+}
+
+void WbXMLMessageDecoder::readElementTag( quint8 aToken )
+{
+    quint8 token = aToken & WBXML_TAG_MASK;
+    int tag = TAG_UNKNOWN;
+
+    if( token == WBXML_LITERAL ) {
+        // Element names outside of code pages are not used by SyncML, such
+        // elements are reported as unknown
+        quint32 nameOffset = 0;
+
+        if( !readMultiByteInt( iData, iPos, nameOffset ) ) {
+            setInvalid( "Invalid literal element in WbXML document" );
+            return;
+        }
+    }
+    else {
+        tag = ( iLanguage << 16 ) | ( iPage << 8 ) | token;
+    }
+
+    if( ( aToken & WBXML_TAG_ATTRIBUTES ) && !skipAttributes() ) {
+        setInvalid( "Invalid attributes in WbXML document" );
+        return;
+    }
+
+    iTokenType = TOKEN_START_ELEMENT;
+    iTag = tag;
+    iElementStack.append( tag );
+    iPendingEnd = !( aToken & WBXML_TAG_CONTENT );
+}
+
+bool WbXMLMessageDecoder::readElementText( quint8 aToken )
+{
+    switch( aToken )
+    {
+        case WBXML_STR_I:
+        {
+            return readInlineString( iData, iPos, iText );
+        }
+        case WBXML_STR_T:
+        {
+            quint32 offset = 0;
+            return readMultiByteInt( iData, iPos, offset ) &&
+                   readTableString( iStringTable, offset, iText );
+        }
+        case WBXML_ENTITY:
+        {
+            quint32 code = 0;
+
+            if( !readMultiByteInt( iData, iPos, code ) ) {
+                return false;
+            }
+
+            uint ucs = code;
+            QString entity = QString::fromUcs4( &ucs, 1 );
+            iText = ( iCharset == WBXML_CHARSET_LATIN1 ) ? entity.toLatin1() : entity.toUtf8();
+            return true;
+        }
+        case WBXML_OPAQUE:
+        {
+            quint32 length = 0;
+
+            if( !readMultiByteInt( iData, iPos, length ) ||
+                length > static_cast<quint32>( iData.size() - iPos ) ) {
+                return false;
+            }
+
+            iText = iData.mid( iPos, length );
+            iPos += length;
+            iTextIsOpaque = true;
+            return true;
+        }
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+bool WbXMLMessageDecoder::skipAttributes()
+{
+    quint8 token = 0;
+
+    while( readByte( iData, iPos, token ) ) {
+
+        bool ok = true;
+        quint8 page = 0;
+        quint32 value = 0;
+        QByteArray string;
+
+        switch( token )
+        {
+            case WBXML_END:
+            {
+                return true;
+            }
+            case WBXML_SWITCH_PAGE:
+            {
+                ok = readByte( iData, iPos, page );
+                break;
+            }
+            case WBXML_STR_I:
+            case WBXML_EXT_I_0:
+            case WBXML_EXT_I_1:
+            case WBXML_EXT_I_2:
+            {
+                ok = readInlineString( iData, iPos, string );
+                break;
+            }
+            case WBXML_STR_T:
+            case WBXML_ENTITY:
+            case WBXML_LITERAL:
+            case WBXML_EXT_T_0:
+            case WBXML_EXT_T_1:
+            case WBXML_EXT_T_2:
+            {
+                ok = readMultiByteInt( iData, iPos, value );
+                break;
+            }
+            case WBXML_OPAQUE:
+            {
+                ok = readMultiByteInt( iData, iPos, value ) &&
+                     value <= static_cast<quint32>( iData.size() - iPos );
+                iPos += value;
+                break;
+            }
+            default:
+            {
+                // Attribute start or attribute value token
+                break;
+            }
+        }
+
+        if( !ok ) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+void WbXMLMessageDecoder::setInvalid( const char* aReason )
+{
+    qCCritical(lcSyncML) << aReason;
+    iError = PARSER_ERROR_INVALID_DATA;
+    iTokenType = TOKEN_NONE;
+    iAtEnd = true;
+}
+
+QString WbXMLMessageDecoder::decodeText( const QByteArray& aText ) const
+{
+    if( iCharset == WBXML_CHARSET_LATIN1 ) {
+        return QString::fromLatin1( aText.constData(), aText.size() );
+    }
+    else {
+        return QString::fromUtf8( aText.constData(), aText.size() );
+    }
+}
+
+const char* WbXMLMessageDecoder::elementName( int aTag )
+{
+    if( aTag == TAG_UNKNOWN ) {
+        return 0;
+    }
+
+    int language = aTag >> 16;
+    int page = ( aTag >> 8 ) & 0xFF;
+    int index = ( aTag & 0xFF ) - WBXML_FIRST_ELEMENT_TOKEN;
+
+    const char* const* names = 0;
+    int count = 0;
+
+    if( language == LANGUAGE_DEVINF && page == 0 ) {
+        names = DEVINF_PAGE_ELEMENTS;
+        count = sizeof( DEVINF_PAGE_ELEMENTS ) / sizeof( DEVINF_PAGE_ELEMENTS[0] );
+    }
+    else if( language == LANGUAGE_SYNCML && page == WBXML_PAGE_SYNCML ) {
+        names = SYNCML_PAGE_ELEMENTS;
+        count = sizeof( SYNCML_PAGE_ELEMENTS ) / sizeof( SYNCML_PAGE_ELEMENTS[0] );
+    }
+    else if( language == LANGUAGE_SYNCML && page == WBXML_PAGE_METINF ) {
+        names = METINF_PAGE_ELEMENTS;
+        count = sizeof( METINF_PAGE_ELEMENTS ) / sizeof( METINF_PAGE_ELEMENTS[0] );
+    }
+
+    if( !names || index < 0 || index >= count ) {
+        return 0;
+    }
+
+    return names[index];
+}
+
+void WbXMLMessageDecoder::startDecoding()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isStartElement() ) {
+            if( iTag == TAG_SYNCHDR ) {
+                readHeader();
+            } else if( iTag == TAG_SYNCBODY ) {
+                readBody();
+            } else if( iTag != TAG_SYNCML ) {
+                qCCritical(lcSyncML) << "Unexpected element in SyncML message:" << elementName( iTag );
+                iError = PARSER_ERROR_UNEXPECTED_DATA;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readBody()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iSyncBodyFound )
+    {
+        qCCritical(lcSyncML) << "Invalid SyncML message, multiple SyncBody elements found";
+        iError = PARSER_ERROR_INVALID_DATA;
+        return;
+    }
+
+    iSyncBodyFound = true;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_SYNCBODY ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_STATUS ) {
+                readStatus();
+            } else if( iTag == TAG_SYNC ) {
+                readSync();
+            } else if( iTag == TAG_PUT ) {
+                readPut();
+            } else if( iTag == TAG_RESULTS ) {
+                readResults();
+            } else if( iTag == TAG_MAP ) {
+                readMap();
+            } else if( iTag == TAG_FINAL ) {
+                iLastMessageInPackage = true;
+            } else {
+                CommandParams* command = new CommandParams();
+
+                if( readCommand( iTag, *command ) ) {
+                    iFragments.append( command );
+                }
+                else {
+                    delete command;
+                    command = 0;
+                    qCWarning(lcSyncML) << "UNKNOWN  TOKEN TYPE in BODY:NOT HANDLED BY DECODER" << elementName( iTag );
+                }
+            }
+        }
+    }
+
+    if( atEnd() ) {
+        qCCritical(lcSyncML) << "Incomplete SyncML message";
+        iError = PARSER_ERROR_INCOMPLETE_DATA;
+    }
+}
+
+void WbXMLMessageDecoder::readHeader()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iSyncHdrFound )
+    {
+        qCCritical(lcSyncML) << "Invalid SyncML message, multiple SyncHdr elements found";
+        iError = PARSER_ERROR_INVALID_DATA;
+        return;
+    }
+
+    iSyncHdrFound = true;
+
+    HeaderParams *header = new HeaderParams();
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_SYNCHDR ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_VERDTD:
+                    header->verDTD = readString();
+                    break;
+                case TAG_VERPROTO:
+                    header->verProto = readString();
+                    break;
+                case TAG_SESSIONID:
+                    header->sessionID = readString();
+                    break;
+                case TAG_MSGID:
+                    header->msgID = readInt();
+                    break;
+                case TAG_TARGET:
+                    header->targetDevice = readURI();
+                    break;
+                case TAG_SOURCE:
+                    header->sourceDevice = readURI();
+                    break;
+                case TAG_RESPURI:
+                    header->respURI = readString();
+                    break;
+                case TAG_NORESP:
+                    header->noResp = true;
+                    break;
+                case TAG_CRED:
+                    readCred( header->cred );
+                    break;
+                case TAG_META:
+                    readMeta( header->meta );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in HEADER:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+
+    iFragments.append(header);
+
+    if( atEnd() ) {
+        qCCritical(lcSyncML) << "Incomplete SyncML message";
+        iError = PARSER_ERROR_INCOMPLETE_DATA;
+    }
+}
+
+void WbXMLMessageDecoder::readChal( ChalParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_CHAL ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_META ) {
+                readMeta( aParams.meta );
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in CHAL:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readStatus()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    StatusParams *status = new StatusParams();
+    QStringList targetRefs;
+    QStringList sourceRefs;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_STATUS ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    status->cmdId = readInt();
+                    break;
+                case TAG_MSGREF:
+                    status->msgRef = readInt();
+                    break;
+                case TAG_CMDREF:
+                    status->cmdRef = readInt();
+                    break;
+                case TAG_CMD:
+                    status->cmd = readString();
+                    break;
+                case TAG_TARGETREF:
+                    targetRefs.append( readString() );
+                    break;
+                case TAG_SOURCEREF:
+                    sourceRefs.append( readString() );
+                    break;
+                case TAG_DATA:
+                    status->data = (ResponseStatusCode)readInt();
+                    break;
+                case TAG_ITEM:
+                {
+                    ItemParams item;
+                    readItem( item );
+                    status->items.append( item );
+                    break;
+                }
+                case TAG_CHAL:
+                    status->hasChal = true;
+                    readChal( status->chal );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in STATUS:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+
+    status->setRefs( targetRefs, sourceRefs );
+
+    iFragments.append(status);
+}
+
+void WbXMLMessageDecoder::readSync()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    SyncParams *sync = new SyncParams();
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_SYNC ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    sync->cmdId = readInt();
+                    break;
+                case TAG_NORESP:
+                    sync->noResp = true;
+                    break;
+                case TAG_META:
+                    readMeta( sync->meta );
+                    break;
+                case TAG_TARGET:
+                    sync->target = readURI();
+                    break;
+                case TAG_SOURCE:
+                    sync->source = readURI();
+                    break;
+                case TAG_NUMBEROFCHANGES:
+                    sync->numberOfChanges = readInt();
+                    break;
+                default:
+                {
+                    CommandParams command;
+                    if( readCommand( iTag, command ) ) {
+                        sync->commands.append(command);
+                    }
+                    else {
+                        qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in SYNC:NOT HANDLED BY DECODER" << elementName( iTag );
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    iFragments.append(sync);
+}
+
+void WbXMLMessageDecoder::readMap()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    MapParams *map = new MapParams();
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_MAP ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    map->cmdId = readInt();
+                    break;
+                case TAG_TARGET:
+                    map->target = readURI();
+                    break;
+                case TAG_SOURCE:
+                    map->source = readURI();
+                    break;
+                case TAG_META:
+                    readMeta( map->meta );
+                    break;
+                case TAG_MAPITEM:
+                {
+                    MapItemParams item;
+                    readMapItem( item );
+                    map->mapItems.append( item );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in MAP:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+
+    iFragments.append(map);
+}
+
+void WbXMLMessageDecoder::readMapItem( MapItemParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_MAPITEM ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_TARGET ) {
+                aParams.target = readURI();
+            }
+            else if( iTag == TAG_SOURCE ) {
+                aParams.source = readURI();
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in MAPITEM:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readPut()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    PutParams* put = new PutParams;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_PUT ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    put->cmdId = readInt();
+                    break;
+                case TAG_NORESP:
+                    put->noResp = true;
+                    break;
+                case TAG_META:
+                    readMeta( put->meta );
+                    break;
+                case TAG_ITEM:
+                    readDevInfItem( put->devInf );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in PUT:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+
+    // Ensure that the PUT fragment is kept next only to the HEADER, or RESULTS fragment.
+    if( iFragments.count() > 0 ) {
+        iFragments.insert( 1, put );
+    }
+    else {
+        iFragments.append( put );
+    }
+}
+
+void WbXMLMessageDecoder::readResults()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    ResultsParams *results = new ResultsParams();
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_RESULTS ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    results->cmdId = readInt();
+                    break;
+                case TAG_MSGREF:
+                    results->msgRef = readInt();
+                    break;
+                case TAG_CMDREF:
+                    results->cmdRef = readInt();
+                    break;
+                case TAG_META:
+                    readMeta( results->meta );
+                    break;
+                case TAG_TARGETREF:
+                    results->targetRef = readString();
+                    break;
+                case TAG_SOURCEREF:
+                    results->sourceRef = readString();
+                    break;
+                case TAG_ITEM:
+                    readDevInfItem( results->devInf );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in RESULTS:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+
+    // Ensure that the RESULTS fragment is kept next only to the HEADER, or PUT fragment.
+    if( iFragments.count() > 0 ) {
+        iFragments.insert( 1, results );
+    }
+    else {
+        iFragments.append( results );
+    }
+}
+
+bool WbXMLMessageDecoder::readCommand( int aTag, CommandParams& aCommand )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    bool found = true;
+
+    switch( aTag )
+    {
+        case TAG_ALERT:
+            aCommand.commandType = CommandParams::COMMAND_ALERT;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_ADD:
+            aCommand.commandType = CommandParams::COMMAND_ADD;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_REPLACE:
+            aCommand.commandType = CommandParams::COMMAND_REPLACE;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_DELETE:
+            aCommand.commandType = CommandParams::COMMAND_DELETE;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_GET:
+            aCommand.commandType = CommandParams::COMMAND_GET;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_COPY:
+            aCommand.commandType = CommandParams::COMMAND_COPY;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_MOVE:
+            aCommand.commandType = CommandParams::COMMAND_MOVE;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_EXEC:
+            aCommand.commandType = CommandParams::COMMAND_EXEC;
+            readLeafCommand( aCommand, aTag );
+            break;
+        case TAG_ATOMIC:
+            aCommand.commandType = CommandParams::COMMAND_ATOMIC;
+            readContainerCommand( aCommand, aTag );
+            break;
+        case TAG_SEQUENCE:
+            aCommand.commandType = CommandParams::COMMAND_SEQUENCE;
+            readContainerCommand( aCommand, aTag );
+            break;
+        default:
+            found = false;
+            break;
+    }
+
+    return found;
+}
+
+void WbXMLMessageDecoder::readLeafCommand( CommandParams& aParams, int aCommand )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == aCommand ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    aParams.cmdId = readInt();
+                    break;
+                case TAG_NORESP:
+                    aParams.noResp = true;
+                    break;
+                case TAG_DATA:
+                    aParams.data = readString();
+                    break;
+                case TAG_CORRELATOR:
+                    aParams.correlator = readString();
+                    break;
+                case TAG_META:
+                    readMeta( aParams.meta );
+                    break;
+                case TAG_ITEM:
+                {
+                    ItemParams item;
+                    readItem( item );
+                    aParams.items.append( item );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in COMMAND:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readContainerCommand( CommandParams& aParams, int aCommand )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == aCommand ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_CMDID:
+                    aParams.cmdId = readInt();
+                    break;
+                case TAG_NORESP:
+                    aParams.noResp = true;
+                    break;
+                case TAG_META:
+                    readMeta( aParams.meta );
+                    break;
+                default:
+                {
+                    CommandParams command;
+
+                    if( readCommand( iTag, command ) ) {
+                        aParams.subCommands.append( command );
+                    }
+                    else {
+                        qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in COMMAND:NOT HANDLED BY DECODER" << elementName( iTag );
+                    }
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readCred( CredParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_CRED ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_META ) {
+                readMeta( aParams.meta );
+            }
+            else if( iTag == TAG_DATA ) {
+                aParams.data = readString();
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in CRED:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readMeta( MetaParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_META ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_FORMAT:
+                    aParams.format = readString();
+                    break;
+                case TAG_SIZE:
+                    aParams.size = readInt();
+                    break;
+                case TAG_TYPE:
+                    aParams.type = readString();
+                    break;
+                case TAG_ANCHOR:
+                    readAnchor( aParams.anchor );
+                    break;
+                case TAG_VERSION:
+                    aParams.version = readString();
+                    break;
+                case TAG_NEXTNONCE:
+                    aParams.nextNonce = readString();
+                    break;
+                case TAG_MAXMSGSIZE:
+                    aParams.maxMsgSize = readInt();
+                    break;
+                case TAG_MAXOBJSIZE:
+                    aParams.maxObjSize = readInt();
+                    break;
+                case TAG_EMI:
+                    aParams.EMI.append( readString() );
+                    break;
+                case TAG_MARK:
+                    aParams.mark = readString();
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in META:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readAnchor( AnchorParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_ANCHOR ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_NEXT ) {
+                aParams.next = readString();
+            }
+            else if( iTag == TAG_LAST ) {
+                aParams.last = readString();
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in ANCHOR:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readDevInfItem( DevInfItemParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_ITEM ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_SOURCE ) {
+                aParams.source = readURI();
+            }
+            else if( iTag == TAG_DATA ) {
+                readDevInfData( aParams );
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readDevInfData( DevInfItemParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // DevInf is a separate WbXML language, so it's carried inside Data as
+    // an opaque WbXML document of its own
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() ) {
+            break;
+        }
+
+        if( iTokenType == TOKEN_TEXT ) {
+            if( iTextIsOpaque && isSyncMLDocument( iText ) ) {
+                WbXMLMessageDecoder decoder;
+                decoder.decodeDevInf( iText, aParams );
+
+                if( decoder.iError != PARSER_ERROR_LAST ) {
+                    iError = decoder.iError;
+                }
+            }
+            else {
+                qCWarning(lcSyncML) << "Ignoring DevInf data that is not a WbXML document";
+            }
+        }
+        else if( isStartElement() ) {
+            qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+        }
+    }
+}
+
+void WbXMLMessageDecoder::decodeDevInf( const QByteArray& aData, DevInfItemParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    iLanguage = LANGUAGE_DEVINF;
+
+    if( !openDocument( aData ) ) {
+        return;
+    }
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isStartElement() ) {
+            if( iTag == TAG_DEVINF_DEVINF ) {
+                readDevInf( aParams );
+            }
+            else {
+                qCCritical(lcSyncML) << "Unexpected element in DevInf document:" << elementName( iTag );
+                iError = PARSER_ERROR_UNEXPECTED_DATA;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readDevInf( DevInfItemParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QString dtd;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_DEVINF ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_DEVINF_VERDTD:
+                {
+                    dtd = readString();
+
+                    if( dtd != SYNCML_DTD_VERSION_1_1 &&
+                        dtd != SYNCML_DTD_VERSION_1_2 ) {
+                        qCCritical(lcSyncML) << "Unrecognized DevInf verDTD:" << dtd;
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    break;
+                }
+                case TAG_DEVINF_MAN:
+                    aParams.devInfo.deviceInfo().setManufacturer( readString() );
+                    break;
+                case TAG_DEVINF_MOD:
+                    aParams.devInfo.deviceInfo().setModel( readString() );
+                    break;
+                case TAG_DEVINF_OEM:
+                    aParams.devInfo.deviceInfo().setOEM( readString() );
+                    break;
+                case TAG_DEVINF_FWV:
+                    aParams.devInfo.deviceInfo().setFirmwareVersion( readString() );
+                    break;
+                case TAG_DEVINF_SWV:
+                    aParams.devInfo.deviceInfo().setSoftwareVersion( readString() );
+                    break;
+                case TAG_DEVINF_HWV:
+                    aParams.devInfo.deviceInfo().setHardwareVersion( readString() );
+                    break;
+                case TAG_DEVINF_DEVID:
+                    aParams.devInfo.deviceInfo().setDeviceID( readString() );
+                    break;
+                case TAG_DEVINF_DEVTYP:
+                    aParams.devInfo.deviceInfo().setDeviceType( readString() );
+                    break;
+                case TAG_DEVINF_UTC:
+                    aParams.devInfo.setSupportsUTC( true );
+                    break;
+                case TAG_DEVINF_SUPPORTLARGEOBJS:
+                    aParams.devInfo.setSupportsLargeObjs( true );
+                    break;
+                case TAG_DEVINF_SUPPORTNUMBEROFCHANGES:
+                    aParams.devInfo.setSupportsNumberOfChanges( true );
+                    break;
+                case TAG_DEVINF_DATASTORE:
+                {
+                    Datastore newDatastore;
+                    readDataStore( newDatastore, dtd );
+                    aParams.devInfo.datastores().append( newDatastore );
+                    break;
+                }
+                case TAG_DEVINF_CTCAP:
+                {
+                    // CTCap element resides under DevInf only 1.1, in 1.2 it's under
+                    // DataStore
+                    if( dtd == SYNCML_DTD_VERSION_1_1 ) {
+                        readCTCap11( aParams.devInfo.datastores() );
+                    }
+                    else {
+                        qCCritical(lcSyncML) << SYNCML_ELEMENT_CTCAP << "under DevInf allowed only for DS 1.1";
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readDataStore( Datastore& aDatastore, const QString& aDTD )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_DATASTORE ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_DEVINF_SOURCEREF:
+                {
+                    QString URI = readString();
+                    qCDebug(lcSyncML) << "URI of the new datastore instance:" << URI;
+                    aDatastore.setSourceURI( URI );
+                    break;
+                }
+                case TAG_DEVINF_RX_PREF:
+                {
+                    ContentFormat rxPref;
+                    readContentFormat( rxPref, TAG_DEVINF_RX_PREF );
+                    aDatastore.formatInfo().setPreferredRx( rxPref );
+                    break;
+                }
+                case TAG_DEVINF_RX:
+                {
+                    ContentFormat rx;
+                    readContentFormat( rx, TAG_DEVINF_RX );
+                    aDatastore.formatInfo().rx().append( rx );
+                    break;
+                }
+                case TAG_DEVINF_TX_PREF:
+                {
+                    ContentFormat txPref;
+                    readContentFormat( txPref, TAG_DEVINF_TX_PREF );
+                    aDatastore.formatInfo().setPreferredTx( txPref );
+                    break;
+                }
+                case TAG_DEVINF_TX:
+                {
+                    ContentFormat tx;
+                    readContentFormat( tx, TAG_DEVINF_TX );
+                    aDatastore.formatInfo().tx().append( tx );
+                    break;
+                }
+                case TAG_DEVINF_SYNCCAP:
+                    readSyncCaps( aDatastore );
+                    break;
+                case TAG_DEVINF_CTCAP:
+                    readCTCap12( aDatastore );
+                    break;
+                case TAG_DEVINF_SUPPORTHIERARCHICALSYNC:
+                {
+                    if( aDTD == SYNCML_DTD_VERSION_1_2 ) {
+                        aDatastore.setSupportsHierarchicalSync( true );
+                    }
+                    else {
+                        qCCritical(lcSyncML) << SYNCML_ELEMENT_SUPPORTHIERARCHICALSYNC << "under DevInf allowed only for DS 1.2";
+                        iError = PARSER_ERROR_INVALID_DATA;
+                    }
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readContentFormat( ContentFormat& aFormat, int aEndElement )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == aEndElement ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_DEVINF_CTTYPE ) {
+                aFormat.iType = readString();
+            }
+            else if( iTag == TAG_DEVINF_VERCT ) {
+                aFormat.iVersion = readString();
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readSyncCaps( Datastore& aDatastore )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_SYNCCAP ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_DEVINF_SYNCTYPE ) {
+                int syncType = readInt();
+                aDatastore.syncCaps().append( static_cast<SyncTypes>( syncType ) );
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readCTCap11( QList<Datastore>& aDataStores )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QList<CTCap> caps;
+
+    CTCap* currentCap = 0;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_CTCAP ) {
+            break;
+        }
+
+        if( !isStartElement() ) {
+            continue;
+        }
+
+        if( iTag == TAG_DEVINF_CTTYPE ) {
+            QString type = readString();
+
+            currentCap = 0;
+
+            for( int i = 0; i < caps.count(); ++i ) {
+                if( caps[i].getFormat().iType == type ) {
+                    currentCap = &caps[i];
+                    break;
+                }
+            }
+
+            if( !currentCap ) {
+                qCDebug(lcSyncML) << "Creating new CTCap instance with type" << type;
+                CTCap newCap;
+                ContentFormat format;
+                format.iType = type;
+                newCap.setFormat( format );
+                caps.append( newCap );
+                currentCap = &caps.last();
+            }
+        }
+        else if( !currentCap ) {
+            qCCritical(lcSyncML) << "Cannot process" << elementName( iTag ) << "as no" << SYNCML_ELEMENT_CTTYPE << "was found!";
+            iError = PARSER_ERROR_INVALID_DATA;
+        }
+        else if( iTag == TAG_DEVINF_PROPNAME ) {
+            CTCapProperty newProp;
+            newProp.iName = readString();
+            currentCap->properties().append( newProp );
+        }
+        else if( currentCap->properties().isEmpty() ) {
+            qCCritical(lcSyncML) << "Cannot process" << elementName( iTag ) << "as no" << SYNCML_ELEMENT_PROPNAME << "was found!";
+            iError = PARSER_ERROR_INVALID_DATA;
+        }
+        else if( iTag == TAG_DEVINF_VALENUM ) {
+            currentCap->properties().last().iValues.append( readString() );
+        }
+        else if( iTag == TAG_DEVINF_DATATYPE ) {
+            currentCap->properties().last().iType = readString();
+        }
+        else if( iTag == TAG_DEVINF_SIZE ) {
+            currentCap->properties().last().iSize = readInt();
+        }
+        else if( iTag == TAG_DEVINF_DISPLAYNAME ) {
+            currentCap->properties().last().iDisplayName = readString();
+        }
+        else if( iTag == TAG_DEVINF_PARAMNAME ) {
+            // In SyncML 1.1, parameter names (for example TYPE) are not conveyed, instead
+            // parameter values (for example WORK). So we must create an anonymous parameter
+            // that includes all the allowed parameter values
+            QString paramName = readString();
+            CTCapProperty& property = currentCap->properties().last();
+
+            if( property.iParameters.isEmpty() ) {
+                CTCapParameter newParam;
+                newParam.iValues.append( paramName );
+                property.iParameters.append( newParam );
+            }
+            else {
+                property.iParameters.last().iValues.append( paramName );
+            }
+        }
+        else {
+            qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+        }
+    }
+
+    // Sweep through declared datastores, check the content formats they are interested, and add
+    // parsed CTCaps if a datastore is interested
+    for( int i = 0; i < caps.count(); ++i ) {
+
+        for( int a = 0; a < aDataStores.count(); ++a ) {
+
+            QList<ContentFormat> interestedFormats;
+            const StorageContentFormatInfo& formatInfo = aDataStores[a].formatInfo();
+            interestedFormats.append( formatInfo.getPreferredRx() );
+            interestedFormats.append( formatInfo.rx() );
+            interestedFormats.append( formatInfo.getPreferredTx() );
+            interestedFormats.append( formatInfo.tx() );
+
+            for( int b = 0; b < interestedFormats.count(); ++b ) {
+                if( interestedFormats[b].iType == caps[i].getFormat().iType ) {
+                    qCDebug(lcSyncML) << "Datastore" << aDataStores[a].getSourceURI() << "is interested in CTType" << caps[i].getFormat().iType;
+                    aDataStores[a].ctCaps().append( caps[i] );
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readCTCap12( Datastore& aDatastore )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    CTCap cap;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_CTCAP ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            if( iTag == TAG_DEVINF_CTTYPE ) {
+                ContentFormat format = cap.getFormat();
+                format.iType = readString();
+                cap.setFormat( format );
+            }
+            else if( iTag == TAG_DEVINF_VERCT ) {
+                ContentFormat format = cap.getFormat();
+                format.iVersion = readString();
+                cap.setFormat( format );
+            }
+            else if( iTag == TAG_DEVINF_PROPERTY ) {
+                CTCapProperty newProperty;
+                readCTCap12Property( newProperty );
+                cap.properties().append( newProperty );
+            }
+            else {
+                qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+            }
+        }
+    }
+
+    aDatastore.ctCaps().append( cap );
+}
+
+void WbXMLMessageDecoder::readCTCap12Property( CTCapProperty& aProperty )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_PROPERTY ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_DEVINF_PROPNAME:
+                    aProperty.iName = readString();
+                    break;
+                case TAG_DEVINF_DATATYPE:
+                    aProperty.iType = readString();
+                    break;
+                case TAG_DEVINF_MAXOCCUR:
+                    aProperty.iMaxOccur = readInt();
+                    break;
+                case TAG_DEVINF_SIZE:
+                    aProperty.iSize = readInt();
+                    break;
+                case TAG_DEVINF_NOTRUNCATE:
+                    aProperty.iNoTruncate = true;
+                    break;
+                case TAG_DEVINF_DISPLAYNAME:
+                    aProperty.iDisplayName = readString();
+                    break;
+                case TAG_DEVINF_VALENUM:
+                    aProperty.iValues.append( readString() );
+                    break;
+                case TAG_DEVINF_PROPPARAM:
+                {
+                    CTCapParameter newParam;
+                    readCTCap12Parameter( newParam );
+                    aProperty.iParameters.append( newParam );
+                    break;
+                }
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readCTCap12Parameter( CTCapParameter& aParameter )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_DEVINF_PROPPARAM ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_DEVINF_PARAMNAME:
+                    aParameter.iName = readString();
+                    break;
+                case TAG_DEVINF_DATATYPE:
+                    aParameter.iType = readString();
+                    break;
+                case TAG_DEVINF_DISPLAYNAME:
+                    aParameter.iDisplayName = readString();
+                    break;
+                case TAG_DEVINF_VALENUM:
+                    aParameter.iValues.append( readString() );
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in DEVINF:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+void WbXMLMessageDecoder::readItem( ItemParams& aParams )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() && iTag == TAG_ITEM ) {
+            break;
+        }
+
+        if( isStartElement() ) {
+            switch( iTag )
+            {
+                case TAG_META:
+                    readMeta( aParams.meta );
+                    break;
+                case TAG_TARGET:
+                    aParams.target = readURI();
+                    break;
+                case TAG_SOURCE:
+                    aParams.source = readURI();
+                    break;
+                case TAG_TARGETPARENT:
+                    aParams.targetParent = readURI();
+                    break;
+                case TAG_SOURCEPARENT:
+                    aParams.sourceParent = readURI();
+                    break;
+                case TAG_DATA:
+                    aParams.data = readData();
+                    break;
+                case TAG_MOREDATA:
+                    aParams.moreData = true;
+                    break;
+                default:
+                    qCWarning(lcSyncML) << "UNKNOWN TOKEN TYPE in ITEM:NOT HANDLED BY DECODER" << elementName( iTag );
+                    break;
+            }
+        }
+    }
+}
+
+QString WbXMLMessageDecoder::readURI()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QString uri;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isEndElement() &&
+            ( iTag == TAG_TARGET ||
+              iTag == TAG_SOURCE ||
+              iTag == TAG_TARGETPARENT ||
+              iTag == TAG_SOURCEPARENT ) ) {
+            break;
+        }
+
+        if( isStartElement() && iTag == TAG_LOCURI ) {
+            uri = readString();
+        }
+    }
+
+    return uri;
+}
+
+int WbXMLMessageDecoder::readInt()
+{
+    return readString().toInt();
+}
+
+QString WbXMLMessageDecoder::readString()
+{
+    QString string;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( iTokenType == TOKEN_TEXT ) {
+            string.append( decodeText( iText ) );
+        }
+        else if( isEndElement() ) {
+            break;
+        }
+    }
+
+    return string;
+}
+
+QString WbXMLMessageDecoder::readMixed()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QString text;
+    QString xml;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isStartElement() ) {
+            // Same as SyncMLMessageParser, only the first embedded element is
+            // returned. Data element is in SyncML code page.
+            writeElement( xml, WBXML_PAGE_SYNCML );
+            break;
+        }
+        else if( iTokenType == TOKEN_TEXT ) {
+            text.append( decodeText( iText ) );
+        }
+        else if( isEndElement() ) {
+            break;
+        }
+    }
+
+    if( xml.isEmpty() ) {
+        qCDebug(lcSyncML) << "Text was found:" << text.size() << "bytes";
+        return text;
+    }
+    else {
+        qCDebug(lcSyncML) << "XML data was found:" << xml.size() << "bytes";
+        return xml;
+    }
+}
+
+QByteArray WbXMLMessageDecoder::readData()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Item data is handed to storages as UTF-8, so in UTF-8 documents the
+    // inline and opaque bytes are taken as such instead of decoding them
+    if( iCharset == WBXML_CHARSET_LATIN1 ) {
+        return readMixed().toUtf8();
+    }
+
+    QByteArray data;
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isStartElement() ) {
+            QString xml;
+            writeElement( xml, WBXML_PAGE_SYNCML );
+            qCDebug(lcSyncML) << "XML data was found:" << xml.size() << "bytes";
+            return xml.toUtf8();
+        }
+        else if( iTokenType == TOKEN_TEXT ) {
+            if( data.isEmpty() ) {
+                // Shares the token buffer when data consists of a single token
+                data = iText;
+            }
+            else {
+                data.append( iText );
+            }
+        }
+        else if( isEndElement() ) {
+            break;
+        }
+    }
+
+    qCDebug(lcSyncML) << "Text was found:" << data.size() << "bytes";
+    return data;
+}
+
+void WbXMLMessageDecoder::writeElement( QString& aXml, int aParentPage )
+{
+    // Serializes current element and its children as compact XML. Namespace is
+    // declared when the element is in different code page than its parent, as
+    // libwbxml2 does when converting WbXML to XML.
+    const char* name = elementName( iTag );
+    int page = ( iTag >> 8 ) & 0xFF;
+    QString content;
+
+    if( !name ) {
+        page = aParentPage;
+    }
+
+    while( shouldContinue() ) {
+
+        readNext();
+
+        if( isStartElement() ) {
+            writeElement( content, page );
+        }
+        else if( iTokenType == TOKEN_TEXT ) {
+            content.append( escapeText( decodeText( iText ) ) );
+        }
+        else if( isEndElement() ) {
+            break;
+        }
+    }
+
+    if( !name ) {
+        aXml.append( content );
+        return;
+    }
+
+    aXml.append( QLatin1Char( '<' ) );
+    aXml.append( QLatin1String( name ) );
+
+    if( page != aParentPage ) {
+        aXml.append( QLatin1String( " " XML_NAMESPACE "=\"" ) );
+        aXml.append( QLatin1String( page == WBXML_PAGE_METINF ? XML_NAMESPACE_VALUE_METINF
+                                                              : XML_NAMESPACE_VALUE_SYNCML12 ) );
+        aXml.append( QLatin1Char( '"' ) );
+    }
+
+    if( content.isEmpty() ) {
+        aXml.append( QLatin1String( "/>" ) );
+    }
+    else {
+        aXml.append( QLatin1Char( '>' ) );
+        aXml.append( content );
+        aXml.append( QLatin1String( "</" ) );
+        aXml.append( QLatin1String( name ) );
+        aXml.append( QLatin1Char( '>' ) );
+    }
+}
+
+bool WbXMLMessageDecoder::shouldContinue() const
+{
+    if( iError == PARSER_ERROR_LAST && !iAtEnd ) {
+        return true;
+    }
+    else {
+        return false;
+    }
+}
@@ -0,0 +1,185 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+#ifndef WBXMLMESSAGEDECODER_H
+#define WBXMLMESSAGEDECODER_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "SyncMLMessageParser.h"
+
+class WbXMLMessageDecoderTest;
+
+namespace DataSync {
+
+/*! \brief Decodes WbXML encoded SyncML messages directly to fragments
+ *
+ * Counterpart of SyncMLMessageParser for WbXML encoded messages. Instead of
+ * first converting the message to XML text with libwbxml2 and then parsing
+ * that text, the WbXML tokens of the SyncML, MetInf and DevInf code pages are
+ * decoded directly to the same fragment structures that SyncMLMessageParser
+ * produces.
+ */
+class WbXMLMessageDecoder
+{
+public:
+
+    /*! \brief Constructor
+     */
+    WbXMLMessageDecoder();
+
+    /*! \brief Destructor
+     */
+    ~WbXMLMessageDecoder();
+
+    /*! \brief Checks if data is a WbXML encoded SyncML or DevInf document
+     *
+     * Only the document header is inspected.
+     *
+     * @param aData Data to check
+     * @return True if data looks like a WbXML encoded SyncML document
+     */
+    static bool isSyncMLDocument( const QByteArray& aData );
+
+    /*! \brief Decodes a WbXML encoded SyncML message
+     *
+     * @param aData WbXML encoded SyncML message
+     * @return PARSER_ERROR_LAST if decoding succeeded, otherwise the occurred error
+     */
+    ParserError decode( const QByteArray& aData );
+
+    /*! \brief Retrieves the fragments of the last decoding operation
+     *
+     * Ownership of the fragments is transferred.
+     * @return Decoded fragments
+     */
+    QList<DataSync::Fragment*> takeFragments();
+
+    /*! \brief Returns true if the last decoded message contained Final element
+     *
+     * @return True if Final was found, otherwise false
+     */
+    bool lastMessageInPackage() const;
+
+private:
+
+    enum TokenType
+    {
+        TOKEN_NONE,
+        TOKEN_START_ELEMENT,
+        TOKEN_END_ELEMENT,
+        TOKEN_TEXT
+    };
+
+    enum Language
+    {
+        LANGUAGE_SYNCML,
+        LANGUAGE_DEVINF
+    };
+
+    bool openDocument( const QByteArray& aData );
+    void readNext();
+    bool isStartElement() const;
+    bool isEndElement() const;
+    bool atEnd() const;
+
+    void readElementTag( quint8 aToken );
+    bool readElementText( quint8 aToken );
+    bool skipAttributes();
+    void setInvalid( const char* aReason );
+    QString decodeText( const QByteArray& aText ) const;
+    static const char* elementName( int aTag );
+
+    void startDecoding();
+    void readHeader();
+    void readBody();
+    void readStatus();
+    void readSync();
+    void readPut();
+    void readResults();
+    void readMap();
+    void readMapItem( MapItemParams& aParams );
+    bool readCommand( int aTag, CommandParams& aCommand );
+    void readLeafCommand( CommandParams& aParams, int aCommand );
+    void readContainerCommand( CommandParams& aParams, int aCommand );
+    void readChal( ChalParams& aParams );
+    void readCred( CredParams& aParams );
+    void readMeta( MetaParams& aParams );
+    void readItem( ItemParams& aParams );
+    void readAnchor( AnchorParams& aParams );
+    void readDevInfItem( DevInfItemParams& aParams );
+    void readDevInfData( DevInfItemParams& aParams );
+    void decodeDevInf( const QByteArray& aData, DevInfItemParams& aParams );
+    void readDevInf( DevInfItemParams& aParams );
+    void readDataStore( Datastore& aDatastore, const QString& aDTD );
+    void readContentFormat( ContentFormat& aFormat, int aEndElement );
+    void readSyncCaps( Datastore& aDatastore );
+    void readCTCap11( QList<Datastore>& aDatastores );
+    void readCTCap12( Datastore& aDatastore );
+    void readCTCap12Property( CTCapProperty& aProperty );
+    void readCTCap12Parameter( CTCapParameter& aParameter );
+    QString readURI();
+    int readInt();
+    QString readString();
+    QString readMixed();
+    QByteArray readData();
+    void writeElement( QString& aXml, int aParentPage );
+    bool shouldContinue() const;
+
+    QByteArray                  iData;
+    int                         iPos;
+    QByteArray                  iStringTable;
+    quint32                     iCharset;
+    Language                    iLanguage;
+    int                         iPage;
+
+    TokenType                   iTokenType;
+    int                         iTag;
+    bool                        iTextIsOpaque;
+    QByteArray                  iText;
+    bool                        iPendingEnd;
+    QVector<int>                iElementStack;
+    bool                        iAtEnd;
+
+    QList<DataSync::Fragment*>  iFragments;
+    bool                        iLastMessageInPackage;
+    ParserError                 iError;
+    bool                        iSyncHdrFound;
+    bool                        iSyncBodyFound;
+
+    friend class ::WbXMLMessageDecoderTest;
+};
+
+}
+
+#endif // WBXMLMESSAGEDECODER_H
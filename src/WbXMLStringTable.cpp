@@ -0,0 +1,181 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "WbXMLStringTable.h"
+
+#include "SyncMLCmdObject.h"
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+namespace {
+
+// Longest value that is considered for the string table
+const int WBXML_STRTBL_MAX_STRING_LENGTH = 128;
+
+// Bytes taken by a reference to the string table in the worst case:
+// STR_T token and an offset of up to 14 bits
+const int WBXML_STRTBL_MAX_REFERENCE_COST = 3;
+
+int multiByteLength( quint32 aValue )
+{
+    int length = 1;
+    for( ; aValue >= 0x80; aValue >>= 7 ) {
+        ++length;
+    }
+
+    return length;
+}
+
+}
+
+WbXMLStringTable::WbXMLStringTable()
+ : iEstimatedSavings( 0 )
+{
+}
+
+WbXMLStringTable::~WbXMLStringTable()
+{
+}
+
+void WbXMLStringTable::addObject( const SyncMLCmdObject& aObject )
+{
+    // Embedded DevInf documents have string tables of their own
+    if( aObject.getAttributes().value( XML_NAMESPACE ) == XML_NAMESPACE_VALUE_DEVINF ) {
+        return;
+    }
+
+    QByteArray value;
+    if( candidateValue( aObject, value ) ) {
+        addString( value );
+    }
+
+    const QList<SyncMLCmdObject*>& children = aObject.getChildren();
+    for( int i = 0; i < children.count(); ++i ) {
+        addObject( *children[i] );
+    }
+}
+
+int WbXMLStringTable::estimatedSavings() const
+{
+    return iEstimatedSavings;
+}
+
+void WbXMLStringTable::build()
+{
+    iOffsets.clear();
+    iData.clear();
+
+    // Strings are placed in the order of first occurrence. Whether a string
+    // pays off depends on the length of its offset, so it is checked here
+    // with the actual offset
+    for( int i = 0; i < iStrings.count(); ++i ) {
+
+        const QByteArray& string = iStrings[i];
+        const int count = iCounts.value( string );
+
+        if( count < 2 ) {
+            continue;
+        }
+
+        const int length = string.size();
+        const int referenceCost = 1 + multiByteLength( iData.size() );
+
+        if( count * ( length + 2 ) > ( length + 1 ) + count * referenceCost ) {
+            iOffsets.insert( string, iData.size() );
+            iData.append( string );
+            iData.append( '\0' );
+        }
+    }
+
+    qCDebug(lcSyncML) << "WbXML string table has" << iOffsets.count() << "strings out of"
+                      << iStrings.count() << "," << iData.size() << "bytes";
+}
+
+int WbXMLStringTable::offset( const QByteArray& aString ) const
+{
+    return iOffsets.value( aString, -1 );
+}
+
+const QByteArray& WbXMLStringTable::data() const
+{
+    return iData;
+}
+
+bool WbXMLStringTable::candidateValue( const SyncMLCmdObject& aObject, QByteArray& aValue )
+{
+    if( aObject.getCDATA() ) {
+        return false;
+    }
+
+    if( !aObject.getUtf8Value().isEmpty() ) {
+        aValue = aObject.getUtf8Value();
+    }
+    else if( !aObject.getValue().isEmpty() &&
+             aObject.getValue().length() <= WBXML_STRTBL_MAX_STRING_LENGTH ) {
+        aValue = aObject.getValue().toUtf8();
+    }
+    else {
+        return false;
+    }
+
+    return aValue.size() <= WBXML_STRTBL_MAX_STRING_LENGTH && !aValue.contains( '\0' );
+}
+
+void WbXMLStringTable::addString( const QByteArray& aString )
+{
+    QHash<QByteArray, int>::iterator i = iCounts.find( aString );
+
+    if( i == iCounts.end() ) {
+        iCounts.insert( aString, 1 );
+        iStrings.append( aString );
+    }
+    else {
+        const int count = ++( *i );
+        iEstimatedSavings += savings( count, aString.size() ) -
+                             savings( count - 1, aString.size() );
+    }
+}
+
+int WbXMLStringTable::savings( int aCount, int aLength )
+{
+    // Inline string takes STR_I, the string and NUL at every occurrence. In
+    // the table the string and NUL are written once, plus a reference at
+    // every occurrence
+    const int inlineCost = aCount * ( aLength + 2 );
+    const int tableCost = ( aLength + 1 ) + aCount * WBXML_STRTBL_MAX_REFERENCE_COST;
+
+    return qMax( 0, inlineCost - tableCost );
+}
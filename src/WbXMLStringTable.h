@@ -0,0 +1,133 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef WBXMLSTRINGTABLE_H
+#define WBXMLSTRINGTABLE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+namespace DataSync {
+
+class SyncMLCmdObject;
+
+/*! \brief String table of an outgoing WbXML document
+ *
+ * Collects values that repeat in a SyncML message, like LocURIs, MIME types
+ * and anchors. A string is placed in the table only if referencing it is
+ * cheaper than writing it inline at every occurrence. Strings are counted
+ * incrementally, so that the savings can be estimated while the message is
+ * being built. Content of embedded DevInf documents is not counted, as they
+ * are encoded as separate documents.
+ */
+class WbXMLStringTable
+{
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    WbXMLStringTable();
+
+    /*! \brief Destructor
+     *
+     */
+    ~WbXMLStringTable();
+
+    /*! \brief Count the values of an object and its children
+     *
+     * @param aObject Object to add
+     */
+    void addObject( const SyncMLCmdObject& aObject );
+
+    /*! \brief Estimate how many bytes the string table saves
+     *
+     * Estimate assumes the worst case cost of a reference for every string,
+     * so the actual savings are usually somewhat larger. Constant time.
+     *
+     * @return Estimated savings in bytes
+     */
+    int estimatedSavings() const;
+
+    /*! \brief Select the strings to place in the table and assign offsets
+     *
+     * Must be called after all objects have been added and before offset()
+     * or data() are used.
+     */
+    void build();
+
+    /*! \brief Returns the offset of a string in the table
+     *
+     * @param aString UTF-8 encoded string
+     * @return Offset, or -1 if the string is not in the table
+     */
+    int offset( const QByteArray& aString ) const;
+
+    /*! \brief Returns the contents of the table
+     *
+     * @return NUL terminated strings of the table
+     */
+    const QByteArray& data() const;
+
+    /*! \brief Returns the value of an object as a string table candidate
+     *
+     * Only values that would otherwise be written as inline strings are
+     * candidates, and long values are excluded as they rarely repeat.
+     *
+     * @param aObject Object
+     * @param aValue UTF-8 encoded value of the object
+     * @return True if the value is a candidate, otherwise false
+     */
+    static bool candidateValue( const SyncMLCmdObject& aObject, QByteArray& aValue );
+
+protected:
+
+private:
+
+    void addString( const QByteArray& aString );
+
+    static int savings( int aCount, int aLength );
+
+    QHash<QByteArray, int>  iCounts;
+    QList<QByteArray>       iStrings;
+    int                     iEstimatedSavings;
+
+    QHash<QByteArray, int>  iOffsets;
+    QByteArray              iData;
+
+};
+
+}
+
+#endif  //  WBXMLSTRINGTABLE_H
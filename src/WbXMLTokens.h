@@ -0,0 +1,131 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef WBXMLTOKENS_H
+#define WBXMLTOKENS_H
+
+#include <QtGlobal>
+
+/*! \file WbXMLTokens.h
+ * \brief Tokens and code pages of WbXML encoded SyncML documents, shared by
+ *        WbXMLMessageDecoder and WbXMLEncoder
+ */
+
+namespace DataSync {
+
+// WbXML versions
+const quint8 WBXML_VERSION_11 = 0x01;
+const quint8 WBXML_VERSION_12 = 0x02;
+const quint8 WBXML_VERSION_13 = 0x03;
+
+// WbXML global tokens
+const quint8 WBXML_SWITCH_PAGE = 0x00;
+const quint8 WBXML_END = 0x01;
+const quint8 WBXML_ENTITY = 0x02;
+const quint8 WBXML_STR_I = 0x03;
+const quint8 WBXML_LITERAL = 0x04;
+const quint8 WBXML_EXT_I_0 = 0x40;
+const quint8 WBXML_EXT_I_1 = 0x41;
+const quint8 WBXML_EXT_I_2 = 0x42;
+const quint8 WBXML_PI = 0x43;
+const quint8 WBXML_EXT_T_0 = 0x80;
+const quint8 WBXML_EXT_T_1 = 0x81;
+const quint8 WBXML_EXT_T_2 = 0x82;
+const quint8 WBXML_STR_T = 0x83;
+const quint8 WBXML_EXT_0 = 0xC0;
+const quint8 WBXML_EXT_1 = 0xC1;
+const quint8 WBXML_EXT_2 = 0xC2;
+const quint8 WBXML_OPAQUE = 0xC3;
+
+// Bits of a tag token
+const quint8 WBXML_TAG_ATTRIBUTES = 0x80;
+const quint8 WBXML_TAG_CONTENT = 0x40;
+const quint8 WBXML_TAG_MASK = 0x3F;
+
+// Public identifiers of SyncML documents
+const quint32 WBXML_PUBLICID_STRING = 0x00;
+const quint32 WBXML_PUBLICID_SYNCML_10 = 0x0FD1;
+const quint32 WBXML_PUBLICID_DEVINF_10 = 0x0FD2;
+const quint32 WBXML_PUBLICID_SYNCML_11 = 0x0FD3;
+const quint32 WBXML_PUBLICID_DEVINF_11 = 0x0FD4;
+const quint32 WBXML_PUBLICID_SYNCML_12 = 0x1201;
+const quint32 WBXML_PUBLICID_METINF_12 = 0x1202;
+const quint32 WBXML_PUBLICID_DEVINF_12 = 0x1203;
+
+// IANA MIBenum of ISO-8859-1, all other charsets are treated as UTF-8
+const quint32 WBXML_CHARSET_LATIN1 = 4;
+
+// IANA MIBenum of UTF-8
+const quint32 WBXML_CHARSET_UTF8 = 106;
+
+// Code pages of SyncML language
+const int WBXML_PAGE_SYNCML = 0;
+const int WBXML_PAGE_METINF = 1;
+
+// Element names of the code pages, starting from token 0x05
+const char* const SYNCML_PAGE_ELEMENTS[] = {
+    "Add", "Alert", "Archive", "Atomic", "Chal", "Cmd", "CmdID", "CmdRef",
+    "Copy", "Cred", "Data", "Delete", "Exec", "Final", "Get", "Item", "Lang",
+    "LocName", "LocURI", "Map", "MapItem", "Meta", "MsgID", "MsgRef", "NoResp",
+    "NoResults", "Put", "Replace", "RespURI", "Results", "Search", "Sequence",
+    "SessionID", "SftDel", "Source", "SourceRef", "Status", "Sync", "SyncBody",
+    "SyncHdr", "SyncML", "Target", "TargetRef", 0, "VerDTD", "VerProto",
+    "NumberOfChanges", "MoreData", "Field", "Filter", "Record", "FilterType",
+    "SourceParent", "TargetParent", "Move", "Correlator"
+};
+
+const char* const METINF_PAGE_ELEMENTS[] = {
+    "Anchor", "EMI", "Format", "FreeID", "FreeMem", "Last", "Mark", "MaxMsgSize",
+    "Mem", "MetInf", "Next", "NextNonce", "SharedMem", "Size", "Type", "Version",
+    "MaxObjSize", "FieldLevel"
+};
+
+const char* const DEVINF_PAGE_ELEMENTS[] = {
+    "CTCap", "CTType", "DataStore", "DataType", "DevID", "DevInf", "DevTyp",
+    "DisplayName", "DSMem", "Ext", "FwV", "HwV", "Man", "MaxGUIDSize", "MaxID",
+    "MaxMem", "Mod", "OEM", "ParamName", "PropName", "Rx", "Rx-Pref", "SharedMem",
+    "MaxSize", "SourceRef", "SwV", "SyncCap", "SyncType", "Tx", "Tx-Pref",
+    "ValEnum", "VerCT", "VerDTD", "XNam", "XVal", "UTC", "SupportNumberOfChanges",
+    "SupportLargeObjs", "Property", "PropParam", "MaxOccur", "NoTruncate", 0,
+    "Filter-Rx", "FilterCap", "FilterKeyword", "FieldLevel",
+    "SupportHierarchicalSync"
+};
+
+const int WBXML_FIRST_ELEMENT_TOKEN = 0x05;
+
+// Token of Size element of DevInf 1.1, which is MaxSize in DevInf 1.2
+const quint8 WBXML_DEVINF_SIZE_TOKEN = 0x1C;
+
+}
+
+#endif  //  WBXMLTOKENS_H
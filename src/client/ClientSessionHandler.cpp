@@ -143,6 +143,8 @@ void ClientSessionHandler::handleNotificationPackage( const SANDS& aData )
 
     params().setRemoteDeviceName( aData.iHeader.iServerIdentifier );
 
+    loadRemoteDevInf();
+
     QString verDTD;
     QString verProto;
 
@@ -782,6 +784,14 @@ void ClientSessionHandler::composeClientInitialization()
                                             params().localDeviceName(),
                                             params().remoteDeviceName() );
 
+    // Stored remote device info is requested again along with a slow or
+    // refresh sync
+    foreach( const SyncTarget* target, getSyncTargets() ) {
+        if( target != NULL && target->getSyncMode()->syncType() != TYPE_FAST ) {
+            getDevInfHandler().setRemoteDevInfStale();
+        }
+    }
+
     // Device info exchange
     getDevInfHandler().composeLocalInitiatedDevInfExchange( getStorages(),
                                                             getProtocolVersion(),
@@ -307,6 +307,9 @@ namespace DataSync
     #define HTTP_UA_VALUE "libmeegosyncml"
     #define HTTP_HDRSTR_ACCEPT "Accept"
     #define HTTP_ACCEPT_VALUE  "*/*"
+    #define HTTP_HDRSTR_CONTENT_ENCODING "Content-Encoding"
+    #define HTTP_HDRSTR_ACCEPT_ENCODING "Accept-Encoding"
+    #define HTTP_ACCEPT_ENCODING_VALUE "gzip, deflate"
 
     #define DEFAULT_MAX_CHANGES_TO_SEND 22
     #define DEFAULT_MAX_MESSAGESIZE     16384
@@ -528,6 +528,9 @@ ResponseStatusCode ServerSessionHandler::setupTargetByClient( const SyncMode& aS
 
         // In slow mode, all mappings become invalid
         target->clearUIDMappings();
+
+        // Stored remote device info is requested again
+        getDevInfHandler().setRemoteDevInfStale();
     }
 
     addSyncTarget( target );
@@ -688,6 +691,10 @@ void ServerSessionHandler::composeServerInitialization()
 
     }
 
+    // Request stale remote device info if the client did not send it
+    getDevInfHandler().composeRemoteDevInfRequest( getProtocolVersion(), ROLE_SERVER,
+                                                   getResponseGenerator() );
+
 }
 
 void ServerSessionHandler::serverInitiatedSyncDS11( const QList< QPair<QString, QString> >& aStorages )
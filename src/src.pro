@@ -37,7 +37,12 @@ SOURCES += SyncItem.cpp \
         SyncAgent.cpp \
         SyncAgentConfig.cpp \
         SyncMLMessageParser.cpp \
+        WbXMLMessageDecoder.cpp \
+        WbXMLStringTable.cpp \
+        FragmentArena.cpp \
+        ParserThread.cpp \
         AuthenticationPackage.cpp \
+        LocalChanges.cpp \
         LocalChangesPackage.cpp \
         LocalMappingsPackage.cpp \
         DeviceInfo.cpp \
@@ -56,6 +61,7 @@ SOURCES += SyncItem.cpp \
         ConflictResolver.cpp \
         AuthHelper.cpp \
         NonceStorage.cpp \
+        DevInfStorage.cpp \
         ServerAlertedNotification.cpp \
         RequestListener.cpp \
         SyncMLLogging.cpp \
@@ -65,18 +71,27 @@ SOURCES += SyncItem.cpp \
     DataStore.cpp \
     StorageContentFormatInfo.cpp \
     SessionAuthentication.cpp \
-    SessionParams.cpp
+    SessionParams.cpp \
+    ItemReferenceIndex.cpp
 
 HEADERS += SyncItem.h \
         StoragePlugin.h \
+        AsyncStoragePlugin.h \
+        ConcurrentFetchStoragePlugin.h \
         ChangeLog.h \
         SuspendLog.h \
         SyncAgent.h \
         SyncItemKey.h \
         datatypes.h \
     Fragments.h \
+    ByteSlice.h \
+    FragmentArena.h \
+    ParserThread.h \
         SyncAgentConfig.h \
         SyncMLMessageParser.h \
+        WbXMLMessageDecoder.h \
+        WbXMLTokens.h \
+        WbXMLStringTable.h \
         AuthenticationPackage.h \
         LocalChangesPackage.h \
         LocalMappingsPackage.h \
@@ -99,6 +114,7 @@ HEADERS += SyncItem.h \
         ConflictResolver.h \
         AuthHelper.h \
         NonceStorage.h \
+        DevInfStorage.h \
         StorageProvider.h \
         ServerAlertedNotification.h \
     SyncMLGlobals.h \
@@ -112,12 +128,13 @@ HEADERS += SyncItem.h \
     StorageContentFormatInfo.h \
     LocalChanges.h \
     SessionAuthentication.h \
-    SessionParams.h
+    SessionParams.h \
+    ItemReferenceIndex.h
 
 OTHER_FILES += config/meego-syncml-conf.xsd \
                config/meego-syncml-conf.xml
 
-LIBS += -lsqlite3 -lopenobex
+LIBS += -lsqlite3 -lopenobex -lz
 
 QTDIR = $$[QT_INSTALL_LIBS]/qt5
 
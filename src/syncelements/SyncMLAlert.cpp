@@ -101,7 +101,7 @@ SyncMLAlert::SyncMLAlert(CommandParams& aAlertParams)
         }
 
         if( !item.data.isEmpty() ) {
-            itemObject->insertData( item.data.toUtf8() );
+            itemObject->insertData( item.data );
         }
 
         addChild( itemObject );
@@ -32,9 +32,13 @@
 */
 
 #include "SyncMLCmdObject.h"
+
+#include <QHash>
+
+#include "SyncMLNodePool.h"
+#include "WbXMLStringTable.h"
+#include "WbXMLTokens.h"
 #include "SyncMLLogging.h"
-#include "LibWbXML2Encoder.h"
-#include "QtEncoder.h"
 #include "datatypes.h"
 
 // As this base class is extensively used in SyncML generation, please do not
@@ -43,17 +47,168 @@
 
 using namespace DataSync;
 
-SyncMLCmdObject::SyncMLCmdObject( const QString& aName, const QString& aValue )
-: iName( aName ), iValue( aValue ), iIsCDATA( false )
+namespace {
+
+// Bytes taken by a namespace change in WbXML: a code page switch, or an
+// embedded document for DevInf
+const int WBXML_NAMESPACE_OVERHEAD = 8;
+
+// Number of bytes needed to encode a string as UTF-8
+int utf8Length( const QString& aString )
+{
+    int length = 0;
+    const QChar* data = aString.constData();
+    const int size = aString.size();
+
+    for( int i = 0; i < size; ++i ) {
+        const ushort unicode = data[i].unicode();
+
+        if( unicode < 0x80 ) {
+            length += 1;
+        }
+        else if( unicode < 0x800 ) {
+            length += 2;
+        }
+        else if( data[i].isSurrogate() ) {
+            // Surrogate pair takes 4 bytes
+            length += 2;
+        }
+        else {
+            length += 3;
+        }
+    }
+
+    return length;
+}
+
+// Number of bytes taken by WbXML inline string or opaque data of given length
+int wbxmlStringLength( int aLength )
+{
+    // Token, mb_u_int32 length and data. Inline strings take the same
+    // number of bytes for data shorter than 128 bytes
+    int lengthBytes = 1;
+    for( quint32 length = aLength; length >= 0x80; length >>= 7 ) {
+        ++lengthBytes;
+    }
+
+    return 1 + lengthBytes + aLength;
+}
+
+// Shared names of the elements SyncML messages are built from
+class ElementNames
+{
+public:
+
+    ElementNames()
+    {
+        add( SYNCML_PAGE_ELEMENTS, sizeof( SYNCML_PAGE_ELEMENTS ) / sizeof( SYNCML_PAGE_ELEMENTS[0] ) );
+        add( METINF_PAGE_ELEMENTS, sizeof( METINF_PAGE_ELEMENTS ) / sizeof( METINF_PAGE_ELEMENTS[0] ) );
+        add( DEVINF_PAGE_ELEMENTS, sizeof( DEVINF_PAGE_ELEMENTS ) / sizeof( DEVINF_PAGE_ELEMENTS[0] ) );
+    }
+
+    QString name( const char* aName ) const
+    {
+        QHash<QLatin1String, QString>::const_iterator i = iNames.constFind( QLatin1String( aName ) );
+
+        if( i != iNames.constEnd() ) {
+            return i.value();
+        }
+
+        return QString::fromLatin1( aName );
+    }
 
+private:
+
+    void add( const char* const* aNames, int aCount )
+    {
+        for( int i = 0; i < aCount; ++i ) {
+            if( aNames[i] ) {
+                iNames.insert( QLatin1String( aNames[i] ), QString::fromLatin1( aNames[i] ) );
+            }
+        }
+    }
+
+    // Keys point to the static element tables
+    QHash<QLatin1String, QString> iNames;
+
+};
+
+Q_GLOBAL_STATIC(ElementNames, elementNames)
+
+}
+
+QString SyncMLAttributes::value( const QString& aName ) const
 {
+    for( int i = 0; i < iAttributes.count(); ++i ) {
+        if( iAttributes[i].first == aName ) {
+            return iAttributes[i].second;
+        }
+    }
 
+    return QString();
+}
+
+bool SyncMLAttributes::contains( const QString& aName ) const
+{
+    for( int i = 0; i < iAttributes.count(); ++i ) {
+        if( iAttributes[i].first == aName ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SyncMLAttributes::insert( const QString& aName, const QString& aValue )
+{
+    // Keep attributes sorted by name, so that they are encoded in the same
+    // order regardless of the order they were added in
+    int i = 0;
+    while( i < iAttributes.count() && iAttributes[i].first < aName ) {
+        ++i;
+    }
+
+    if( i < iAttributes.count() && iAttributes[i].first == aName ) {
+        iAttributes[i].second = aValue;
+    }
+    else {
+        iAttributes.insert( i, qMakePair( aName, aValue ) );
+    }
+}
+
+SyncMLCmdObject::SyncMLCmdObject( const QString& aName, const QString& aValue )
+: iName( aName ), iValue( aValue ), iIsCDATA( false ), iParent( NULL ),
+  iXMLSize( 0 ), iWbXMLSize( 0 ), iChildrenXMLSize( 0 ), iChildrenWbXMLSize( 0 ),
+  iStringTable( NULL ), iEncodingWbXML( false ), iEncodingVersion( SYNCML_UNKNOWN )
+{
+    updateSize();
+}
+
+SyncMLCmdObject::SyncMLCmdObject( const char* aName, const QString& aValue )
+: iName( elementNames()->name( aName ) ), iValue( aValue ), iIsCDATA( false ), iParent( NULL ),
+  iXMLSize( 0 ), iWbXMLSize( 0 ), iChildrenXMLSize( 0 ), iChildrenWbXMLSize( 0 ),
+  iStringTable( NULL ), iEncodingWbXML( false ), iEncodingVersion( SYNCML_UNKNOWN )
+{
+    updateSize();
 }
 
 SyncMLCmdObject::~SyncMLCmdObject() {
 
     qDeleteAll(iChildren);
     iChildren.clear();
+
+    delete iStringTable;
+    iStringTable = NULL;
+}
+
+void* SyncMLCmdObject::operator new( size_t aSize )
+{
+    return SyncMLNodePool::instance().allocate( aSize );
+}
+
+void SyncMLCmdObject::operator delete( void* aObject, size_t aSize )
+{
+    SyncMLNodePool::instance().release( aObject, aSize );
 }
 
 const QString& SyncMLCmdObject::getName() const
@@ -64,6 +219,7 @@ const QString& SyncMLCmdObject::getName() const
 void SyncMLCmdObject::setName( const QString& aName )
 {
     iName = aName;
+    updateSize();
 }
 
 const QString& SyncMLCmdObject::getValue() const
@@ -74,6 +230,20 @@ const QString& SyncMLCmdObject::getValue() const
 void SyncMLCmdObject::setValue( const QString& aValue )
 {
     iValue = aValue;
+    iUtf8Value.clear();
+    updateSize();
+}
+
+const QByteArray& SyncMLCmdObject::getUtf8Value() const
+{
+    return iUtf8Value;
+}
+
+void SyncMLCmdObject::setUtf8Value( const QByteArray& aValue )
+{
+    iUtf8Value = aValue;
+    iValue.clear();
+    updateSize();
 }
 
 bool SyncMLCmdObject::getCDATA() const
@@ -84,14 +254,16 @@ bool SyncMLCmdObject::getCDATA() const
 void SyncMLCmdObject::setCDATA( bool aCDATA )
 {
     iIsCDATA = aCDATA;
+    updateSize();
 }
 
 void SyncMLCmdObject::addAttribute( const QString& aName, const QString& aValue )
 {
     iAttributes.insert( aName, aValue );
+    updateSize();
 }
 
-const QMap<QString, QString>& SyncMLCmdObject::getAttributes() const
+const SyncMLAttributes& SyncMLCmdObject::getAttributes() const
 {
     return iAttributes;
 }
@@ -100,7 +272,22 @@ void SyncMLCmdObject::addChild( SyncMLCmdObject* aChild )
 {
 
     Q_ASSERT( aChild );
+    Q_ASSERT( !aChild->iParent );
     iChildren.append( aChild );
+    aChild->iParent = this;
+
+    iChildrenXMLSize += aChild->iXMLSize;
+    iChildrenWbXMLSize += aChild->iWbXMLSize;
+    updateSize();
+
+    SyncMLCmdObject* root = this;
+    while( root->iParent ) {
+        root = root->iParent;
+    }
+
+    if( root->iStringTable ) {
+        root->iStringTable->addObject( *aChild );
+    }
 
 }
 
@@ -109,42 +296,79 @@ const QList<SyncMLCmdObject*>& SyncMLCmdObject::getChildren() const
     return iChildren;
 }
 
-int SyncMLCmdObject::calculateSize(bool aWBXML, const ProtocolVersion& aVersion)
+int SyncMLCmdObject::calculateSize( bool aWbXML, const ProtocolVersion& aVersion ) const
 {
+    Q_UNUSED( aVersion );
 
-    // It should be noted that this is just coarse estimation! Document size limit
-    // is always set to 90% of the maximum available transport size, so this does
-    // not need to be byte-accurate. We gain lots of performance when we don't have
-    // to serialize to XML to check the current size
+    if( aWbXML && iStringTable ) {
+        return iWbXMLSize - iStringTable->estimatedSavings();
+    }
 
-    if (aWBXML) {
-        LibWbXML2Encoder encoder;
+    return aWbXML ? iWbXMLSize : iXMLSize;
+}
 
-        QByteArray aData;
+void SyncMLCmdObject::setEncoding( const QByteArray& aEncoding, bool aWbXML,
+                                   const ProtocolVersion& aVersion ) const
+{
+    iEncoding = aEncoding;
+    iEncodingWbXML = aWbXML;
+    iEncodingVersion = aVersion;
+}
 
-        if( aVersion == SYNCML_1_1 ) {
-            addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_SYNCML11 );
-        }
-        else if( aVersion == SYNCML_1_2 ) {
-            addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_SYNCML12 );
-        }
+QByteArray SyncMLCmdObject::getEncoding( bool aWbXML, const ProtocolVersion& aVersion ) const
+{
+    if( iEncodingWbXML != aWbXML || ( aWbXML && iEncodingVersion != aVersion ) ) {
+        return QByteArray();
+    }
 
+    return iEncoding;
+}
 
-        if( encoder.encodeToWbXML( *this,
-                                   aVersion,
-                                   aData ) )
-        {
-            return aData.size();
-        }
+void SyncMLCmdObject::enableStringTable()
+{
+    if( !iStringTable ) {
+        iStringTable = new WbXMLStringTable;
+        iStringTable->addObject( *this );
     }
+}
+
+const WbXMLStringTable* SyncMLCmdObject::stringTable() const
+{
+    return iStringTable;
+}
+
+void SyncMLCmdObject::clearEncoding()
+{
+    // Encoding of a parent contains this element, so it is out of date too.
+    // A parent may have been encoded without this element being encoded
+    // separately, so the whole chain is cleared
+    for( SyncMLCmdObject* object = this; object; object = object->iParent ) {
+        object->iEncoding.clear();
+    }
+}
+
+void SyncMLCmdObject::updateSize()
+{
+    clearEncoding();
+
+    // It should be noted that this is just coarse estimation! Document size limit
+    // is always set to 90% of the maximum available transport size, so this does
+    // not need to be byte-accurate. We gain lots of performance when we don't have
+    // to serialize to check the current size.
+    //
+    // Size of each object is updated whenever the object changes, and the change
+    // is propagated to its ancestors, so that sizes never need to be calculated
+    // by traversing the tree.
 
-    int size = 0;
+    int xmlSize = 0;
+    int wbxmlSize = 1; // Tag token
 
     if( iValue.isEmpty() &&
+        iUtf8Value.isEmpty() &&
         iChildren.isEmpty() )
     {
         // <element/>
-        size += 3 + iName.length();
+        xmlSize += 3 + iName.length();
     }
     else
     {
@@ -153,31 +377,64 @@ int SyncMLCmdObject::calculateSize(bool aWBXML, const ProtocolVersion& aVersion)
 
         if( iName.length() > 0 )
         {
-            size += 5 + 2* iName.length();
+            xmlSize += 5 + 2* iName.length();
         }
 
         // value
-        size += iValue.length();
+        xmlSize += iValue.length() + iUtf8Value.size();
+
+        if( !iValue.isEmpty() ) {
+            wbxmlSize += wbxmlStringLength( utf8Length( iValue ) );
+        }
+        else if( !iUtf8Value.isEmpty() ) {
+            wbxmlSize += wbxmlStringLength( iUtf8Value.size() );
+        }
 
         // CDATA
         if( iIsCDATA )
         {
             // <![CDATA[----]]>
-            size += 12;
+            xmlSize += 12;
         }
 
-        for( int i = 0; i < iChildren.count(); ++i ) {
-            size += iChildren[i]->calculateSize(aWBXML, aVersion);
-        }
+        xmlSize += iChildrenXMLSize;
+
+        // Content and END token
+        wbxmlSize += iChildrenWbXMLSize + 1;
     }
 
     // attributes ( attr="value" )
-    QMapIterator<QString, QString> i( iAttributes );
-    while( i.hasNext() )
+    bool wbxmlAttributes = false;
+    for( int i = 0; i < iAttributes.count(); ++i )
     {
-        i.next();
-        size +=  1 + i.key().length() + 2 + i.value().length() + 1;
+        const QString& name = iAttributes.nameAt( i );
+        const QString& value = iAttributes.valueAt( i );
+        xmlSize +=  1 + name.length() + 2 + value.length() + 1;
+
+        if( name == XML_NAMESPACE ) {
+            wbxmlSize += WBXML_NAMESPACE_OVERHEAD;
+        }
+        else {
+            wbxmlSize += wbxmlStringLength( utf8Length( name ) ) +
+                         wbxmlStringLength( utf8Length( value ) );
+            wbxmlAttributes = true;
+        }
+    }
+
+    if( wbxmlAttributes ) {
+        // END token of attribute list
+        ++wbxmlSize;
     }
 
-    return size;
+    const int xmlDelta = xmlSize - iXMLSize;
+    const int wbxmlDelta = wbxmlSize - iWbXMLSize;
+
+    iXMLSize = xmlSize;
+    iWbXMLSize = wbxmlSize;
+
+    if( iParent && ( xmlDelta != 0 || wbxmlDelta != 0 ) ) {
+        iParent->iChildrenXMLSize += xmlDelta;
+        iParent->iChildrenWbXMLSize += wbxmlDelta;
+        iParent->updateSize();
+    }
 }
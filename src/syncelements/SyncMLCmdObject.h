@@ -35,12 +35,79 @@
 #define SYNCMLCMDOBJECT_H
 
 #include <QString>
-#include <QMap>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QVarLengthArray>
 
 #include "SyncAgentConsts.h"
 
 namespace DataSync {
 
+class WbXMLStringTable;
+
+/*! \brief XML attributes of a SyncML element
+ *
+ * Elements rarely have more than one attribute, so attributes are stored
+ * inline in a flat array kept sorted by name.
+ */
+class SyncMLAttributes {
+
+public:
+
+    /*! \brief Returns the number of attributes
+     *
+     * @return Number of attributes
+     */
+    int count() const { return iAttributes.count(); }
+
+    /*! \brief Returns whether there are no attributes
+     *
+     * @return True if there are no attributes, otherwise false
+     */
+    bool isEmpty() const { return iAttributes.isEmpty(); }
+
+    /*! \brief Returns the name of an attribute
+     *
+     * @param aIndex Index of the attribute, 0 <= aIndex < count()
+     * @return Name of the attribute
+     */
+    const QString& nameAt( int aIndex ) const { return iAttributes[aIndex].first; }
+
+    /*! \brief Returns the value of an attribute
+     *
+     * @param aIndex Index of the attribute, 0 <= aIndex < count()
+     * @return Value of the attribute
+     */
+    const QString& valueAt( int aIndex ) const { return iAttributes[aIndex].second; }
+
+    /*! \brief Returns the value of an attribute
+     *
+     * @param aName Name of the attribute
+     * @return Value of the attribute, or empty if there is no such attribute
+     */
+    QString value( const QString& aName ) const;
+
+    /*! \brief Returns whether an attribute has been set
+     *
+     * @param aName Name of the attribute
+     * @return True if the attribute has been set, otherwise false
+     */
+    bool contains( const QString& aName ) const;
+
+    /*! \brief Sets the value of an attribute
+     *
+     * @param aName Name of the attribute
+     * @param aValue Value of the attribute
+     */
+    void insert( const QString& aName, const QString& aValue );
+
+private:
+
+    QVarLengthArray<QPair<QString, QString>, 1> iAttributes;
+
+};
+
 /*! \brief SyncMLCmdObject is the base class for generating
  *         SyncML message tree
  *
@@ -56,11 +123,50 @@ public:
      */
 	explicit SyncMLCmdObject( const QString& aName = "", const QString& aValue = "" );
 
+    /*! \brief Constructor
+     *
+     * Names of SyncML, MetInf and DevInf elements are shared between all
+     * objects instead of being converted for each object.
+     *
+     * @param aName Name of this element
+     * @param aValue Value of this element
+     */
+    explicit SyncMLCmdObject( const char* aName, const QString& aValue = QString() );
+
 	/*! \brief Destructor
 	 *
 	 */
 	virtual ~SyncMLCmdObject();
 
+    /*! \brief Allocates objects from SyncMLNodePool
+     *
+     * @param aSize Size of the object
+     * @return Memory for the object
+     */
+    static void* operator new( size_t aSize );
+
+    /*! \brief Returns objects to SyncMLNodePool
+     *
+     * @param aObject Object to release
+     * @param aSize Size of the object
+     */
+    static void operator delete( void* aObject, size_t aSize );
+
+    /*! \brief Placement new, for containers that construct objects in place
+     *
+     * @param aSize Size of the object
+     * @param aPlace Memory for the object
+     * @return aPlace
+     */
+    static void* operator new( size_t aSize, void* aPlace ) { Q_UNUSED( aSize ); return aPlace; }
+
+    /*! \brief Placement delete matching placement new
+     *
+     * @param aObject Object
+     * @param aPlace Memory of the object
+     */
+    static void operator delete( void* aObject, void* aPlace ) { Q_UNUSED( aObject ); Q_UNUSED( aPlace ); }
+
 	/*! \brief Returns the name of the XML element represented by this object
 	 *
 	 * @return Name of the XML element
@@ -85,6 +191,22 @@ public:
      */
 	void setValue( const QString& aValue );
 
+    /*! \brief Returns the UTF-8 encoded value of the XML element, if the value
+     *         was set with setUtf8Value()
+     *
+     * @return UTF-8 encoded value of the XML element, or empty
+     */
+    const QByteArray& getUtf8Value() const;
+
+    /*! \brief Sets the value of the XML element as UTF-8 encoded data
+     *
+     * Used for item payloads, which are kept in their storage encoding until
+     * the message is encoded. Replaces any value set with setValue().
+     *
+     * @param aValue UTF-8 encoded value of the XML element
+     */
+    void setUtf8Value( const QByteArray& aValue );
+
 	/*! \brief Returns whether the value of the XML element should be written as CDATA
 	 *
 	 * @return True if value of XML element should be written as CDATA, otherwise false
@@ -108,7 +230,7 @@ public:
 	 *
 	 * @return XML attributes
 	 */
-	const QMap<QString, QString>& getAttributes() const;
+	const SyncMLAttributes& getAttributes() const;
 
 	/*! \brief Adds a child to this element
 	 *
@@ -124,23 +246,82 @@ public:
 
 	/*! \brief Estimate the size of the present object when formatted as XML object
 	 *
+	 * Estimates are maintained as the object and its children are modified,
+	 * so this is a constant time operation.
+	 *
+	 * @param aWbXML True to estimate size as WbXML, false to estimate size as XML
+	 * @param aVersion Protocol version
 	 * @return Estimated size of the object, including all child objects
 	 */
-    int calculateSize(bool aWbXML, const ProtocolVersion& aVersion);
+    int calculateSize( bool aWbXML, const ProtocolVersion& aVersion ) const;
+
+    /*! \brief Keeps an encoding of this element
+     *
+     * Encoders write the element as given instead of encoding it again, as
+     * long as the element and its children are not modified. Modifying the
+     * element or any of its children discards the encoding of the element
+     * and of its parents.
+     *
+     * @param aEncoding Encoded element, as it is written inside a SyncML message body
+     * @param aWbXML True if the encoding is WbXML, false if it is XML
+     * @param aVersion Protocol version, XML encoding does not depend on it
+     */
+    void setEncoding( const QByteArray& aEncoding, bool aWbXML, const ProtocolVersion& aVersion ) const;
+
+    /*! \brief Returns the encoding kept with setEncoding()
+     *
+     * @param aWbXML True to return WbXML encoding, false to return XML encoding
+     * @param aVersion Protocol version, only used with WbXML
+     * @return Encoded element, or empty if there is no such encoding
+     */
+    QByteArray getEncoding( bool aWbXML, const ProtocolVersion& aVersion = SYNCML_UNKNOWN ) const;
 
 protected:
 
+    /*! \brief Start maintaining a WbXML string table for this object
+     *
+     * Values of this object and its children, including children added
+     * later, are counted in the string table, and WbXML size estimates of
+     * this object take the savings of the table into account. Values are
+     * counted when an object is attached, so values should be set before
+     * adding an object to its parent.
+     */
+    void enableStringTable();
+
+    /*! \brief Returns the string table of this object
+     *
+     * @return String table, or NULL if enableStringTable() has not been called
+     */
+    const WbXMLStringTable* stringTable() const;
+
 private:
 
+    void updateSize();
+
+    void clearEncoding();
+
     QString                 iName;
 
     QString                 iValue;
+    QByteArray              iUtf8Value;
     bool                    iIsCDATA;
 
-    QMap<QString, QString>  iAttributes;
+    SyncMLAttributes        iAttributes;
 
     QList<SyncMLCmdObject*> iChildren;
 
+    SyncMLCmdObject*        iParent;
+
+    int                     iXMLSize;
+    int                     iWbXMLSize;
+    int                     iChildrenXMLSize;
+    int                     iChildrenWbXMLSize;
+
+    WbXMLStringTable*       iStringTable;
+
+    mutable QByteArray      iEncoding;
+    mutable bool            iEncodingWbXML;
+    mutable ProtocolVersion iEncodingVersion;
 
 };
 
@@ -88,10 +88,10 @@ void SyncMLItem::insertSourceParent( const SyncItemKey& aLocURI )
 void SyncMLItem::insertData( const QByteArray& aData )
 {
 
-    // Data is always encoded in UTF-8, so make sure it's being read as such instead
-    // of default behavior of latin
-    QString data = QString::fromUtf8( aData.constData() );
-    SyncMLCmdObject* dataObject = new SyncMLCmdObject( SYNCML_ELEMENT_DATA, data );
+    // Data is always encoded in UTF-8. It is kept as such until the message is
+    // encoded, so large payloads are not converted back and forth
+    SyncMLCmdObject* dataObject = new SyncMLCmdObject( SYNCML_ELEMENT_DATA );
+    dataObject->setUtf8Value( aData );
 
     dataObject->setCDATA( true );
 
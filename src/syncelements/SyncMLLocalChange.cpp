@@ -39,9 +39,10 @@
 using namespace DataSync;
 
 SyncMLLocalChange::SyncMLLocalChange( const QString &aElementName, int aCmdID )
- : SyncMLCmdObject( aElementName ), iMetaObject( NULL )
+ : SyncMLCmdObject( aElementName ), iCmdIdObject( NULL ), iMetaObject( NULL )
 {
-    addChild( generateCmdElement( aCmdID ) );
+    iCmdIdObject = generateCmdElement( aCmdID );
+    addChild( iCmdIdObject );
 }
 
 SyncMLLocalChange::~SyncMLLocalChange()
@@ -66,6 +67,11 @@ void SyncMLLocalChange::addFormatMetadata( const QString& aFormat )
     iMetaObject->addFormat( aFormat );
 }
 
+void SyncMLLocalChange::setCmdId( int aCmdID )
+{
+    iCmdIdObject->setValue( QString::number( aCmdID ) );
+}
+
 SyncMLCmdObject* SyncMLLocalChange::generateCmdElement( int aCmdID ) const
 {
 
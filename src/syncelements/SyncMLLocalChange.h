@@ -83,6 +83,12 @@ public:
      */
     void addVersionMetadata(const QString& aVersion);
 
+    /*! \brief Changes the command id of this element
+     *
+     * @param aCmdID New command id
+     */
+    void setCmdId( int aCmdID );
+
 protected:
 
 private:
@@ -90,6 +96,7 @@ private:
 
     void ensureMetaElement();
 
+    SyncMLCmdObject* iCmdIdObject;
     SyncMLMeta* iMetaObject;
 };
 
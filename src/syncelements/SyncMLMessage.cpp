@@ -43,7 +43,7 @@ using namespace DataSync;
 SyncMLMessage::SyncMLMessage( const HeaderParams& aHeaderParams,
                               ProtocolVersion aProtocolVersion)
  : SyncMLCmdObject(SYNCML_ELEMENT_SYNCML ), iMsgId( aHeaderParams.msgID ), iCmdId( 0 ),
-   iProtocolVersion( aProtocolVersion )
+   iProtocolVersion( aProtocolVersion ), iExactPacking( false )
 {
 
     if( iProtocolVersion == SYNCML_1_1 ) {
@@ -81,6 +81,18 @@ int SyncMLMessage::getNextCmdId()
     return ++iCmdId;
 }
 
+void SyncMLMessage::releaseCmdId( int aCmdId )
+{
+    if( aCmdId == iCmdId ) {
+        --iCmdId;
+    }
+}
+
+const SyncMLCmdObject& SyncMLMessage::getBody() const
+{
+    return *iSyncBody;
+}
+
 int SyncMLMessage::getMsgId() const
 {
     return iMsgId;
@@ -90,3 +102,23 @@ ProtocolVersion SyncMLMessage::getProtocolVersion() const
 {
     return iProtocolVersion;
 }
+
+void SyncMLMessage::enableWbXMLStringTable()
+{
+    enableStringTable();
+}
+
+bool SyncMLMessage::wbxmlStringTableEnabled() const
+{
+    return stringTable() != NULL;
+}
+
+void SyncMLMessage::enableExactPacking()
+{
+    iExactPacking = true;
+}
+
+bool SyncMLMessage::exactPackingEnabled() const
+{
+    return iExactPacking;
+}
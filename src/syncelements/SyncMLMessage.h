@@ -79,6 +79,22 @@ public:
      */
     int getNextCmdId();
 
+    /*! \brief Releases a command id assigned by getNextCmdId()
+     *
+     * Used when a command is dropped from the message before it was added,
+     * so that command ids stay contiguous. Only the most recently assigned
+     * command id can be released.
+     *
+     * @param aCmdId Command id to release
+     */
+    void releaseCmdId( int aCmdId );
+
+    /*! \brief Returns the body of this message
+     *
+     * @return Body of this message
+     */
+    const SyncMLCmdObject& getBody() const;
+
     /*! \brief Returns message id of this message
      *
      * @return
@@ -91,6 +107,35 @@ public:
      */
     ProtocolVersion getProtocolVersion() const;
 
+    /*! \brief Use a string table when this message is encoded as WbXML
+     *
+     * Strings that repeat in the message are placed in a string table when
+     * that makes the encoded message smaller. WbXML size estimates of the
+     * message account for the string table from this point on.
+     */
+    void enableWbXMLStringTable();
+
+    /*! \brief Returns whether a string table should be used when this message
+     *         is encoded as WbXML
+     *
+     * @return True if string table should be used, otherwise false
+     */
+    bool wbxmlStringTableEnabled() const;
+
+    /*! \brief Mark this message as filled to exact sizes
+     *
+     * Sizes of exactly packed messages are resolved with the native encoders,
+     * so the message must be encoded with them to stay within the size
+     * limit of the remote party.
+     */
+    void enableExactPacking();
+
+    /*! \brief Returns whether this message was filled to exact sizes
+     *
+     * @return True if the message was filled to exact sizes, otherwise false
+     */
+    bool exactPackingEnabled() const;
+
 protected:
 
 private:
@@ -100,6 +145,7 @@ private:
     ProtocolVersion iProtocolVersion;
     SyncMLHdr*      iSyncHdr;
     SyncMLBody*     iSyncBody;
+    bool            iExactPacking;
 };
 }
 #endif  //  SYNCMLMESSAGE_H
@@ -0,0 +1,238 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SyncMLNodePool.h"
+
+#include <new>
+#include <stdlib.h>
+
+using namespace DataSync;
+
+SyncMLNodePool& SyncMLNodePool::instance()
+{
+    // Never destroyed, so that nodes owned by static objects can still be
+    // released during program exit
+    static SyncMLNodePool* pool = new SyncMLNodePool;
+    return *pool;
+}
+
+SyncMLNodePool::SyncMLNodePool()
+ : iSpareBlock( NULL ), iBlockCount( 0 ), iNodeCount( 0 )
+{
+    for( int i = 0; i < CLASS_COUNT; ++i ) {
+        iBlocks[i] = NULL;
+    }
+}
+
+SyncMLNodePool::~SyncMLNodePool()
+{
+    if( iSpareBlock ) {
+        ::free( iSpareBlock );
+    }
+}
+
+void* SyncMLNodePool::allocate( size_t aSize )
+{
+    if( aSize == 0 || aSize > static_cast<size_t>( MAX_NODE_SIZE ) ) {
+        return ::operator new( aSize );
+    }
+
+    const int index = ( aSize - 1 ) / GRANULARITY;
+
+    QMutexLocker locker( &iMutex );
+
+    Block* block = iBlocks[index];
+
+    if( !block ) {
+        block = newBlock( index );
+        link( block );
+    }
+
+    void* node = NULL;
+
+    if( block->iFreeNodes ) {
+        FreeNode* freeNode = block->iFreeNodes;
+        block->iFreeNodes = freeNode->iNext;
+        node = freeNode;
+    }
+    else {
+        node = block->iPos;
+        block->iPos += ( index + 1 ) * GRANULARITY;
+    }
+
+    ++block->iNodeCount;
+    ++iNodeCount;
+
+    // Only blocks with room for another node are kept in the list of their
+    // size class
+    if( !hasRoom( block ) ) {
+        unlink( block );
+    }
+
+    return node;
+}
+
+void SyncMLNodePool::release( void* aNode, size_t aSize )
+{
+    if( !aNode ) {
+        return;
+    }
+
+    if( aSize == 0 || aSize > static_cast<size_t>( MAX_NODE_SIZE ) ) {
+        ::operator delete( aNode );
+        return;
+    }
+
+    QMutexLocker locker( &iMutex );
+
+    Block* block = reinterpret_cast<Block*>( reinterpret_cast<quintptr>( aNode ) &
+                                             ~static_cast<quintptr>( BLOCK_SIZE - 1 ) );
+
+    Q_ASSERT( block->iClass == static_cast<int>( ( aSize - 1 ) / GRANULARITY ) );
+
+    bool full = !hasRoom( block );
+
+    FreeNode* node = static_cast<FreeNode*>( aNode );
+    node->iNext = block->iFreeNodes;
+    block->iFreeNodes = node;
+
+    if( full ) {
+        link( block );
+    }
+
+    --block->iNodeCount;
+    --iNodeCount;
+
+    if( block->iNodeCount == 0 ) {
+        // All nodes of the block have been released, no need to keep its
+        // memory around while other nodes of this size are alive
+        unlink( block );
+        freeBlock( block );
+    }
+
+    if( iNodeCount == 0 && iSpareBlock ) {
+        ::free( iSpareBlock );
+        iSpareBlock = NULL;
+        --iBlockCount;
+    }
+}
+
+int SyncMLNodePool::blockCount() const
+{
+    QMutexLocker locker( &iMutex );
+    return iBlockCount;
+}
+
+int SyncMLNodePool::nodeCount() const
+{
+    QMutexLocker locker( &iMutex );
+    return iNodeCount;
+}
+
+SyncMLNodePool::Block* SyncMLNodePool::newBlock( int aClass )
+{
+    Block* block = iSpareBlock;
+    iSpareBlock = NULL;
+
+    if( !block ) {
+        void* memory = NULL;
+
+        if( posix_memalign( &memory, BLOCK_SIZE, BLOCK_SIZE ) != 0 ) {
+            throw std::bad_alloc();
+        }
+
+        block = static_cast<Block*>( memory );
+        ++iBlockCount;
+    }
+
+    // Nodes follow the header, keeping the alignment of the size classes
+    const size_t header = ( ( sizeof( Block ) - 1 ) / GRANULARITY + 1 ) * GRANULARITY;
+
+    block->iPrev = NULL;
+    block->iNext = NULL;
+    block->iFreeNodes = NULL;
+    block->iPos = reinterpret_cast<char*>( block ) + header;
+    block->iEnd = reinterpret_cast<char*>( block ) + BLOCK_SIZE;
+    block->iClass = aClass;
+    block->iNodeCount = 0;
+
+    return block;
+}
+
+void SyncMLNodePool::freeBlock( Block* aBlock )
+{
+    // One empty block is kept, so that a size class that keeps emptying and
+    // refilling its only block does not go to the heap every time
+    if( !iSpareBlock && iNodeCount > 0 ) {
+        iSpareBlock = aBlock;
+    }
+    else {
+        ::free( aBlock );
+        --iBlockCount;
+    }
+}
+
+bool SyncMLNodePool::hasRoom( const Block* aBlock ) const
+{
+    return aBlock->iFreeNodes ||
+           aBlock->iEnd - aBlock->iPos >= ( aBlock->iClass + 1 ) * GRANULARITY;
+}
+
+void SyncMLNodePool::link( Block* aBlock )
+{
+    aBlock->iPrev = NULL;
+    aBlock->iNext = iBlocks[aBlock->iClass];
+
+    if( aBlock->iNext ) {
+        aBlock->iNext->iPrev = aBlock;
+    }
+
+    iBlocks[aBlock->iClass] = aBlock;
+}
+
+void SyncMLNodePool::unlink( Block* aBlock )
+{
+    if( aBlock->iPrev ) {
+        aBlock->iPrev->iNext = aBlock->iNext;
+    }
+    else {
+        iBlocks[aBlock->iClass] = aBlock->iNext;
+    }
+
+    if( aBlock->iNext ) {
+        aBlock->iNext->iPrev = aBlock->iPrev;
+    }
+
+    aBlock->iPrev = NULL;
+    aBlock->iNext = NULL;
+}
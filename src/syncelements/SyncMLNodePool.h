@@ -0,0 +1,141 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef SYNCMLNODEPOOL_H
+#define SYNCMLNODEPOOL_H
+
+#include <QMutex>
+
+namespace DataSync {
+
+/*! \brief Allocator of SyncML message tree nodes
+ *
+ * Messages consist of thousands of small objects that are created and
+ * destroyed together. The pool carves them from large blocks, each block
+ * holding nodes of one size, and recycles freed nodes within their block,
+ * so building and tearing down a message costs a handful of heap
+ * allocations. A block is returned to the heap as soon as all of its nodes
+ * have been released, so memory of a message does not outlive it even when
+ * nodes of other messages are alive. One empty block is kept for reuse while
+ * any nodes are allocated.
+ */
+class SyncMLNodePool
+{
+
+public:
+
+    /*! \brief Returns the pool instance
+     *
+     * @return Pool
+     */
+    static SyncMLNodePool& instance();
+
+    /*! \brief Allocates memory for a node
+     *
+     * @param aSize Size of the node in bytes
+     * @return Memory for the node
+     */
+    void* allocate( size_t aSize );
+
+    /*! \brief Releases memory of a node
+     *
+     * @param aNode Node allocated with allocate()
+     * @param aSize Size passed to allocate()
+     */
+    void release( void* aNode, size_t aSize );
+
+    /*! \brief Returns the number of blocks currently held by the pool
+     *
+     * @return Number of blocks
+     */
+    int blockCount() const;
+
+    /*! \brief Returns the number of nodes currently allocated from the pool
+     *
+     * @return Number of nodes
+     */
+    int nodeCount() const;
+
+protected:
+
+private:
+
+    SyncMLNodePool();
+
+    ~SyncMLNodePool();
+
+    struct FreeNode
+    {
+        FreeNode* iNext;
+    };
+
+    // Header at the start of every block. Blocks are aligned to their size,
+    // so the block of a node is found from the address of the node
+    struct Block
+    {
+        Block*      iPrev;
+        Block*      iNext;
+        FreeNode*   iFreeNodes;
+        char*       iPos;
+        char*       iEnd;
+        int         iClass;
+        int         iNodeCount;
+    };
+
+    Block* newBlock( int aClass );
+
+    void freeBlock( Block* aBlock );
+
+    bool hasRoom( const Block* aBlock ) const;
+
+    void link( Block* aBlock );
+
+    void unlink( Block* aBlock );
+
+    static const int    GRANULARITY = 16;
+    static const int    MAX_NODE_SIZE = 512;
+    static const int    CLASS_COUNT = MAX_NODE_SIZE / GRANULARITY;
+    static const int    BLOCK_SIZE = 32768;
+
+    mutable QMutex      iMutex;
+    Block*              iBlocks[CLASS_COUNT];
+    Block*              iSpareBlock;
+    int                 iBlockCount;
+    int                 iNodeCount;
+
+    Q_DISABLE_COPY(SyncMLNodePool)
+
+};
+
+}
+
+#endif // SYNCMLNODEPOOL_H
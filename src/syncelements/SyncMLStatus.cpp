@@ -40,6 +40,50 @@
 
 using namespace DataSync;
 
+namespace {
+
+// References of items can be written as TargetRef and SourceRef elements
+// only if the items carry nothing else, and the references pair up by
+// their position
+bool compactRefs( const StatusParams& aParams )
+{
+    if( !aParams.compactRefs || aParams.items.isEmpty() )
+    {
+        return false;
+    }
+
+    int targets = 0;
+    int sources = 0;
+
+    for( int i = 0; i < aParams.items.count(); ++i )
+    {
+        const ItemParams& item = aParams.items[i];
+
+        if( !item.data.isEmpty() || !item.sourceParent.isEmpty() || !item.targetParent.isEmpty() )
+        {
+            return false;
+        }
+
+        if( !item.target.isEmpty() )
+        {
+            ++targets;
+        }
+
+        if( !item.source.isEmpty() )
+        {
+            ++sources;
+        }
+    }
+
+    const int count = aParams.items.count();
+
+    return ( targets > 0 || sources > 0 ) &&
+           ( targets == 0 || targets == count ) &&
+           ( sources == 0 || sources == count );
+}
+
+}
+
 SyncMLStatus::SyncMLStatus(const StatusParams& aParams)
 
     : SyncMLCmdObject(SYNCML_ELEMENT_STATUS)
@@ -69,6 +113,27 @@ SyncMLStatus::SyncMLStatus(const StatusParams& aParams)
         addChild(sourceRefObject);
     }
 
+    const bool compact = compactRefs( aParams );
+
+    if( compact )
+    {
+        for( int i = 0; i < aParams.items.count(); ++i )
+        {
+            if( !aParams.items[i].target.isEmpty() )
+            {
+                addChild( new SyncMLCmdObject( SYNCML_ELEMENT_TARGETREF, aParams.items[i].target ) );
+            }
+        }
+
+        for( int i = 0; i < aParams.items.count(); ++i )
+        {
+            if( !aParams.items[i].source.isEmpty() )
+            {
+                addChild( new SyncMLCmdObject( SYNCML_ELEMENT_SOURCEREF, aParams.items[i].source ) );
+            }
+        }
+    }
+
     SyncMLCmdObject* dataObject = new SyncMLCmdObject( SYNCML_ELEMENT_DATA, QString::number(aParams.data) );
     dataObject->setCDATA( true );
     addChild(dataObject);
@@ -89,7 +154,7 @@ SyncMLStatus::SyncMLStatus(const StatusParams& aParams)
         addChild(item);
     }
 
-    for( int i = 0; i < aParams.items.count(); ++i )
+    for( int i = 0; !compact && i < aParams.items.count(); ++i )
     {
 
         SyncMLItem* itemObject = new SyncMLItem();
@@ -106,7 +171,7 @@ SyncMLStatus::SyncMLStatus(const StatusParams& aParams)
 
         if( !aParams.items[i].data.isEmpty() )
         {
-            itemObject->insertData( aParams.items[i].data.toUtf8() );
+            itemObject->insertData( aParams.items[i].data );
         }
 
         addChild( itemObject );
@@ -20,7 +20,8 @@ SyncMLMessage.cpp \
  SyncMLResults.cpp \
  SyncMLCTCap.cpp \
  SyncMLGet.cpp \
-SyncMLExt.cpp
+ SyncMLExt.cpp \
+ SyncMLNodePool.cpp
 
 
 HEADERS += SyncMLCmdObject.h \
@@ -45,4 +46,5 @@ SyncMLMessage.h \
  SyncMLResults.h \
  SyncMLCTCap.h \
  SyncMLGet.h \
-SyncMLExt.h
+ SyncMLExt.h \
+ SyncMLNodePool.h
@@ -39,6 +39,9 @@
 #include "SyncMLMessage.h"
 #include "LibWbXML2Encoder.h"
 #include "QtEncoder.h"
+#include "WbXMLEncoder.h"
+#include "WbXMLMessageDecoder.h"
+#include "SyncAgentConfigProperties.h"
 #include "datatypes.h"
 
 #include "SyncMLLogging.h"
@@ -47,7 +50,9 @@ using namespace DataSync;
 
 BaseTransport::BaseTransport( const ProtocolContext& aContext, QObject* aParent )
  : Transport( aParent ), iContext( aContext ), iHandleIncomingData( false ),
-   iWbXml( false )
+   iWbXml( false ), iWbXMLNativeDecoding( false ), iWbXMLNativeEncoding( false ),
+   iIncrementalParsing( false ),
+   iReceivingChunks( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -69,6 +74,28 @@ bool BaseTransport::usesWbXML()
     return iWbXml;
 }
 
+void BaseTransport::setProperty( const QString& aProperty, const QString& aValue )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aProperty == WBXMLNATIVEDECODINGPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        setWbXMLNativeDecoding( aValue.toInt() > 0 );
+    }
+    else if( aProperty == WBXMLNATIVEENCODINGPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        setWbXMLNativeEncoding( aValue.toInt() > 0 );
+    }
+    else if( aProperty == INCREMENTALPARSINGPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        setIncrementalParsing( aValue.toInt() > 0 );
+    }
+
+}
+
 bool BaseTransport::sendSyncML( SyncMLMessage* aMessage )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -213,6 +240,70 @@ void BaseTransport::receive( const QByteArray& aData, const QString& aContentTyp
     }
 }
 
+bool BaseTransport::acceptsChunk( const QString& aContentType ) const
+{
+    if( iReceivingChunks ) {
+        return true;
+    }
+
+    // Only XML can be parsed in parts, and only if a message is expected
+    return iIncrementalParsing && iHandleIncomingData &&
+           ( aContentType.contains( SYNCML_CONTTYPE_DS_XML ) ||
+             aContentType.contains( SYNCML_CONTTYPE_DM_XML ) );
+}
+
+void BaseTransport::receiveChunk( const QByteArray& aData, bool aLastChunk )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    bool firstChunk = !iReceivingChunks;
+
+    if( firstChunk ) {
+
+        iReceivingChunks = true;
+        iHandleIncomingData = false;
+
+        iIODevice.close();
+        iIncomingData.clear();
+        iIODeviceData.clear();
+
+        if( iContext == CONTEXT_DM )
+        {
+            iContentType = SYNCML_CONTTYPE_DM_XML;
+        }
+        else
+        {
+            iContentType = SYNCML_CONTTYPE_DS_XML;
+        }
+    }
+
+    // Whole message is kept so that it can be purged and parsed again
+    iIODeviceData.append( aData );
+
+    if( aLastChunk ) {
+        iReceivingChunks = false;
+
+#ifndef QT_NO_DEBUG
+        qCDebug(lcSyncMLProtocol) << "\nReceived XML message:\n=========\n" << iIODeviceData << "\n=========";
+#endif  //  QT_NO_DEBUG
+    }
+
+    emit readXMLChunk( aData, firstChunk, aLastChunk );
+}
+
+bool BaseTransport::receivingChunks() const
+{
+    return iReceivingChunks;
+}
+
+void BaseTransport::cancelChunks()
+{
+    if( iReceivingChunks ) {
+        iReceivingChunks = false;
+        emit chunksCancelled();
+    }
+}
+
 const QString& BaseTransport::getRemoteLocURI() const
 {
     return iRemoteLocURI;
@@ -228,25 +319,48 @@ bool BaseTransport::encodeMessage( const SyncMLMessage& aMessage, QByteArray& aD
     {
 
         LibWbXML2Encoder encoder;
+        encoder.setUseStringTable( aMessage.wbxmlStringTableEnabled() );
+        bool encoded = false;
+
+        // Exactly packed messages were measured with the native encoder,
+        // which must then produce the message as well
+        if( iWbXMLNativeEncoding || aMessage.exactPackingEnabled() )
+        {
+            WbXMLEncoder nativeEncoder;
+            nativeEncoder.setUseStringTable( aMessage.wbxmlStringTableEnabled() );
+            encoded = nativeEncoder.encodeToWbXML( aMessage,
+                                                   aMessage.getProtocolVersion(),
+                                                   aData );
+
+            if( !encoded )
+            {
+                qCWarning(lcSyncML) << "Native WbXML encoding failed, using libwbxml2";
+            }
+        }
 
-        if( encoder.encodeToWbXML( aMessage,
-                                   aMessage.getProtocolVersion(),
-                                   aData ) )
+        if( encoded || encoder.encodeToWbXML( aMessage,
+                                              aMessage.getProtocolVersion(),
+                                              aData ) )
         {
             qCDebug(lcSyncML) << "WbXML encoding successful";
 
 #ifndef QT_NO_DEBUG
 
-            QByteArray xml;
-            if( encoder.encodeToXML( aMessage,
-                                     aMessage.getProtocolVersion(),
-                                     xml, true ) )
+            // Re-encoding the message for the dump is as expensive as sending
+            // it, so only do it when someone is listening
+            if( lcSyncMLProtocol().isDebugEnabled() )
             {
-                qCDebug(lcSyncMLProtocol) << "\nSending message:\n=========\n" << xml << "\n=========size:"<<xml.size();
-            }
-            else
-            {
-                qCDebug(lcSyncMLProtocol) << "Failed to print request" ;
+                QByteArray xml;
+                if( encoder.encodeToXML( aMessage,
+                                         aMessage.getProtocolVersion(),
+                                         xml, true ) )
+                {
+                    qCDebug(lcSyncMLProtocol) << "\nSending message:\n=========\n" << xml << "\n=========size:"<<xml.size();
+                }
+                else
+                {
+                    qCDebug(lcSyncMLProtocol) << "Failed to print request" ;
+                }
             }
 
 #endif  //  QT_NO_DEBUG
@@ -264,17 +378,23 @@ bool BaseTransport::encodeMessage( const SyncMLMessage& aMessage, QByteArray& aD
 
         QtEncoder encoder;
 
+        // The encoder streams straight into aData. Reserving the estimated
+        // size up front avoids reallocating the buffer while it grows
+        aData.reserve( aData.size() + aMessage.calculateSize( false, aMessage.getProtocolVersion() ) );
+
         if( encoder.encodeToXML( aMessage, aData, false ) )
         {
             qCDebug(lcSyncML) << "XML encoding successful";
 
 #ifndef QT_NO_DEBUG
 
-            QByteArray xml;
-            if( encoder.encodeToXML( aMessage, xml, true ) ) {
-                qCDebug(lcSyncMLProtocol) << "\nSending message:\n=========\n" << xml << "\n=========";
-            } else {
-                qCDebug(lcSyncMLProtocol) << "Failed to print request" ;
+            if( lcSyncMLProtocol().isDebugEnabled() ) {
+                QByteArray xml;
+                if( encoder.encodeToXML( aMessage, xml, true ) ) {
+                    qCDebug(lcSyncMLProtocol) << "\nSending message:\n=========\n" << xml << "\n=========";
+                } else {
+                    qCDebug(lcSyncMLProtocol) << "Failed to print request" ;
+                }
             }
 
 #endif  //  QT_NO_DEBUG
@@ -305,7 +425,9 @@ void BaseTransport::emitReadSignal()
         emit readSANData( &iIODevice );
     }
     else if( iContentType == SYNCML_CONTTYPE_DM_XML ||
-             iContentType == SYNCML_CONTTYPE_DS_XML ) {
+             iContentType == SYNCML_CONTTYPE_DS_XML ||
+             iContentType == SYNCML_CONTTYPE_DM_WBXML ||
+             iContentType == SYNCML_CONTTYPE_DS_WBXML ) {
         emit readXMLData( &iIODevice, true );
     }
     else {
@@ -319,6 +441,21 @@ void BaseTransport::setWbXml( bool aUse )
     iWbXml = aUse;
 }
 
+void BaseTransport::setWbXMLNativeDecoding( bool aEnable )
+{
+    iWbXMLNativeDecoding = aEnable;
+}
+
+void BaseTransport::setWbXMLNativeEncoding( bool aEnable )
+{
+    iWbXMLNativeEncoding = aEnable;
+}
+
+void BaseTransport::setIncrementalParsing( bool aEnable )
+{
+    iIncrementalParsing = aEnable;
+}
+
 bool BaseTransport::useWbXml() const
 {
     return iWbXml;
@@ -330,6 +467,11 @@ void BaseTransport::receiveWbXMLData( const QByteArray& aData )
 
     setWbXml( true );
 
+    if( iWbXMLNativeDecoding ) {
+        receiveNativeWbXMLData( aData );
+        return;
+    }
+
     bool prettyPrint = false;
 
 #ifndef QT_NO_DEBUG
@@ -351,6 +493,43 @@ void BaseTransport::receiveWbXMLData( const QByteArray& aData )
 
 }
 
+void BaseTransport::receiveNativeWbXMLData( const QByteArray& aData )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !WbXMLMessageDecoder::isSyncMLDocument( aData ) ) {
+        qCWarning(lcSyncML) << "Data is not a WbXML SyncML document!";
+        qCWarning(lcSyncML) << "Presuming SAN package sent with wrong content type...";
+        receiveSANData( aData );
+        return;
+    }
+
+    if( iContext == CONTEXT_DM )
+    {
+        iContentType = SYNCML_CONTTYPE_DM_WBXML;
+    }
+    else
+    {
+        iContentType = SYNCML_CONTTYPE_DS_WBXML;
+    }
+    iIncomingData = aData;
+
+#ifndef QT_NO_DEBUG
+    if( lcSyncMLProtocol().isDebugEnabled() ) {
+        LibWbXML2Encoder encoder;
+        QByteArray xmlData;
+
+        if( encoder.decodeFromWbXML( aData, xmlData, true ) ) {
+            qCDebug(lcSyncMLProtocol) << "\nReceived WbXML message:\n=========\n" << xmlData << "\n=========";
+        }
+        else {
+            qCDebug(lcSyncMLProtocol) << "\nReceived WbXML message:\n=========\n" << iIncomingData.toHex() << "\n=========";
+        }
+    }
+#endif  //  QT_NO_DEBUG
+
+}
+
 void BaseTransport::receiveXMLData( const QByteArray& aData )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
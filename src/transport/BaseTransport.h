@@ -72,12 +72,43 @@ public:
 
     virtual bool receive();
 
+    virtual void setProperty( const QString& aProperty, const QString& aValue );
+
     /*! \brief Enable/disable WbXML
      *
      * @param aUse True/false to enable/disable WbXML encoding
      */
     void setWbXml( bool aUse );
 
+    /*! \brief Enable/disable native decoding of incoming WbXML
+     *
+     * When enabled, incoming WbXML messages are not converted to XML but
+     * passed as such with readXMLData() signal. SyncMLMessageParser
+     * decodes them directly with WbXMLMessageDecoder.
+     *
+     * @param aEnable True/false to enable/disable native decoding
+     */
+    void setWbXMLNativeDecoding( bool aEnable );
+
+    /*! \brief Enable/disable native encoding of outgoing WbXML
+     *
+     * When enabled, outgoing WbXML messages are encoded with WbXMLEncoder
+     * instead of libwbxml2. Messages WbXMLEncoder cannot encode are still
+     * encoded with libwbxml2.
+     *
+     * @param aEnable True/false to enable/disable native encoding
+     */
+    void setWbXMLNativeEncoding( bool aEnable );
+
+    /*! \brief Enable/disable incremental parsing of incoming XML
+     *
+     * When enabled, transports that are able to receive a message in parts
+     * pass the parts with readXMLChunk() signal as they arrive.
+     *
+     * @param aEnable True/false to enable/disable incremental parsing
+     */
+    void setIncrementalParsing( bool aEnable );
+
 private slots:
     /*! \brief Remove any illegal XML characters from the previous message
      *
@@ -124,6 +155,33 @@ protected:
      */
     void receive( const QByteArray& aData, const QString& aContentType );
 
+    /*! \brief Check if incoming data can be received in chunks
+     *
+     * @param aContentType Content type of incoming data
+     * @return True if data should be passed to receiveChunk(), otherwise false
+     */
+    bool acceptsChunk( const QString& aContentType ) const;
+
+    /*! \brief Receive a chunk of incoming XML data
+     *
+     * @param aData Chunk of content data
+     * @param aLastChunk True if this is the last chunk of the message
+     */
+    void receiveChunk( const QByteArray& aData, bool aLastChunk );
+
+    /*! \brief Check if a message is being received in chunks
+     *
+     * @return True if message is being received in chunks, otherwise false
+     */
+    bool receivingChunks() const;
+
+    /*! \brief Stop receiving current message in chunks
+     *
+     * Should be called if the message cannot be received completely.
+     * chunksCancelled() is emitted if some chunks had already been passed.
+     */
+    void cancelChunks();
+
     /*! \brief Retrieves remote location URI
      *
      * @return Remote URI
@@ -147,6 +205,7 @@ private:
     bool useWbXml() const;
 
     void receiveWbXMLData( const QByteArray& aData );
+    void receiveNativeWbXMLData( const QByteArray& aData );
     void receiveXMLData( const QByteArray& aData );
     void receiveSANData( const QByteArray& aData );
 
@@ -158,6 +217,10 @@ private:
     QBuffer             iIODevice;
     bool                iHandleIncomingData;
     bool                iWbXml;
+    bool                iWbXMLNativeDecoding;
+    bool                iWbXMLNativeEncoding;
+    bool                iIncrementalParsing;
+    bool                iReceivingChunks;
 
 };
 
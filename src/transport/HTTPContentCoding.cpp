@@ -0,0 +1,267 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "HTTPContentCoding.h"
+
+#include <zlib.h>
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+namespace {
+
+const char* const CODING_NAME_GZIP = "gzip";
+const char* const CODING_NAME_XGZIP = "x-gzip";
+const char* const CODING_NAME_DEFLATE = "deflate";
+
+// Size of the buffer data is inflated to in one go
+const int INFLATE_BUFFER_SIZE = 16384;
+
+// Size of the zlib and gzip headers needed to tell them from raw deflate data
+const int WRAPPER_HEADER_SIZE = 2;
+
+bool hasWrapperHeader( const QByteArray& aData )
+{
+    const unsigned char first = static_cast<unsigned char>( aData.at( 0 ) );
+    const unsigned char second = static_cast<unsigned char>( aData.at( 1 ) );
+
+    // gzip magic number
+    if( first == 0x1f && second == 0x8b ) {
+        return true;
+    }
+
+    // zlib header: deflate method, window of at most 32K and check bits
+    return ( first & 0x0f ) == Z_DEFLATED && ( first >> 4 ) <= 7 &&
+           ( ( first << 8 ) | second ) % 31 == 0;
+}
+
+}
+
+HTTPContentCoding::Coding HTTPContentCoding::fromName( const QByteArray& aName )
+{
+    const QByteArray name = aName.trimmed().toLower();
+
+    if( name == CODING_NAME_GZIP || name == CODING_NAME_XGZIP ) {
+        return CODING_GZIP;
+    }
+    else if( name == CODING_NAME_DEFLATE ) {
+        return CODING_DEFLATE;
+    }
+    else {
+        return CODING_IDENTITY;
+    }
+}
+
+QByteArray HTTPContentCoding::name( Coding aCoding )
+{
+    switch( aCoding )
+    {
+        case CODING_GZIP:
+            return CODING_NAME_GZIP;
+        case CODING_DEFLATE:
+            return CODING_NAME_DEFLATE;
+        default:
+            return QByteArray();
+    }
+}
+
+bool HTTPContentCoding::compress( const QByteArray& aData, Coding aCoding, QByteArray& aCompressed )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( aCoding == CODING_IDENTITY ) {
+        aCompressed = aData;
+        return true;
+    }
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // gzip wrapper is requested by adding 16 to window bits
+    const int windowBits = ( aCoding == CODING_GZIP ) ? MAX_WBITS + 16 : MAX_WBITS;
+
+    if( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits,
+                      8, Z_DEFAULT_STRATEGY ) != Z_OK ) {
+        qCWarning(lcSyncML) << "Could not initialize compression:" << ( stream.msg ? stream.msg : "" );
+        return false;
+    }
+
+    // Bound does not include the gzip header and trailer with older zlib
+    aCompressed.resize( deflateBound( &stream, aData.size() ) + 18 );
+
+    stream.next_in = reinterpret_cast<Bytef*>( const_cast<char*>( aData.constData() ) );
+    stream.avail_in = aData.size();
+    stream.next_out = reinterpret_cast<Bytef*>( aCompressed.data() );
+    stream.avail_out = aCompressed.size();
+
+    const int result = deflate( &stream, Z_FINISH );
+    const uLong size = stream.total_out;
+
+    deflateEnd( &stream );
+
+    if( result != Z_STREAM_END ) {
+        qCWarning(lcSyncML) << "Compression failed:" << result;
+        aCompressed.clear();
+        return false;
+    }
+
+    aCompressed.resize( size );
+
+    return true;
+}
+
+HTTPContentDecoder::HTTPContentDecoder( HTTPContentCoding::Coding aCoding )
+ : iCoding( aCoding ), iStream( NULL ), iRawDeflate( false ), iFinished( false ),
+   iError( false )
+{
+}
+
+HTTPContentDecoder::~HTTPContentDecoder()
+{
+    cleanup();
+}
+
+bool HTTPContentDecoder::decode( const QByteArray& aData, QByteArray& aDecoded )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iCoding == HTTPContentCoding::CODING_IDENTITY ) {
+        aDecoded.append( aData );
+        return true;
+    }
+
+    if( iError ) {
+        return false;
+    }
+
+    // Anything after the end of compressed data is ignored
+    if( iFinished || aData.isEmpty() ) {
+        return true;
+    }
+
+    QByteArray data = aData;
+
+    if( !iStream ) {
+
+        if( iCoding == HTTPContentCoding::CODING_DEFLATE ) {
+
+            // Some servers send deflate data without the zlib wrapper. Data is
+            // held back until the header has been checked, as a part of it
+            // may arrive alone.
+            iHeader.append( aData );
+
+            if( iHeader.size() < WRAPPER_HEADER_SIZE ) {
+                return true;
+            }
+
+            iRawDeflate = !hasWrapperHeader( iHeader );
+            data = iHeader;
+            iHeader.clear();
+        }
+
+        // Both zlib and gzip headers are detected by adding 32 to window bits,
+        // so servers that mix the two up are understood
+        if( !init( iRawDeflate ? -MAX_WBITS : MAX_WBITS + 32 ) ) {
+            iError = true;
+            return false;
+        }
+    }
+
+    iStream->next_in = reinterpret_cast<Bytef*>( const_cast<char*>( data.constData() ) );
+    iStream->avail_in = data.size();
+
+    char buffer[INFLATE_BUFFER_SIZE];
+
+    do {
+        iStream->next_out = reinterpret_cast<Bytef*>( buffer );
+        iStream->avail_out = sizeof( buffer );
+
+        const int result = inflate( iStream, Z_NO_FLUSH );
+
+        if( result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR ) {
+            qCWarning(lcSyncML) << "Could not decompress HTTP body:" << ( iStream->msg ? iStream->msg : "" );
+            iError = true;
+            return false;
+        }
+
+        aDecoded.append( buffer, sizeof( buffer ) - iStream->avail_out );
+
+        if( result == Z_STREAM_END ) {
+            iFinished = true;
+        }
+        else if( result == Z_BUF_ERROR ) {
+            // No progress possible until more data arrives
+            break;
+        }
+
+    } while( !iFinished && ( iStream->avail_in > 0 || iStream->avail_out == 0 ) );
+
+    return true;
+}
+
+bool HTTPContentDecoder::finished() const
+{
+    return iCoding == HTTPContentCoding::CODING_IDENTITY || iFinished ||
+           ( !iStream && iHeader.isEmpty() );
+}
+
+bool HTTPContentDecoder::init( int aWindowBits )
+{
+    iStream = new z_stream;
+    iStream->zalloc = Z_NULL;
+    iStream->zfree = Z_NULL;
+    iStream->opaque = Z_NULL;
+    iStream->next_in = Z_NULL;
+    iStream->avail_in = 0;
+
+    if( inflateInit2( iStream, aWindowBits ) != Z_OK ) {
+        qCWarning(lcSyncML) << "Could not initialize decompression";
+        delete iStream;
+        iStream = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void HTTPContentDecoder::cleanup()
+{
+    if( iStream ) {
+        inflateEnd( iStream );
+        delete iStream;
+        iStream = NULL;
+    }
+}
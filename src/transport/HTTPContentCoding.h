@@ -0,0 +1,140 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+#ifndef HTTPCONTENTCODING_H
+#define HTTPCONTENTCODING_H
+
+#include <QByteArray>
+
+struct z_stream_s;
+
+namespace DataSync {
+
+/*! \brief Content codings of HTTP message bodies
+ *
+ */
+class HTTPContentCoding
+{
+
+public:
+
+    /*! \brief Supported content codings
+     *
+     */
+    enum Coding
+    {
+        CODING_IDENTITY,    /*!< No compression */
+        CODING_GZIP,        /*!< gzip file format */
+        CODING_DEFLATE      /*!< zlib data format */
+    };
+
+    /*! \brief Returns the coding matching a Content-Encoding value
+     *
+     * @param aName Name of the coding, as in the Content-Encoding header
+     * @return Coding, CODING_IDENTITY for unknown codings
+     */
+    static Coding fromName( const QByteArray& aName );
+
+    /*! \brief Returns the Content-Encoding value of a coding
+     *
+     * @param aCoding Coding
+     * @return Name of the coding, empty for CODING_IDENTITY
+     */
+    static QByteArray name( Coding aCoding );
+
+    /*! \brief Compresses data
+     *
+     * @param aData Data to compress
+     * @param aCoding Coding to use
+     * @param aCompressed Compressed data
+     * @return True on success, otherwise false
+     */
+    static bool compress( const QByteArray& aData, Coding aCoding, QByteArray& aCompressed );
+
+};
+
+/*! \brief Decompresses a HTTP message body as it is received
+ *
+ */
+class HTTPContentDecoder
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aCoding Coding of the body
+     */
+    explicit HTTPContentDecoder( HTTPContentCoding::Coding aCoding );
+
+    /*! \brief Destructor
+     *
+     */
+    ~HTTPContentDecoder();
+
+    /*! \brief Decompresses next part of the body
+     *
+     * @param aData Next part of the body as received
+     * @param aDecoded Decompressed data is appended here
+     * @return True on success, false if the body is not valid
+     */
+    bool decode( const QByteArray& aData, QByteArray& aDecoded );
+
+    /*! \brief Returns whether the body is complete
+     *
+     * @return False if the body ended in the middle of compressed data,
+     *         otherwise true
+     */
+    bool finished() const;
+
+protected:
+
+private:
+
+    bool init( int aWindowBits );
+
+    void cleanup();
+
+    HTTPContentCoding::Coding   iCoding;
+    z_stream_s*                 iStream;
+    QByteArray                  iHeader;        ///< Start of the body until the wrapper has been detected
+    bool                        iRawDeflate;
+    bool                        iFinished;
+    bool                        iError;
+
+    Q_DISABLE_COPY(HTTPContentDecoder)
+
+};
+
+}
+
+#endif  //  HTTPCONTENTCODING_H
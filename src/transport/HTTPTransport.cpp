@@ -44,7 +44,8 @@ using namespace DataSync;
 
 HTTPTransport::HTTPTransport( const ProtocolContext& aContext, QObject* aParent )
 : BaseTransport( aContext, aParent), iManager( 0 ), iFirstMessageSent( false ),
-  iMaxNumberOfResendAttempts( 0 ), iNumberOfResendAttempts( 0 )
+  iMaxNumberOfResendAttempts( 0 ), iNumberOfResendAttempts( 0 ),
+  iContentEncoding( HTTPContentCoding::CODING_IDENTITY )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -60,6 +61,9 @@ HTTPTransport::~HTTPTransport()
 
     delete iManager;
     iManager = NULL;
+
+    qDeleteAll( iResponseDecoders );
+    iResponseDecoders.clear();
 }
 
 void HTTPTransport::setProperty( const QString& aProperty, const QString& aValue )
@@ -87,6 +91,15 @@ void HTTPTransport::setProperty( const QString& aProperty, const QString& aValue
         proxy.setPort( aValue.toInt() );
         iManager->setProxy(proxy);
     }
+    else if( aProperty == HTTPCONTENTENCODINGPROP )
+    {
+        qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
+        iContentEncoding = HTTPContentCoding::fromName( aValue.toLatin1() );
+    }
+    else
+    {
+        BaseTransport::setProperty( aProperty, aValue );
+    }
 
 }
 
@@ -169,7 +182,7 @@ void HTTPTransport::addXheader(const QString& aName, const QString& aValue)
 }
 
 void HTTPTransport::prepareRequest( QNetworkRequest& aRequest, const QByteArray& aContentType,
-                                    int aContentLength )
+                                    int aContentLength, const QByteArray& aContentEncoding )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
@@ -185,6 +198,14 @@ void HTTPTransport::prepareRequest( QNetworkRequest& aRequest, const QByteArray&
     aRequest.setRawHeader( HTTP_HDRSTR_UA, HTTP_UA_VALUE);
     aRequest.setRawHeader( HTTP_HDRSTR_CONTENT_TYPE, aContentType );
     aRequest.setRawHeader( HTTP_HDRSTR_ACCEPT,HTTP_ACCEPT_VALUE );
+    if( !aContentEncoding.isEmpty() ) {
+        aRequest.setRawHeader( HTTP_HDRSTR_CONTENT_ENCODING, aContentEncoding );
+    }
+    if( iContentEncoding != HTTPContentCoding::CODING_IDENTITY ) {
+        // Setting Accept-Encoding explicitly turns off the implicit response
+        // decompression of QNetworkAccessManager, see createResponseDecoder()
+        aRequest.setRawHeader( HTTP_HDRSTR_ACCEPT_ENCODING, HTTP_ACCEPT_ENCODING_VALUE );
+    }
     aRequest.setHeader( QNetworkRequest::ContentLengthHeader, QVariant( aContentLength ) );
     QMap<QString, QString>::const_iterator i;
     for (i = iXheaders.constBegin(); i != iXheaders.constEnd(); i++) {
@@ -213,22 +234,42 @@ void HTTPTransport::prepareRequest( QNetworkRequest& aRequest, const QByteArray&
 bool HTTPTransport::sendRequest( const QByteArray& aData, const QString& aContentType )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // Message size limits apply to the uncompressed message, compression only
+    // reduces the amount of data sent over the network
+    QByteArray body;
+    QByteArray contentEncoding;
+
+    if( iContentEncoding != HTTPContentCoding::CODING_IDENTITY &&
+        HTTPContentCoding::compress( aData, iContentEncoding, body ) ) {
+        contentEncoding = HTTPContentCoding::name( iContentEncoding );
+        qCDebug(lcSyncML) << "Compressed request from" << aData.size() << "to" << body.size() << "bytes";
+    }
+    else {
+        body = aData;
+    }
+
     // build the message, and send it
     QNetworkRequest request;
-    prepareRequest( request, aContentType.toLatin1(), aData.size() );
+    prepareRequest( request, aContentType.toLatin1(), body.size(), contentEncoding );
 
 #ifndef QT_NO_DEBUG
     // Print the message
-    qCDebug(lcSyncMLProtocol) << "Sending request to" << request.url().host();
-    qCDebug(lcSyncMLProtocol) << "Headers:";
-    QList<QByteArray> headers = request.rawHeaderList();
-    foreach( const QByteArray& ar, headers ) {
-            qCDebug(lcSyncMLProtocol) << ar << ": " << request.rawHeader(ar);
+    if( lcSyncMLProtocol().isDebugEnabled() ) {
+        qCDebug(lcSyncMLProtocol) << "Sending request to" << request.url().host();
+        qCDebug(lcSyncMLProtocol) << "Headers:";
+        QList<QByteArray> headers = request.rawHeaderList();
+        foreach( const QByteArray& ar, headers ) {
+                qCDebug(lcSyncMLProtocol) << ar << ": " << request.rawHeader(ar);
+        }
     }
 #endif  //  QT_NO_DEBUG
 
-    if( iManager->post(request, aData) ) {
+    QNetworkReply* reply = iManager->post(request, body);
+
+    if( reply ) {
         // send succeeded
+        connect( reply, SIGNAL(readyRead()), this, SLOT(httpReadyRead()) );
         return true;
     }
     else {
@@ -237,6 +278,21 @@ bool HTTPTransport::sendRequest( const QByteArray& aData, const QString& aConten
     }
 }
 
+HTTPContentDecoder* HTTPTransport::createResponseDecoder( QNetworkReply* aReply ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    // QNetworkAccessManager negotiates compression and decompresses responses
+    // by itself, unless Accept-Encoding was set explicitly for the request
+    HTTPContentCoding::Coding coding = HTTPContentCoding::CODING_IDENTITY;
+
+    if( aReply->request().hasRawHeader( HTTP_HDRSTR_ACCEPT_ENCODING ) ) {
+        coding = HTTPContentCoding::fromName( aReply->rawHeader( HTTP_HDRSTR_CONTENT_ENCODING ) );
+    }
+
+    return new HTTPContentDecoder( coding );
+}
+
 bool HTTPTransport::shouldResend() const
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -283,6 +339,9 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
 
     Q_ASSERT( aReply );
 
+    // Decoder exists already if parts of the response have been received
+    QScopedPointer<HTTPContentDecoder> decoder( iResponseDecoders.take( aReply ) );
+
     if( aReply->error() != QNetworkReply::NoError )
     {
         switch( aReply->error() )
@@ -292,8 +351,15 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
 
                 // In case the remote side times out, possibly try to re-send the message.
                 // If message should not be re-sent, or the re-send fails, handle as
-                // an error
-                if( !shouldResend() || !resend() ) {
+                // an error. A response that has been partly passed to the parser is
+                // never re-sent, as parts of it may already have been processed.
+                bool partlyReceived = receivingChunks();
+                cancelChunks();
+                if( partlyReceived ) {
+                    qCWarning(lcSyncML) << "Connection timeout while receiving response:" << aReply->errorString();
+                    emit sendEvent(TRANSPORT_CONNECTION_TIMEOUT, aReply->errorString());
+                }
+                else if( !shouldResend() || !resend() ) {
                     qCDebug(lcSyncML) << "Connection timeout:" << aReply->errorString();
                     emit sendEvent(TRANSPORT_CONNECTION_TIMEOUT, aReply->errorString());
                 }
@@ -301,6 +367,7 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
             }
             default:
             {
+                cancelChunks();
                 qCDebug(lcSyncML) << "TRANSPORT ERROR REASON:" << aReply->errorString();
                 emit sendEvent(TRANSPORT_CONNECTION_FAILED, aReply->errorString());
                 break;
@@ -310,16 +377,44 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
     else {
 
 #ifndef QT_NO_DEBUG
-        qCDebug(lcSyncMLProtocol) << "Received response" ;
-        qCDebug(lcSyncMLProtocol) << "Headers:" ;
+        if( lcSyncMLProtocol().isDebugEnabled() ) {
+            qCDebug(lcSyncMLProtocol) << "Received response" ;
+            qCDebug(lcSyncMLProtocol) << "Headers:" ;
 
-        QList<QByteArray> headers = aReply->rawHeaderList();
-        foreach( const QByteArray& ar, headers ) {
-                qCDebug(lcSyncMLProtocol) << ar << ": " << aReply->rawHeader(ar);
+            QList<QByteArray> headers = aReply->rawHeaderList();
+            foreach( const QByteArray& ar, headers ) {
+                    qCDebug(lcSyncMLProtocol) << ar << ": " << aReply->rawHeader(ar);
+            }
         }
 #endif  //  QT_NO_DEBUG
 
-        QByteArray data = aReply->readAll();
+        if( !decoder ) {
+            decoder.reset( createResponseDecoder( aReply ) );
+        }
+
+        QByteArray data;
+
+        if( !decoder->decode( aReply->readAll(), data ) || !decoder->finished() ) {
+            cancelChunks();
+            qCWarning(lcSyncML) << "Could not decompress response";
+            emit sendEvent( TRANSPORT_DATA_INVALID_CONTENT, "Invalid compressed response" );
+            aReply->deleteLater();
+            return;
+        }
+
+        if( receivingChunks() ) {
+
+            if( !iFirstMessageSent ) {
+                iFirstMessageSent = true;
+                iFirstMessageData.clear();
+                iFirstMessageContentType.clear();
+            }
+
+            receiveChunk( data, true );
+
+            aReply->deleteLater();
+            return;
+        }
 
         // In case of zero-length response, possibly try to re-send the message. If the message
         // should not be re-sent, or if re-send fails, let the zero-length response through.
@@ -344,6 +439,37 @@ void HTTPTransport::httpRequestFinished( QNetworkReply *aReply )
 
 }
 
+void HTTPTransport::httpReadyRead()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>( sender() );
+
+    if( !reply || reply->error() != QNetworkReply::NoError ) {
+        return;
+    }
+
+    // Pass the response on in parts if it can be parsed while it is still
+    // being received. Otherwise it is read completely once finished.
+    QString contentType = reply->header( QNetworkRequest::ContentTypeHeader ).toString();
+
+    if( acceptsChunk( contentType ) ) {
+
+        HTTPContentDecoder* decoder = iResponseDecoders.value( reply );
+
+        if( !decoder ) {
+            decoder = createResponseDecoder( reply );
+            iResponseDecoders.insert( reply, decoder );
+        }
+
+        // Errors are reported once the response has been finished
+        QByteArray data;
+        if( decoder->decode( reply->readAll(), data ) && !data.isEmpty() ) {
+            receiveChunk( data, false );
+        }
+    }
+}
+
 void HTTPTransport::authRequired(QNetworkReply* /*aReply*/, QAuthenticator* /*aAuth*/ ) {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
     qCDebug(lcSyncML) << "Network Connection needs authentication";
@@ -37,6 +37,7 @@
 #include <QMap>
 
 #include "BaseTransport.h"
+#include "HTTPContentCoding.h"
 #include <QNetworkAccessManager>
 
 class QNetworkProxy;
@@ -103,6 +104,8 @@ private slots:
 
     void httpRequestFinished( QNetworkReply* aReply );
 
+    void httpReadyRead();
+
     void slotNetworkStateChanged(bool aState);
 
     void handleProxyAuthentication( QNetworkProxy& aProxy, QAuthenticator* aAuth );
@@ -117,10 +120,12 @@ private slots:
 private:
 
     void prepareRequest( QNetworkRequest& aRequest, const QByteArray& aContentType,
-                         int aContentLength );
+                         int aContentLength, const QByteArray& aContentEncoding );
 
     bool sendRequest( const QByteArray& aData, const QString& aContentType );
 
+    HTTPContentDecoder* createResponseDecoder( QNetworkReply* aReply ) const;
+
     bool shouldResend() const;
     bool resend();
 
@@ -134,6 +139,8 @@ private:
     int                     iMaxNumberOfResendAttempts;
     int                     iNumberOfResendAttempts;
     QMap<QString, QString>  iXheaders;
+    HTTPContentCoding::Coding iContentEncoding;
+    QMap<QNetworkReply*, HTTPContentDecoder*> iResponseDecoders;
 };
 
 }
@@ -42,6 +42,7 @@
 using namespace DataSync;
 
 LibWbXML2Encoder::LibWbXML2Encoder()
+ : iUseStringTable( false )
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 }
@@ -128,46 +129,38 @@ bool LibWbXML2Encoder::encodeToWbXML( const SyncMLCmdObject& aRootObject,
         qCCritical(lcSyncML) << "Could not generate WBXMLTree";
         return false;
     }
-   
 
-    WBXMLEncoder* encoder = wbxml_encoder_create();
+    QByteArray wbxml;
+    bool success = encodeTree( tree, false, wbxml );
 
-    if( !encoder ) {
-        qCCritical(lcSyncML) << "Could not create WBXMLEncoder";
-        wbxml_tree_destroy( tree );
-        return false;
-    }
-    
-    wbxml_encoder_set_wbxml_version(encoder, WBXML_VERSION_12);
-    //Workaround : For N900 combo sync
-    wbxml_encoder_set_use_strtbl (encoder, false);
-    wbxml_encoder_set_tree( encoder, tree );
+    if( success && iUseStringTable ) {
 
-    WB_UTINY* wbxml;
-    WB_ULONG wbxml_len;
+        // String table is used only if it makes the document smaller
+        QByteArray wbxmlWithStringTable;
 
-    WBXMLError error = wbxml_encoder_encode_tree_to_wbxml( encoder, &wbxml, &wbxml_len );
-    bool success = false;
+        if( encodeTree( tree, true, wbxmlWithStringTable ) &&
+            wbxmlWithStringTable.size() < wbxml.size() ) {
+            qCDebug(lcSyncML) << "Using string table, size without table:" << wbxml.size();
+            wbxml = wbxmlWithStringTable;
+        }
+    }
 
-    if( error == WBXML_OK ) {
-        aWbXMLDocument.append( (char *)wbxml, wbxml_len );
-        wbxml_free( wbxml );
-        success = true;
+    if( success ) {
+        aWbXMLDocument.append( wbxml );
         qCDebug(lcSyncML) << "Encoding successful";
-        qCDebug(lcSyncML) << "wbXML buffer size:" << wbxml_len;
-    }
-    else {
-        qCCritical(lcSyncML) << "wbXML conversion failed:" << (const char* )wbxml_errors_string( error );
-        success = false;
+        qCDebug(lcSyncML) << "wbXML buffer size:" << wbxml.size();
     }
 
     destroyTree( tree );
 
-    wbxml_encoder_destroy( encoder );
-
     return success;
 }
 
+void LibWbXML2Encoder::setUseStringTable( bool aUse )
+{
+    iUseStringTable = aUse;
+}
+
 bool LibWbXML2Encoder::decodeFromWbXML( const QByteArray& aWbXMLDocument, QByteArray& aXMLDocument,
                                         bool aPrettyPrint ) const
 {
@@ -226,6 +219,44 @@ bool LibWbXML2Encoder::decodeFromWbXML( const QByteArray& aWbXMLDocument, QByteA
 
 }
 
+bool LibWbXML2Encoder::encodeTree( WBXMLTree* aTree, bool aUseStringTable,
+                                   QByteArray& aWbXMLDocument ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    WBXMLEncoder* encoder = wbxml_encoder_create();
+
+    if( !encoder ) {
+        qCCritical(lcSyncML) << "Could not create WBXMLEncoder";
+        return false;
+    }
+
+    wbxml_encoder_set_wbxml_version(encoder, WBXML_VERSION_12);
+    //Workaround : For N900 combo sync, string table is used only on request
+    wbxml_encoder_set_use_strtbl (encoder, aUseStringTable);
+    wbxml_encoder_set_tree( encoder, aTree );
+
+    WB_UTINY* wbxml;
+    WB_ULONG wbxml_len;
+
+    WBXMLError error = wbxml_encoder_encode_tree_to_wbxml( encoder, &wbxml, &wbxml_len );
+    bool success = false;
+
+    if( error == WBXML_OK ) {
+        aWbXMLDocument.append( (char *)wbxml, wbxml_len );
+        wbxml_free( wbxml );
+        success = true;
+    }
+    else {
+        qCCritical(lcSyncML) << "wbXML conversion failed:" << (const char* )wbxml_errors_string( error );
+        success = false;
+    }
+
+    wbxml_encoder_destroy( encoder );
+
+    return success;
+}
+
 WBXMLTree* LibWbXML2Encoder::generateTree( const SyncMLCmdObject& aRootObject,
                                             ProtocolVersion aVersion ) const
 {
@@ -286,15 +317,13 @@ bool LibWbXML2Encoder::createNode( const SyncMLCmdObject& aObject,
     }
 
     // ** Write element attributes
-    const QMap<QString, QString>& attributes = aObject.getAttributes();
+    const SyncMLAttributes& attributes = aObject.getAttributes();
     bool attributesOk = true;
 
-    QMapIterator<QString, QString> i( attributes );
-    while( i.hasNext() ) {
-        i.next();
+    for( int i = 0; i < attributes.count(); ++i ) {
 
-        QByteArray attrName = i.key().toUtf8();
-        QByteArray attrValue = i.value().toUtf8();
+        QByteArray attrName = attributes.nameAt( i ).toUtf8();
+        QByteArray attrValue = attributes.valueAt( i ).toUtf8();
         WBXMLError error = wbxml_tree_node_add_xml_attr( aTree->lang, node,
                                                          (unsigned char*)attrName.constData(),
                                                          (unsigned char*)attrValue.constData() );
@@ -311,7 +340,8 @@ bool LibWbXML2Encoder::createNode( const SyncMLCmdObject& aObject,
     }
 
     // ** Write element value
-    QByteArray value = aObject.getValue().toUtf8();
+    QByteArray value = aObject.getUtf8Value().isEmpty() ? aObject.getValue().toUtf8()
+                                                        : aObject.getUtf8Value();
 
     bool valueOk = true;
 
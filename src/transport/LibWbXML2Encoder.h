@@ -100,10 +100,22 @@ public:
     bool decodeFromWbXML( const QByteArray& aWbXMLDocument, QByteArray& aXMLDocument,
                           bool aPrettyPrint ) const;
 
+    /*! \brief Set whether to use a string table in WbXML documents
+     *
+     * When enabled, the document is encoded both with and without a string
+     * table, and the smaller one is used. Disabled by default, as some
+     * devices do not handle string tables.
+     *
+     * @param aUse True to use string table when it pays off, otherwise false
+     */
+    void setUseStringTable( bool aUse );
+
 protected:
 
 private:
 
+    bool encodeTree( WBXMLTree* aTree, bool aUseStringTable, QByteArray& aWbXMLDocument ) const;
+
     WBXMLTree* generateTree( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion ) const;
 
     WBXMLTree* createTree( const SyncMLCmdObject& aObject, ProtocolVersion aVersion ) const;
@@ -115,6 +127,8 @@ private:
 
     WBXMLLanguage namespaceToLanguage( const SyncMLCmdObject& aObject, ProtocolVersion aVersion ) const;
 
+    bool iUseStringTable;
+
 };
 
 }
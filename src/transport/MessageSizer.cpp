@@ -0,0 +1,180 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "MessageSizer.h"
+
+#include "SyncMLMessage.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+MessageSizer::MessageSizer( bool aWbXML, ProtocolVersion aVersion )
+ : iWbXML( aWbXML ), iVersion( aVersion )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+MessageSizer::~MessageSizer()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+int MessageSizer::messageSize( const SyncMLMessage& aMessage ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( iWbXML ) {
+        return iWbXMLEncoder.encodedSize( aMessage, iVersion );
+    }
+    else {
+        return iQtEncoder.encodedSize( aMessage );
+    }
+}
+
+int MessageSizer::elementSize( const SyncMLCmdObject& aObject ) const
+{
+    const QByteArray encoding = aObject.getEncoding( iWbXML, iVersion );
+
+    if( !encoding.isEmpty() ) {
+        return encoding.size();
+    }
+
+    QByteArray data;
+    bool encoded = false;
+
+    if( iWbXML ) {
+        encoded = iWbXMLEncoder.encodeElement( aObject, iVersion, data );
+    }
+    else {
+        encoded = iQtEncoder.encodeElement( aObject, data );
+    }
+
+    if( !encoded ) {
+        return -1;
+    }
+
+    aObject.setEncoding( data, iWbXML, iVersion );
+
+    return data.size();
+}
+
+int MessageSizer::appendSize( const SyncMLCmdObject& aParent, const SyncMLCmdObject& aChild ) const
+{
+    int size = elementSize( aChild );
+
+    if( size < 0 ) {
+        return -1;
+    }
+
+    if( !isEmptyElement( aParent ) ) {
+        return size;
+    }
+
+    int overhead = contentOverhead( aParent );
+
+    if( overhead < 0 ) {
+        return -1;
+    }
+
+    return size + overhead;
+}
+
+int MessageSizer::childrenSize( const SyncMLCmdObject& aParent, int aFirstChild ) const
+{
+    const QList<SyncMLCmdObject*>& children = aParent.getChildren();
+
+    if( aFirstChild >= children.count() ) {
+        return 0;
+    }
+
+    int size = 0;
+
+    for( int i = aFirstChild; i < children.count(); ++i ) {
+
+        int childSize = elementSize( *children[i] );
+
+        if( childSize < 0 ) {
+            return -1;
+        }
+
+        size += childSize;
+    }
+
+    if( aFirstChild == 0 && aParent.getValue().isEmpty() && aParent.getUtf8Value().isEmpty() ) {
+
+        int overhead = contentOverhead( aParent );
+
+        if( overhead < 0 ) {
+            return -1;
+        }
+
+        size += overhead;
+    }
+
+    return size;
+}
+
+bool MessageSizer::isEmptyElement( const SyncMLCmdObject& aObject ) const
+{
+    return aObject.getChildren().isEmpty() &&
+           aObject.getValue().isEmpty() &&
+           aObject.getUtf8Value().isEmpty();
+}
+
+int MessageSizer::contentOverhead( const SyncMLCmdObject& aParent ) const
+{
+    // Empty element is written as a single tag. Resolve what writing it
+    // as start and end tags costs by encoding it once without and once with
+    // an empty child
+    SyncMLCmdObject parent( aParent.getName() );
+
+    const SyncMLAttributes& attributes = aParent.getAttributes();
+    for( int i = 0; i < attributes.count(); ++i ) {
+        parent.addAttribute( attributes.nameAt( i ), attributes.valueAt( i ) );
+    }
+
+    int emptySize = elementSize( parent );
+
+    SyncMLCmdObject* child = new SyncMLCmdObject( aParent.getName() );
+    parent.addChild( child );
+
+    int withChild = elementSize( parent );
+    int childSize = elementSize( *child );
+
+    if( withChild < 0 || childSize < 0 || emptySize < 0 ) {
+        return -1;
+    }
+
+    return withChild - childSize - emptySize;
+}
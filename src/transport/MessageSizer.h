@@ -0,0 +1,131 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef MESSAGESIZER_H
+#define MESSAGESIZER_H
+
+#include "SyncAgentConsts.h"
+#include "QtEncoder.h"
+#include "WbXMLEncoder.h"
+
+namespace DataSync {
+
+class SyncMLMessage;
+class SyncMLCmdObject;
+
+/*! \brief Resolves the exact encoded size of SyncML messages and commands
+ *
+ * Sizes are those of compact XML as written by QtEncoder, or WbXML as
+ * written by WbXMLEncoder without a string table. Unlike the estimates of
+ * SyncMLCmdObject::calculateSize(), the size of a message can be tracked
+ * exactly while commands are added to it.
+ */
+class MessageSizer
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     * @param aWbXML True to resolve WbXML sizes, false to resolve XML sizes
+     * @param aVersion SyncML version
+     */
+    MessageSizer( bool aWbXML, ProtocolVersion aVersion );
+
+    /*! \brief Destructor
+     *
+     */
+    ~MessageSizer();
+
+    /*! \brief Returns the exact size of an encoded message
+     *
+     * @param aMessage Message
+     * @return Size in bytes, or -1 if the message cannot be encoded
+     */
+    int messageSize( const SyncMLMessage& aMessage ) const;
+
+    /*! \brief Returns the exact size of an element inside an encoded message
+     *
+     * The element is encoded, and the encoding is kept with the element.
+     * It is written as such when the message is encoded, so measuring an
+     * element does not add to the cost of sending it, and an element that
+     * has already been measured is not encoded again.
+     *
+     * @param aObject Element, usually a SyncML command
+     * @return Size in bytes, or -1 if the element cannot be encoded
+     */
+    int elementSize( const SyncMLCmdObject& aObject ) const;
+
+    /*! \brief Returns the number of bytes adding an element as a child of
+     *         another element adds to an encoded message
+     *
+     * Element is expected to be in the code page of its parent, which is the
+     * case for SyncML commands added to SyncBody or Sync.
+     *
+     * @param aParent Element the child is added to
+     * @param aChild Child element
+     * @return Size in bytes, or -1 if the element cannot be encoded
+     */
+    int appendSize( const SyncMLCmdObject& aParent, const SyncMLCmdObject& aChild ) const;
+
+    /*! \brief Returns the number of bytes children of an element add to an
+     *         encoded message
+     *
+     * Used to account for what has been added to a message since a
+     * checkpoint, without encoding the rest of the message again.
+     *
+     * @param aParent Element the children were added to
+     * @param aFirstChild Index of the first child to account for. If 0,
+     *                    aParent is expected to have been empty before
+     * @return Size in bytes, or -1 if an element cannot be encoded
+     */
+    int childrenSize( const SyncMLCmdObject& aParent, int aFirstChild ) const;
+
+protected:
+
+private:
+
+    bool isEmptyElement( const SyncMLCmdObject& aObject ) const;
+
+    int contentOverhead( const SyncMLCmdObject& aParent ) const;
+
+    bool            iWbXML;
+    ProtocolVersion iVersion;
+    QtEncoder       iQtEncoder;
+    WbXMLEncoder    iWbXMLEncoder;
+
+};
+
+}
+
+#endif  //  MESSAGESIZER_H
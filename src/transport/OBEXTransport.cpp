@@ -93,7 +93,10 @@ void OBEXTransport::setProperty( const QString& aProperty, const QString& aValue
         qCDebug(lcSyncML) << "Setting property" << aProperty <<":" << aValue;
         iTimeOut = aValue.toInt();
     }
-
+    else
+    {
+        BaseTransport::setProperty( aProperty, aValue );
+    }
 
 }
 
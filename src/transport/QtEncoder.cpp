@@ -33,6 +33,8 @@
 
 #include "QtEncoder.h"
 
+#include <QBuffer>
+#include <QIODevice>
 #include <QXmlStreamWriter>
 
 #include "SyncMLMessage.h"
@@ -41,6 +43,102 @@
 
 using namespace DataSync;
 
+namespace {
+
+// Device that only counts the bytes written to it
+class ByteCounter : public QIODevice
+{
+public:
+
+    ByteCounter() : iCount( 0 )
+    {
+        open( QIODevice::WriteOnly );
+    }
+
+    qint64 count() const
+    {
+        return iCount;
+    }
+
+protected:
+
+    virtual qint64 readData( char* /*aData*/, qint64 /*aMaxSize*/ )
+    {
+        return -1;
+    }
+
+    virtual qint64 writeData( const char* /*aData*/, qint64 aSize )
+    {
+        iCount += aSize;
+        return aSize;
+    }
+
+private:
+
+    qint64 iCount;
+
+};
+
+// Returns true if aData is well-formed UTF-8. Values that are not are left to
+// QString conversion, which replaces the malformed sequences
+bool isValidUtf8( const QByteArray& aData )
+{
+    const unsigned char* data = reinterpret_cast<const unsigned char*>( aData.constData() );
+    const int size = aData.size();
+    int i = 0;
+
+    while( i < size ) {
+
+        const unsigned char c = data[i];
+        int trailing = 0;
+        unsigned int codePoint = 0;
+
+        if( c < 0x80 ) {
+            ++i;
+            continue;
+        }
+        else if( ( c & 0xE0 ) == 0xC0 ) {
+            trailing = 1;
+            codePoint = c & 0x1F;
+        }
+        else if( ( c & 0xF0 ) == 0xE0 ) {
+            trailing = 2;
+            codePoint = c & 0x0F;
+        }
+        else if( ( c & 0xF8 ) == 0xF0 ) {
+            trailing = 3;
+            codePoint = c & 0x07;
+        }
+        else {
+            return false;
+        }
+
+        if( i + trailing >= size ) {
+            return false;
+        }
+
+        for( int j = 1; j <= trailing; ++j ) {
+            if( ( data[i + j] & 0xC0 ) != 0x80 ) {
+                return false;
+            }
+            codePoint = ( codePoint << 6 ) | ( data[i + j] & 0x3F );
+        }
+
+        // Reject overlong forms, surrogates and values beyond Unicode range
+        static const unsigned int minimum[] = { 0, 0x80, 0x800, 0x10000 };
+        if( codePoint < minimum[trailing] || codePoint > 0x10FFFF ||
+            ( codePoint >= 0xD800 && codePoint <= 0xDFFF ) ) {
+            return false;
+        }
+
+        i += trailing + 1;
+    }
+
+    return true;
+}
+
+}
+
 QtEncoder::QtEncoder()
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
@@ -58,7 +156,27 @@ bool QtEncoder::encodeToXML( const SyncMLCmdObject& aRootObject,
 {
     FUNCTION_CALL_TRACE(lcSyncMLTrace);
 
-    QXmlStreamWriter writer( &aXMLDocument );
+    QBuffer buffer( &aXMLDocument );
+
+    if( !buffer.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+        return false;
+    }
+
+    return encodeToXML( aRootObject, &buffer, aPrettyPrint );
+}
+
+bool QtEncoder::encodeToXML( const SyncMLCmdObject& aRootObject,
+                             QIODevice* aDevice,
+                             bool aPrettyPrint ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    if( !aDevice || !aDevice->isWritable() ) {
+        qCWarning(lcSyncML) << "Cannot encode XML to a device that is not writable";
+        return false;
+    }
+
+    QXmlStreamWriter writer( aDevice );
 
     writer.setAutoFormatting( aPrettyPrint );
 
@@ -66,16 +184,70 @@ bool QtEncoder::encodeToXML( const SyncMLCmdObject& aRootObject,
     generateElement(aRootObject, writer );
     writer.writeEndDocument();
 
-    return true;
+    return !writer.hasError();
+}
+
+int QtEncoder::encodedSize( const SyncMLCmdObject& aRootObject ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    ByteCounter counter;
+    QXmlStreamWriter writer( &counter );
+
+    writer.writeStartDocument();
+    generateElement( aRootObject, writer );
+    writer.writeEndDocument();
+
+    return counter.count();
+}
+
+int QtEncoder::encodedElementSize( const SyncMLCmdObject& aObject ) const
+{
+    ByteCounter counter;
+    QXmlStreamWriter writer( &counter );
+
+    generateElement( aObject, writer );
+
+    return counter.count();
+}
+
+bool QtEncoder::encodeElement( const SyncMLCmdObject& aObject, QByteArray& aData ) const
+{
+    QBuffer buffer( &aData );
+
+    if( !buffer.open( QIODevice::WriteOnly | QIODevice::Append ) ) {
+        return false;
+    }
+
+    QXmlStreamWriter writer( &buffer );
+
+    generateElement( aObject, writer );
+
+    return !writer.hasError();
 }
 
 void QtEncoder::generateElement( const SyncMLCmdObject& aObject,
                                  QXmlStreamWriter& aWriter ) const
 {
 
+    // Element that was encoded when the message was filled is written as it
+    // was encoded then. Human-readable output is always generated
+    if( !aWriter.autoFormatting() && aWriter.device() ) {
+
+        const QByteArray encoding = aObject.getEncoding( false );
+
+        if( !encoding.isEmpty() ) {
+            // Close the pending start tag of the parent before the raw write
+            aWriter.writeCharacters( QString() );
+            aWriter.device()->write( encoding );
+            return;
+        }
+    }
+
     const QList<SyncMLCmdObject*>& children = aObject.getChildren();
 
     if( aObject.getValue().isEmpty() &&
+        aObject.getUtf8Value().isEmpty() &&
         children.isEmpty() ) {
 
         aWriter.writeEmptyElement( aObject.getName() );
@@ -84,22 +256,40 @@ void QtEncoder::generateElement( const SyncMLCmdObject& aObject,
     else {
         aWriter.writeStartElement( aObject.getName() );
 
-        const QMap<QString, QString>& attributes = aObject.getAttributes();
+        const SyncMLAttributes& attributes = aObject.getAttributes();
         QXmlStreamAttributes attr;
-        QMapIterator<QString, QString> i( attributes );
-        while( i.hasNext() ) {
-            i.next();
-
-            attr.append( i.key(), i.value() );
+        for( int i = 0; i < attributes.count(); ++i ) {
+            attr.append( attributes.nameAt( i ), attributes.valueAt( i ) );
         }
 
         aWriter.writeAttributes( attr );
 
+        // Item data is usually the bulk of the message. When it can be written
+        // verbatim, stream it to the device without a round trip through QString
+        if( aObject.getCDATA() && !aObject.getUtf8Value().isEmpty() &&
+            !aWriter.autoFormatting() && aWriter.device() &&
+            isValidUtf8( aObject.getUtf8Value() ) ) {
+
+            writeCDATA( aObject.getUtf8Value(), aWriter );
+
+            for( int i = 0; i < children.count(); ++i ) {
+                generateElement( *children[i], aWriter );
+            }
+
+            aWriter.writeEndElement();
+            return;
+        }
+
+        // UTF-8 values are converted only here, as QXmlStreamWriter does not
+        // accept encoded data
+        const QString value = aObject.getUtf8Value().isEmpty() ? aObject.getValue()
+                                                               : QString::fromUtf8( aObject.getUtf8Value() );
+
         if( aObject.getCDATA() ) {
-            aWriter.writeCDATA( aObject.getValue() );
+            aWriter.writeCDATA( value );
         }
         else {
-            aWriter.writeCharacters( aObject.getValue() );
+            aWriter.writeCharacters( value );
         }
 
         for( int i = 0; i < children.count(); ++i ) {
@@ -111,3 +301,34 @@ void QtEncoder::generateElement( const SyncMLCmdObject& aObject,
     }
 
 }
+
+void QtEncoder::writeCDATA( const QByteArray& aUtf8Value,
+                            QXmlStreamWriter& aWriter ) const
+{
+    static const char openTag[] = "<![CDATA[";
+    static const char closeTag[] = "]]>";
+    static const char splitTag[] = "]]]]><![CDATA[>";
+
+    // Close the pending start tag. Anything QXmlStreamWriter writes goes
+    // directly to the device, so raw writes below keep the document in order
+    aWriter.writeCharacters( QString() );
+
+    QIODevice* device = aWriter.device();
+
+    // Same output as QXmlStreamWriter::writeCDATA(): terminators inside the
+    // data are split over two CDATA sections
+    device->write( openTag, sizeof( openTag ) - 1 );
+
+    int start = 0;
+    int end = aUtf8Value.indexOf( closeTag );
+
+    while( end != -1 ) {
+        device->write( aUtf8Value.constData() + start, end - start );
+        device->write( splitTag, sizeof( splitTag ) - 1 );
+        start = end + static_cast<int>( sizeof( closeTag ) ) - 1;
+        end = aUtf8Value.indexOf( closeTag, start );
+    }
+
+    device->write( aUtf8Value.constData() + start, aUtf8Value.size() - start );
+    device->write( closeTag, sizeof( closeTag ) - 1 );
+}
@@ -35,6 +35,7 @@
 
 #include <QByteArray>
 
+class QIODevice;
 class QXmlStreamWriter;
 
 namespace DataSync {
@@ -69,12 +70,55 @@ public:
     bool encodeToXML( const SyncMLCmdObject& aRootObject, QByteArray& aXMLDocument,
                       bool aPrettyPrint ) const;
 
+    /*! \brief Encode a SyncML message to XML document, writing it straight
+     *         to a device
+     *
+     * The document is streamed as it is generated, so no intermediate copy of
+     * it is kept in memory.
+     *
+     * @param aRootObject Root object of the document
+     * @param aDevice Output device, must be open for writing
+     * @param aPrettyPrint If true prefer human-readable output, otherwise prefer compact size
+     * @return True on success, otherwise false
+     */
+    bool encodeToXML( const SyncMLCmdObject& aRootObject, QIODevice* aDevice,
+                      bool aPrettyPrint ) const;
+
+    /*! \brief Returns the exact size of the compact XML document encodeToXML()
+     *         would produce
+     *
+     * @param aRootObject Root object of the document
+     * @return Size in bytes
+     */
+    int encodedSize( const SyncMLCmdObject& aRootObject ) const;
+
+    /*! \brief Returns the exact number of bytes an element takes in a compact
+     *         XML document
+     *
+     * @param aObject Element, usually a SyncML command
+     * @return Size in bytes
+     */
+    int encodedElementSize( const SyncMLCmdObject& aObject ) const;
+
+    /*! \brief Encode an element as it is written in a compact XML document
+     *
+     * Elements that keep an XML encoding (see SyncMLCmdObject::setEncoding())
+     * are written as such when a compact document is encoded.
+     *
+     * @param aObject Element, usually a SyncML command
+     * @param aData Output data. Encoded element is appended
+     * @return True on success, otherwise false
+     */
+    bool encodeElement( const SyncMLCmdObject& aObject, QByteArray& aData ) const;
+
 protected:
 
 private:
 
     void generateElement( const SyncMLCmdObject& aObject, QXmlStreamWriter& aWriter ) const;
 
+    void writeCDATA( const QByteArray& aUtf8Value, QXmlStreamWriter& aWriter ) const;
+
 };
 
 }
@@ -170,6 +170,9 @@ signals:
     void sendEvent( DataSync::TransportStatusEvent aEvent, const QString& aDescription );
 
     /*! \brief Signal that is emitted when new XML data is available
+     *
+     * If native WbXML decoding has been enabled, data can also be WbXML
+     * that SyncMLMessageParser decodes directly.
      *
      * @param aDevice QIODevice that can be used to read data
      * @param aIsNewPacket bool To indicate if this is a newly received packet
@@ -177,6 +180,25 @@ signals:
      */
     void readXMLData( QIODevice* aDevice, bool aIsNewPacket );
 
+    /*! \brief Signal that is emitted when a chunk of an incoming XML message
+     *         has been received
+     *
+     * Emitted instead of readXMLData() when incremental parsing has been
+     * enabled and the transport is able to deliver the message in parts.
+     *
+     * @param aData Received chunk
+     * @param aFirstChunk True if this is the first chunk of a new message
+     * @param aLastChunk True if this is the last chunk of the message
+     */
+    void readXMLChunk( const QByteArray& aData, bool aFirstChunk, bool aLastChunk );
+
+    /*! \brief Signal that is emitted when a message that was being received
+     *         in chunks will not be completed
+     *
+     * Chunks already passed with readXMLChunk() should be discarded.
+     */
+    void chunksCancelled();
+
     /*! \brief Signal that is emitted when new SAN data is available
      *
      * @param aDevice QIODevice that can be used to read data
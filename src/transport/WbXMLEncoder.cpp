@@ -0,0 +1,512 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "WbXMLEncoder.h"
+
+#include <QHash>
+
+#include "SyncMLCmdObject.h"
+#include "WbXMLTokens.h"
+#include "WbXMLStringTable.h"
+#include "datatypes.h"
+
+#include "SyncMLLogging.h"
+
+using namespace DataSync;
+
+namespace {
+
+enum Language {
+    LANGUAGE_NONE,      // Element does not declare a namespace
+    LANGUAGE_UNKNOWN,
+    LANGUAGE_SYNCML,    // SyncML and MetInf code pages
+    LANGUAGE_DEVINF
+};
+
+// Maps element names to tokens. Token is stored in the lowest byte and the
+// code page in the next byte
+typedef QHash<QString, int> TokenTable;
+
+void addTokens( TokenTable& aTable, const char* const aNames[], int aCount, int aPage )
+{
+    for( int i = 0; i < aCount; ++i ) {
+        if( aNames[i] ) {
+            aTable.insert( QLatin1String( aNames[i] ),
+                           ( aPage << 8 ) | ( WBXML_FIRST_ELEMENT_TOKEN + i ) );
+        }
+    }
+}
+
+TokenTable createSyncMLTokens()
+{
+    TokenTable tokens;
+    addTokens( tokens, SYNCML_PAGE_ELEMENTS,
+               sizeof( SYNCML_PAGE_ELEMENTS ) / sizeof( SYNCML_PAGE_ELEMENTS[0] ),
+               WBXML_PAGE_SYNCML );
+    addTokens( tokens, METINF_PAGE_ELEMENTS,
+               sizeof( METINF_PAGE_ELEMENTS ) / sizeof( METINF_PAGE_ELEMENTS[0] ),
+               WBXML_PAGE_METINF );
+    return tokens;
+}
+
+TokenTable createDevInfTokens()
+{
+    TokenTable tokens;
+    addTokens( tokens, DEVINF_PAGE_ELEMENTS,
+               sizeof( DEVINF_PAGE_ELEMENTS ) / sizeof( DEVINF_PAGE_ELEMENTS[0] ),
+               0 );
+    tokens.insert( QLatin1String( "Size" ), WBXML_DEVINF_SIZE_TOKEN );
+    return tokens;
+}
+
+int elementToken( const QString& aName, Language aLanguage )
+{
+    static const TokenTable syncMLTokens = createSyncMLTokens();
+    static const TokenTable devInfTokens = createDevInfTokens();
+
+    const TokenTable& tokens = ( aLanguage == LANGUAGE_DEVINF ) ? devInfTokens : syncMLTokens;
+    return tokens.value( aName, -1 );
+}
+
+Language namespaceToLanguage( const SyncMLCmdObject& aObject )
+{
+    const SyncMLAttributes& attributes = aObject.getAttributes();
+
+    if( !attributes.contains( XML_NAMESPACE ) ) {
+        return LANGUAGE_NONE;
+    }
+
+    const QString ns = attributes.value( XML_NAMESPACE );
+
+    if( ns == XML_NAMESPACE_VALUE_SYNCML11 ||
+        ns == XML_NAMESPACE_VALUE_SYNCML12 ||
+        ns == XML_NAMESPACE_VALUE_METINF ) {
+        return LANGUAGE_SYNCML;
+    }
+    else if( ns == XML_NAMESPACE_VALUE_DEVINF ) {
+        return LANGUAGE_DEVINF;
+    }
+    else {
+        return LANGUAGE_UNKNOWN;
+    }
+}
+
+// Number of bytes needed to encode a string as UTF-8
+int utf8Length( const QString& aString )
+{
+    int length = 0;
+    const QChar* data = aString.constData();
+    const int size = aString.size();
+
+    for( int i = 0; i < size; ++i ) {
+        const ushort unicode = data[i].unicode();
+
+        if( unicode < 0x80 ) {
+            length += 1;
+        }
+        else if( unicode < 0x800 ) {
+            length += 2;
+        }
+        else if( data[i].isSurrogate() ) {
+            // Surrogate pair takes 4 bytes
+            length += 2;
+        }
+        else {
+            length += 3;
+        }
+    }
+
+    return length;
+}
+
+// Appends WbXML to a byte array, or only counts the bytes if no array is given
+class WbXMLWriter
+{
+public:
+
+    explicit WbXMLWriter( QByteArray* aData ) : iData( aData ), iSize( 0 ) { }
+
+    bool counting() const { return !iData; }
+
+    int size() const { return iSize; }
+
+    void writeByte( quint8 aByte )
+    {
+        if( iData ) {
+            iData->append( static_cast<char>( aByte ) );
+        }
+        ++iSize;
+    }
+
+    void writeBytes( const char* aData, int aLength )
+    {
+        if( iData ) {
+            iData->append( aData, aLength );
+        }
+        iSize += aLength;
+    }
+
+    void skip( int aLength )
+    {
+        Q_ASSERT( !iData );
+        iSize += aLength;
+    }
+
+    void writeMultiByteInt( quint32 aValue )
+    {
+        quint8 bytes[5];
+        int count = 0;
+
+        do {
+            bytes[count++] = aValue & 0x7F;
+            aValue >>= 7;
+        } while( aValue );
+
+        while( count > 1 ) {
+            writeByte( bytes[--count] | 0x80 );
+        }
+
+        writeByte( bytes[0] );
+    }
+
+private:
+
+    QByteArray* iData;
+    int         iSize;
+
+};
+
+void writeValue( const SyncMLCmdObject& aObject, const WbXMLStringTable* aStringTable,
+                 WbXMLWriter& aWriter )
+{
+    QByteArray candidate;
+    if( aStringTable && WbXMLStringTable::candidateValue( aObject, candidate ) ) {
+
+        int offset = aStringTable->offset( candidate );
+
+        if( offset >= 0 ) {
+            aWriter.writeByte( WBXML_STR_T );
+            aWriter.writeMultiByteInt( offset );
+            return;
+        }
+    }
+
+    QByteArray value = aObject.getUtf8Value();
+    int length = value.size();
+
+    if( value.isEmpty() ) {
+        if( aWriter.counting() ) {
+            length = utf8Length( aObject.getValue() );
+        }
+        else {
+            value = aObject.getValue().toUtf8();
+            length = value.size();
+        }
+    }
+
+    // Inline strings are NUL terminated, so values containing NUL characters
+    // are written as opaque data just like CDATA sections
+    bool opaque = aObject.getCDATA() ||
+                  aObject.getUtf8Value().contains( '\0' ) ||
+                  aObject.getValue().contains( QChar( 0 ) );
+
+    if( opaque ) {
+        aWriter.writeByte( WBXML_OPAQUE );
+        aWriter.writeMultiByteInt( length );
+        aWriter.writeBytes( value.constData(), length );
+    }
+    else {
+        aWriter.writeByte( WBXML_STR_I );
+        aWriter.writeBytes( value.constData(), length );
+        aWriter.writeByte( 0 );
+    }
+}
+
+bool writeDocument( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion,
+                    const WbXMLStringTable* aStringTable, WbXMLWriter& aWriter );
+
+bool writeElement( const SyncMLCmdObject& aObject, Language aLanguage, ProtocolVersion aVersion,
+                   const WbXMLStringTable* aStringTable, int& aPage, WbXMLWriter& aWriter )
+{
+    // Element that was encoded when the message was filled is written as it
+    // was encoded then. The encoding starts and ends in the SyncML code page
+    // and does not refer to a string table
+    if( !aStringTable && aLanguage == LANGUAGE_SYNCML && aPage == WBXML_PAGE_SYNCML ) {
+
+        const QByteArray encoding = aObject.getEncoding( true, aVersion );
+
+        if( !encoding.isEmpty() ) {
+            aWriter.writeBytes( encoding.constData(), encoding.size() );
+            return true;
+        }
+    }
+
+    int token = elementToken( aObject.getName(), aLanguage );
+
+    if( token < 0 ) {
+        qCWarning(lcSyncML) << "No WbXML token for element" << aObject.getName();
+        return false;
+    }
+
+    // Namespace declarations are implied by the document and code page, any
+    // other attributes cannot be encoded
+    const SyncMLAttributes& attributes = aObject.getAttributes();
+    if( attributes.count() > ( attributes.contains( XML_NAMESPACE ) ? 1 : 0 ) ) {
+        qCWarning(lcSyncML) << "Cannot encode attributes of element" << aObject.getName();
+        return false;
+    }
+
+    int page = token >> 8;
+    if( page != aPage ) {
+        aWriter.writeByte( WBXML_SWITCH_PAGE );
+        aWriter.writeByte( page );
+        aPage = page;
+    }
+
+    const QList<SyncMLCmdObject*>& children = aObject.getChildren();
+    bool hasValue = !aObject.getUtf8Value().isEmpty() || !aObject.getValue().isEmpty();
+    bool hasContent = hasValue || !children.isEmpty();
+
+    aWriter.writeByte( ( token & 0xFF ) | ( hasContent ? WBXML_TAG_CONTENT : 0 ) );
+
+    if( hasValue ) {
+        writeValue( aObject, aStringTable, aWriter );
+    }
+
+    for( int i = 0; i < children.count(); ++i ) {
+
+        const SyncMLCmdObject& child = *children[i];
+        Language language = namespaceToLanguage( child );
+
+        if( language != LANGUAGE_NONE && language != aLanguage ) {
+
+            // Content in another language, like device info inside SyncML
+            // message, is embedded as a separate document without a string
+            // table
+            WbXMLWriter counter( NULL );
+
+            if( !writeDocument( child, aVersion, NULL, counter ) ) {
+                return false;
+            }
+
+            aWriter.writeByte( WBXML_OPAQUE );
+            aWriter.writeMultiByteInt( counter.size() );
+
+            if( aWriter.counting() ) {
+                aWriter.skip( counter.size() );
+            }
+            else if( !writeDocument( child, aVersion, NULL, aWriter ) ) {
+                return false;
+            }
+
+        }
+        else if( !writeElement( child, aLanguage, aVersion, aStringTable, aPage, aWriter ) ) {
+            return false;
+        }
+
+    }
+
+    if( hasContent ) {
+
+        // Switch back to the code page of this element before its end tag.
+        // Every element then ends in the code page it started in, so the
+        // size of a command does not depend on the commands before it
+        if( aPage != page ) {
+            aWriter.writeByte( WBXML_SWITCH_PAGE );
+            aWriter.writeByte( page );
+            aPage = page;
+        }
+
+        aWriter.writeByte( WBXML_END );
+    }
+
+    return true;
+}
+
+bool writeDocument( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion,
+                    const WbXMLStringTable* aStringTable, WbXMLWriter& aWriter )
+{
+    Language language = namespaceToLanguage( aRootObject );
+    quint32 publicId = 0;
+
+    if( language == LANGUAGE_SYNCML && aVersion == SYNCML_1_1 ) {
+        publicId = WBXML_PUBLICID_SYNCML_11;
+    }
+    else if( language == LANGUAGE_SYNCML && aVersion == SYNCML_1_2 ) {
+        publicId = WBXML_PUBLICID_SYNCML_12;
+    }
+    else if( language == LANGUAGE_DEVINF && aVersion == SYNCML_1_1 ) {
+        publicId = WBXML_PUBLICID_DEVINF_11;
+    }
+    else if( language == LANGUAGE_DEVINF && aVersion == SYNCML_1_2 ) {
+        publicId = WBXML_PUBLICID_DEVINF_12;
+    }
+    else {
+        qCWarning(lcSyncML) << "Cannot encode document" << aRootObject.getName()
+                            << ", unknown language";
+        return false;
+    }
+
+    aWriter.writeByte( WBXML_VERSION_12 );
+    aWriter.writeMultiByteInt( publicId );
+    aWriter.writeMultiByteInt( WBXML_CHARSET_UTF8 );
+
+    if( aStringTable ) {
+        aWriter.writeMultiByteInt( aStringTable->data().size() );
+        aWriter.writeBytes( aStringTable->data().constData(), aStringTable->data().size() );
+    }
+    else {
+        aWriter.writeMultiByteInt( 0 );
+    }
+
+    int page = 0;
+    return writeElement( aRootObject, language, aVersion, aStringTable, page, aWriter );
+}
+
+// Resolves the size of the document, and whether a string table makes it smaller
+bool resolveDocument( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion,
+                      WbXMLStringTable* aStringTable, bool& aUseStringTable, int& aSize )
+{
+    WbXMLWriter counter( NULL );
+
+    if( !writeDocument( aRootObject, aVersion, NULL, counter ) ) {
+        return false;
+    }
+
+    aSize = counter.size();
+    aUseStringTable = false;
+
+    if( aStringTable ) {
+
+        aStringTable->addObject( aRootObject );
+        aStringTable->build();
+
+        if( !aStringTable->data().isEmpty() ) {
+
+            WbXMLWriter tableCounter( NULL );
+
+            if( writeDocument( aRootObject, aVersion, aStringTable, tableCounter ) &&
+                tableCounter.size() < aSize ) {
+                aSize = tableCounter.size();
+                aUseStringTable = true;
+            }
+        }
+
+        qCDebug(lcSyncML) << "WbXML string table" << ( aUseStringTable ? "used," : "not used," )
+                          << "size without table" << counter.size() << "bytes";
+    }
+
+    return true;
+}
+
+}
+
+WbXMLEncoder::WbXMLEncoder()
+ : iUseStringTable( false )
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+WbXMLEncoder::~WbXMLEncoder()
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+}
+
+bool WbXMLEncoder::encodeToWbXML( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion,
+                                  QByteArray& aWbXMLDocument ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    WbXMLStringTable stringTable;
+    bool useStringTable = false;
+    int size = 0;
+
+    if( !resolveDocument( aRootObject, aVersion, iUseStringTable ? &stringTable : NULL,
+                          useStringTable, size ) ) {
+        return false;
+    }
+
+    aWbXMLDocument.reserve( aWbXMLDocument.size() + size );
+
+    WbXMLWriter writer( &aWbXMLDocument );
+
+    if( !writeDocument( aRootObject, aVersion, useStringTable ? &stringTable : NULL, writer ) ) {
+        return false;
+    }
+
+    Q_ASSERT( writer.size() == size );
+
+    return true;
+}
+
+int WbXMLEncoder::encodedSize( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion ) const
+{
+    FUNCTION_CALL_TRACE(lcSyncMLTrace);
+
+    WbXMLStringTable stringTable;
+    bool useStringTable = false;
+    int size = 0;
+
+    if( !resolveDocument( aRootObject, aVersion, iUseStringTable ? &stringTable : NULL,
+                          useStringTable, size ) ) {
+        return -1;
+    }
+
+    return size;
+}
+
+int WbXMLEncoder::encodedElementSize( const SyncMLCmdObject& aObject, ProtocolVersion aVersion ) const
+{
+    WbXMLWriter counter( NULL );
+    int page = WBXML_PAGE_SYNCML;
+
+    if( !writeElement( aObject, LANGUAGE_SYNCML, aVersion, NULL, page, counter ) ) {
+        return -1;
+    }
+
+    return counter.size();
+}
+
+bool WbXMLEncoder::encodeElement( const SyncMLCmdObject& aObject, ProtocolVersion aVersion,
+                                  QByteArray& aData ) const
+{
+    WbXMLWriter writer( &aData );
+    int page = WBXML_PAGE_SYNCML;
+
+    return writeElement( aObject, LANGUAGE_SYNCML, aVersion, NULL, page, writer );
+}
+
+void WbXMLEncoder::setUseStringTable( bool aUse )
+{
+    iUseStringTable = aUse;
+}
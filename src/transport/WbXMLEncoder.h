@@ -0,0 +1,133 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef WBXMLENCODER_H
+#define WBXMLENCODER_H
+
+#include <QByteArray>
+
+#include "SyncAgentConsts.h"
+
+namespace DataSync {
+
+class SyncMLCmdObject;
+
+/*! \brief Native WbXML encoder for SyncML messages
+ *
+ * Writes WbXML straight from a tree of SyncMLCmdObjects without building an
+ * intermediate libwbxml2 tree. The size of the document is resolved first,
+ * so that the output buffer is allocated only once. Elements that have no
+ * token in the SyncML, MetInf or DevInf code pages cannot be encoded, in
+ * which case LibWbXML2Encoder should be used instead.
+ */
+class WbXMLEncoder
+{
+
+public:
+
+    /*! \brief Constructor
+     *
+     */
+    WbXMLEncoder();
+
+    /*! \brief Destructor
+     *
+     */
+    ~WbXMLEncoder();
+
+    /*! \brief Encode a SyncML message to WbXML document
+     *
+     * @param aRootObject Root object of the document
+     * @param aVersion SyncML version
+     * @param aWbXMLDocument Output WbXML document. Encoded document is appended
+     * @return True on success, otherwise false
+     */
+    bool encodeToWbXML( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion,
+                        QByteArray& aWbXMLDocument ) const;
+
+    /*! \brief Returns the exact size of the WbXML document encodeToWbXML() would produce
+     *
+     * @param aRootObject Root object of the document
+     * @param aVersion SyncML version
+     * @return Size in bytes, or -1 if the message cannot be encoded
+     */
+    int encodedSize( const SyncMLCmdObject& aRootObject, ProtocolVersion aVersion ) const;
+
+    /*! \brief Returns the exact number of bytes an element of a SyncML message
+     *         takes when encoded
+     *
+     * Size is that of the element and its children inside a SyncML message
+     * body, without a string table. As an element always ends in the code
+     * page it started in, the size of a message is the size of its elements
+     * added up, which allows filling a message command by command.
+     *
+     * @param aObject Element, usually a SyncML command
+     * @param aVersion SyncML version
+     * @return Size in bytes, or -1 if the element cannot be encoded
+     */
+    int encodedElementSize( const SyncMLCmdObject& aObject, ProtocolVersion aVersion ) const;
+
+    /*! \brief Encode an element as it is written inside a SyncML message body
+     *
+     * Encoding is that of encodedElementSize(). Elements that keep a WbXML
+     * encoding (see SyncMLCmdObject::setEncoding()) are written as such when
+     * a document is encoded without a string table.
+     *
+     * @param aObject Element, usually a SyncML command
+     * @param aVersion SyncML version
+     * @param aData Output data. Encoded element is appended
+     * @return True on success, otherwise false
+     */
+    bool encodeElement( const SyncMLCmdObject& aObject, ProtocolVersion aVersion,
+                        QByteArray& aData ) const;
+
+    /*! \brief Set whether to use a string table
+     *
+     * When enabled, strings that repeat in the document are placed in a
+     * string table, if that makes the document smaller. Disabled by default.
+     *
+     * @param aUse True to use string table when it pays off, otherwise false
+     */
+    void setUseStringTable( bool aUse );
+
+protected:
+
+private:
+
+    bool iUseStringTable;
+
+};
+
+}
+
+#endif  //  WBXMLENCODER_H
@@ -1,8 +1,11 @@
 SOURCES += BaseTransport.cpp \
 	HTTPTransport.cpp \
+    HTTPContentCoding.cpp \
     OBEXDataHandler.cpp \
     LibWbXML2Encoder.cpp \
+    WbXMLEncoder.cpp \
     QtEncoder.cpp \
+    MessageSizer.cpp \
     OBEXTransport.cpp \
     OBEXWorker.cpp \
     OBEXClientWorker.cpp \
@@ -11,10 +14,13 @@ SOURCES += BaseTransport.cpp \
 HEADERS += Transport.h \
 	BaseTransport.h \
 	HTTPTransport.h \
+    HTTPContentCoding.h \
 	OBEXConnection.h \
     OBEXDataHandler.h \
     LibWbXML2Encoder.h \
+    WbXMLEncoder.h \
     QtEncoder.h \
+    MessageSizer.h \
     OBEXTransport.h \
     OBEXWorker.h \
     OBEXClientWorker.h \
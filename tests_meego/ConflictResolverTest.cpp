@@ -34,8 +34,157 @@
 
 #include "ConflictResolverTest.h"
 
+#include "ConflictResolver.h"
+#include "LocalChanges.h"
 
 using namespace DataSync;
 
+void ConflictResolverTest::testLocalChangeList()
+{
+    LocalChangeList list;
+    QVERIFY( list.isEmpty() );
+
+    for( int i = 0; i < 10; ++i ) {
+        list.append( QString::number( i ) );
+    }
+    QCOMPARE( list.count(), 10 );
+    QVERIFY( list.contains( "5" ) );
+    QVERIFY( !list.contains( "10" ) );
+
+    // Removal from the middle keeps the order of the remaining items
+    QVERIFY( list.removeOne( "5" ) );
+    QVERIFY( !list.removeOne( "5" ) );
+    QVERIFY( !list.contains( "5" ) );
+    QCOMPARE( list.size(), 9 );
+
+    QVERIFY( list.removeOne( "0" ) );
+    QCOMPARE( list.first(), QString( "1" ) );
+    list.removeFirst();
+    QCOMPARE( list.first(), QString( "2" ) );
+
+    QList<SyncItemKey> expected;
+    expected << "2" << "3" << "4" << "6" << "7" << "8" << "9";
+    QCOMPARE( list.toList(), expected );
+    QCOMPARE( list.toList( 3 ), expected.mid( 0, 3 ) );
+
+    // Removing most items compacts the list, which must not affect lookups
+    QVERIFY( list.removeOne( "3" ) );
+    QVERIFY( list.removeOne( "6" ) );
+    QVERIFY( list.removeOne( "7" ) );
+    QVERIFY( list.removeOne( "9" ) );
+    expected.clear();
+    expected << "2" << "4" << "8";
+    QCOMPARE( list.toList(), expected );
+    QVERIFY( list.contains( "8" ) );
+    QVERIFY( !list.contains( "9" ) );
+
+    list.append( "9" );
+    QVERIFY( list.removeOne( "4" ) );
+    expected.clear();
+    expected << "2" << "8" << "9";
+    QCOMPARE( list.toList(), expected );
+
+    // Duplicates are removed one at a time, earliest first
+    list.append( "2" );
+    QVERIFY( list.removeOne( "2" ) );
+    QVERIFY( list.contains( "2" ) );
+    QCOMPARE( list.first(), QString( "8" ) );
+    expected.clear();
+    expected << "8" << "9" << "2";
+    QCOMPARE( list.toList(), expected );
+
+    while( !list.isEmpty() ) {
+        list.removeFirst();
+    }
+    QCOMPARE( list.count(), 0 );
+    QVERIFY( !list.contains( "2" ) );
+
+    list = expected;
+    QCOMPARE( list.toList(), expected );
+    list.clear();
+    QVERIFY( list.isEmpty() );
+}
+
+void ConflictResolverTest::testConflicts()
+{
+    LocalChanges changes;
+    changes.added.append( "added" );
+    changes.modified.append( "modified" );
+    changes.removed.append( "removed" );
+
+    ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
+
+    QVERIFY( resolver.localSideWins() );
+    QVERIFY( !resolver.isConflict( "", false ) );
+    QVERIFY( !resolver.isConflict( "added", false ) );
+    QVERIFY( !resolver.isConflict( "unchanged", false ) );
+    QVERIFY( resolver.isConflict( "modified", false ) );
+    QVERIFY( resolver.isConflict( "modified", true ) );
+    QVERIFY( resolver.isConflict( "removed", false ) );
+    QVERIFY( !resolver.isConflict( "removed", true ) );
+}
+
+void ConflictResolverTest::testRevertLocalChange()
+{
+    LocalChanges changes;
+    changes.modified.append( "modified1" );
+    changes.modified.append( "modified2" );
+    changes.modified.append( "modified3" );
+    changes.removed.append( "removed" );
+
+    ConflictResolver resolver( changes, PREFER_REMOTE_CHANGES );
+    QVERIFY( !resolver.localSideWins() );
+
+    resolver.revertLocalChange( "removed", CR_REMOVE_LOCAL );
+    QVERIFY( changes.removed.isEmpty() );
+    QVERIFY( !resolver.isConflict( "removed", false ) );
+
+    resolver.revertLocalChange( "modified2", CR_REMOVE_LOCAL );
+    QCOMPARE( changes.modified.count(), 2 );
+    QVERIFY( !resolver.isConflict( "modified2", false ) );
+
+    resolver.revertLocalChange( "modified3", CR_MODIFY_TO_ADD );
+    QCOMPARE( changes.modified.toList(), QList<SyncItemKey>() << "modified1" );
+    QCOMPARE( changes.added.toList(), QList<SyncItemKey>() << "modified3" );
+    QVERIFY( !resolver.isConflict( "modified3", false ) );
+
+    // Reverting a change that is not there is a no-op
+    resolver.revertLocalChange( "modified3", CR_MODIFY_TO_ADD );
+    QCOMPARE( changes.added.count(), 1 );
+}
+
+void ConflictResolverTest::benchmarkConflictCheck_data()
+{
+    QTest::addColumn<int>( "changes" );
+
+    QTest::newRow( "1k" ) << 1000;
+    QTest::newRow( "5k" ) << 5000;
+    QTest::newRow( "50k" ) << 50000;
+}
+
+void ConflictResolverTest::benchmarkConflictCheck()
+{
+    QFETCH( int, changes );
+
+    // Two-way sync where every remote modification hits a local one, and
+    // the conflicting local change is dropped as remote side wins
+    QBENCHMARK {
+        LocalChanges localChanges;
+        for( int i = 0; i < changes; ++i ) {
+            localChanges.modified.append( QString::number( i ) );
+        }
+
+        ConflictResolver resolver( localChanges, PREFER_REMOTE_CHANGES );
+        for( int i = changes - 1; i >= 0; --i ) {
+            SyncItemKey key = QString::number( i );
+            if( resolver.isConflict( key, false ) ) {
+                resolver.revertLocalChange( key, CR_REMOVE_LOCAL );
+            }
+        }
+
+        QVERIFY( localChanges.modified.isEmpty() );
+    }
+}
+
 
 QTEST_MAIN(DataSync::ConflictResolverTest)
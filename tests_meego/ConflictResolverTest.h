@@ -44,6 +44,11 @@ class ConflictResolverTest: public QObject
     Q_OBJECT;
 private slots:
 
+    void testLocalChangeList();
+    void testConflicts();
+    void testRevertLocalChange();
+    void benchmarkConflictCheck_data();
+    void benchmarkConflictCheck();
 
 private:
 
@@ -201,5 +201,87 @@ void DevInfHandlerTest::testHandleResults()
     QCOMPARE( response, SUCCESS );
 }
 
+void DevInfHandlerTest::testCachedRemoteDevInf()
+{
+    DeviceInfo deviceInfo;
+    DevInfHandler handler( deviceInfo );
+
+    RemoteDeviceInfo cached;
+    cached.deviceInfo().setManufacturer( "CachedManufacturer" );
+    const QByteArray hash( "0123456789abcdef" );
+
+    handler.setCachedRemoteDeviceInfo( cached, hash );
+    QCOMPARE( handler.getRemoteDevInfHash(), hash );
+
+    ProtocolVersion version = SYNCML_1_2;
+
+    // Parser skipped DevInf that matches the cached one
+    PutParams put;
+    put.devInf.source = SYNCML_DEVINF_PATH_12;
+    put.devInf.hash = hash;
+    put.devInf.cached = true;
+    QCOMPARE( handler.handlePut( put, version ), SUCCESS );
+    QVERIFY( !handler.remoteDevInfUpdated() );
+    QCOMPARE( handler.getRemoteDeviceInfo().deviceInfo().getManufacturer(),
+              QString( "CachedManufacturer" ) );
+
+    // Remote device sent a different DevInf
+    PutParams changed;
+    changed.devInf.source = SYNCML_DEVINF_PATH_12;
+    changed.devInf.hash = "fedcba9876543210";
+    changed.devInf.devInfo.deviceInfo().setManufacturer( "NewManufacturer" );
+    QCOMPARE( handler.handlePut( changed, version ), SUCCESS );
+    QVERIFY( handler.remoteDevInfUpdated() );
+    QCOMPARE( handler.getRemoteDevInfHash(), changed.devInf.hash );
+    QCOMPARE( handler.getRemoteDeviceInfo().deviceInfo().getManufacturer(),
+              QString( "NewManufacturer" ) );
+}
+
+void DevInfHandlerTest::testStaleRemoteDevInf()
+{
+    DeviceInfo deviceInfo;
+    DevInfHandler handler( deviceInfo );
+
+    QList<StoragePlugin*>storages;
+    ProtocolVersion version = SYNCML_1_2;
+    Role role = ROLE_CLIENT;
+
+    RemoteDeviceInfo cached;
+    const QByteArray hash( "0123456789abcdef" );
+    handler.setCachedRemoteDeviceInfo( cached, hash );
+
+    // Cached device info is not requested
+    ResponseGenerator generator;
+    handler.composeLocalInitiatedDevInfExchange( storages, version, role, generator );
+    QCOMPARE( handler.iRemoteDevInfRequested, false );
+    handler.composeRemoteDevInfRequest( version, role, generator );
+    QCOMPARE( generator.getPackages().count(), 1 );
+
+    // Stale device info is requested once
+    handler.setRemoteDevInfStale();
+    handler.composeRemoteDevInfRequest( version, role, generator );
+    QCOMPARE( handler.iRemoteDevInfRequested, true );
+    QCOMPARE( generator.getPackages().count(), 2 );
+    handler.composeRemoteDevInfRequest( version, role, generator );
+    QCOMPARE( generator.getPackages().count(), 2 );
+
+    // Unchanged device info is stored again to renew its age
+    PutParams put;
+    put.devInf.source = SYNCML_DEVINF_PATH_12;
+    put.devInf.hash = hash;
+    put.devInf.cached = true;
+    QCOMPARE( handler.handlePut( put, version ), SUCCESS );
+    QVERIFY( handler.remoteDevInfUpdated() );
+    QCOMPARE( handler.iRemoteDevInfStale, false );
+
+    // Rejected device info is forgotten and requested again
+    handler.reset();
+    handler.clearCachedRemoteDeviceInfo();
+    QVERIFY( handler.getRemoteDevInfHash().isEmpty() );
+    ResponseGenerator generator2;
+    handler.composeLocalInitiatedDevInfExchange( storages, version, role, generator2 );
+    QCOMPARE( handler.iRemoteDevInfRequested, true );
+}
+
 QTEST_MAIN(DevInfHandlerTest)
 
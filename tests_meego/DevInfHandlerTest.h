@@ -50,6 +50,8 @@ private slots:
 
     void testHandlePut();
     void testHandleResults();
+    void testCachedRemoteDevInf();
+    void testStaleRemoteDevInf();
 
 };
 
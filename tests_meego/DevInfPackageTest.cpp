@@ -49,7 +49,9 @@ void DevInfPackageTest::testPutGet()
     storage_plugins.append(&storage);
     const int SIZE_TRESHOLD = 10000;
 
-    DevInfPackage pkg(storage_plugins, devInfo, SYNCML_1_2, ROLE_CLIENT );
+    bool retrieveRemoteDevInf = true;
+
+    DevInfPackage pkg(storage_plugins, devInfo, SYNCML_1_2, ROLE_CLIENT, retrieveRemoteDevInf );
 
     SyncMLMessage msg(HeaderParams(), SYNCML_1_2);
     int remaining = SIZE_TRESHOLD;
@@ -72,6 +74,64 @@ void DevInfPackageTest::testPutGet()
 
 }
 
+void DevInfPackageTest::testPut()
+{
+
+    QList<StoragePlugin*> storage_plugins;
+    DeviceInfo devInfo;
+    MockStorage storage("storage");
+    storage_plugins.append(&storage);
+    const int SIZE_TRESHOLD = 10000;
+    bool retrieveRemoteDevInf = false;
+
+    DevInfPackage pkg(storage_plugins, devInfo, SYNCML_1_2, ROLE_CLIENT, retrieveRemoteDevInf );
+
+    SyncMLMessage msg(HeaderParams(), SYNCML_1_2);
+    int remaining = SIZE_TRESHOLD;
+    QCOMPARE(pkg.write(msg, remaining, false, SYNCML_1_2), true);
+    QVERIFY(remaining < SIZE_TRESHOLD);
+
+    QtEncoder encoder;
+    QByteArray result_xml;
+    QVERIFY( encoder.encodeToXML( msg, result_xml, true ) );
+
+    QByteArray putData = extractElement( result_xml, "<Put>", "</Put>" );
+    QVERIFY( !putData.isEmpty() );
+
+    verifyDevInf(putData);
+
+    QByteArray getData = extractElement( result_xml, "<Get>", "</Get>" );
+    QVERIFY( getData.isEmpty() );
+
+}
+
+void DevInfPackageTest::testGet()
+{
+
+    DeviceInfo devInfo;
+    const int SIZE_TRESHOLD = 10000;
+
+    DevInfPackage pkg(devInfo, SYNCML_1_2, ROLE_SERVER);
+
+    SyncMLMessage msg(HeaderParams(), SYNCML_1_2);
+    int remaining = SIZE_TRESHOLD;
+    QCOMPARE(pkg.write(msg, remaining, false, SYNCML_1_2), true);
+    QVERIFY(remaining < SIZE_TRESHOLD);
+
+    QtEncoder encoder;
+    QByteArray result_xml;
+    QVERIFY( encoder.encodeToXML( msg, result_xml, true ) );
+
+    QByteArray putData = extractElement( result_xml, "<Put>", "</Put>" );
+    QVERIFY( putData.isEmpty() );
+
+    QByteArray getData = extractElement( result_xml, "<Get>", "</Get>" );
+    QVERIFY( !getData.isEmpty() );
+
+    verifyGet(getData);
+
+}
+
 void DevInfPackageTest::testResults()
 {
 
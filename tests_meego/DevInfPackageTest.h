@@ -42,6 +42,8 @@ class DevInfPackageTest : public QObject
 
 private slots:
     void testPutGet();
+    void testPut();
+    void testGet();
     void testResults();
     void testResultsGet();
 
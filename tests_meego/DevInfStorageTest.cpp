@@ -0,0 +1,193 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "DevInfStorageTest.h"
+
+#include "DatabaseHandler.h"
+#include "DevInfStorage.h"
+#include "RemoteDeviceInfo.h"
+
+
+const QString DB( QProcessEnvironment::systemEnvironment().value("TMPDIR", "/tmp") + "/devinfstoragetest.db" );
+const QString REMOTEDEVICE( "remoteDevice" );
+const QString OTHERDEVICE( "otherDevice" );
+
+using namespace DataSync;
+
+static ContentFormat contentFormat( const QString& aType, const QString& aVersion )
+{
+    ContentFormat format;
+    format.iType = aType;
+    format.iVersion = aVersion;
+    return format;
+}
+
+static RemoteDeviceInfo remoteDevInf()
+{
+    RemoteDeviceInfo devInf;
+    devInf.deviceInfo().setManufacturer( "FooManufacturer" );
+    devInf.deviceInfo().setModel( "FooModel" );
+    devInf.deviceInfo().setDeviceID( "IMEI:356064034969473" );
+    devInf.setSupportsLargeObjs( true );
+    devInf.setSupportsNumberOfChanges( true );
+
+    Datastore datastore;
+    datastore.setSourceURI( "./Contacts" );
+    datastore.formatInfo().setPreferredRx( contentFormat( "text/x-vcard", "2.1" ) );
+    datastore.formatInfo().setPreferredTx( contentFormat( "text/x-vcard", "2.1" ) );
+    datastore.formatInfo().rx().append( contentFormat( "text/vcard", "3.0" ) );
+    datastore.syncCaps().append( SYNCTYPE_TWOWAY );
+    datastore.syncCaps().append( SYNCTYPE_TWOWAYSLOW );
+
+    CTCap ctCap;
+    ctCap.setFormat( contentFormat( "text/x-vcard", "2.1" ) );
+    CTCapProperty property;
+    property.iName = "TEL";
+    property.iMaxOccur = 5;
+    property.iValues << "CELL" << "HOME";
+    CTCapParameter parameter;
+    parameter.iName = "TYPE";
+    parameter.iValues << "VOICE";
+    property.iParameters.append( parameter );
+    ctCap.properties().append( property );
+    datastore.ctCaps().append( ctCap );
+
+    devInf.datastores().append( datastore );
+
+    Datastore notes;
+    notes.setSourceURI( "./Notes" );
+    notes.addCTCapData( "<CTCap><CTType>text/plain</CTType><VerCT>1.0</VerCT></CTCap>" );
+    devInf.datastores().append( notes );
+
+    return devInf;
+}
+
+void DevInfStorageTest::testSetGetDevInf()
+{
+    DatabaseHandler handler( DB );
+    DevInfStorage storage( handler.getDbHandle(), REMOTEDEVICE );
+    storage.clearDevInf();
+
+    RemoteDeviceInfo devInf;
+    QByteArray hash;
+    QDateTime updated;
+    QVERIFY( !storage.devInf( devInf, hash, updated ) );
+
+    QDateTime before = QDateTime::fromTime_t( QDateTime::currentDateTime().toTime_t() );
+    storage.setDevInf( remoteDevInf(), "0123456789abcdef" );
+    QVERIFY( storage.devInf( devInf, hash, updated ) );
+    QCOMPARE( hash, QByteArray( "0123456789abcdef" ) );
+    QVERIFY( updated >= before );
+    QVERIFY( updated <= QDateTime::currentDateTime() );
+
+    QCOMPARE( devInf.deviceInfo().getManufacturer(), QString( "FooManufacturer" ) );
+    QCOMPARE( devInf.deviceInfo().getModel(), QString( "FooModel" ) );
+    QCOMPARE( devInf.deviceInfo().getDeviceID(), QString( "IMEI:356064034969473" ) );
+    QVERIFY( !devInf.getSupportsUTC() );
+    QVERIFY( devInf.getSupportsLargeObjs() );
+    QVERIFY( devInf.getSupportsNumberOfChanges() );
+
+    QCOMPARE( devInf.datastores().count(), 2 );
+    const Datastore& datastore = devInf.datastores().at( 0 );
+    QCOMPARE( datastore.getSourceURI(), QString( "./Contacts" ) );
+    QCOMPARE( datastore.formatInfo().getPreferredRx().iType, QString( "text/x-vcard" ) );
+    QCOMPARE( datastore.formatInfo().getPreferredTx().iVersion, QString( "2.1" ) );
+    QCOMPARE( datastore.formatInfo().rx().count(), 1 );
+    QCOMPARE( datastore.formatInfo().rx().at( 0 ).iType, QString( "text/vcard" ) );
+    QCOMPARE( datastore.formatInfo().tx().count(), 0 );
+    QCOMPARE( datastore.syncCaps().count(), 2 );
+    QVERIFY( datastore.syncCaps().contains( SYNCTYPE_TWOWAYSLOW ) );
+
+    QCOMPARE( datastore.ctCaps().count(), 1 );
+    const CTCap& ctCap = datastore.ctCaps().at( 0 );
+    QCOMPARE( ctCap.getFormat().iType, QString( "text/x-vcard" ) );
+    QCOMPARE( ctCap.properties().count(), 1 );
+    const CTCapProperty& property = ctCap.properties().at( 0 );
+    QCOMPARE( property.iName, QString( "TEL" ) );
+    QCOMPARE( property.iMaxOccur, 5 );
+    QCOMPARE( property.iSize, -1 );
+    QCOMPARE( property.iValues.count(), 2 );
+    QCOMPARE( property.iParameters.count(), 1 );
+    QCOMPARE( property.iParameters.at( 0 ).iName, QString( "TYPE" ) );
+    QCOMPARE( property.iParameters.at( 0 ).iValues.at( 0 ), QString( "VOICE" ) );
+
+    // CT caps that were not decoded are stored as such
+    const Datastore& notes = devInf.datastores().at( 1 );
+    QCOMPARE( notes.ctCapData().count(), 1 );
+    QCOMPARE( notes.ctCaps().count(), 1 );
+    QCOMPARE( notes.ctCaps().at( 0 ).getFormat().iType, QString( "text/plain" ) );
+
+    // Device info is stored per remote device
+    DevInfStorage other( handler.getDbHandle(), OTHERDEVICE );
+    other.clearDevInf();
+    RemoteDeviceInfo otherDevInf;
+    QVERIFY( !other.devInf( otherDevInf, hash, updated ) );
+}
+
+void DevInfStorageTest::testReplaceDevInf()
+{
+    DatabaseHandler handler( DB );
+    DevInfStorage storage( handler.getDbHandle(), REMOTEDEVICE );
+
+    storage.setDevInf( remoteDevInf(), "0123456789abcdef" );
+
+    RemoteDeviceInfo changed;
+    changed.deviceInfo().setManufacturer( "BarManufacturer" );
+    storage.setDevInf( changed, "fedcba9876543210" );
+
+    RemoteDeviceInfo devInf;
+    QByteArray hash;
+    QDateTime updated;
+    QVERIFY( storage.devInf( devInf, hash, updated ) );
+    QCOMPARE( hash, QByteArray( "fedcba9876543210" ) );
+    QCOMPARE( devInf.deviceInfo().getManufacturer(), QString( "BarManufacturer" ) );
+    QCOMPARE( devInf.datastores().count(), 0 );
+}
+
+void DevInfStorageTest::testClearDevInf()
+{
+    DatabaseHandler handler( DB );
+    DevInfStorage storage( handler.getDbHandle(), REMOTEDEVICE );
+
+    storage.setDevInf( remoteDevInf(), "0123456789abcdef" );
+    storage.clearDevInf();
+
+    RemoteDeviceInfo devInf;
+    QByteArray hash;
+    QDateTime updated;
+    QVERIFY( !storage.devInf( devInf, hash, updated ) );
+    QVERIFY( hash.isEmpty() );
+}
+
+QTEST_MAIN(DataSync::DevInfStorageTest)
@@ -0,0 +1,163 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may
+* be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include "ItemReferenceIndexTest.h"
+
+#include "ItemReferenceIndex.h"
+
+using namespace DataSync;
+
+static ItemReference reference( int aMsgId, int aCmdId, int aItemIndex, const SyncItemKey& aKey )
+{
+    ItemReference item;
+    item.iMsgId = aMsgId;
+    item.iCmdId = aCmdId;
+    item.iItemIndex = aItemIndex;
+    item.iKey = aKey;
+    item.iModificationType = MOD_ITEM_ADDED;
+    item.iLocalDatabase = "localdb";
+    item.iRemoteDatabase = "remotedb";
+    item.iMimeType = "text/x-vcard";
+    return item;
+}
+
+void ItemReferenceIndexTest::testTake()
+{
+    ItemReferenceIndex index;
+    index.insert( reference( 1, 3, 0, "key1" ) );
+    index.insert( reference( 1, 4, 0, "key2" ) );
+    index.insert( reference( 2, 3, 0, "key1" ) );
+    QCOMPARE( index.count(), 3 );
+
+    ItemReference taken;
+    QVERIFY( !index.take( 1, 3, "key2", taken ) );
+    QVERIFY( !index.take( 3, 3, "key1", taken ) );
+
+    QVERIFY( index.take( 2, 3, "key1", taken ) );
+    QCOMPARE( taken.iMsgId, 2 );
+    QCOMPARE( taken.iCmdId, 3 );
+    QCOMPARE( taken.iKey, QString( "key1" ) );
+    QCOMPARE( taken.iLocalDatabase, QString( "localdb" ) );
+    QVERIFY( !index.take( 2, 3, "key1", taken ) );
+    QCOMPARE( index.count(), 2 );
+
+    // Referring to the same item again within a command replaces the reference
+    index.insert( reference( 1, 3, 1, "key1" ) );
+    QCOMPARE( index.count(), 2 );
+    QVERIFY( index.take( 1, 3, "key1", taken ) );
+    QCOMPARE( taken.iItemIndex, 1 );
+
+    index.clear();
+    QCOMPARE( index.count(), 0 );
+    QVERIFY( !index.take( 1, 4, "key2", taken ) );
+}
+
+void ItemReferenceIndexTest::testTakeCommand()
+{
+    ItemReferenceIndex index;
+    for( int i = 0; i < 5; ++i ) {
+        index.insert( reference( 1, 5, i, "key" + QString::number( i ) ) );
+    }
+    index.insert( reference( 1, 6, 0, "key5" ) );
+
+    ItemReference taken;
+    QVERIFY( index.take( 1, 5, "key2", taken ) );
+
+    QList<ItemReference> references = index.takeCommand( 1, 5 );
+    QCOMPARE( references.count(), 4 );
+    QCOMPARE( references[0].iKey, QString( "key0" ) );
+    QCOMPARE( references[1].iKey, QString( "key1" ) );
+    QCOMPARE( references[2].iKey, QString( "key3" ) );
+    QCOMPARE( references[3].iKey, QString( "key4" ) );
+    QCOMPARE( index.count(), 1 );
+
+    QVERIFY( index.takeCommand( 1, 5 ).isEmpty() );
+    QCOMPARE( index.takeCommand( 1, 6 ).count(), 1 );
+    QCOMPARE( index.count(), 0 );
+}
+
+void ItemReferenceIndexTest::testMessageCounts()
+{
+    ItemReferenceIndex index;
+    index.insert( reference( 1, 3, 0, "key1" ) );
+    index.insert( reference( 1, 3, 1, "key2" ) );
+    index.insert( reference( 1, 4, 0, "key3" ) );
+    index.insert( reference( 2, 3, 0, "key4" ) );
+
+    QCOMPARE( index.count( 1 ), 3 );
+    QCOMPARE( index.count( 2 ), 1 );
+    QCOMPARE( index.count( 3 ), 0 );
+
+    ItemReference taken;
+    QVERIFY( index.take( 1, 4, "key3", taken ) );
+    QCOMPARE( index.count( 1 ), 2 );
+
+    index.takeCommand( 1, 3 );
+    QCOMPARE( index.count( 1 ), 0 );
+    QCOMPARE( index.count( 2 ), 1 );
+    QCOMPARE( index.count(), 1 );
+}
+
+void ItemReferenceIndexTest::benchmarkStatusMatching_data()
+{
+    QTest::addColumn<int>( "items" );
+
+    QTest::newRow( "1k" ) << 1000;
+    QTest::newRow( "10k" ) << 10000;
+    QTest::newRow( "100k" ) << 100000;
+}
+
+void ItemReferenceIndexTest::benchmarkStatusMatching()
+{
+    QFETCH( int, items );
+
+    const int itemsPerMessage = 100;
+
+    // Large upload where every item is acknowledged with a status of its own
+    QBENCHMARK {
+        ItemReferenceIndex index;
+        for( int i = 0; i < items; ++i ) {
+            index.insert( reference( i / itemsPerMessage + 1, i % itemsPerMessage + 3, 0,
+                                     QString::number( i ) ) );
+        }
+
+        ItemReference taken;
+        for( int i = items - 1; i >= 0; --i ) {
+            index.take( i / itemsPerMessage + 1, i % itemsPerMessage + 3, QString::number( i ), taken );
+        }
+
+        QCOMPARE( index.count(), 0 );
+    }
+}
+
+QTEST_MAIN(DataSync::ItemReferenceIndexTest)
@@ -0,0 +1 @@
+include(testapplication.pri)
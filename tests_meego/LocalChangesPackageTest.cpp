@@ -38,6 +38,7 @@
 #include "LocalChangesPackage.h"
 #include "SyncMLMessage.h"
 #include "QtEncoder.h"
+#include "MessageSizer.h"
 #include "Mock.h"
 #include "Fragments.h"
 
@@ -383,4 +384,390 @@ void LocalChangesPackageTest::testLargeObjects()
     QVERIFY( !result_xml2.contains( "MoreData" ) );
 
 }
+void LocalChangesPackageTest::testExactPacking()
+{
+    // Test that with exact packing the exact encoded size of written commands
+    // is accounted for, and that a command that does not fit is rolled back
+    // to the next message
+
+    const int msgSize = 65535;
+    const int budget = 1000;
+    const int itemCount = 10;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+
+    for( int i = 0; i < itemCount; ++i )
+    {
+        const QString itemId = QString( "addedItem%1" ).arg( i );
+        QByteArray itemData;
+        itemData.fill( 'a' + i, 200 );
+        MockSyncItem* item = new MockSyncItem( itemId );
+        item->setType( "text/foo" );
+        item->write( 0, itemData );
+        items.append( item );
+        changes.added.append( itemId );
+    }
+
+    storage.setItems( items );
+
+    SyncMode syncMode;
+    SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+
+    LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    QVERIFY( package.setExactPacking( true ) );
+
+    MessageSizer sizer( false, SYNCML_1_2 );
+    QtEncoder encoder;
+
+    SyncMLMessage msg1( HeaderParams(), SYNCML_1_2 );
+    int emptySize = sizer.messageSize( msg1 );
+
+    int remaining = budget;
+    QVERIFY( !package.write( msg1, remaining, false, SYNCML_1_2 ) );
+    QVERIFY( remaining >= 0 );
+
+    QByteArray result_xml1;
+    QVERIFY( encoder.encodeToXML( msg1, result_xml1, false ) );
+    QCOMPARE( result_xml1.size(), emptySize + budget - remaining );
+    QCOMPARE( sizer.messageSize( msg1 ), result_xml1.size() );
+
+    // Add that did not fit must not leave a gap in command ids
+    int written = result_xml1.count( "<Add>" );
+    QVERIFY( written > 0 && written < itemCount );
+    QCOMPARE( msg1.getNextCmdId(), written + 2 );
+
+    remaining = msgSize;
+    SyncMLMessage msg2( HeaderParams(), SYNCML_1_2 );
+    QVERIFY( package.write( msg2, remaining, false, SYNCML_1_2 ) );
+
+    QByteArray result_xml2;
+    QVERIFY( encoder.encodeToXML( msg2, result_xml2, false ) );
+    QCOMPARE( result_xml2.count( "<Add>" ), itemCount - written );
+
+    // Every item is written exactly once
+    for( int i = 0; i < itemCount; ++i )
+    {
+        QByteArray itemData;
+        itemData.fill( 'a' + i, 200 );
+        QCOMPARE( result_xml1.count( itemData ) + result_xml2.count( itemData ), 1 );
+    }
+
+}
+
+void LocalChangesPackageTest::testExactPackingLargeObjects()
+{
+    // Test that chunks of a large object are sized to fill the message
+    // exactly
+
+    const int budget = 1024;
+    const int objSize = 3000;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+
+    const QString addedItemId( "addedItem" );
+    QByteArray addedItemData;
+    for( int i = 0; i < objSize; ++i )
+    {
+        addedItemData.append( 'a' + i % 26 );
+    }
+    MockSyncItem* addedItem = new MockSyncItem( addedItemId );
+    addedItem->setType( "text/foo" );
+    addedItem->write( 0, addedItemData );
+    items.append( addedItem );
+    changes.added.append( addedItemId );
+
+    storage.setItems( items );
+
+    SyncMode syncMode;
+    SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+
+    LocalChangesPackage package( target, changes, budget / 2, ROLE_CLIENT, maxChanges );
+    QVERIFY( package.setExactPacking( true ) );
+
+    MessageSizer sizer( false, SYNCML_1_2 );
+    QtEncoder encoder;
+
+    QByteArray data;
+    bool allWritten = false;
+
+    for( int messages = 0; !allWritten && messages < 10; ++messages )
+    {
+        SyncMLMessage msg( HeaderParams(), SYNCML_1_2 );
+        int emptySize = sizer.messageSize( msg );
+
+        int remaining = budget;
+        allWritten = package.write( msg, remaining, false, SYNCML_1_2 );
+
+        QByteArray result_xml;
+        QVERIFY( encoder.encodeToXML( msg, result_xml, false ) );
+        QCOMPARE( result_xml.size(), emptySize + budget - remaining );
+        QVERIFY( remaining >= 0 );
+
+        if( !allWritten )
+        {
+            // Chunk fills the message up to the byte
+            QVERIFY( result_xml.contains( "MoreData" ) );
+            QCOMPARE( remaining, 0 );
+        }
+
+        const QByteArray cdataStart( "<![CDATA[" );
+        int start = result_xml.indexOf( cdataStart ) + cdataStart.size();
+        int end = result_xml.indexOf( "]]>", start );
+        QVERIFY( start >= cdataStart.size() && end > start );
+        data.append( result_xml.mid( start, end - start ) );
+    }
+
+    QVERIFY( allWritten );
+    QCOMPARE( data, addedItemData );
+
+}
+
+void LocalChangesPackageTest::testPreparedCommands()
+{
+    // Test that a package prepared in advance writes exactly what it would
+    // have written without preparing, also when the message turns out to
+    // be smaller than what was prepared for
+
+    const int msgSize = 65535;
+    const int budget = 1000;
+    const int itemCount = 10;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+    LocalChangesPackageStorage preparedStorage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+    QList<SyncItem*> preparedItems;
+
+    for( int i = 0; i < itemCount; ++i )
+    {
+        const QString itemId = QString( "item%1" ).arg( i );
+        QByteArray itemData;
+        itemData.fill( 'a' + i, 200 );
+
+        MockSyncItem* item = new MockSyncItem( itemId );
+        item->setType( "text/foo" );
+        item->write( 0, itemData );
+        items.append( item );
+
+        MockSyncItem* preparedItem = new MockSyncItem( itemId );
+        preparedItem->setType( "text/foo" );
+        preparedItem->write( 0, itemData );
+        preparedItems.append( preparedItem );
+
+        if( i % 2 ) {
+            changes.modified.append( itemId );
+        }
+        else {
+            changes.added.append( itemId );
+        }
+    }
+
+    storage.setItems( items );
+    preparedStorage.setItems( preparedItems );
+
+    SyncMode syncMode;
+    SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+    SyncTarget preparedTarget( NULL, &preparedStorage, syncMode, "localAnchor" );
+    preparedTarget.setTargetDatabase( "./RemoteContacts");
+
+    LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    LocalChangesPackage preparedPackage( preparedTarget, changes, msgSize, ROLE_CLIENT, maxChanges );
+    QVERIFY( package.setExactPacking( true ) );
+    QVERIFY( preparedPackage.setExactPacking( true ) );
+
+    QtEncoder encoder;
+
+    // First message has room for only some of the prepared commands, the
+    // rest are discarded and written in the second message
+    const int budgets[] = { budget, msgSize };
+
+    for( int round = 0; round < 2; ++round )
+    {
+        preparedPackage.prepare( msgSize, false, SYNCML_1_2 );
+        QVERIFY( !preparedPackage.iPreparedCommands.isEmpty() );
+
+        // Items of prepared commands are encoded in advance
+        const SyncMLCmdObject& command = *preparedPackage.iPreparedCommands.first().iObject;
+        QVERIFY( !command.getChildren().isEmpty() );
+        QVERIFY( !command.getChildren().last()->getEncoding( false ).isEmpty() );
+
+        SyncMLMessage msg( HeaderParams(), SYNCML_1_2 );
+        SyncMLMessage preparedMsg( HeaderParams(), SYNCML_1_2 );
+
+        int remaining = budgets[round];
+        int preparedRemaining = budgets[round];
+
+        bool written = package.write( msg, remaining, false, SYNCML_1_2 );
+        QCOMPARE( preparedPackage.write( preparedMsg, preparedRemaining, false, SYNCML_1_2 ), written );
+        QCOMPARE( written, round == 1 );
+        QCOMPARE( preparedRemaining, remaining );
+        QCOMPARE( preparedMsg.getNextCmdId(), msg.getNextCmdId() );
+        QVERIFY( preparedPackage.iPreparedCommands.isEmpty() );
+
+        QByteArray result_xml;
+        QByteArray prepared_xml;
+        QVERIFY( encoder.encodeToXML( msg, result_xml, false ) );
+        QVERIFY( encoder.encodeToXML( preparedMsg, prepared_xml, false ) );
+        QCOMPARE( prepared_xml, result_xml );
+    }
+
+}
+
+void LocalChangesPackageTest::testMultiItemCommands()
+{
+    // Test that consecutive items of the same type share a command, and
+    // that items of another type or modification start a new one
+
+    const int msgSize = 65535;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+
+    for( int i = 0; i < 7; ++i )
+    {
+        const QString itemId = QString( "item%1" ).arg( i );
+        MockSyncItem* item = new MockSyncItem( itemId );
+        item->setType( i == 4 ? "text/bar" : "text/foo" );
+        item->write( 0, QByteArray( "data" ) + itemId.toLatin1() );
+        items.append( item );
+
+        if( i < 5 ) {
+            changes.added.append( itemId );
+        }
+        else {
+            changes.modified.append( itemId );
+        }
+    }
+
+    changes.removed.append( "deletedItem" );
+
+    storage.setItems( items );
+
+    SyncMode syncMode;
+    SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+
+    LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    package.setMultiItemCommands( true );
+
+    SyncMLMessage msg( HeaderParams(), SYNCML_1_2 );
+
+    int remaining = msgSize;
+    QVERIFY( package.write( msg, remaining, false, SYNCML_1_2 ) );
+
+    QtEncoder encoder;
+    QByteArray result_xml;
+    QVERIFY( encoder.encodeToXML( msg, result_xml, false ) );
+
+    QCOMPARE( result_xml.count( "<Add>" ), 2 );
+    QCOMPARE( result_xml.count( "<Replace>" ), 1 );
+    QCOMPARE( result_xml.count( "<Delete>" ), 1 );
+    QCOMPARE( result_xml.count( "<Item>" ), 8 );
+    QCOMPARE( result_xml.count( "<Type" ), 3 );
+
+    for( int i = 0; i < 7; ++i )
+    {
+        QCOMPARE( result_xml.count( QString( "dataitem%1" ).arg( i ).toLatin1() ), 1 );
+    }
+
+    // Sync, two Adds, Replace and Delete
+    QCOMPARE( msg.getNextCmdId(), 6 );
+
+    // Looking at the type of an item does not count it twice
+    PrefetchStatistics statistics = package.iPrefetcher.statistics();
+    QCOMPARE( statistics.iHits + statistics.iStalls, 7 );
+
+}
+
+void LocalChangesPackageTest::testMultiItemCommandsExactPacking()
+{
+    // Test that items added to a shared command are accounted for exactly,
+    // and that an item that does not fit is written to the next message
+
+    const int msgSize = 65535;
+    const int budget = 1000;
+    const int itemCount = 10;
+    const int maxChanges = 50;
+
+    LocalChangesPackageStorage storage( "./LocalContacts" );
+
+    LocalChanges changes;
+    QList<SyncItem*> items;
+
+    for( int i = 0; i < itemCount; ++i )
+    {
+        const QString itemId = QString( "addedItem%1" ).arg( i );
+        QByteArray itemData;
+        itemData.fill( 'a' + i, 200 );
+        MockSyncItem* item = new MockSyncItem( itemId );
+        item->setType( "text/foo" );
+        item->write( 0, itemData );
+        items.append( item );
+        changes.added.append( itemId );
+    }
+
+    storage.setItems( items );
+
+    SyncMode syncMode;
+    SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+    target.setTargetDatabase( "./RemoteContacts");
+
+    LocalChangesPackage package( target, changes, msgSize, ROLE_CLIENT, maxChanges );
+    QVERIFY( package.setExactPacking( true ) );
+    package.setMultiItemCommands( true );
+
+    MessageSizer sizer( false, SYNCML_1_2 );
+    QtEncoder encoder;
+
+    SyncMLMessage msg1( HeaderParams(), SYNCML_1_2 );
+    int emptySize = sizer.messageSize( msg1 );
+
+    int remaining = budget;
+    QVERIFY( !package.write( msg1, remaining, false, SYNCML_1_2 ) );
+    QVERIFY( remaining >= 0 );
+
+    QByteArray result_xml1;
+    QVERIFY( encoder.encodeToXML( msg1, result_xml1, false ) );
+    QCOMPARE( result_xml1.size(), emptySize + budget - remaining );
+    QCOMPARE( result_xml1.count( "<Add>" ), 1 );
+    QCOMPARE( msg1.getNextCmdId(), 3 );
+
+    int written = result_xml1.count( "<Item>" );
+    QVERIFY( written > 1 && written < itemCount );
+
+    remaining = msgSize;
+    SyncMLMessage msg2( HeaderParams(), SYNCML_1_2 );
+    QVERIFY( package.write( msg2, remaining, false, SYNCML_1_2 ) );
+
+    QByteArray result_xml2;
+    QVERIFY( encoder.encodeToXML( msg2, result_xml2, false ) );
+    QCOMPARE( result_xml2.count( "<Add>" ), 1 );
+    QCOMPARE( result_xml2.count( "<Item>" ), itemCount - written );
+
+    // Every item is written exactly once
+    for( int i = 0; i < itemCount; ++i )
+    {
+        QByteArray itemData;
+        itemData.fill( 'a' + i, 200 );
+        QCOMPARE( result_xml1.count( itemData ) + result_xml2.count( itemData ), 1 );
+    }
+
+}
+
 QTEST_MAIN(LocalChangesPackageTest)
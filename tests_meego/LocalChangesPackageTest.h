@@ -96,6 +96,11 @@ private slots:
     void testSimpleServer();
 
     void testLargeObjects();
+    void testExactPacking();
+    void testExactPackingLargeObjects();
+    void testPreparedCommands();
+    void testMultiItemCommands();
+    void testMultiItemCommandsExactPacking();
 
 };
 
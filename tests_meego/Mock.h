@@ -329,7 +329,8 @@ class TestTransport : public BaseTransport
 
 public:
 
-    TestTransport( bool aDoReceive, QObject* aParent = NULL ) : BaseTransport( CONTEXT_DS, aParent ), iDoReceive( aDoReceive )
+    TestTransport( bool aDoReceive, QObject* aParent = NULL ) : BaseTransport( CONTEXT_DS, aParent ),
+        iChunkSize( 0 ), iCancelAfterChunks( 0 ), iDoReceive( aDoReceive )
     {
     }
 
@@ -355,6 +356,8 @@ public:
 
     QByteArray  iData;
     QString     iContentType;
+    int         iChunkSize;
+    int         iCancelAfterChunks;
 
 protected:
 
@@ -381,7 +384,19 @@ protected:
     {
         Q_UNUSED( aContentType );
 
-        if( iDoReceive )
+        if( iDoReceive && iChunkSize > 0 && acceptsChunk( iContentType ) )
+        {
+            for( int i = 0; i < iData.size(); i += iChunkSize )
+            {
+                if( iCancelAfterChunks > 0 && i / iChunkSize == iCancelAfterChunks )
+                {
+                    cancelChunks();
+                    break;
+                }
+                receiveChunk( iData.mid( i, iChunkSize ), i + iChunkSize >= iData.size() );
+            }
+        }
+        else if( iDoReceive )
         {
             receive( iData, iContentType );
         }
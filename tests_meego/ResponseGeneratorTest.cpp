@@ -39,6 +39,7 @@
 #include "ResponseGenerator.h"
 #include "LocalMappingsPackage.h"
 #include "QtEncoder.h"
+#include "WbXMLEncoder.h"
 #include "SyncMLMessage.h"
 
 
@@ -697,6 +698,216 @@ void ResponseGeneratorTest::test208762()
     QVERIFY( result_xml.size() + 157 < maxMsgSize );
 
 }
-        
-QTEST_MAIN(DataSync::ResponseGeneratorTest)
 
+void ResponseGeneratorTest::testExactPacking()
+{
+    const int maxMsgSize = 2048;
+    const int statusCount = 1000;
+
+    int xmlMessages = generateMessages( false, false, maxMsgSize, statusCount );
+    int exactXmlMessages = generateMessages( true, false, maxMsgSize, statusCount );
+    QVERIFY( exactXmlMessages > 0 );
+    QVERIFY( exactXmlMessages < xmlMessages );
+
+    int wbxmlMessages = generateMessages( false, true, maxMsgSize, statusCount );
+    int exactWbxmlMessages = generateMessages( true, true, maxMsgSize, statusCount );
+    QVERIFY( exactWbxmlMessages > 0 );
+    QVERIFY( exactWbxmlMessages < wbxmlMessages );
+}
+
+int ResponseGeneratorTest::generateMessages( bool aExact, bool aWbXML, int aMaxMsgSize, int aStatusCount )
+{
+    ResponseGenerator respGen;
+    respGen.setExactPacking( aExact );
+
+    HeaderParams hdr;
+    hdr.sessionID = 1;
+    hdr.msgID = 8;
+    hdr.targetDevice = "IMEI:356407011863641";
+    hdr.sourceDevice = "IMEI:004402130345691";
+    respGen.setHeaderParams( hdr );
+    respGen.setRemoteMsgId( 8 );
+
+    for( int i = 0; i < aStatusCount; ++i ) {
+        StatusParams* status = new StatusParams;
+        status->msgRef = 8;
+        status->cmdRef = i + 1;
+        status->cmd = SYNCML_ELEMENT_ADD;
+        status->sourceRef = QString::number( 1000 + i );
+        status->data = ITEM_ADDED;
+        respGen.addStatus( status );
+    }
+
+    QtEncoder encoder;
+    WbXMLEncoder wbxmlEncoder;
+    int messages = 0;
+    int statuses = 0;
+
+    while( !respGen.getStatuses().isEmpty() && messages < aStatusCount ) {
+
+        SyncMLMessage* msg = respGen.generateNextMessage( aMaxMsgSize, SYNCML_1_2, aWbXML );
+        if( !msg ) {
+            return -1;
+        }
+
+        ++messages;
+        statuses += msg->getBody().getChildren().count();
+
+        QByteArray data;
+        if( aWbXML ) {
+            wbxmlEncoder.encodeToWbXML( *msg, SYNCML_1_2, data );
+        }
+        else {
+            encoder.encodeToXML( *msg, data, false );
+        }
+        delete msg;
+        msg = 0;
+
+        if( data.isEmpty() || ( aExact && data.size() > aMaxMsgSize ) ) {
+            return -1;
+        }
+
+        // Exactly packed messages are filled up to the size of one status
+        // below the maximum
+        if( aExact && !respGen.getStatuses().isEmpty() &&
+            data.size() < aMaxMsgSize - 200 ) {
+            return -1;
+        }
+    }
+
+    if( statuses != aStatusCount ) {
+        return -1;
+    }
+
+    return messages;
+}
+
+void ResponseGeneratorTest::testCompactStatuses()
+{
+    // Statuses of items of the same command with the same code are merged,
+    // and the items are referred to with SourceRef elements
+    ResponseGenerator respGen;
+    respGen.setCompactStatuses( true );
+    respGen.setRemoteMsgId( 8 );
+
+    CommandParams command( CommandParams::COMMAND_ADD );
+    command.cmdId = 3;
+
+    for( int i = 0; i < 3; ++i ) {
+        ItemParams item;
+        item.source = QString::number( 1000 + i );
+        command.items.append( item );
+    }
+
+    respGen.addStatus( command, ITEM_ADDED, QList<int>() << 0 );
+    respGen.addStatus( command, ITEM_ADDED, QList<int>() << 1 );
+    respGen.addStatus( command, ALREADY_EXISTS, QList<int>() << 2 );
+
+    QCOMPARE( respGen.getStatuses().count(), 2 );
+    QCOMPARE( respGen.getStatuses()[0]->items.count(), 2 );
+    QVERIFY( respGen.getStatuses()[1]->items.isEmpty() );
+
+    SyncMLMessage* msg = respGen.generateNextMessage( 65535, SYNCML_1_2 );
+    QVERIFY( msg );
+
+    QtEncoder encoder;
+    QByteArray data;
+    QVERIFY( encoder.encodeToXML( *msg, data, false ) );
+    delete msg;
+
+    QCOMPARE( data.count( "<Status>" ), 2 );
+    QCOMPARE( data.count( "<SourceRef>" ), 3 );
+    QVERIFY( data.contains( "<SourceRef>1000</SourceRef><SourceRef>1001</SourceRef>" ) );
+    QVERIFY( !data.contains( "<Item>" ) );
+
+    // Statuses of 1000 items received in 50 commands
+    const int maxMsgSize = 4096;
+    const int commandCount = 50;
+    const int itemCount = 20;
+
+    for( int wbxml = 0; wbxml < 2; ++wbxml ) {
+        int bytes = 0;
+        int compactBytes = 0;
+        int messages = generateItemStatuses( false, wbxml, maxMsgSize, commandCount, itemCount, bytes );
+        int compactMessages = generateItemStatuses( true, wbxml, maxMsgSize, commandCount, itemCount, compactBytes );
+
+        QVERIFY( compactMessages > 0 );
+        QVERIFY( compactMessages < messages );
+        QVERIFY( compactBytes < bytes );
+
+        // A merged item costs a SourceRef element instead of a whole Status,
+        // which at least halves the bytes and messages needed
+        QVERIFY( compactBytes * 2 < bytes );
+        QVERIFY( compactMessages * 2 <= messages );
+
+        qDebug() << ( wbxml ? "WbXML:" : "XML:" ) << "statuses of" << commandCount * itemCount
+                 << "items took" << bytes << "bytes in" << messages << "messages,"
+                 << compactBytes << "bytes in" << compactMessages << "messages when compact";
+    }
+}
+
+int ResponseGeneratorTest::generateItemStatuses( bool aCompact, bool aWbXML, int aMaxMsgSize,
+                                                 int aCommandCount, int aItemCount, int& aBytes )
+{
+    ResponseGenerator respGen;
+    respGen.setCompactStatuses( aCompact );
+
+    HeaderParams hdr;
+    hdr.sessionID = 1;
+    hdr.msgID = 8;
+    hdr.targetDevice = "IMEI:356407011863641";
+    hdr.sourceDevice = "IMEI:004402130345691";
+    respGen.setHeaderParams( hdr );
+    respGen.setRemoteMsgId( 8 );
+
+    for( int i = 0; i < aCommandCount; ++i ) {
+        CommandParams command( CommandParams::COMMAND_ADD );
+        command.cmdId = i + 1;
+
+        for( int a = 0; a < aItemCount; ++a ) {
+            ItemParams item;
+            item.source = QString::number( 1000 + i * aItemCount + a );
+            command.items.append( item );
+        }
+
+        // Status of every item is added as it is processed
+        for( int a = 0; a < aItemCount; ++a ) {
+            respGen.addStatus( command, ITEM_ADDED, QList<int>() << a );
+        }
+    }
+
+    QtEncoder encoder;
+    WbXMLEncoder wbxmlEncoder;
+    int messages = 0;
+    aBytes = 0;
+
+    while( !respGen.getStatuses().isEmpty() && messages < aCommandCount * aItemCount ) {
+
+        SyncMLMessage* msg = respGen.generateNextMessage( aMaxMsgSize, SYNCML_1_2, aWbXML );
+        if( !msg ) {
+            return -1;
+        }
+
+        ++messages;
+
+        QByteArray data;
+        if( aWbXML ) {
+            wbxmlEncoder.encodeToWbXML( *msg, SYNCML_1_2, data );
+        }
+        else {
+            encoder.encodeToXML( *msg, data, false );
+        }
+        delete msg;
+        msg = 0;
+
+        if( data.isEmpty() ) {
+            return -1;
+        }
+
+        aBytes += data.size();
+    }
+
+    return messages;
+}
+
+QTEST_MAIN(DataSync::ResponseGeneratorTest)
@@ -53,6 +53,13 @@ private slots:
     void testNB182304();
 
     void test208762();
+    void testExactPacking();
+    void testCompactStatuses();
+
+private:
+    int generateMessages( bool aExact, bool aWbXML, int aMaxMsgSize, int aStatusCount );
+    int generateItemStatuses( bool aCompact, bool aWbXML, int aMaxMsgSize,
+                              int aCommandCount, int aItemCount, int& aBytes );
 
 };
 }
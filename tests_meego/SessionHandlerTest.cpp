@@ -39,6 +39,7 @@
 #include "ClientSessionHandler.h"
 #include "ServerSessionHandler.h"
 #include "Mock.h"
+#include "AsyncStoragePlugin.h"
 #include "SyncAgent.h"
 #include "TestUtils.h"
 #include "ServerAlertedNotification.h"
@@ -53,7 +54,25 @@ QString NB153701UNKNOWNDEVICE( "/" );
 QString NB153701SOURCEDEVICE( "IMEI:000000000000000" );
 QString NB153701TARGETDEVICE( "IMEI:000000000000001" );
 QString NB153701FORCEDEVICE( "IMEI:000000000000002" );
+QString DEFERREDDB( "deferred" );
 
+/*! \brief Storage that never completes asynchronous commits by itself
+ *
+ */
+class DeferredCommitStorage : public MockStorage, public AsyncStoragePlugin
+{
+public:
+
+    DeferredCommitStorage() : MockStorage( "storage" ) { }
+
+    virtual void addItemsAsync( const QList<SyncItem*>& /*aItems*/, StorageCommitObserver& /*aObserver*/ ) { }
+
+    virtual void replaceItemsAsync( const QList<SyncItem*>& /*aItems*/, StorageCommitObserver& /*aObserver*/ ) { }
+
+    virtual void deleteItemsAsync( const QList<SyncItemKey>& /*aKeys*/, StorageCommitObserver& /*aObserver*/ ) { }
+
+    virtual void cancelCommit( StorageCommitObserver& /*aObserver*/ ) { }
+};
 
 
 
@@ -66,8 +85,12 @@ bool SessionHandlerTest::getStorageContentFormatInfo( const QString& aURI,
     return true;
 }
 
-StoragePlugin* SessionHandlerTest::acquireStorageByURI( const QString& /*aURI*/ )
+StoragePlugin* SessionHandlerTest::acquireStorageByURI( const QString& aURI )
 {
+    if( aURI == DEFERREDDB ) {
+        return new DeferredCommitStorage;
+    }
+
     return new MockStorage( "storage" );
 }
 
@@ -253,6 +276,96 @@ void SessionHandlerTest::testNoRespSyncElement()
 
 }
 
+void SessionHandlerTest::testAbortDuringCommit()
+{
+    // Test that sync is aborted right away while a storage plugin is
+    // committing items, instead of waiting for the plugin to finish
+
+    TestTransport transport( false );
+    const QString DB = DEFERREDDB;
+
+    SyncAgentConfig config;
+    config.setTransport(&transport);
+    config.setStorageProvider( this );
+    config.addSyncTarget( DB, DB );
+    config.setDatabaseFilePath( DBFILE );
+
+    config.setAuthParams( AUTH_BASIC, "user", "password" );
+
+    ClientSessionHandler session_handler(&config, NULL);
+    session_handler.initiateSync();
+
+    HeaderParams* hp1 = new HeaderParams();
+    hp1->verDTD = SYNCML_DTD_VERSION_1_2;
+    hp1->sourceDevice = "Source device";
+    hp1->sessionID = "1";
+    hp1->msgID = 1;
+    hp1->targetDevice = SYNCML_UNKNOWN_DEVICE;
+    hp1->respURI = "redirect URI";
+    hp1->meta.maxMsgSize = 30000;
+    session_handler.handleHeaderElement(hp1);
+    hp1 = NULL;
+
+    StatusParams* sp1 = new StatusParams();
+    sp1->cmdId = 1;
+    sp1->msgRef = 1;
+    sp1->cmdRef = 0;
+    sp1->cmd = SYNCML_ELEMENT_SYNCHDR;
+    sp1->data = AUTH_ACCEPTED;
+    session_handler.handleStatusElement( sp1 );
+
+    CommandParams* ap1 = new CommandParams( CommandParams::COMMAND_ALERT );
+    ap1->cmdId = 2;
+    ap1->data = QString::number( SLOW_SYNC );
+    ItemParams item;
+    item.source = DB;
+    item.target = DB;
+    item.meta.anchor.next = "something";
+    ap1->items.append(item);
+    session_handler.handleAlertElement(ap1);
+    ap1 = NULL;
+
+    session_handler.handleFinal();
+    QCOMPARE(session_handler.getSyncState(), SENDING_ITEMS);
+    session_handler.handleEndOfMessage();
+
+    SyncParams* sync = new SyncParams();
+    sync->cmdId = 1;
+    sync->source = DB;
+    sync->target = DB;
+
+    CommandParams add( CommandParams::COMMAND_ADD );
+    add.cmdId = 2;
+    ItemParams addItem;
+    addItem.source = "fooid";
+    addItem.data = "foodata";
+    addItem.meta.type = "text/x-vcard";
+    add.items.append( addItem );
+    sync->commands.append( add );
+
+    CommandParams* get = new CommandParams( CommandParams::COMMAND_GET );
+    get->cmdId = 3;
+
+    QList<Fragment*> fragments;
+    fragments.append( sync );
+    fragments.append( get );
+    session_handler.processMessage( fragments, true );
+
+    // Commit is outstanding, and the Get waits for it
+    QVERIFY( session_handler.iPendingSync );
+    QVERIFY( session_handler.iProcessing );
+    QCOMPARE( session_handler.iPendingFragments.count(), 1 );
+
+    session_handler.abortSync( ABORTED, "Aborted by user" );
+
+    QVERIFY( session_handler.iSessionClosed );
+    QCOMPARE( session_handler.getSyncState(), ABORTED );
+    QVERIFY( !session_handler.iPendingSync );
+    QVERIFY( session_handler.iPendingFragments.isEmpty() );
+    QVERIFY( !session_handler.iProcessing );
+    QVERIFY( !session_handler.iStorageHandler.commitInProgress() );
+}
+
 void SessionHandlerTest::testClientWithServerInitiated()
 {
     MockTransport transport("transport");
@@ -82,6 +82,7 @@ private slots:
     void regression_NB153701_03();
     void regression_NB153701_04();
     void testNoRespSyncElement();
+    void testAbortDuringCommit();
 
 private:
 
@@ -32,6 +32,9 @@
 */
 
 #include "StorageHandlerTest.h"
+
+#include <QSignalSpy>
+
 #include "Mock.h"
 #include "ConflictResolver.h"
 #include "SyncMLLogging.h"
@@ -39,6 +42,58 @@
 
 using namespace DataSync;
 
+/*! \brief Storage that completes asynchronous commits only when asked to
+ *
+ */
+class DeferredStorage : public MockStorage, public AsyncStoragePlugin
+{
+public:
+
+    DeferredStorage() : MockStorage( "id" ), iObserver( 0 ) { }
+
+    virtual void addItemsAsync( const QList<SyncItem*>& aItems, StorageCommitObserver& aObserver )
+    {
+        iStatuses = addItems( aItems );
+        iObserver = &aObserver;
+    }
+
+    virtual void replaceItemsAsync( const QList<SyncItem*>& aItems, StorageCommitObserver& aObserver )
+    {
+        iStatuses = replaceItems( aItems );
+        iObserver = &aObserver;
+    }
+
+    virtual void deleteItemsAsync( const QList<SyncItemKey>& aKeys, StorageCommitObserver& aObserver )
+    {
+        iStatuses = deleteItems( aKeys );
+        iObserver = &aObserver;
+    }
+
+    virtual void cancelCommit( StorageCommitObserver& aObserver )
+    {
+        if( iObserver == &aObserver ) {
+            iObserver = 0;
+        }
+    }
+
+    bool complete()
+    {
+        if( !iObserver ) {
+            return false;
+        }
+
+        StorageCommitObserver* observer = iObserver;
+        iObserver = 0;
+        observer->commitCompleted( iStatuses );
+        return true;
+    }
+
+private:
+
+    StorageCommitObserver*      iObserver;
+    QList<StoragePluginStatus>  iStatuses;
+};
+
 void StorageHandlerTest::testAddItem()
 {
 
@@ -52,7 +107,7 @@ void StorageHandlerTest::testAddItem()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
     LocalChanges changes;
     ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
 
@@ -84,7 +139,7 @@ void StorageHandlerTest::testReplaceItem()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -125,6 +180,127 @@ void StorageHandlerTest::testDeleteItem()
 
 }
 
+void StorageHandlerTest::testCommit()
+{
+    MockStorage storage( "id" );
+    StorageHandler handler;
+    QSignalSpy finished( &handler, SIGNAL(commitFinished()) );
+
+    LocalChanges changes;
+    ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
+
+    ItemId addId;
+    addId.iCmdId = 1;
+    addId.iItemIndex = 0;
+
+    ItemId deleteId;
+    deleteId.iCmdId = 2;
+    deleteId.iItemIndex = 0;
+
+    QVERIFY( handler.addItem( addId, storage, QString(), "", "text/x-vcard", "", "", "fasdaagadtadg" ) );
+    QVERIFY( handler.deleteItem( deleteId, "fookey" ) );
+
+    // Plugins implementing only synchronous API finish before startCommit() returns
+    handler.startCommit( storage, &resolver );
+
+    QCOMPARE( finished.count(), 1 );
+    QVERIFY( !handler.commitInProgress() );
+
+    QMap<ItemId, CommitResult> results = handler.takeCommitResults();
+    QCOMPARE( results.count(), 2 );
+    QVERIFY( results.value( addId ).iStatus == COMMIT_ADDED );
+    QVERIFY( results.value( deleteId ).iStatus == COMMIT_DELETED );
+    QCOMPARE( results.value( deleteId ).iItemKey, QString( "fookey" ) );
+    QVERIFY( handler.takeCommitResults().isEmpty() );
+}
+
+void StorageHandlerTest::testAsyncCommit()
+{
+    DeferredStorage storage;
+    StorageHandler handler;
+    QSignalSpy finished( &handler, SIGNAL(commitFinished()) );
+
+    LocalChanges changes;
+    ConflictResolver resolver( changes, PREFER_LOCAL_CHANGES );
+
+    ItemId addId;
+    addId.iCmdId = 1;
+    addId.iItemIndex = 0;
+
+    ItemId replaceId;
+    replaceId.iCmdId = 2;
+    replaceId.iItemIndex = 0;
+
+    ItemId deleteId;
+    deleteId.iCmdId = 3;
+    deleteId.iItemIndex = 0;
+
+    QVERIFY( handler.addItem( addId, storage, QString(), "", "text/x-vcard", "", "", "fasdaagadtadg" ) );
+    QVERIFY( handler.replaceItem( replaceId, storage, "replacekey", "", "text/x-vcard", "", "", "fasdaagadtadg" ) );
+    QVERIFY( handler.deleteItem( deleteId, "deletekey" ) );
+
+    handler.startCommit( storage, &resolver );
+    QVERIFY( handler.commitInProgress() );
+
+    // Added, replaced and deleted items are committed one request at a time
+    QVERIFY( storage.complete() );
+    QVERIFY( handler.commitInProgress() );
+    QVERIFY( storage.complete() );
+    QVERIFY( handler.commitInProgress() );
+    QCOMPARE( finished.count(), 0 );
+
+    QVERIFY( storage.complete() );
+    QVERIFY( !storage.complete() );
+    QVERIFY( !handler.commitInProgress() );
+    QCOMPARE( finished.count(), 1 );
+
+    QMap<ItemId, CommitResult> results = handler.takeCommitResults();
+    QCOMPARE( results.count(), 3 );
+    QVERIFY( results.value( addId ).iStatus == COMMIT_ADDED );
+    QVERIFY( !results.value( addId ).iItemKey.isEmpty() );
+    QVERIFY( results.value( replaceId ).iStatus == COMMIT_REPLACED );
+    QCOMPARE( results.value( replaceId ).iItemKey, QString( "replacekey" ) );
+    QVERIFY( results.value( deleteId ).iStatus == COMMIT_DELETED );
+}
+
+void StorageHandlerTest::testCancelCommit()
+{
+    DeferredStorage storage;
+    StorageHandler handler;
+    QSignalSpy finished( &handler, SIGNAL(commitFinished()) );
+
+    ItemId addId;
+    addId.iCmdId = 1;
+    addId.iItemIndex = 0;
+
+    ItemId replaceId;
+    replaceId.iCmdId = 2;
+    replaceId.iItemIndex = 0;
+
+    QVERIFY( handler.addItem( addId, storage, QString(), "", "text/x-vcard", "", "", "fasdaagadtadg" ) );
+    QVERIFY( handler.replaceItem( replaceId, storage, "replacekey", "", "text/x-vcard", "", "", "fasdaagadtadg" ) );
+
+    handler.startCommit( storage, NULL );
+    QVERIFY( handler.commitInProgress() );
+    QCOMPARE( handler.iCommitItems.count(), 1 );
+
+    // Plugin stops reporting, and the handler can be used again
+    handler.cancelCommit();
+    QVERIFY( !handler.commitInProgress() );
+    QVERIFY( handler.iCommitItems.isEmpty() );
+    QVERIFY( !storage.complete() );
+    QCOMPARE( finished.count(), 0 );
+    QVERIFY( handler.takeCommitResults().isEmpty() );
+
+    // Cancelling without a commit in progress does nothing
+    handler.cancelCommit();
+    QVERIFY( !handler.commitInProgress() );
+
+    // Replaced item that was not committed yet stays queued until the
+    // handler is destroyed
+    QCOMPARE( handler.iReplaceList.count(), 1 );
+}
+
 void StorageHandlerTest::testLargeObjectReplace()
 {
 
@@ -138,7 +314,7 @@ void StorageHandlerTest::testLargeObjectReplace()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "ab" );
+    QByteArray data( "ab" );
     QString key = "fookey";
     qint64 size = 4;
 
@@ -178,7 +354,7 @@ void StorageHandlerTest::regression_NB153991_01()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -210,7 +386,7 @@ void StorageHandlerTest::regression_NB203771_01()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -240,7 +416,7 @@ void StorageHandlerTest::regression_NB203771_02()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.addItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -272,7 +448,7 @@ void StorageHandlerTest::regression_NB203771_03()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -309,7 +485,7 @@ void StorageHandlerTest::regression_NB203771_04()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
@@ -345,7 +521,7 @@ void StorageHandlerTest::regression_NB203771_05()
     QString type( "text/x-vcard" );
     QString format("");
     QString version("");
-    QString data( "fasdaagadtadg" );
+    QByteArray data( "fasdaagadtadg" );
 
     QVERIFY( iStorageHandler.replaceItem( id, storage, key, parent, type, format, version, data ) );
 
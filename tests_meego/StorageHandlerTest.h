@@ -52,6 +52,10 @@ private slots:
 
     void testLargeObjectReplace();
 
+    void testCommit();
+    void testAsyncCommit();
+    void testCancelCommit();
+
     void regression_NB153991_01();
     void regression_NB203771_01();
     void regression_NB203771_02();
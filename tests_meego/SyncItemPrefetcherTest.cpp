@@ -41,7 +41,7 @@
 #include "SyncMLLogging.h"
 
 PrefetchStorage::PrefetchStorage( const QList<SyncItemKey>& aItemIds )
-    : iItemIds( aItemIds ), iForceSyncItems( false )
+    : iItemIds( aItemIds ), iForceSyncItems( false ), iItemSize( 0 )
 {
     ContentFormat format;
     format.iType = "text/foo";
@@ -67,6 +67,11 @@ void PrefetchStorage::forceSyncItems( const QList<SyncItem*> aSyncItems )
     iSyncItems = aSyncItems;
 }
 
+void PrefetchStorage::setItemSize( int aItemSize )
+{
+    iItemSize = aItemSize;
+}
+
 const QString& PrefetchStorage::getSourceURI() const
 {
     return iSourceURI;
@@ -139,6 +144,7 @@ QList<SyncItem*> PrefetchStorage::getSyncItems( const QList<SyncItemKey>& aKeyLi
             if( iItemIds.contains( aKeyList[i] ) )
             {
                 item = new MockSyncItem( aKeyList[i] );
+                item->write( 0, QByteArray( iItemSize, 'x' ) );
             }
             items.append( item );
         }
@@ -360,5 +366,249 @@ void SyncItemPrefetcherTest::testAbnormalBadItemCount()
     QCOMPARE( prefetcher.iFetchedItems.count(), batchSizeHint - 1 );
     delete item;
 }
+void SyncItemPrefetcherTest::testStatistics()
+{
+    // Test that prefetch hits and stalls are counted
+
+    QList<SyncItemKey> items;
+    items.append( "1" );
+    items.append( "2" );
+    items.append( "3" );
+    const int batchSizeHint = 2;
+
+    PrefetchStorage storage( items );
+
+    SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+
+    QCOMPARE( prefetcher.statistics().iHits, 0 );
+    QCOMPARE( prefetcher.statistics().iStalls, 0 );
+
+    // Miss
+    SyncItem* item = prefetcher.getItem( items.at(0) );
+    QVERIFY( item );
+    delete item;
+
+    // Hit
+    item = prefetcher.getItem( items.at(1) );
+    QVERIFY( item );
+    delete item;
+
+    // Miss
+    item = prefetcher.getItem( items.at(2) );
+    QVERIFY( item );
+    delete item;
+
+    PrefetchStatistics statistics = prefetcher.statistics();
+    QCOMPARE( statistics.iHits, 1 );
+    QCOMPARE( statistics.iStalls, 2 );
+    QVERIFY( statistics.iStallTime >= 0 );
+}
+
+void SyncItemPrefetcherTest::testPeekItem()
+{
+    // Test that peeked items are kept for retrieval and not counted
+
+    QList<SyncItemKey> items;
+    items.append( "1" );
+    items.append( "2" );
+    items.append( "3" );
+    const int batchSizeHint = 2;
+
+    PrefetchStorage storage( items );
+
+    SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+
+    const SyncItem* peeked = prefetcher.peekItem( items.at(0) );
+    QVERIFY( peeked );
+    QCOMPARE( peeked->getKey(), items.at(0) );
+    QCOMPARE( prefetcher.peekItem( items.at(0) ), peeked );
+    QCOMPARE( prefetcher.statistics().iHits, 0 );
+    QCOMPARE( prefetcher.statistics().iStalls, 0 );
+
+    SyncItem* item = prefetcher.getItem( items.at(0) );
+    QCOMPARE( static_cast<const SyncItem*>( item ), peeked );
+    delete item;
+
+    // Item fetched by the peek is already there when retrieved
+    QVERIFY( prefetcher.peekItem( items.at(2) ) );
+    item = prefetcher.getItem( items.at(2) );
+    QVERIFY( item );
+    delete item;
+
+    QVERIFY( !prefetcher.peekItem( "unknown" ) );
+
+    PrefetchStatistics statistics = prefetcher.statistics();
+    QCOMPARE( statistics.iHits, 2 );
+    QCOMPARE( statistics.iStalls, 0 );
+}
+
+void SyncItemPrefetcherTest::testMemoryBudget()
+{
+    // Test that items are prefetched only as far as memory budget allows
+
+    QList<SyncItemKey> items;
+    items.append( "1" );
+    items.append( "2" );
+    items.append( "3" );
+    items.append( "4" );
+    items.append( "5" );
+    const int batchSizeHint = 5;
+    const int itemSize = 100;
+
+    PrefetchStorage storage( items );
+    storage.setItemSize( itemSize );
+
+    SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+    prefetcher.setMemoryBudget( 2 * itemSize + itemSize / 2 );
+
+    // Size of items is not known yet, so only the requested item is fetched
+    SyncItem* item = prefetcher.getItem( items.at(0) );
+    QVERIFY( item );
+    QCOMPARE( prefetcher.iItemIdList.count(), items.count() - 1 );
+    QCOMPARE( prefetcher.iFetchedItems.count(), 0 );
+    QCOMPARE( prefetcher.iFetchedBytes, Q_INT64_C( 0 ) );
+    delete item;
+
+    // Two items fit to the budget
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iItemIdList.count(), items.count() - 3 );
+    QCOMPARE( prefetcher.iFetchedItems.count(), 2 );
+    QCOMPARE( prefetcher.iFetchedBytes, static_cast<qint64>( 2 * itemSize ) );
+
+    // Budget is in use, nothing more is fetched
+    prefetcher.prefetch();
+    QCOMPARE( prefetcher.iItemIdList.count(), items.count() - 3 );
+    QCOMPARE( prefetcher.iFetchedItems.count(), 2 );
+
+    item = prefetcher.getItem( items.at(1) );
+    QVERIFY( item );
+    QCOMPARE( prefetcher.iFetchedBytes, static_cast<qint64>( itemSize ) );
+    delete item;
+
+    // Requested item is fetched even if it does not fit to the budget
+    prefetcher.setMemoryBudget( itemSize / 2 );
+    item = prefetcher.getItem( items.at(3) );
+    QVERIFY( item );
+    QCOMPARE( item->getKey(), items.at(3) );
+    QCOMPARE( prefetcher.iItemIdList.count(), 1 );
+    QCOMPARE( prefetcher.iFetchedItems.count(), 1 );
+    delete item;
+
+    item = prefetcher.getItem( items.at(2) );
+    QVERIFY( item );
+    QCOMPARE( prefetcher.iFetchedBytes, Q_INT64_C( 0 ) );
+    delete item;
+
+    item = prefetcher.getItem( items.at(4) );
+    QVERIFY( item );
+    QCOMPARE( prefetcher.iItemIdList.count(), 0 );
+    QCOMPARE( prefetcher.iFetchedItems.count(), 0 );
+    delete item;
+
+    PrefetchStatistics statistics = prefetcher.statistics();
+    QCOMPARE( statistics.iHits, 2 );
+    QCOMPARE( statistics.iStalls, 3 );
+}
+
+void SyncItemPrefetcherTest::testBackgroundFetching()
+{
+    // Test item prefetcher fetching items in a background thread
+
+    QList<SyncItemKey> items;
+    for( int i = 0; i < 20; ++i )
+    {
+        items.append( QString::number( i + 1 ) );
+    }
+    const int batchSizeHint = 4;
+
+    ConcurrentPrefetchStorage storage( items );
+    storage.setItemSize( 10 );
+
+    {
+        SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+        prefetcher.setMemoryBudget( 25 );
+        QVERIFY( prefetcher.startBackgroundFetching() );
+
+        // Items are requested out of order, too
+        SyncItem* item = prefetcher.getItem( items.at(5) );
+        QVERIFY( item );
+        QCOMPARE( item->getKey(), items.at(5) );
+        delete item;
+
+        for( int i = 0; i < items.count(); ++i )
+        {
+            if( i == 5 )
+            {
+                continue;
+            }
+
+            item = prefetcher.getItem( items.at(i) );
+            QVERIFY( item );
+            QCOMPARE( item->getKey(), items.at(i) );
+
+            if( i == 8 )
+            {
+                // Peeked item is kept for retrieval
+                const SyncItem* peeked = prefetcher.peekItem( items.at(i + 1) );
+                QVERIFY( peeked );
+                QCOMPARE( peeked->getKey(), items.at(i + 1) );
+            }
+
+            if( i == 10 )
+            {
+                // Returned item is given out again
+                prefetcher.returnItem( items.at(i), item );
+                QCOMPARE( prefetcher.getItem( items.at(i) ), item );
+            }
+
+            delete item;
+        }
+
+        QVERIFY( !prefetcher.getItem( "unknown" ) );
+
+        PrefetchStatistics statistics = prefetcher.statistics();
+        QCOMPARE( statistics.iHits + statistics.iStalls, items.count() + 1 );
+    }
+
+    {
+        // Prefetcher is destroyed while items are still being fetched
+        SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+        QVERIFY( prefetcher.startBackgroundFetching() );
+
+        SyncItem* item = prefetcher.getItem( items.at(0) );
+        QVERIFY( item );
+        delete item;
+    }
+}
+
+void SyncItemPrefetcherTest::testBackgroundFetchingUnsupported()
+{
+    // Test that items of a plugin that does not support being read from
+    // another thread are fetched in the foreground
+
+    QList<SyncItemKey> items;
+    items.append( "1" );
+    items.append( "2" );
+    items.append( "3" );
+    const int batchSizeHint = 2;
+
+    PrefetchStorage storage( items );
+
+    SyncItemPrefetcher prefetcher( items, storage, batchSizeHint );
+    QVERIFY( !prefetcher.startBackgroundFetching() );
+    QVERIFY( !prefetcher.iFetchThread );
+
+    for( int i = 0; i < items.count(); ++i )
+    {
+        SyncItem* item = prefetcher.getItem( items.at(i) );
+        QVERIFY( item );
+        QCOMPARE( item->getKey(), items.at(i) );
+        delete item;
+    }
+
+    PrefetchStatistics statistics = prefetcher.statistics();
+    QCOMPARE( statistics.iHits, 1 );
+    QCOMPARE( statistics.iStalls, 2 );
+}
 
 QTEST_MAIN(SyncItemPrefetcherTest)
@@ -36,6 +36,7 @@
 #include <QObject>
 
 #include "StoragePlugin.h"
+#include "ConcurrentFetchStoragePlugin.h"
 
 using namespace DataSync;
 
@@ -47,6 +48,8 @@ public:
 
     void forceSyncItems( const QList<SyncItem*> aSyncItems );
 
+    void setItemSize( int aItemSize );
+
     virtual const QString& getSourceURI() const;
 
     virtual qint64 getMaxObjSize() const;
@@ -85,6 +88,14 @@ private:
     bool                        iForceSyncItems;
     QList<SyncItem*>            iSyncItems;
 
+    int                         iItemSize;
+
+};
+
+class ConcurrentPrefetchStorage : public PrefetchStorage, public ConcurrentFetchStoragePlugin
+{
+public:
+    ConcurrentPrefetchStorage( const QList<SyncItemKey>& aItemIds ) : PrefetchStorage( aItemIds ) { }
 };
 
 class SyncItemPrefetcherTest : public QObject
@@ -99,6 +110,12 @@ private slots:
     void testAbnormalBadItems();
     void testAbnormalBadItemCount();
 
+    void testStatistics();
+    void testPeekItem();
+    void testMemoryBudget();
+    void testBackgroundFetching();
+    void testBackgroundFetchingUnsupported();
+
 };
 
 #endif // SYNCITEMPREFETCHERTEST_H
@@ -91,6 +91,19 @@ void SyncResultsTest::testAddProcessedItem()
     iSyncResults->addProcessedItem(modType, modBase, database);
 }
 
+void SyncResultsTest::testAddPrefetchStatistics()
+{
+    QString database = "bar";
+
+    iSyncResults->addPrefetchStatistics( database, 5, 2, 30 );
+    iSyncResults->addPrefetchStatistics( database, 1, 1, 10 );
+
+    DatabaseResults results = iSyncResults->getDatabaseResults()->value( database );
+    QCOMPARE( results.iPrefetchHits, 6 );
+    QCOMPARE( results.iPrefetchStalls, 3 );
+    QCOMPARE( results.iPrefetchStallTime, Q_INT64_C( 40 ) );
+}
+
 
 
 QTEST_MAIN(DataSync::SyncResultsTest)
@@ -51,6 +51,7 @@ namespace DataSync {
             void testGetLastState();
             void testGetLastErrorString();
             void testAddProcessedItem();
+            void testAddPrefetchStatistics();
         
         private:
             SyncResults* iSyncResults;
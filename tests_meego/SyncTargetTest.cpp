@@ -95,4 +95,149 @@ void SyncTargetTest::testSetRefreshFromClient()
     QCOMPARE( iSyncTarget->setRefreshFromClient(), false );
 }
 
+void SyncTargetTest::testUIDMappings()
+{
+    const SyncMode syncMode;
+    SyncTarget target( NULL, iStorage, syncMode, "fooanchor" );
+
+    UIDMapping first;
+    first.iRemoteUID = "remote1";
+    first.iLocalUID = "local1";
+    target.addUIDMapping( first );
+
+    UIDMapping second;
+    second.iRemoteUID = "remote2";
+    second.iLocalUID = "local2";
+    target.addUIDMapping( second );
+
+    // Duplicate of a remote UID does not replace the existing mapping
+    UIDMapping duplicate;
+    duplicate.iRemoteUID = "remote1";
+    duplicate.iLocalUID = "local3";
+    target.addUIDMapping( duplicate );
+
+    QCOMPARE( target.mapToLocalUID( "remote1" ), SyncItemKey( "local1" ) );
+    QCOMPARE( target.mapToLocalUID( "remote2" ), SyncItemKey( "local2" ) );
+    QCOMPARE( target.mapToRemoteUID( "local1" ), QString( "remote1" ) );
+    QCOMPARE( target.mapToRemoteUID( "local3" ), QString( "remote1" ) );
+    QVERIFY( target.mapToLocalUID( "remote4" ).isEmpty() );
+    QVERIFY( target.mapToRemoteUID( "local4" ).isEmpty() );
+
+    // Removing a mapping reveals the duplicate
+    target.removeUIDMapping( "local1" );
+    QCOMPARE( target.getUIDMappings().count(), 2 );
+    QVERIFY( target.mapToRemoteUID( "local1" ).isEmpty() );
+    QCOMPARE( target.mapToLocalUID( "remote1" ), SyncItemKey( "local3" ) );
+
+    target.removeUIDMapping( "local4" );
+    QCOMPARE( target.getUIDMappings().count(), 2 );
+
+    target.removeUIDMapping( "local3" );
+    QVERIFY( target.mapToLocalUID( "remote1" ).isEmpty() );
+    QCOMPARE( target.mapToLocalUID( "remote2" ), SyncItemKey( "local2" ) );
+
+    target.clearUIDMappings();
+    QVERIFY( target.getUIDMappings().isEmpty() );
+    QVERIFY( target.mapToLocalUID( "remote2" ).isEmpty() );
+    QVERIFY( target.mapToRemoteUID( "local2" ).isEmpty() );
+}
+
+void SyncTargetTest::testUIDMappingRemoval()
+{
+    const SyncMode syncMode;
+    SyncTarget target( NULL, iStorage, syncMode, "fooanchor" );
+
+    const int count = 100;
+
+    for( int i = 0; i < count; ++i ) {
+        UIDMapping mapping;
+        mapping.iRemoteUID = QString( "remote%1" ).arg( i );
+        mapping.iLocalUID = QString( "local%1" ).arg( i );
+        target.addUIDMapping( mapping );
+    }
+
+    // Duplicate of a local UID does not replace the existing mapping
+    UIDMapping duplicate;
+    duplicate.iRemoteUID = "remoteDuplicate";
+    duplicate.iLocalUID = "local1";
+    target.addUIDMapping( duplicate );
+
+    QCOMPARE( target.mapToRemoteUID( "local1" ), QString( "remote1" ) );
+    QCOMPARE( target.mapToLocalUID( "remoteDuplicate" ), SyncItemKey( "local1" ) );
+
+    // Removing every other mapping keeps the rest and their order
+    for( int i = 0; i < count; i += 2 ) {
+        target.removeUIDMapping( QString( "local%1" ).arg( i ) );
+        QVERIFY( target.mapToRemoteUID( QString( "local%1" ).arg( i ) ).isEmpty() );
+        QVERIFY( target.mapToLocalUID( QString( "remote%1" ).arg( i ) ).isEmpty() );
+    }
+
+    for( int i = 1; i < count; i += 2 ) {
+        QCOMPARE( target.mapToRemoteUID( QString( "local%1" ).arg( i ) ), QString( "remote%1" ).arg( i ) );
+        QCOMPARE( target.mapToLocalUID( QString( "remote%1" ).arg( i ) ), SyncItemKey( QString( "local%1" ).arg( i ) ) );
+    }
+
+    const QList<UIDMapping>& mappings = target.getUIDMappings();
+    QCOMPARE( mappings.count(), count / 2 + 1 );
+
+    for( int i = 0; i < count / 2; ++i ) {
+        QCOMPARE( mappings[i].iLocalUID, SyncItemKey( QString( "local%1" ).arg( 2 * i + 1 ) ) );
+    }
+
+    QCOMPARE( mappings.last().iRemoteUID, QString( "remoteDuplicate" ) );
+
+    // Removing the first mapping of a local UID reveals the duplicate
+    target.removeUIDMapping( "local1" );
+    QCOMPARE( target.mapToRemoteUID( "local1" ), QString( "remoteDuplicate" ) );
+    QVERIFY( target.mapToLocalUID( "remote1" ).isEmpty() );
+    QCOMPARE( target.mapToLocalUID( "remoteDuplicate" ), SyncItemKey( "local1" ) );
+
+    target.removeUIDMapping( "local1" );
+    QVERIFY( target.mapToRemoteUID( "local1" ).isEmpty() );
+    QVERIFY( target.mapToLocalUID( "remoteDuplicate" ).isEmpty() );
+    QCOMPARE( target.getUIDMappings().count(), count / 2 - 1 );
+}
+
+void SyncTargetTest::benchmarkUIDMappingLookup_data()
+{
+    QTest::addColumn<int>( "mappings" );
+
+    QTest::newRow( "1000" ) << 1000;
+    QTest::newRow( "10000" ) << 10000;
+    QTest::newRow( "100000" ) << 100000;
+}
+
+void SyncTargetTest::benchmarkUIDMappingLookup()
+{
+    // Lookups with different numbers of mappings
+    QFETCH( int, mappings );
+
+    const int lookups = 1000;
+    const SyncMode syncMode;
+    SyncTarget target( NULL, iStorage, syncMode, "fooanchor" );
+
+    for( int i = 0; i < mappings; ++i ) {
+        UIDMapping mapping;
+        mapping.iRemoteUID = QString( "remote%1" ).arg( i );
+        mapping.iLocalUID = QString( "local%1" ).arg( i );
+        target.addUIDMapping( mapping );
+    }
+
+    QStringList remoteUIDs;
+    QStringList localUIDs;
+
+    for( int i = 0; i < lookups; ++i ) {
+        int index = ( i * 7919 ) % mappings;
+        remoteUIDs.append( QString( "remote%1" ).arg( index ) );
+        localUIDs.append( QString( "local%1" ).arg( index ) );
+    }
+
+    QBENCHMARK {
+        for( int i = 0; i < lookups; ++i ) {
+            QCOMPARE( target.mapToLocalUID( remoteUIDs[i] ), localUIDs[i] );
+            QCOMPARE( target.mapToRemoteUID( localUIDs[i] ), remoteUIDs[i] );
+        }
+    }
+}
+
 QTEST_MAIN(DataSync::SyncTargetTest)
@@ -56,6 +56,11 @@ class SyncTargetTest: public QObject {
         void testReverted();
         void testClearUIDMappings();
         void testSetRefreshFromClient();
+        void testUIDMappings();
+        void testUIDMappingRemoval();
+
+        void benchmarkUIDMappingLookup_data();
+        void benchmarkUIDMappingLookup();
 
     private:
         StoragePlugin* iStorage;
@@ -8,7 +8,9 @@ SUBDIRS = \
     ConflictResolverTest.pro \
     DevInfHandlerTest.pro \
     DevInfPackageTest.pro \
+    DevInfStorageTest.pro \
     FinalPackageTest.pro \
+    ItemReferenceIndexTest.pro \
     ChangeLogTest.pro \
     LocalChangesPackageTest.pro \
     LocalMappingsPackageTest.pro \
@@ -0,0 +1,283 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "MessageSizerTest.h"
+
+#include <QtTest>
+
+#include "MessageSizer.h"
+#include "QtEncoder.h"
+#include "WbXMLEncoder.h"
+#include "SyncMLMessage.h"
+#include "SyncMLStatus.h"
+#include "SyncMLSync.h"
+#include "SyncMLAdd.h"
+#include "SyncMLItem.h"
+#include "Fragments.h"
+#include "datatypes.h"
+
+using namespace DataSync;
+
+namespace {
+
+HeaderParams createHeader()
+{
+    HeaderParams header;
+    header.sessionID = "1230022352";
+    header.msgID = 3;
+    header.targetDevice = "http://www.syncml.org/sync-server";
+    header.sourceDevice = "IMEI:493005100592800";
+    return header;
+}
+
+SyncMLMessage* createMessage( SyncMLSync*& aSync, SyncMLAdd*& aLastAdd )
+{
+    SyncMLMessage* message = new SyncMLMessage( createHeader(), SYNCML_1_2 );
+
+    aSync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+
+    for( int i = 0; i < 3; ++i ) {
+        aLastAdd = new SyncMLAdd( message->getNextCmdId() );
+        aLastAdd->addMimeMetadata( "text/x-vcard" );
+        SyncMLItem* item = new SyncMLItem();
+        item->insertSource( QString::number( 2000 + i ) );
+        item->insertData( QByteArray( "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4;<A&B>\r\nEND:VCARD\r\n" ) );
+        aLastAdd->addChild( item );
+        aSync->addChild( aLastAdd );
+    }
+
+    message->addToBody( aSync );
+
+    return message;
+}
+
+bool encode( const SyncMLMessage& aMessage, bool aWbXML, QByteArray& aData )
+{
+    if( aWbXML ) {
+        WbXMLEncoder encoder;
+        return encoder.encodeToWbXML( aMessage, SYNCML_1_2, aData );
+    }
+    else {
+        QtEncoder encoder;
+        return encoder.encodeToXML( aMessage, aData, false );
+    }
+}
+
+}
+
+void MessageSizerTest::testAppendSize_data()
+{
+    QTest::addColumn<bool>( "wbxml" );
+
+    QTest::newRow( "XML" ) << false;
+    QTest::newRow( "WbXML" ) << true;
+}
+
+void MessageSizerTest::testAppendSize()
+{
+    QFETCH( bool, wbxml );
+
+    HeaderParams header;
+    header.sessionID = "1230022352";
+    header.msgID = 3;
+    header.targetDevice = "http://www.syncml.org/sync-server";
+    header.sourceDevice = "IMEI:493005100592800";
+
+    SyncMLMessage message( header, SYNCML_1_2 );
+    MessageSizer sizer( wbxml, SYNCML_1_2 );
+
+    int expected = sizer.messageSize( message );
+    QVERIFY( expected > 0 );
+
+    // Body turns from an empty element to one with content
+    StatusParams params;
+    params.cmdId = message.getNextCmdId();
+    params.msgRef = 2;
+    params.cmdRef = 0;
+    params.cmd = SYNCML_ELEMENT_SYNCHDR;
+    params.data = SUCCESS;
+    SyncMLStatus* status = new SyncMLStatus( params );
+
+    expected += sizer.appendSize( message.getBody(), *status );
+    message.addToBody( status );
+    QCOMPARE( sizer.messageSize( message ), expected );
+
+    SyncMLSync* sync = new SyncMLSync( message.getNextCmdId(), "./contacts", "./card" );
+    expected += sizer.appendSize( message.getBody(), *sync );
+    message.addToBody( sync );
+    QCOMPARE( sizer.messageSize( message ), expected );
+
+    // Meta of the commands is on another code page in WbXML
+    for( int i = 0; i < 5; ++i ) {
+        SyncMLAdd* add = new SyncMLAdd( message.getNextCmdId() );
+        add->addMimeMetadata( "text/x-vcard" );
+        SyncMLItem* item = new SyncMLItem();
+        item->insertSource( QString::number( 2000 + i ) );
+        item->insertData( QByteArray( "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4;<A&B>\r\nEND:VCARD\r\n" ) );
+        add->addChild( item );
+
+        QCOMPARE( sizer.appendSize( *sync, *add ), sizer.elementSize( *add ) );
+        expected += sizer.elementSize( *add );
+        sync->addChild( add );
+        QCOMPARE( sizer.messageSize( message ), expected );
+    }
+
+    QByteArray data;
+    if( wbxml ) {
+        WbXMLEncoder encoder;
+        QVERIFY( encoder.encodeToWbXML( message, SYNCML_1_2, data ) );
+    }
+    else {
+        QtEncoder encoder;
+        QVERIFY( encoder.encodeToXML( message, data, false ) );
+    }
+
+    QCOMPARE( data.size(), expected );
+}
+
+void MessageSizerTest::testUnknownElement()
+{
+    MessageSizer sizer( true, SYNCML_1_2 );
+    SyncMLCmdObject unknown( "Unknown", "value" );
+
+    QCOMPARE( sizer.elementSize( unknown ), -1 );
+
+    SyncMLMessage message( HeaderParams(), SYNCML_1_2 );
+    QCOMPARE( sizer.appendSize( message.getBody(), unknown ), -1 );
+}
+
+void MessageSizerTest::testEncodingReused_data()
+{
+    QTest::addColumn<bool>( "wbxml" );
+
+    QTest::newRow( "XML" ) << false;
+    QTest::newRow( "WbXML" ) << true;
+}
+
+void MessageSizerTest::testEncodingReused()
+{
+    QFETCH( bool, wbxml );
+
+    MessageSizer sizer( wbxml, SYNCML_1_2 );
+
+    SyncMLSync* referenceSync = 0;
+    SyncMLAdd* referenceAdd = 0;
+    QScopedPointer<SyncMLMessage> reference( createMessage( referenceSync, referenceAdd ) );
+    QByteArray expected;
+    QVERIFY( encode( *reference, wbxml, expected ) );
+
+    // Measured commands keep their encoding, and the message is written
+    // using it
+    SyncMLSync* sync = 0;
+    SyncMLAdd* add = 0;
+    QScopedPointer<SyncMLMessage> message( createMessage( sync, add ) );
+
+    int size = sizer.elementSize( *add );
+    QVERIFY( size > 0 );
+    QCOMPARE( add->getEncoding( wbxml, SYNCML_1_2 ).size(), size );
+    QVERIFY( add->getEncoding( !wbxml, SYNCML_1_2 ).isEmpty() );
+
+    QByteArray data;
+    QVERIFY( encode( *message, wbxml, data ) );
+    QCOMPARE( data, expected );
+
+    // Modifying the command discards the encoding of the command and of
+    // the elements containing it
+    QVERIFY( sizer.elementSize( *sync ) > size );
+    QVERIFY( !sync->getEncoding( wbxml, SYNCML_1_2 ).isEmpty() );
+
+    SyncMLItem* item = new SyncMLItem();
+    item->insertSource( "3000" );
+    add->addChild( item );
+
+    QVERIFY( add->getEncoding( wbxml, SYNCML_1_2 ).isEmpty() );
+    QVERIFY( sync->getEncoding( wbxml, SYNCML_1_2 ).isEmpty() );
+
+    SyncMLItem* referenceItem = new SyncMLItem();
+    referenceItem->insertSource( "3000" );
+    referenceAdd->addChild( referenceItem );
+
+    expected.clear();
+    QVERIFY( encode( *reference, wbxml, expected ) );
+    data.clear();
+    QVERIFY( encode( *message, wbxml, data ) );
+    QCOMPARE( data, expected );
+    QCOMPARE( sizer.elementSize( *add ), size + sizer.elementSize( *item ) );
+}
+
+void MessageSizerTest::testChildrenSize_data()
+{
+    QTest::addColumn<bool>( "wbxml" );
+
+    QTest::newRow( "XML" ) << false;
+    QTest::newRow( "WbXML" ) << true;
+}
+
+void MessageSizerTest::testChildrenSize()
+{
+    QFETCH( bool, wbxml );
+
+    MessageSizer sizer( wbxml, SYNCML_1_2 );
+
+    SyncMLMessage message( createHeader(), SYNCML_1_2 );
+
+    int size = sizer.messageSize( message );
+    QVERIFY( size > 0 );
+
+    // Children added to an empty body since the checkpoint
+    StatusParams params;
+    params.cmdId = message.getNextCmdId();
+    params.msgRef = 2;
+    params.cmdRef = 0;
+    params.cmd = SYNCML_ELEMENT_SYNCHDR;
+    params.data = SUCCESS;
+    message.addToBody( new SyncMLStatus( params ) );
+    message.addToBody( new SyncMLSync( message.getNextCmdId(), "./contacts", "./card" ) );
+
+    size += sizer.childrenSize( message.getBody(), 0 );
+    QCOMPARE( sizer.messageSize( message ), size );
+
+    int count = message.getBody().getChildren().count();
+    QCOMPARE( sizer.childrenSize( message.getBody(), count ), 0 );
+
+    message.addToBody( new SyncMLSync( message.getNextCmdId(), "./calendar", "./vcalendar" ) );
+    size += sizer.childrenSize( message.getBody(), count );
+    QCOMPARE( sizer.messageSize( message ), size );
+
+    QByteArray data;
+    QVERIFY( encode( message, wbxml, data ) );
+    QCOMPARE( data.size(), size );
+}
+
+QTEST_MAIN(MessageSizerTest)
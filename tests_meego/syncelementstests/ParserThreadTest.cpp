@@ -0,0 +1,181 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "ParserThreadTest.h"
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QBuffer>
+
+#include "ParserThread.h"
+#include "SyncMLMessageParser.h"
+#include "TestUtils.h"
+
+using namespace DataSync;
+
+void ParserThreadTest::testParseResponse()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    ParserThread thread;
+    thread.start();
+
+    QSignalSpy parsingSpy( &thread, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &thread, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    thread.parseResponse( &buffer, true );
+
+    // Device can be released as soon as the message has been passed on
+    buffer.close();
+
+    QTRY_COMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    QList<Fragment*> expected = parseDirectly( data );
+    QList<Fragment*> fragments = thread.takeFragments();
+
+    QCOMPARE( fragments.count(), expected.count() );
+    for( int i = 0; i < fragments.count(); ++i ) {
+        QCOMPARE( fragments[i]->fragmentType, expected[i]->fragmentType );
+    }
+
+    QVERIFY( thread.takeFragments().isEmpty() );
+
+    qDeleteAll( fragments );
+    qDeleteAll( expected );
+}
+
+void ParserThreadTest::testMessageQueue()
+{
+    // Fragments of a message stay apart from the next message, even if the
+    // next one is parsed before the previous fragments have been taken
+    QByteArray data1;
+    QByteArray data2;
+    QVERIFY( readFile( "data/resp.txt", data1 ) );
+    QVERIFY( readFile( "data/resp2.txt", data2 ) );
+
+    ParserThread thread;
+    thread.start();
+
+    QSignalSpy parsingSpy( &thread, SIGNAL(parsingComplete(bool)) );
+
+    QBuffer buffer1( &data1 );
+    QVERIFY( buffer1.open( QIODevice::ReadOnly ) );
+    thread.parseResponse( &buffer1, true );
+
+    QBuffer buffer2( &data2 );
+    QVERIFY( buffer2.open( QIODevice::ReadOnly ) );
+    thread.parseResponse( &buffer2, true );
+
+    QTRY_COMPARE( parsingSpy.count(), 2 );
+
+    QList<Fragment*> expected1 = parseDirectly( data1 );
+    QList<Fragment*> expected2 = parseDirectly( data2 );
+    QList<Fragment*> fragments1 = thread.takeFragments();
+    QList<Fragment*> fragments2 = thread.takeFragments();
+
+    QCOMPARE( fragments1.count(), expected1.count() );
+    QCOMPARE( fragments2.count(), expected2.count() );
+
+    qDeleteAll( fragments1 );
+    qDeleteAll( fragments2 );
+    qDeleteAll( expected1 );
+    qDeleteAll( expected2 );
+}
+
+void ParserThreadTest::testParseChunks()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    ParserThread thread;
+    thread.start();
+
+    QSignalSpy availableSpy( &thread, SIGNAL(fragmentsAvailable()) );
+    QSignalSpy parsingSpy( &thread, SIGNAL(parsingComplete(bool)) );
+
+    const int chunkSize = 64;
+
+    for( int i = 0; i < data.size(); i += chunkSize ) {
+        thread.parseChunk( data.mid( i, chunkSize ), i == 0, i + chunkSize >= data.size() );
+    }
+
+    QTRY_COMPARE( parsingSpy.count(), 1 );
+
+    // Each signal has a batch of fragments of its own
+    QList<Fragment*> fragments;
+    for( int i = 0; i < availableSpy.count(); ++i ) {
+        fragments.append( thread.takeAvailableFragments() );
+    }
+    fragments.append( thread.takeFragments() );
+
+    QList<Fragment*> expected = parseDirectly( data );
+
+    QCOMPARE( fragments.count(), expected.count() );
+
+    qDeleteAll( fragments );
+    qDeleteAll( expected );
+}
+
+void ParserThreadTest::testParsingError()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/respinvalid1.txt", data ) );
+
+    ParserThread thread;
+    thread.start();
+
+    QSignalSpy parsingSpy( &thread, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &thread, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    thread.parseResponse( &buffer, true );
+
+    QTRY_COMPARE( errorSpy.count(), 1 );
+    QCOMPARE( parsingSpy.count(), 0 );
+}
+
+QList<Fragment*> ParserThreadTest::parseDirectly( const QByteArray& aData )
+{
+    SyncMLMessageParser parser;
+    parser.parseMessage( aData, true );
+
+    return parser.takeFragments();
+}
+
+QTEST_MAIN(ParserThreadTest)
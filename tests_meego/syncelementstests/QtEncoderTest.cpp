@@ -0,0 +1,170 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "QtEncoderTest.h"
+
+#include <QtTest>
+#include <QBuffer>
+#include <QXmlStreamReader>
+
+#include "QtEncoder.h"
+#include "SyncMLCmdObject.h"
+
+using namespace DataSync;
+
+void QtEncoderTest::testDeviceEncoding()
+{
+    SyncMLCmdObject* root = createDocument( "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4;<A&B>\r\nEND:VCARD\r\n" );
+
+    QtEncoder encoder;
+
+    QByteArray reference;
+    QVERIFY( encoder.encodeToXML( *root, reference, false ) );
+
+    QBuffer buffer;
+    QVERIFY( buffer.open( QIODevice::WriteOnly ) );
+    QVERIFY( encoder.encodeToXML( *root, &buffer, false ) );
+    QCOMPARE( buffer.data(), reference );
+
+    // Encoded document is appended to existing data
+    QByteArray document( "prefix" );
+    QVERIFY( encoder.encodeToXML( *root, document, false ) );
+    QCOMPARE( document, QByteArray( "prefix" ) + reference );
+
+    // Devices that cannot be written to are rejected
+    QBuffer readOnly;
+    QVERIFY( readOnly.open( QIODevice::ReadOnly ) );
+    QVERIFY( !encoder.encodeToXML( *root, &readOnly, false ) );
+    QVERIFY( !encoder.encodeToXML( *root, static_cast<QIODevice*>( NULL ), false ) );
+
+    delete root;
+}
+
+void QtEncoderTest::testEncodedSize()
+{
+    SyncMLCmdObject* root = createDocument( "]]>\xc3\xa4]]]>" );
+
+    QtEncoder encoder;
+
+    QByteArray document;
+    QVERIFY( encoder.encodeToXML( *root, document, false ) );
+    QCOMPARE( encoder.encodedSize( *root ), document.size() );
+
+    delete root;
+}
+
+void QtEncoderTest::testCDATA_data()
+{
+    QTest::addColumn<QByteArray>( "data" );
+
+    QTest::newRow( "plain" ) << QByteArray( "BEGIN:VCARD\nEND:VCARD\n" );
+    QTest::newRow( "multibyte" ) << QByteArray( "M\xc3\xa4kel\xc3\xa4 \xe2\x82\xac \xf0\x9f\x98\x80" );
+    QTest::newRow( "markup" ) << QByteArray( "<A&B>" );
+    QTest::newRow( "terminator" ) << QByteArray( "a]]>b" );
+    QTest::newRow( "terminators" ) << QByteArray( "]]>]]]>]]>" );
+}
+
+void QtEncoderTest::testCDATA()
+{
+    QFETCH( QByteArray, data );
+
+    SyncMLCmdObject* root = createDocument( data );
+
+    QtEncoder encoder;
+    QByteArray document;
+    QVERIFY( encoder.encodeToXML( *root, document, false ) );
+
+    // Output must be identical to what QXmlStreamWriter produces for the
+    // same value
+    QByteArray reference;
+    QXmlStreamWriter writer( &reference );
+    writer.writeStartDocument();
+    writer.writeStartElement( "SyncML" );
+    writer.writeStartElement( "Data" );
+    writer.writeCDATA( QString::fromUtf8( data ) );
+    writer.writeEndElement();
+    writer.writeEmptyElement( "Final" );
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    QCOMPARE( document, reference );
+
+    // Pretty printed output carries the same data
+    QByteArray pretty;
+    QVERIFY( encoder.encodeToXML( *root, pretty, true ) );
+
+    QXmlStreamReader reader( pretty );
+    QVERIFY( reader.readNextStartElement() );
+    QVERIFY( reader.readNextStartElement() );
+    QCOMPARE( reader.name().toString(), QString( "Data" ) );
+    QCOMPARE( reader.readElementText().toUtf8(), data );
+
+    delete root;
+}
+
+void QtEncoderTest::testInvalidUtf8()
+{
+    // Chunk split in the middle of a multibyte sequence
+    SyncMLCmdObject* root = createDocument( "M\xc3\xa4kel\xc3" );
+
+    QtEncoder encoder;
+    QByteArray document;
+    QVERIFY( encoder.encodeToXML( *root, document, false ) );
+
+    // Document stays well-formed
+    QXmlStreamReader reader( document );
+    while( !reader.atEnd() ) {
+        reader.readNext();
+    }
+    QVERIFY( !reader.hasError() );
+
+    QCOMPARE( encoder.encodedSize( *root ), document.size() );
+
+    delete root;
+}
+
+SyncMLCmdObject* QtEncoderTest::createDocument( const QByteArray& aData )
+{
+    SyncMLCmdObject* root = new SyncMLCmdObject( "SyncML" );
+
+    SyncMLCmdObject* data = new SyncMLCmdObject( "Data" );
+    data->setUtf8Value( aData );
+    data->setCDATA( true );
+    root->addChild( data );
+
+    root->addChild( new SyncMLCmdObject( "Final" ) );
+
+    return root;
+}
+
+QTEST_MAIN(QtEncoderTest)
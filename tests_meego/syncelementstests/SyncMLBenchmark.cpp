@@ -0,0 +1,572 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "SyncMLBenchmark.h"
+
+#include <QTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+
+#include "SyncMLMessageParser.h"
+#include "QtEncoder.h"
+#include "LibWbXML2Encoder.h"
+#include "WbXMLEncoder.h"
+#include "ResponseGenerator.h"
+#include "LocalChangesPackage.h"
+#include "SyncMLMessage.h"
+#include "SyncMLStatus.h"
+#include "SyncMLSync.h"
+#include "SyncMLReplace.h"
+#include "SyncMLItem.h"
+#include "SyncMLPut.h"
+#include "DeviceInfo.h"
+#include "Mock.h"
+
+using namespace DataSync;
+
+namespace {
+
+/*! \brief Storage that advertises a CTCap with the given number of properties
+ *
+ */
+class LargeCTCapStorage : public MockStorage
+{
+public:
+    LargeCTCapStorage( const QString& aURI, int aProperties )
+     : MockStorage( aURI, "text/x-vcard", "2.1" ), iProperties( aProperties )
+    {
+    }
+
+    virtual QByteArray getPluginCTCaps( ProtocolVersion /*aVersion*/ ) const
+    {
+        QByteArray ctCaps( "<CTCaps><CTCap><CTType>text/x-vcard</CTType><VerCT>2.1</VerCT>" );
+
+        for( int i = 0; i < iProperties; ++i ) {
+            ctCaps.append( "<Property><PropName>X-PROPERTY-" + QByteArray::number( i ) + "</PropName>"
+                           "<DataType>chr</DataType><MaxOccur>1</MaxOccur><MaxSize>255</MaxSize>"
+                           "<ValEnum>HOME</ValEnum><ValEnum>WORK</ValEnum><ValEnum>CELL</ValEnum>"
+                           "<PropParam><ParamName>TYPE</ParamName><ValEnum>PREF</ValEnum></PropParam>"
+                           "</Property>" );
+        }
+
+        ctCaps.append( "</CTCap></CTCaps>" );
+        return ctCaps;
+    }
+
+private:
+    int iProperties;
+};
+
+HeaderParams createMessageHeader()
+{
+    HeaderParams headerParams;
+    headerParams.verDTD = SYNCML_DTD_VERSION_1_2;
+    headerParams.verProto = DS_VERPROTO_1_2;
+    headerParams.sessionID = "1230022352";
+    headerParams.msgID = 3;
+    headerParams.targetDevice = "http://www.example.com/sync";
+    headerParams.sourceDevice = "IMEI:493005100592800";
+    headerParams.meta.maxMsgSize = 16384;
+    headerParams.meta.maxObjSize = 500000;
+
+    return headerParams;
+}
+
+SyncMLMessage* createMessage()
+{
+    return new SyncMLMessage( createMessageHeader(), SYNCML_1_2 );
+}
+
+QByteArray vCard( int aIndex )
+{
+    return "BEGIN:VCARD\r\nVERSION:2.1\r\n"
+           "N:Lastname" + QByteArray::number( aIndex ) + ";Firstname\r\n"
+           "TEL;CELL:+35840" + QByteArray::number( 1000000 + aIndex ) + "\r\n"
+           "EMAIL;INTERNET:user" + QByteArray::number( aIndex ) + "@example.com\r\n"
+           "NOTE:<A&B>\r\nEND:VCARD\r\n";
+}
+
+/*! \brief Storage that returns a vCard for every numeric key
+ *
+ */
+class VCardStorage : public MockStorage
+{
+public:
+    explicit VCardStorage( const QString& aURI )
+     : MockStorage( aURI, "text/x-vcard", "2.1" )
+    {
+    }
+
+    virtual SyncItem* getSyncItem( const SyncItemKey& aKey )
+    {
+        MockSyncItem* item = new MockSyncItem( aKey );
+        item->setType( "text/x-vcard" );
+        item->write( 0, vCard( aKey.toInt() ) );
+        return item;
+    }
+};
+
+SyncMLMessage* createSyncMessage( int aItems )
+{
+    SyncMLMessage* message = createMessage();
+
+    SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+    sync->addNumberOfChanges( aItems );
+
+    for( int i = 0; i < aItems; ++i ) {
+        SyncMLReplace* replace = new SyncMLReplace( message->getNextCmdId() );
+        replace->addMimeMetadata( "text/x-vcard" );
+        SyncMLItem* item = new SyncMLItem();
+        item->insertSource( QString::number( 1000 + i ) );
+        item->insertTarget( QString::number( 2000 + i ) );
+        item->insertData( vCard( i ) );
+        replace->addChild( item );
+        sync->addChild( replace );
+    }
+
+    message->addToBody( sync );
+    message->addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
+SyncMLMessage* createStatusMessage( int aStatuses )
+{
+    SyncMLMessage* message = createMessage();
+
+    for( int i = 0; i < aStatuses; ++i ) {
+        StatusParams status;
+        status.cmdId = message->getNextCmdId();
+        status.msgRef = 2;
+        status.cmdRef = i + 1;
+        status.cmd = SYNCML_ELEMENT_REPLACE;
+        status.targetRef = QString::number( 2000 + i );
+        status.sourceRef = QString::number( 1000 + i );
+        status.data = SUCCESS;
+        message->addToBody( new SyncMLStatus( status ) );
+    }
+
+    message->addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
+SyncMLMessage* createLargeObjectMessage( int aChunkSize )
+{
+    SyncMLMessage* message = createMessage();
+
+    SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+    SyncMLReplace* replace = new SyncMLReplace( message->getNextCmdId() );
+    replace->addMimeMetadata( "text/x-vcard" );
+    replace->addSizeMetadata( aChunkSize * 4 );
+
+    QByteArray data( "BEGIN:VCARD\r\nVERSION:2.1\r\nPHOTO;ENCODING=BASE64:\r\n" );
+    const QByteArray line( " /9j/4AAQSkZJRgABAQEASABIAAD/2wBDAAYEBQYFBAYGBQYHBwYIChAKCgkJChQODwwQFxQYGBcU\r\n" );
+    while( data.size() + line.size() <= aChunkSize ) {
+        data.append( line );
+    }
+
+    SyncMLItem* item = new SyncMLItem();
+    item->insertSource( "1000" );
+    item->insertTarget( "2000" );
+    item->insertData( data );
+    item->insertMoreData();
+    replace->addChild( item );
+    sync->addChild( replace );
+
+    message->addToBody( sync );
+    message->addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
+SyncMLMessage* createDevInfMessage( int aProperties )
+{
+    SyncMLMessage* message = createMessage();
+
+    DeviceInfo deviceInfo;
+    deviceInfo.setManufacturer( "FooManufacturer" );
+    deviceInfo.setModel( "FooModel" );
+    deviceInfo.setDeviceID( "IMEI:493005100592800" );
+    deviceInfo.setDeviceType( "phone" );
+
+    LargeCTCapStorage contacts( "./contacts", aProperties );
+    LargeCTCapStorage calendar( "./calendar", aProperties );
+    QList<StoragePlugin*> storages;
+    storages.append( &contacts );
+    storages.append( &calendar );
+
+    message->addToBody( new SyncMLPut( message->getNextCmdId(), storages, deviceInfo,
+                                       SYNCML_1_2, ROLE_CLIENT ) );
+    message->addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
+}
+
+void SyncMLBenchmark::initTestCase()
+{
+    addCorpus( "sync-10", createSyncMessage( 10 ), 10 );
+    addCorpus( "sync-100", createSyncMessage( 100 ), 100 );
+    addCorpus( "sync-1000", createSyncMessage( 1000 ), 1000 );
+    addCorpus( "sync-10000", createSyncMessage( 10000 ), 10000 );
+    addCorpus( "status-1000", createStatusMessage( 1000 ), 1000 );
+    addCorpus( "status-10000", createStatusMessage( 10000 ), 10000 );
+    addCorpus( "largeobject-64k", createLargeObjectMessage( 64 * 1024 ), 1 );
+    addCorpus( "largeobject-512k", createLargeObjectMessage( 512 * 1024 ), 1 );
+    addCorpus( "devinf-500", createDevInfMessage( 500 ), 2 * 500 );
+}
+
+void SyncMLBenchmark::cleanupTestCase()
+{
+    writeResults();
+
+    foreach( const Corpus& corpus, iCorpora ) {
+        delete corpus.message;
+    }
+    iCorpora.clear();
+}
+
+void SyncMLBenchmark::benchmarkParseXML_data()
+{
+    addCorpusRows();
+}
+
+void SyncMLBenchmark::benchmarkParseXML()
+{
+    QFETCH( int, corpus );
+    const Corpus& data = iCorpora[corpus];
+
+    QByteArray xml( data.xml );
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        QBuffer buffer( &xml );
+        buffer.open( QIODevice::ReadOnly );
+        SyncMLMessageParser parser;
+        parser.parseResponse( &buffer, true );
+        qDeleteAll( parser.takeFragments() );
+        ++iterations;
+    }
+
+    record( data.items, xml.size(), iterations, timer.nsecsElapsed() );
+}
+
+void SyncMLBenchmark::benchmarkEncodeXML_data()
+{
+    addCorpusRows();
+}
+
+void SyncMLBenchmark::benchmarkEncodeXML()
+{
+    QFETCH( int, corpus );
+    const Corpus& data = iCorpora[corpus];
+
+    QtEncoder encoder;
+    QByteArray xml;
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        xml.clear();
+        encoder.encodeToXML( *data.message, xml, false );
+        ++iterations;
+    }
+
+    record( data.items, xml.size(), iterations, timer.nsecsElapsed() );
+}
+
+void SyncMLBenchmark::benchmarkEncodeWbXML_data()
+{
+    addCorpusRows();
+}
+
+void SyncMLBenchmark::benchmarkEncodeWbXML()
+{
+    QFETCH( int, corpus );
+    const Corpus& data = iCorpora[corpus];
+
+    LibWbXML2Encoder encoder;
+    QByteArray wbxml;
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        wbxml.clear();
+        encoder.encodeToWbXML( *data.message, SYNCML_1_2, wbxml );
+        ++iterations;
+    }
+
+    record( data.items, wbxml.size(), iterations, timer.nsecsElapsed() );
+}
+
+void SyncMLBenchmark::benchmarkDecodeWbXML_data()
+{
+    addCorpusRows();
+}
+
+void SyncMLBenchmark::benchmarkDecodeWbXML()
+{
+    QFETCH( int, corpus );
+    const Corpus& data = iCorpora[corpus];
+
+    LibWbXML2Encoder encoder;
+    QByteArray xml;
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        xml.clear();
+        encoder.decodeFromWbXML( data.wbxml, xml, false );
+        ++iterations;
+    }
+
+    record( data.items, data.wbxml.size(), iterations, timer.nsecsElapsed() );
+}
+
+void SyncMLBenchmark::benchmarkCalculateSize_data()
+{
+    QTest::addColumn<int>( "corpus" );
+    QTest::addColumn<bool>( "wbxml" );
+
+    for( int i = 0; i < iCorpora.count(); ++i ) {
+        QTest::newRow( qPrintable( iCorpora[i].name + "/xml" ) ) << i << false;
+        QTest::newRow( qPrintable( iCorpora[i].name + "/wbxml" ) ) << i << true;
+    }
+}
+
+void SyncMLBenchmark::benchmarkCalculateSize()
+{
+    QFETCH( int, corpus );
+    QFETCH( bool, wbxml );
+    const Corpus& data = iCorpora[corpus];
+
+    int size = 0;
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        size = data.message->calculateSize( wbxml, SYNCML_1_2 );
+        ++iterations;
+    }
+
+    QVERIFY( size > 0 );
+    record( data.items, wbxml ? data.wbxml.size() : data.xml.size(), iterations, timer.nsecsElapsed() );
+}
+
+void SyncMLBenchmark::benchmarkPacking_data()
+{
+    QTest::addColumn<int>( "items" );
+    QTest::addColumn<int>( "maxMsgSize" );
+    QTest::addColumn<bool>( "wbxml" );
+    QTest::addColumn<bool>( "exact" );
+
+    const int items[] = { 1000, 10000 };
+
+    for( unsigned i = 0; i < sizeof( items ) / sizeof( items[0] ); ++i ) {
+        const QByteArray name = QByteArray::number( items[i] );
+        QTest::newRow( name + "/xml/estimated" ) << items[i] << 16384 << false << false;
+        QTest::newRow( name + "/xml/exact" ) << items[i] << 16384 << false << true;
+        QTest::newRow( name + "/wbxml/estimated" ) << items[i] << 8192 << true << false;
+        QTest::newRow( name + "/wbxml/exact" ) << items[i] << 8192 << true << true;
+    }
+}
+
+void SyncMLBenchmark::benchmarkPacking()
+{
+    QFETCH( int, items );
+    QFETCH( int, maxMsgSize );
+    QFETCH( bool, wbxml );
+    QFETCH( bool, exact );
+
+    qint64 bytes = 0;
+    qint64 messages = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK_ONCE {
+        VCardStorage storage( "./contacts" );
+        SyncMode syncMode;
+        SyncTarget target( NULL, &storage, syncMode, "localAnchor" );
+        target.setTargetDatabase( "./card" );
+
+        LocalChanges changes;
+        for( int i = 0; i < items; ++i ) {
+            changes.added.append( QString::number( i ) );
+        }
+
+        ResponseGenerator generator;
+        generator.setHeaderParams( createMessageHeader() );
+        generator.setExactPacking( exact );
+
+        // Number of changes per message is not limited, so that only the
+        // message size limits how many changes fit in a message. Large
+        // object threshold is that of SessionHandler
+        generator.addPackage( new LocalChangesPackage( target, changes, maxMsgSize / 10,
+                                                       ROLE_CLIENT, items ) );
+
+        QtEncoder xmlEncoder;
+        WbXMLEncoder wbxmlEncoder;
+
+        while( !generator.packageQueueEmpty() ) {
+            SyncMLMessage* message = generator.generateNextMessage( maxMsgSize, SYNCML_1_2, wbxml );
+            QVERIFY( message );
+
+            QByteArray data;
+            if( wbxml ) {
+                QVERIFY( wbxmlEncoder.encodeToWbXML( *message, SYNCML_1_2, data ) );
+            }
+            else {
+                QVERIFY( xmlEncoder.encodeToXML( *message, data, false ) );
+            }
+            delete message;
+
+            QVERIFY( !exact || data.size() <= maxMsgSize );
+            bytes += data.size();
+            ++messages;
+        }
+    }
+
+    record( items, bytes, 1, timer.nsecsElapsed(), messages );
+}
+
+void SyncMLBenchmark::addCorpus( const QString& aName, SyncMLMessage* aMessage, int aItems )
+{
+    Corpus corpus;
+    corpus.name = aName;
+    corpus.message = aMessage;
+    corpus.items = aItems;
+
+    QtEncoder xmlEncoder;
+    QVERIFY( xmlEncoder.encodeToXML( *aMessage, corpus.xml, false ) );
+
+    LibWbXML2Encoder wbxmlEncoder;
+    QVERIFY( wbxmlEncoder.encodeToWbXML( *aMessage, SYNCML_1_2, corpus.wbxml ) );
+
+    iCorpora.append( corpus );
+}
+
+void SyncMLBenchmark::addCorpusRows()
+{
+    QTest::addColumn<int>( "corpus" );
+
+    for( int i = 0; i < iCorpora.count(); ++i ) {
+        QTest::newRow( qPrintable( iCorpora[i].name ) ) << i;
+    }
+}
+
+void SyncMLBenchmark::record( qint64 aItems, qint64 aBytes, qint64 aIterations, qint64 aNsecs,
+                              qint64 aMessages )
+{
+    if( aIterations <= 0 || aNsecs <= 0 ) {
+        return;
+    }
+
+    Result result;
+    result.function = QTest::currentTestFunction();
+    result.corpus = QTest::currentDataTag();
+    result.items = aItems;
+    result.bytes = aBytes;
+    result.iterations = aIterations;
+    result.nsecs = aNsecs;
+    result.messages = aMessages;
+
+    // Benchmark function can be run several times for the same data, only
+    // the last run is kept
+    iResults.insert( result.function + "/" + result.corpus, result );
+
+    const double seconds = aNsecs / 1e9;
+    qDebug( "%s %s: %.0f items/s, %.0f bytes/s", qPrintable( result.function ),
+            qPrintable( result.corpus ), aItems * aIterations / seconds,
+            aBytes * aIterations / seconds );
+
+    if( aMessages > 0 ) {
+        qDebug( "%s %s: %lld messages", qPrintable( result.function ),
+                qPrintable( result.corpus ), aMessages );
+    }
+}
+
+void SyncMLBenchmark::writeResults() const
+{
+    const QString fileName = QProcessEnvironment::systemEnvironment().value(
+        "SYNCML_BENCHMARK_RESULTS",
+        QProcessEnvironment::systemEnvironment().value( "TMPDIR", "/tmp" ) + "/SyncMLBenchmark.json" );
+
+    QJsonArray results;
+
+    foreach( const Result& result, iResults ) {
+        const double seconds = result.nsecs / 1e9;
+
+        QJsonObject object;
+        object.insert( "function", result.function );
+        object.insert( "corpus", result.corpus );
+        object.insert( "items", result.items );
+        object.insert( "bytes", result.bytes );
+        object.insert( "iterations", result.iterations );
+        object.insert( "nsecsPerIteration", double( result.nsecs ) / result.iterations );
+        object.insert( "itemsPerSecond", result.items * result.iterations / seconds );
+        object.insert( "bytesPerSecond", result.bytes * result.iterations / seconds );
+        if( result.messages > 0 ) {
+            object.insert( "messages", result.messages );
+        }
+        results.append( object );
+    }
+
+    QJsonObject document;
+    document.insert( "qtVersion", QString( qVersion() ) );
+    document.insert( "results", results );
+
+    QFile file( fileName );
+    if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        qWarning( "Could not write benchmark results to %s", qPrintable( fileName ) );
+        return;
+    }
+
+    file.write( QJsonDocument( document ).toJson() );
+    qDebug( "Benchmark results written to %s", qPrintable( fileName ) );
+}
+
+QTEST_MAIN(SyncMLBenchmark)
@@ -0,0 +1,119 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#ifndef SYNCMLBENCHMARK_H
+#define SYNCMLBENCHMARK_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QByteArray>
+
+namespace DataSync {
+class SyncMLMessage;
+}
+
+/*! \brief Benchmarks of parsing, encoding and size calculation of SyncML
+ *         messages
+ *
+ * Corpora are generated when the test case is initialized. Throughput of
+ * each benchmark is reported in items/s and bytes/s, and written as JSON
+ * to the file named by SYNCML_BENCHMARK_RESULTS environment variable, by
+ * default $TMPDIR/SyncMLBenchmark.json. Packing benchmarks also report the
+ * number of messages, that is round trips, needed to send local changes.
+ */
+class SyncMLBenchmark : public QObject
+{
+    Q_OBJECT;
+public:
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkParseXML_data();
+    void benchmarkParseXML();
+
+    void benchmarkEncodeXML_data();
+    void benchmarkEncodeXML();
+
+    void benchmarkEncodeWbXML_data();
+    void benchmarkEncodeWbXML();
+
+    void benchmarkDecodeWbXML_data();
+    void benchmarkDecodeWbXML();
+
+    void benchmarkCalculateSize_data();
+    void benchmarkCalculateSize();
+
+    void benchmarkPacking_data();
+    void benchmarkPacking();
+
+private:
+
+    struct Corpus
+    {
+        QString                 name;
+        DataSync::SyncMLMessage* message;
+        QByteArray              xml;
+        QByteArray              wbxml;
+        int                     items;
+    };
+
+    struct Result
+    {
+        QString     function;
+        QString     corpus;
+        qint64      items;
+        qint64      bytes;
+        qint64      iterations;
+        qint64      nsecs;
+        qint64      messages;
+    };
+
+    void addCorpus( const QString& aName, DataSync::SyncMLMessage* aMessage, int aItems );
+
+    void addCorpusRows();
+
+    void record( qint64 aItems, qint64 aBytes, qint64 aIterations, qint64 aNsecs,
+                 qint64 aMessages = 0 );
+
+    void writeResults() const;
+
+    QList<Corpus>           iCorpora;
+    QMap<QString, Result>   iResults;
+
+};
+
+#endif // SYNCMLBENCHMARK_H
@@ -36,6 +36,12 @@
 #include <QtTest>
 
 #include "SyncMLCmdObject.h"
+#include "SyncMLMessage.h"
+#include "SyncMLSync.h"
+#include "SyncMLReplace.h"
+#include "SyncMLItem.h"
+#include "LibWbXML2Encoder.h"
+#include "QtEncoder.h"
 
 using namespace DataSync;
 
@@ -61,6 +67,27 @@ void SyncMLCmdObjectTest::testSetGetNameValue()
 
 }
 
+void SyncMLCmdObjectTest::testSetGetUtf8Value()
+{
+    const QByteArray value( "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4\r\nEND:VCARD\r\n" );
+
+    SyncMLCmdObject obj( "objname", "objvalue" );
+
+    obj.setUtf8Value( value );
+    QVERIFY( obj.getValue().isEmpty() );
+    QCOMPARE( obj.getUtf8Value(), value );
+
+    // Payload must be shared, not copied
+    QVERIFY( obj.getUtf8Value().constData() == value.constData() );
+
+    // Size estimate counts the encoded bytes: <objname> + </objname> + value
+    QCOMPARE( obj.calculateSize( false, SYNCML_1_2 ), 5 + 2 * 7 + value.size() );
+
+    obj.setValue( "objvalue" );
+    QVERIFY( obj.getUtf8Value().isEmpty() );
+    QCOMPARE( obj.getValue(), QString( "objvalue" ) );
+}
+
 void SyncMLCmdObjectTest::testSetGetCData()
 {
     SyncMLCmdObject obj;
@@ -88,6 +115,48 @@ void SyncMLCmdObjectTest::testAddGetAttribute()
 
 }
 
+void SyncMLCmdObjectTest::testAttributeOrder()
+{
+    SyncMLCmdObject obj( "Element" );
+
+    obj.addAttribute( "b", "2" );
+    obj.addAttribute( "c", "3" );
+    obj.addAttribute( "a", "1" );
+    obj.addAttribute( "b", "4" );
+
+    // Attributes are kept sorted by name, and setting an attribute again
+    // replaces its value
+    const SyncMLAttributes& attributes = obj.getAttributes();
+    QCOMPARE( attributes.count(), 3 );
+    QCOMPARE( attributes.nameAt( 0 ), QString( "a" ) );
+    QCOMPARE( attributes.nameAt( 1 ), QString( "b" ) );
+    QCOMPARE( attributes.nameAt( 2 ), QString( "c" ) );
+    QCOMPARE( attributes.valueAt( 1 ), QString( "4" ) );
+    QVERIFY( attributes.contains( "c" ) );
+    QVERIFY( !attributes.contains( "d" ) );
+    QVERIFY( attributes.value( "d" ).isEmpty() );
+
+    QtEncoder encoder;
+    QByteArray xml;
+    QVERIFY( encoder.encodeToXML( obj, xml, false ) );
+    QVERIFY( xml.contains( "<Element a=\"1\" b=\"4\" c=\"3\"/>" ) );
+}
+
+void SyncMLCmdObjectTest::testInternedNames()
+{
+    SyncMLCmdObject item1( "Item" );
+    SyncMLCmdObject item2( "Item" );
+    SyncMLCmdObject maxObjSize( "MaxObjSize" );
+    SyncMLCmdObject other( "NotAnElement" );
+
+    QCOMPARE( item1.getName(), QString( "Item" ) );
+    QCOMPARE( maxObjSize.getName(), QString( "MaxObjSize" ) );
+    QCOMPARE( other.getName(), QString( "NotAnElement" ) );
+
+    // Known element names share the same data
+    QVERIFY( item1.getName().constData() == item2.getName().constData() );
+}
+
 void SyncMLCmdObjectTest::testAddGetChildren()
 {
 
@@ -105,4 +174,84 @@ void SyncMLCmdObjectTest::testAddGetChildren()
 
 }
 
+void SyncMLCmdObjectTest::testCalculateSize()
+{
+    SyncMLCmdObject parent( "Parent" );
+
+    // <Parent/>
+    QCOMPARE( parent.calculateSize( false, SYNCML_1_2 ), 3 + 6 );
+
+    SyncMLCmdObject* child = new SyncMLCmdObject( "Child", "abc" );
+    QCOMPARE( child->calculateSize( false, SYNCML_1_2 ), 5 + 2 * 5 + 3 );
+
+    // <Parent> + </Parent> + child
+    parent.addChild( child );
+    QCOMPARE( parent.calculateSize( false, SYNCML_1_2 ), 5 + 2 * 6 + 18 );
+
+    // Changes of attached children are reflected in the size of the parent
+    child->setValue( "abcdef" );
+    QCOMPARE( parent.calculateSize( false, SYNCML_1_2 ), 5 + 2 * 6 + 21 );
+
+    child->addAttribute( "attr", "value" );
+    QCOMPARE( parent.calculateSize( false, SYNCML_1_2 ), 5 + 2 * 6 + 21 + 1 + 4 + 2 + 5 + 1 );
+
+    SyncMLCmdObject* grandChild = new SyncMLCmdObject( "GrandChild" );
+    child->addChild( grandChild );
+    grandChild->setCDATA( true );
+    grandChild->setUtf8Value( "data" );
+    QCOMPARE( parent.calculateSize( false, SYNCML_1_2 ),
+              5 + 2 * 6 + 21 + 13 + 5 + 2 * 10 + 4 + 12 );
+
+    // Estimates match XML encoding of the same tree
+    QtEncoder encoder;
+    QByteArray xml;
+    QVERIFY( encoder.encodeToXML( parent, xml, false ) );
+    QVERIFY( qAbs( xml.size() - parent.calculateSize( false, SYNCML_1_2 ) ) < 64 );
+}
+
+void SyncMLCmdObjectTest::testCalculateSizeWbXML()
+{
+    HeaderParams headerParams;
+    headerParams.verDTD = SYNCML_DTD_VERSION_1_2;
+    headerParams.verProto = DS_VERPROTO_1_2;
+    headerParams.sessionID = "1230022352";
+    headerParams.msgID = 1;
+    headerParams.targetDevice = "http://www.example.com/sync";
+    headerParams.sourceDevice = "IMEI:493005100592800";
+
+    SyncMLMessage message( headerParams, SYNCML_1_2 );
+    SyncMLSync* sync = new SyncMLSync( message.getNextCmdId(), "./contacts", "./card" );
+    message.addToBody( sync );
+
+    int previousSize = message.calculateSize( true, SYNCML_1_2 );
+
+    for( int i = 0; i < 50; ++i ) {
+        SyncMLReplace* replace = new SyncMLReplace( message.getNextCmdId() );
+        replace->addMimeMetadata( "text/x-vcard" );
+        SyncMLItem* item = new SyncMLItem();
+        item->insertSource( QString::number( 1000 + i ) );
+        item->insertData( "BEGIN:VCARD\r\nVERSION:2.1\r\nN:Lastname;Firstname\r\n"
+                          "NOTE:" + QByteArray( i * 10, 'x' ) + "\r\nEND:VCARD\r\n" );
+        replace->addChild( item );
+
+        const int replaceSize = replace->calculateSize( true, SYNCML_1_2 );
+        sync->addChild( replace );
+
+        // Running total grows by the size of the added command
+        QCOMPARE( message.calculateSize( true, SYNCML_1_2 ), previousSize + replaceSize );
+        previousSize = message.calculateSize( true, SYNCML_1_2 );
+    }
+
+    message.addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    // Estimate is close to the actual encoded size
+    LibWbXML2Encoder encoder;
+    QByteArray wbxml;
+    QVERIFY( encoder.encodeToWbXML( message, SYNCML_1_2, wbxml ) );
+
+    const int estimate = message.calculateSize( true, SYNCML_1_2 );
+    QVERIFY2( estimate > wbxml.size() * 0.9 && estimate < wbxml.size() * 1.15,
+              qPrintable( QString( "estimate %1, actual %2" ).arg( estimate ).arg( wbxml.size() ) ) );
+}
+
 QTEST_MAIN(SyncMLCmdObjectTest)
@@ -42,9 +42,14 @@ class SyncMLCmdObjectTest: public QObject
 private slots:
 
     void testSetGetNameValue();
+    void testSetGetUtf8Value();
     void testSetGetCData();
     void testAddGetAttribute();
+    void testAttributeOrder();
+    void testInternedNames();
     void testAddGetChildren();
+    void testCalculateSize();
+    void testCalculateSizeWbXML();
 
 };
 #endif // SYNCMLCMDOBJECTTEST_H
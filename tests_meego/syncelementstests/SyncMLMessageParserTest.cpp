@@ -37,12 +37,36 @@
 #include <QSignalSpy>
 #include <QBuffer>
 
+#include <cstdlib>
+#include <new>
+
 #include "SyncMLMessageParser.h"
 #include "TestUtils.h"
 #include "RemoteDeviceInfo.h"
 
 using namespace DataSync;
 
+// Counts heap allocations made through operator new, see testFragmentAllocations()
+static QAtomicInt gHeapAllocations;
+
+void* operator new( std::size_t aSize )
+{
+    gHeapAllocations.ref();
+
+    void* ptr = std::malloc( aSize ? aSize : 1 );
+
+    if( !ptr ) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete( void* aPtr ) noexcept
+{
+    std::free( aPtr );
+}
+
 void SyncMLMessageParserTest::testResp1()
 {
 
@@ -244,7 +268,7 @@ void SyncMLMessageParserTest::verifyAdd( const DataSync::CommandParams& aData )
     QCOMPARE(aData.items.count(), 1 );
     QCOMPARE(aData.items[0].source, QString( "0" ) );
     QCOMPARE(aData.items[0].sourceParent, QString( "1" ) );
-    QCOMPARE(aData.items[0].data.simplified(), QString( "BEGIN:VCARD VERSION:2.1 N:Lahtela;Tatu;;; FN:Lahtela, Tatu TEL;TYPE=PREF:+35840 7532165 EMAIL;INTERNET:tatu.lahtela TITLE: ORG:; END:VCARD") );
+    QCOMPARE(aData.items[0].data.toByteArray().simplified(), QByteArray( "BEGIN:VCARD VERSION:2.1 N:Lahtela;Tatu;;; FN:Lahtela, Tatu TEL;TYPE=PREF:+35840 7532165 EMAIL;INTERNET:tatu.lahtela TITLE: ORG:; END:VCARD") );
 }
 
 void SyncMLMessageParserTest::verifyReplace( const DataSync::CommandParams& aData )
@@ -254,7 +278,7 @@ void SyncMLMessageParserTest::verifyReplace( const DataSync::CommandParams& aDat
     QCOMPARE(aData.items.count(), 1);
     QCOMPARE(aData.items.at(0).target,QString("244"));
     QCOMPARE(aData.items.at(0).targetParent,QString("245"));
-    QCOMPARE(aData.items.at(0).data,QString("ReplaceData"));
+    QCOMPARE(aData.items.at(0).data.toByteArray(),QByteArray("ReplaceData"));
 }
 
 
@@ -534,7 +558,7 @@ void SyncMLMessageParserTest::testEmbeddedXML()
     buffer.open( QIODevice::ReadOnly );
     buffer.seek( 0 );
     SyncMLMessageParser parser;
-    const QString expected( "<Anchor xmlns=\"syncml:metinf\"><Next>276</Next></Anchor>" );
+    const QByteArray expected( "<Anchor xmlns=\"syncml:metinf\"><Next>276</Next></Anchor>" );
 
     parser.parseResponse( &buffer, true );
     QCOMPARE( parser.iError, PARSER_ERROR_LAST );
@@ -548,7 +572,658 @@ void SyncMLMessageParserTest::testEmbeddedXML()
     QVERIFY( fragments[1]->fragmentType == Fragment::FRAGMENT_STATUS );
     StatusParams* status = static_cast<StatusParams*>( fragments[1] );
     QCOMPARE( status->items.count(), 1 );
-    QCOMPARE( status->items.first().data, expected );
+    QCOMPARE( status->items.first().data.toByteArray(), expected );
+}
+
+void SyncMLMessageParserTest::testEmbeddedXMLRaw()
+{
+    // Embedded XML is expected exactly as it appears in the message,
+    // including formatting that re-serialization would not preserve
+    const QByteArray embedded( "<Anchor xmlns='syncml:metinf'>\n"
+                               "  <Next>P\xc3\xa4iv\xc3\xa4 \xe2\x82\xac \xf0\x9f\x98\x80</Next>\n"
+                               "  <Last />\n"
+                               "</Anchor >" );
+    const QByteArray text( "N\xc3\xa4in & n\xc3\xa4in" );
+
+    QByteArray data( "\xef\xbb\xbf<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                     "<SyncML><SyncHdr></SyncHdr><SyncBody>"
+                     "<Status><CmdID>1</CmdID><MsgRef>1</MsgRef><CmdRef>1</CmdRef>"
+                     "<Cmd>Alert</Cmd><Data>200</Data><Item><Data>" );
+    data.append( embedded );
+    data.append( "</Data></Item><Item><Data>N\xc3\xa4in &amp; n\xc3\xa4in</Data></Item>"
+                 "</Status></SyncBody></SyncML>" );
+
+    for( int chunkSize = 0; chunkSize <= 7; chunkSize += 7 ) {
+
+        SyncMLMessageParser parser;
+
+        if( chunkSize == 0 ) {
+            QBuffer buffer( &data );
+            buffer.open( QIODevice::ReadOnly );
+            parser.parseResponse( &buffer, true );
+        }
+        else {
+            parseInChunks( parser, data, chunkSize );
+        }
+
+        QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+        QList<Fragment*> fragments = parser.takeFragments();
+        QCOMPARE( fragments.count(), 2 );
+        QVERIFY( fragments[1]->fragmentType == Fragment::FRAGMENT_STATUS );
+
+        StatusParams* status = static_cast<StatusParams*>( fragments[1] );
+        QCOMPARE( status->items.count(), 2 );
+        QCOMPARE( status->items[0].data.toByteArray(), embedded );
+        QCOMPARE( status->items[1].data.toByteArray(), text );
+
+        if( chunkSize == 0 ) {
+            // Slice refers to the received message instead of a copy of it
+            const char* slice = status->items[0].data.constData();
+            QVERIFY( slice >= data.constData() && slice < data.constData() + data.size() );
+        }
+
+        qDeleteAll( fragments );
+    }
+}
+
+void SyncMLMessageParserTest::testStatusRefs()
+{
+    // Status of several items may refer to them with repeated SourceRef
+    // elements instead of Item elements
+    QByteArray data( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                     "<SyncML><SyncHdr></SyncHdr><SyncBody>"
+                     "<Status><CmdID>1</CmdID><MsgRef>1</MsgRef><CmdRef>2</CmdRef>"
+                     "<Cmd>Add</Cmd><SourceRef>1</SourceRef><Data>201</Data></Status>"
+                     "<Status><CmdID>2</CmdID><MsgRef>1</MsgRef><CmdRef>3</CmdRef>"
+                     "<Cmd>Add</Cmd><SourceRef>2</SourceRef><SourceRef>3</SourceRef>"
+                     "<SourceRef>4</SourceRef><Data>201</Data></Status>"
+                     "</SyncBody></SyncML>" );
+
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+
+    SyncMLMessageParser parser;
+    parser.parseResponse( &buffer, true );
+    QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+    QList<Fragment*> fragments = parser.takeFragments();
+    QCOMPARE( fragments.count(), 3 );
+    QVERIFY( fragments[1]->fragmentType == Fragment::FRAGMENT_STATUS );
+    QVERIFY( fragments[2]->fragmentType == Fragment::FRAGMENT_STATUS );
+
+    StatusParams* single = static_cast<StatusParams*>( fragments[1] );
+    QCOMPARE( single->sourceRef, QString( "1" ) );
+    QVERIFY( single->items.isEmpty() );
+
+    StatusParams* multiple = static_cast<StatusParams*>( fragments[2] );
+    QVERIFY( multiple->sourceRef.isEmpty() );
+    QCOMPARE( multiple->items.count(), 3 );
+    QCOMPARE( multiple->items[0].source, QString( "2" ) );
+    QCOMPARE( multiple->items[1].source, QString( "3" ) );
+    QCOMPARE( multiple->items[2].source, QString( "4" ) );
+    QVERIFY( multiple->items[2].target.isEmpty() );
+
+    qDeleteAll( fragments );
+}
+
+void SyncMLMessageParserTest::testDevInfHash()
+{
+    QByteArray devInf;
+    QVERIFY( readFile( "data/devinf02.txt", devInf ) );
+    devInf = devInf.mid( devInf.indexOf( "<DevInf" ) ).trimmed();
+
+    QByteArray data( "<SyncML><SyncHdr></SyncHdr><SyncBody>"
+                     "<Put><CmdID>1</CmdID>"
+                     "<Meta><Type xmlns=\"syncml:metinf\">application/vnd.syncml-devinf+xml</Type></Meta>"
+                     "<Item><Source><LocURI>./devinf12</LocURI></Source><Data>" );
+    data.append( devInf );
+    data.append( "</Data></Item></Put><Final/></SyncBody></SyncML>" );
+
+    QByteArray hash;
+
+    {
+        SyncMLMessageParser parser;
+        parser.parseMessage( data, true );
+        QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+        QList<Fragment*> fragments = parser.takeFragments();
+        QCOMPARE( fragments.count(), 2 );
+        QVERIFY( fragments[1]->fragmentType == Fragment::FRAGMENT_PUT );
+
+        PutParams* put = static_cast<PutParams*>( fragments[1] );
+        QVERIFY( !put->devInf.cached );
+        QCOMPARE( put->devInf.devInfo.datastores().count(), 3 );
+        hash = put->devInf.hash;
+        QVERIFY( !hash.isEmpty() );
+
+        qDeleteAll( fragments );
+    }
+
+    // Unchanged DevInf is skipped when its hash is known
+    {
+        SyncMLMessageParser parser;
+        parser.setKnownDevInfHash( hash );
+        parser.parseMessage( data, true );
+        QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+        QList<Fragment*> fragments = parser.takeFragments();
+        QCOMPARE( fragments.count(), 2 );
+        QVERIFY( fragments[1]->fragmentType == Fragment::FRAGMENT_PUT );
+
+        PutParams* put = static_cast<PutParams*>( fragments[1] );
+        QVERIFY( put->devInf.cached );
+        QCOMPARE( put->devInf.hash, hash );
+        QCOMPARE( put->devInf.source, QString( "./devinf12" ) );
+        QCOMPARE( put->devInf.devInfo.datastores().count(), 0 );
+
+        qDeleteAll( fragments );
+    }
+}
+
+void SyncMLMessageParserTest::testLazyCTCap()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/devinf02.txt", data ) );
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+    SyncMLMessageParser parser;
+    parser.iReader.setDevice( &buffer );
+    parser.resetInput( data, 0, 0 );
+
+    DevInfItemParams params;
+    parser.readDevInf( params );
+    buffer.close();
+
+    QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+    // CTCaps are not decoded until accessed
+    Datastore& datastore = params.devInfo.datastores()[0];
+    QCOMPARE( datastore.ctCapData().count(), 1 );
+    QCOMPARE( datastore.decodedCTCaps().count(), 0 );
+    QVERIFY( datastore.ctCapData().at(0).contains( "text/x-vcard" ) );
+
+    QCOMPARE( datastore.ctCaps().count(), 1 );
+    QCOMPARE( datastore.ctCapData().count(), 0 );
+    QCOMPARE( datastore.decodedCTCaps().count(), 1 );
+    QCOMPARE( datastore.ctCaps().at(0).getFormat().iType, QString( "text/x-vcard" ) );
+    QCOMPARE( datastore.ctCaps().at(0).properties().count(), 24 );
+
+    // Without the original bytes CTCaps are decoded right away
+    {
+        QBuffer buffer( &data );
+        buffer.open( QIODevice::ReadOnly );
+        SyncMLMessageParser parser;
+        parser.iReader.setDevice( &buffer );
+
+        DevInfItemParams params;
+        parser.readDevInf( params );
+        buffer.close();
+
+        QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+        const Datastore& datastore = params.devInfo.datastores()[0];
+        QCOMPARE( datastore.ctCapData().count(), 0 );
+        QCOMPARE( datastore.decodedCTCaps().count(), 1 );
+        QCOMPARE( datastore.decodedCTCaps().at(0).properties().count(), 24 );
+    }
+
+    // All captured CTCaps are decoded in one go
+    QList<QByteArray> ctCapData;
+    ctCapData << "<CTCap><CTType>text/plain</CTType><VerCT>1.0</VerCT>"
+                 "<Property><PropName>BODY</PropName><MaxSize>100</MaxSize><NoTruncate/>"
+                 "<PropParam><ParamName>CHARSET</ParamName></PropParam>"
+                 "</Property></CTCap>"
+              << "<CTCap><CTType>text/x-vcalendar</CTType><VerCT>1.0</VerCT></CTCap>";
+
+    QList<CTCap> caps;
+    QVERIFY( decodeCTCaps( ctCapData, caps ) );
+    QCOMPARE( caps.count(), 2 );
+    QCOMPARE( caps.at(0).getFormat().iType, QString( "text/plain" ) );
+    QCOMPARE( caps.at(0).getFormat().iVersion, QString( "1.0" ) );
+    QCOMPARE( caps.at(0).properties().count(), 1 );
+    QCOMPARE( caps.at(0).properties().at(0).iName, QString( "BODY" ) );
+    QCOMPARE( caps.at(0).properties().at(0).iSize, 100 );
+    QVERIFY( caps.at(0).properties().at(0).iNoTruncate );
+    QCOMPARE( caps.at(0).properties().at(0).iParameters.count(), 1 );
+    QCOMPARE( caps.at(0).properties().at(0).iParameters.at(0).iName, QString( "CHARSET" ) );
+    QCOMPARE( caps.at(1).getFormat().iType, QString( "text/x-vcalendar" ) );
+
+    // Malformed CTCap does not spoil the valid ones
+    ctCapData.insert( 1, "<CTCap><CTType>text/plain</CTCap>" );
+    caps.clear();
+    QVERIFY( !decodeCTCaps( ctCapData, caps ) );
+    QCOMPARE( caps.count(), 2 );
+    QCOMPARE( caps.at(1).getFormat().iType, QString( "text/x-vcalendar" ) );
+}
+
+void SyncMLMessageParserTest::testIncremental()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    // Reference result from parsing the whole message at once
+    SyncMLMessageParser reference;
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    reference.parseResponse( &buffer, true );
+    buffer.close();
+    QList<DataSync::Fragment*> expected = reference.takeFragments();
+    QCOMPARE( expected.count(), 6 );
+
+    QList<int> chunkSizes;
+    chunkSizes << 1 << 7 << 100 << data.size();
+
+    foreach( int chunkSize, chunkSizes ) {
+
+        SyncMLMessageParser parser;
+        QSignalSpy availableSpy( &parser, SIGNAL(fragmentsAvailable()) );
+        QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+        QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+        int availableBeforeLastChunk = 0;
+
+        for( int i = 0; i < data.size(); i += chunkSize ) {
+            bool lastChunk = ( i + chunkSize >= data.size() );
+
+            if( lastChunk ) {
+                availableBeforeLastChunk = availableSpy.count();
+                QCOMPARE( parsingSpy.count(), 0 );
+            }
+
+            parser.parseChunk( data.mid( i, chunkSize ), i == 0, lastChunk );
+        }
+
+        QCOMPARE( parsingSpy.count(), 1 );
+        QCOMPARE( errorSpy.count(), 0 );
+        QCOMPARE( parsingSpy.at(0).at(0).toBool(), true );
+
+        // Header and status are complete well before the end of the message
+        if( chunkSize < data.size() ) {
+            QVERIFY( availableBeforeLastChunk > 0 );
+        }
+
+        // Fragments that were not taken are in the same order as when parsing
+        // the whole message at once
+        QList<DataSync::Fragment*> fragments = parser.takeFragments();
+        QCOMPARE( fragments.count(), expected.count() );
+
+        for( int i = 0; i < expected.count(); ++i ) {
+            QCOMPARE( fragments[i]->fragmentType, expected[i]->fragmentType );
+        }
+
+        const HeaderParams* header = static_cast<const HeaderParams*>( fragments[0] );
+        QCOMPARE( header->sessionID, QString( "1230022352" ) );
+        QCOMPARE( header->msgID, 5 );
+
+        const SyncParams* sync = static_cast<const SyncParams*>( fragments[4] );
+        const SyncParams* expectedSync = static_cast<const SyncParams*>( expected[4] );
+        QCOMPARE( sync->commands.count(), expectedSync->commands.count() );
+        QCOMPARE( sync->target, expectedSync->target );
+
+        qDeleteAll( fragments );
+    }
+
+    qDeleteAll( expected );
+}
+
+void SyncMLMessageParserTest::testIncrementalProcessing()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    SyncMLMessageParser parser;
+    QSignalSpy availableSpy( &parser, SIGNAL(fragmentsAvailable()) );
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    const int chunkSize = 32;
+    QList<DataSync::Fragment*> fragments;
+    int takenBeforeLastChunk = 0;
+
+    for( int i = 0; i < data.size(); i += chunkSize ) {
+        bool lastChunk = ( i + chunkSize >= data.size() );
+
+        parser.parseChunk( data.mid( i, chunkSize ), i == 0, lastChunk );
+
+        // Take fragments as soon as they are announced, like SessionHandler does
+        if( !lastChunk && availableSpy.count() > 0 ) {
+            availableSpy.clear();
+            fragments.append( parser.takeAvailableFragments() );
+            takenBeforeLastChunk = fragments.count();
+        }
+    }
+
+    QCOMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    // Header and Status are processed early. Alert is held back until the end,
+    // so that Results that comes later can still be processed before it.
+    QCOMPARE( takenBeforeLastChunk, 2 );
+
+    fragments.append( parser.takeFragments() );
+    QCOMPARE( fragments.count(), 6 );
+    QCOMPARE( fragments[0]->fragmentType, Fragment::FRAGMENT_HEADER );
+    QCOMPARE( fragments[1]->fragmentType, Fragment::FRAGMENT_STATUS );
+    QCOMPARE( fragments[2]->fragmentType, Fragment::FRAGMENT_RESULTS );
+    QCOMPARE( fragments[3]->fragmentType, Fragment::FRAGMENT_COMMAND );
+    QCOMPARE( static_cast<CommandParams*>(fragments[3])->commandType, CommandParams::COMMAND_ALERT );
+    QCOMPARE( fragments[4]->fragmentType, Fragment::FRAGMENT_SYNC );
+    QCOMPARE( fragments[5]->fragmentType, Fragment::FRAGMENT_MAP );
+
+    qDeleteAll( fragments );
+}
+
+void SyncMLMessageParserTest::testIncrementalSyncBeforePut()
+{
+    // Sync that comes before a DevInf Put in the same message must not be
+    // processed before the Put
+    QByteArray data( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                     "<SyncML xmlns=\"SYNCML:SYNCML1.2\"><SyncHdr><VerDTD>1.2</VerDTD>"
+                     "<VerProto>SyncML/1.2</VerProto><SessionID>1</SessionID><MsgID>2</MsgID>"
+                     "<Target><LocURI>IMEI:1</LocURI></Target><Source><LocURI>server</LocURI></Source>"
+                     "</SyncHdr><SyncBody>"
+                     "<Status><CmdID>1</CmdID><MsgRef>1</MsgRef><CmdRef>0</CmdRef><Cmd>SyncHdr</Cmd>"
+                     "<TargetRef>server</TargetRef><SourceRef>IMEI:1</SourceRef><Data>200</Data></Status>"
+                     "<Sync><CmdID>2</CmdID><Target><LocURI>./contacts</LocURI></Target>"
+                     "<Source><LocURI>./Contacts</LocURI></Source>"
+                     "<Add><CmdID>3</CmdID><Meta><Type xmlns=\"syncml:metinf\">text/x-vcard</Type></Meta>"
+                     "<Item><Source><LocURI>1</LocURI></Source><Data>item</Data></Item></Add></Sync>"
+                     "<Put><CmdID>4</CmdID><Meta><Type xmlns=\"syncml:metinf\">application/vnd.syncml-devinf+xml</Type></Meta>"
+                     "<Item><Source><LocURI>./devinf12</LocURI></Source><Data>"
+                     "<DevInf xmlns=\"syncml:devinf\"><VerDTD>1.2</VerDTD><DevID>server</DevID>"
+                     "<DevTyp>server</DevTyp></DevInf></Data></Item></Put>"
+                     "<Final/></SyncBody></SyncML>" );
+
+    SyncMLMessageParser parser;
+    QSignalSpy availableSpy( &parser, SIGNAL(fragmentsAvailable()) );
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    const int chunkSize = 16;
+    QList<DataSync::Fragment*> fragments;
+    int takenBeforeLastChunk = 0;
+
+    for( int i = 0; i < data.size(); i += chunkSize ) {
+        bool lastChunk = ( i + chunkSize >= data.size() );
+
+        parser.parseChunk( data.mid( i, chunkSize ), i == 0, lastChunk );
+
+        if( !lastChunk && availableSpy.count() > 0 ) {
+            availableSpy.clear();
+            fragments.append( parser.takeAvailableFragments() );
+            takenBeforeLastChunk = fragments.count();
+        }
+    }
+
+    QCOMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    // Only Header and Status are processed early
+    QCOMPARE( takenBeforeLastChunk, 2 );
+
+    fragments.append( parser.takeFragments() );
+    QCOMPARE( fragments.count(), 4 );
+    QCOMPARE( fragments[0]->fragmentType, Fragment::FRAGMENT_HEADER );
+    QCOMPARE( fragments[1]->fragmentType, Fragment::FRAGMENT_STATUS );
+    QCOMPARE( fragments[2]->fragmentType, Fragment::FRAGMENT_PUT );
+    QCOMPARE( fragments[3]->fragmentType, Fragment::FRAGMENT_SYNC );
+
+    qDeleteAll( fragments );
+}
+
+void SyncMLMessageParserTest::testIncrementalInvalid()
+{
+    QStringList files;
+    files << "data/respinvalid1.txt" << "data/respinvalid2.txt" << "data/respinvalid3.txt"
+          << "data/respinvalid4.txt" << "data/respinvalid5.txt" << "data/respinvalid6.txt";
+
+    foreach( const QString& file, files ) {
+        QByteArray data;
+        QVERIFY( readFile( file, data ) );
+
+        SyncMLMessageParser parser;
+        QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+        QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+        parseInChunks( parser, data, 16 );
+
+        QCOMPARE( parsingSpy.count(), 0 );
+        QCOMPARE( errorSpy.count(), 1 );
+        qDeleteAll( parser.takeFragments() );
+    }
+
+    // Message that ends in the middle of the body
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    SyncMLMessageParser parser;
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    parseInChunks( parser, data.left( data.size() / 2 ), 16 );
+
+    QCOMPARE( parsingSpy.count(), 0 );
+    QCOMPARE( errorSpy.count(), 1 );
+    QCOMPARE( errorSpy.at(0).at(0).value<DataSync::ParserError>(), PARSER_ERROR_INCOMPLETE_DATA );
+    qDeleteAll( parser.takeFragments() );
+}
+
+void SyncMLMessageParserTest::testIncrementalCancel()
+{
+    QByteArray data;
+    QVERIFY( readFile( "data/resp.txt", data ) );
+
+    SyncMLMessageParser parser;
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    // Response times out halfway
+    const int chunkSize = 32;
+    const int half = data.size() / 2;
+    for( int i = 0; i < half; i += chunkSize ) {
+        parser.parseChunk( data.mid( i, qMin( chunkSize, half - i ) ), i == 0, false );
+    }
+
+    parser.cancelStream();
+
+    // Rest of the abandoned message is ignored
+    parser.parseChunk( data.mid( half ), false, true );
+
+    QCOMPARE( parsingSpy.count(), 0 );
+    QCOMPARE( errorSpy.count(), 0 );
+    QVERIFY( parser.takeFragments().isEmpty() );
+
+    // Next message is parsed from the beginning
+    parseInChunks( parser, data, chunkSize );
+
+    QCOMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    QList<DataSync::Fragment*> fragments = parser.takeFragments();
+    QCOMPARE( fragments.count(), 6 );
+    QCOMPARE( fragments[0]->fragmentType, Fragment::FRAGMENT_HEADER );
+    qDeleteAll( fragments );
+}
+
+void SyncMLMessageParserTest::parseInChunks( SyncMLMessageParser& aParser, const QByteArray& aData, int aChunkSize )
+{
+    QSignalSpy errorSpy( &aParser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    for( int i = 0; i < aData.size(); i += aChunkSize ) {
+        bool lastChunk = ( i + aChunkSize >= aData.size() );
+
+        // Errors are reported only after the whole message has been received
+        QCOMPARE( errorSpy.count(), 0 );
+
+        aParser.parseChunk( aData.mid( i, aChunkSize ), i == 0, lastChunk );
+    }
+}
+
+void SyncMLMessageParserTest::testElementTokens()
+{
+    QString names( "SyncML Status Sync Replace CTCap Rx-Pref SupportHierarchicalSync" );
+    QVector<QStringRef> refs = names.splitRef( ' ' );
+
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[0] ), SyncMLMessageParser::ELEMENT_SYNCML );
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[1] ), SyncMLMessageParser::ELEMENT_STATUS );
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[2] ), SyncMLMessageParser::ELEMENT_SYNC );
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[3] ), SyncMLMessageParser::ELEMENT_REPLACE );
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[4] ), SyncMLMessageParser::ELEMENT_CTCAP );
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[5] ), SyncMLMessageParser::ELEMENT_RX_PREF );
+    QCOMPARE( SyncMLMessageParser::elementToken( refs[6] ), SyncMLMessageParser::ELEMENT_SUPPORTHIERARCHICALSYNC );
+
+    // Element names are case sensitive, and unknown names must not match
+    QString unknown( "status Syncs Sta SyncMLx" );
+    foreach( const QStringRef& ref, unknown.splitRef( ' ' ) ) {
+        QCOMPARE( SyncMLMessageParser::elementToken( ref ), SyncMLMessageParser::ELEMENT_UNKNOWN );
+    }
+}
+
+void SyncMLMessageParserTest::testFragmentAllocations()
+{
+    const int blocks = FragmentArena::iBlockCount.load();
+    const int count = 500;
+    CommandParams* commands[count];
+
+    // Fragments created outside of parsing are allocated from the heap
+    int allocations = gHeapAllocations.load();
+
+    for( int i = 0; i < count; ++i ) {
+        commands[i] = new CommandParams;
+    }
+
+    QVERIFY( gHeapAllocations.load() - allocations >= count );
+    QCOMPARE( FragmentArena::iBlockCount.load(), blocks );
+
+    for( int i = 0; i < count; ++i ) {
+        delete commands[i];
+    }
+
+    // While an arena is active, fragments take one heap allocation per block
+    {
+        FragmentArena arena;
+        FragmentArena::Scope scope( arena );
+
+        allocations = gHeapAllocations.load();
+
+        for( int i = 0; i < count; ++i ) {
+            commands[i] = new CommandParams;
+        }
+
+        allocations = gHeapAllocations.load() - allocations;
+        const int maxBlocks = count * ( sizeof( CommandParams ) + 32 ) / FragmentArena::BLOCK_SIZE + 1;
+
+        QVERIFY( allocations <= maxBlocks );
+        QCOMPARE( FragmentArena::iBlockCount.load() - blocks, allocations );
+    }
+
+    // Blocks outlive the arena until their objects have been deleted
+    QVERIFY( FragmentArena::iBlockCount.load() > blocks );
+
+    for( int i = 0; i < count; ++i ) {
+        delete commands[i];
+    }
+
+    QCOMPARE( FragmentArena::iBlockCount.load(), blocks );
+
+    // Commands and items of a parsed Sync are placed in the parser's arena
+    QByteArray data = syncMessage( count );
+    SyncMLMessageParser parser;
+
+    // Baseline: same message parsed with every object allocated from the heap
+    FragmentArena::iBypassed = true;
+    {
+        QBuffer buffer( &data );
+        QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+        parser.parseResponse( &buffer, true );
+        qDeleteAll( parser.takeFragments() );
+    }
+
+    int baseline = gHeapAllocations.load();
+    {
+        QBuffer buffer( &data );
+        QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+        parser.parseResponse( &buffer, true );
+        baseline = gHeapAllocations.load() - baseline;
+        qDeleteAll( parser.takeFragments() );
+    }
+    FragmentArena::iBypassed = false;
+    QCOMPARE( FragmentArena::iBlockCount.load(), blocks );
+
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    allocations = gHeapAllocations.load();
+
+    parser.parseResponse( &buffer, true );
+    QList<Fragment*> fragments = parser.takeFragments();
+
+    allocations = gHeapAllocations.load() - allocations;
+    qDebug() << "Heap allocations while parsing" << count << "commands:" << allocations
+             << "without arena:" << baseline;
+
+    // Each command and its item would be allocated separately, arena needs
+    // one allocation per block instead
+    const int maxParsedBlocks = count * ( sizeof( CommandParams ) + sizeof( ItemParams ) + 64 ) / FragmentArena::BLOCK_SIZE + 2;
+    QVERIFY( allocations <= baseline - 2 * count + maxParsedBlocks );
+
+    QCOMPARE( fragments.count(), 2 );
+    QCOMPARE( static_cast<SyncParams*>( fragments[1] )->commands.count(), count );
+
+    const int parsedBlocks = FragmentArena::iBlockCount.load() - blocks;
+    QVERIFY( parsedBlocks <= maxParsedBlocks );
+
+    // Arena is active only while the parser is parsing
+    CommandParams* command = new CommandParams;
+    QCOMPARE( FragmentArena::iBlockCount.load() - blocks, parsedBlocks );
+    delete command;
+
+    // Blocks of the message are released once its fragments have been deleted
+    qDeleteAll( fragments );
+    parser.iFragmentArena.beginMessage();
+    QCOMPARE( FragmentArena::iBlockCount.load(), blocks );
+}
+
+void SyncMLMessageParserTest::benchmarkSync500()
+{
+    QByteArray data = syncMessage( 500 );
+
+    QBENCHMARK {
+        QBuffer buffer( &data );
+        QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+
+        SyncMLMessageParser parser;
+        parser.parseResponse( &buffer, true );
+        QCOMPARE( parser.iError, PARSER_ERROR_LAST );
+
+        QList<Fragment*> fragments = parser.takeFragments();
+        QCOMPARE( fragments.count(), 2 );
+        QCOMPARE( static_cast<SyncParams*>( fragments[1] )->commands.count(), 500 );
+        qDeleteAll( fragments );
+    }
+}
+
+QByteArray SyncMLMessageParserTest::syncMessage( int aCommands )
+{
+    // Sync with Replace commands, each with a vCard item
+    QByteArray data( "<SyncML xmlns=\"SYNCML:SYNCML1.2\"><SyncHdr><VerDTD>1.2</VerDTD>"
+                     "<VerProto>SyncML/1.2</VerProto><SessionID>1</SessionID><MsgID>2</MsgID>"
+                     "<Target><LocURI>IMEI:493005100592800</LocURI></Target>"
+                     "<Source><LocURI>http://www.syncml.org/sync-server</LocURI></Source></SyncHdr>"
+                     "<SyncBody><Sync><CmdID>1</CmdID><Target><LocURI>./contacts</LocURI></Target>"
+                     "<Source><LocURI>./card</LocURI></Source>" );
+
+    for( int i = 0; i < aCommands; ++i ) {
+        data.append( "<Replace><CmdID>" + QByteArray::number( i + 2 ) + "</CmdID>"
+                     "<Meta><Type xmlns=\"syncml:metinf\">text/x-vcard</Type></Meta>"
+                     "<Item><Source><LocURI>" + QByteArray::number( i ) + "</LocURI></Source>"
+                     "<Data>BEGIN:VCARD\r\nVERSION:2.1\r\nN:Doe;John\r\nEND:VCARD\r\n</Data>"
+                     "</Item></Replace>" );
+    }
+
+    data.append( "</Sync><Final/></SyncBody></SyncML>" );
+
+    return data;
 }
 
 QTEST_MAIN(SyncMLMessageParserTest)
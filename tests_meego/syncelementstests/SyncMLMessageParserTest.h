@@ -38,6 +38,10 @@
 
 #include "Fragments.h"
 
+namespace DataSync {
+class SyncMLMessageParser;
+}
+
 class SyncMLMessageParserTest : public QObject
 {
 	Q_OBJECT;
@@ -50,11 +54,25 @@ private slots:
     void testDevInf12();
     void testSubcommands();
     void testEmbeddedXML();
+    void testEmbeddedXMLRaw();
+    void testStatusRefs();
+    void testDevInfHash();
+    void testLazyCTCap();
+    void testIncremental();
+    void testIncrementalProcessing();
+    void testIncrementalSyncBeforePut();
+    void testIncrementalInvalid();
+    void testIncrementalCancel();
+    void testElementTokens();
+    void testFragmentAllocations();
+    void benchmarkSync500();
 
 private:
     void verifyAdd( const DataSync::CommandParams& aData );
     void verifyReplace( const DataSync::CommandParams& aData );
     void verifyDelete( const DataSync::CommandParams& aData );
+    void parseInChunks( DataSync::SyncMLMessageParser& aParser, const QByteArray& aData, int aChunkSize );
+    QByteArray syncMessage( int aCommands );
 
 };
 #endif // SYNCMLMESSAGEBUILDERTEST_H
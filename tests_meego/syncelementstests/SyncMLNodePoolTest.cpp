@@ -0,0 +1,163 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+#include "SyncMLNodePoolTest.h"
+
+#include <QtTest>
+
+#include "SyncMLNodePool.h"
+#include "SyncMLMessage.h"
+#include "SyncMLSync.h"
+#include "SyncMLAdd.h"
+#include "SyncMLItem.h"
+
+using namespace DataSync;
+
+void SyncMLNodePoolTest::testAllocateRelease()
+{
+    SyncMLNodePool& pool = SyncMLNodePool::instance();
+    QCOMPARE( pool.nodeCount(), 0 );
+    QCOMPARE( pool.blockCount(), 0 );
+
+    void* node1 = pool.allocate( 100 );
+    void* node2 = pool.allocate( 100 );
+    void* node3 = pool.allocate( 40 );
+    QVERIFY( node1 && node2 && node3 );
+    QVERIFY( node1 != node2 );
+    QCOMPARE( pool.nodeCount(), 3 );
+
+    // Nodes of different sizes come from blocks of their own
+    QCOMPARE( pool.blockCount(), 2 );
+
+    // Released nodes are reused for nodes of the same size
+    pool.release( node2, 100 );
+    QCOMPARE( pool.allocate( 100 ), node2 );
+
+    // Empty block is kept for reuse while other nodes are alive
+    pool.release( node1, 100 );
+    pool.release( node2, 100 );
+    QCOMPARE( pool.nodeCount(), 1 );
+    QCOMPARE( pool.blockCount(), 2 );
+
+    // Blocks are freed once the last node is released
+    pool.release( node3, 40 );
+    QCOMPARE( pool.nodeCount(), 0 );
+    QCOMPARE( pool.blockCount(), 0 );
+}
+
+void SyncMLNodePoolTest::testEmptyBlocksReleased()
+{
+    SyncMLNodePool& pool = SyncMLNodePool::instance();
+    QCOMPARE( pool.nodeCount(), 0 );
+
+    // Node of another message that outlives the others
+    void* survivor = pool.allocate( 40 );
+
+    QList<void*> nodes;
+    for( int i = 0; i < 1000; ++i ) {
+        nodes.append( pool.allocate( 100 ) );
+    }
+
+    int blocks = pool.blockCount();
+    QVERIFY( blocks > 3 );
+
+    // Blocks are freed as they become empty, apart from one spare block
+    for( int i = 0; i < nodes.count(); ++i ) {
+        pool.release( nodes[i], 100 );
+    }
+
+    QCOMPARE( pool.nodeCount(), 1 );
+    QCOMPARE( pool.blockCount(), 2 );
+
+    // Spare block is reused for nodes of any size
+    void* node = pool.allocate( 200 );
+    QCOMPARE( pool.blockCount(), 2 );
+
+    pool.release( node, 200 );
+    pool.release( survivor, 40 );
+    QCOMPARE( pool.nodeCount(), 0 );
+    QCOMPARE( pool.blockCount(), 0 );
+}
+
+void SyncMLNodePoolTest::testLargeNodes()
+{
+    SyncMLNodePool& pool = SyncMLNodePool::instance();
+
+    // Large nodes are allocated from the heap directly
+    void* node = pool.allocate( 4096 );
+    QVERIFY( node );
+    QCOMPARE( pool.nodeCount(), 0 );
+    QCOMPARE( pool.blockCount(), 0 );
+
+    pool.release( node, 4096 );
+    QCOMPARE( pool.nodeCount(), 0 );
+}
+
+void SyncMLNodePoolTest::testMessageTree()
+{
+    SyncMLNodePool& pool = SyncMLNodePool::instance();
+
+    HeaderParams headerParams;
+    headerParams.verDTD = SYNCML_DTD_VERSION_1_2;
+    headerParams.verProto = DS_VERPROTO_1_2;
+    headerParams.sessionID = "1";
+    headerParams.msgID = 1;
+    headerParams.targetDevice = "http://www.example.com/sync";
+    headerParams.sourceDevice = "IMEI:493005100592800";
+
+    SyncMLMessage* message = new SyncMLMessage( headerParams, SYNCML_1_2 );
+    SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+    message->addToBody( sync );
+
+    for( int i = 0; i < 500; ++i ) {
+        SyncMLAdd* add = new SyncMLAdd( message->getNextCmdId() );
+        add->addMimeMetadata( "text/x-vcard" );
+        SyncMLItem* item = new SyncMLItem();
+        item->insertSource( QString::number( i ) );
+        item->insertData( "BEGIN:VCARD\r\nEND:VCARD\r\n" );
+        add->addChild( item );
+        sync->addChild( add );
+    }
+
+    // Thousands of nodes fit in a handful of blocks
+    QVERIFY( pool.nodeCount() > 3000 );
+    QVERIFY( pool.blockCount() > 0 );
+    QVERIFY( pool.blockCount() < pool.nodeCount() / 100 );
+
+    delete message;
+
+    QCOMPARE( pool.nodeCount(), 0 );
+    QCOMPARE( pool.blockCount(), 0 );
+}
+
+QTEST_MAIN(SyncMLNodePoolTest)
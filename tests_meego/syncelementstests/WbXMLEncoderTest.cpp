@@ -0,0 +1,334 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "WbXMLEncoderTest.h"
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QBuffer>
+
+#include "WbXMLEncoder.h"
+#include "WbXMLMessageDecoder.h"
+#include "LibWbXML2Encoder.h"
+#include "SyncMLMessageParser.h"
+#include "SyncMLMessage.h"
+#include "SyncMLStatus.h"
+#include "SyncMLSync.h"
+#include "SyncMLAdd.h"
+#include "SyncMLItem.h"
+#include "SyncMLPut.h"
+#include "SyncMLResults.h"
+#include "DeviceInfo.h"
+#include "RemoteDeviceInfo.h"
+#include "Mock.h"
+
+using namespace DataSync;
+
+namespace {
+
+const char* const ITEM_DATA = "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4;<A&B>\r\nEND:VCARD\r\n";
+
+}
+
+void WbXMLEncoderTest::testEncodedSize()
+{
+    SyncMLMessage* message = createMessage( SYNCML_1_2 );
+
+    WbXMLEncoder encoder;
+    int size = encoder.encodedSize( *message, SYNCML_1_2 );
+    QVERIFY( size > 0 );
+
+    // Encoded document is appended to existing data
+    QByteArray wbxml( "prefix" );
+    QVERIFY( encoder.encodeToWbXML( *message, SYNCML_1_2, wbxml ) );
+    QCOMPARE( wbxml.size(), size + 6 );
+    QVERIFY( wbxml.startsWith( "prefix" ) );
+
+    QByteArray reference;
+    QVERIFY( encoder.encodeToWbXML( *message, SYNCML_1_2, reference ) );
+    QCOMPARE( wbxml.mid( 6 ), reference );
+
+    delete message;
+}
+
+void WbXMLEncoderTest::testRoundTrip11()
+{
+    verifyRoundTrip( SYNCML_1_1 );
+}
+
+void WbXMLEncoderTest::testRoundTrip12()
+{
+    verifyRoundTrip( SYNCML_1_2 );
+}
+
+void WbXMLEncoderTest::testUnknownElement()
+{
+    SyncMLMessage* message = createMessage( SYNCML_1_2 );
+    message->addToBody( new SyncMLCmdObject( "Unknown", "value" ) );
+
+    WbXMLEncoder encoder;
+    QCOMPARE( encoder.encodedSize( *message, SYNCML_1_2 ), -1 );
+
+    QByteArray wbxml;
+    QVERIFY( !encoder.encodeToWbXML( *message, SYNCML_1_2, wbxml ) );
+    QVERIFY( wbxml.isEmpty() );
+
+    delete message;
+}
+
+void WbXMLEncoderTest::testStringTable()
+{
+    SyncMLMessage* message = createMessage( SYNCML_1_2 );
+    message->enableWbXMLStringTable();
+
+    // Repeat the MIME type and source so that a string table pays off
+    SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+    message->addToBody( sync );
+    for( int i = 0; i < 10; ++i ) {
+        SyncMLAdd* add = new SyncMLAdd( message->getNextCmdId() );
+        add->addMimeMetadata( "text/x-vcard" );
+        SyncMLItem* item = new SyncMLItem();
+        item->insertSource( QString::number( 2000 + i ) );
+        item->insertData( QByteArray( ITEM_DATA ) );
+        add->addChild( item );
+        sync->addChild( add );
+    }
+
+    WbXMLEncoder encoder;
+    QByteArray inlineStrings;
+    QVERIFY( encoder.encodeToWbXML( *message, SYNCML_1_2, inlineStrings ) );
+
+    encoder.setUseStringTable( true );
+    QByteArray wbxml;
+    QVERIFY( encoder.encodeToWbXML( *message, SYNCML_1_2, wbxml ) );
+    QCOMPARE( wbxml.size(), encoder.encodedSize( *message, SYNCML_1_2 ) );
+    QVERIFY( wbxml.size() < inlineStrings.size() );
+
+    delete message;
+    message = NULL;
+
+    // Both decoders must resolve the string table references
+    LibWbXML2Encoder libEncoder;
+    QByteArray xml;
+    QVERIFY( libEncoder.decodeFromWbXML( wbxml, xml, false ) );
+
+    QList<Fragment*> expected;
+    bool lastMessage = false;
+    parseXML( xml, expected, lastMessage );
+    QVERIFY( lastMessage );
+
+    WbXMLMessageDecoder decoder;
+    QCOMPARE( decoder.decode( wbxml ), PARSER_ERROR_LAST );
+    QList<Fragment*> actual = decoder.takeFragments();
+
+    QCOMPARE( actual.count(), expected.count() );
+    QCOMPARE( actual.count(), 5 );
+    QCOMPARE( actual[4]->fragmentType, Fragment::FRAGMENT_SYNC );
+    QCOMPARE( expected[4]->fragmentType, Fragment::FRAGMENT_SYNC );
+
+    const SyncParams* expectedSync = static_cast<const SyncParams*>( expected[4] );
+    const SyncParams* actualSync = static_cast<const SyncParams*>( actual[4] );
+    QCOMPARE( actualSync->target, QString( "./contacts" ) );
+    QCOMPARE( expectedSync->target, QString( "./contacts" ) );
+    QCOMPARE( actualSync->commands.count(), 10 );
+    QCOMPARE( expectedSync->commands.count(), 10 );
+
+    for( int i = 0; i < 10; ++i ) {
+        QCOMPARE( actualSync->commands[i].meta.type, QString( "text/x-vcard" ) );
+        QCOMPARE( expectedSync->commands[i].meta.type, QString( "text/x-vcard" ) );
+        QCOMPARE( actualSync->commands[i].items.first().source, QString::number( 2000 + i ) );
+        QCOMPARE( expectedSync->commands[i].items.first().source, QString::number( 2000 + i ) );
+        QCOMPARE( actualSync->commands[i].items.first().data.toByteArray(), QByteArray( ITEM_DATA ) );
+        QCOMPARE( expectedSync->commands[i].items.first().data.toByteArray(), QByteArray( ITEM_DATA ) );
+    }
+
+    qDeleteAll( expected );
+    qDeleteAll( actual );
+}
+
+SyncMLMessage* WbXMLEncoderTest::createMessage( ProtocolVersion aVersion )
+{
+    HeaderParams headerParams;
+    headerParams.verDTD = ( aVersion == SYNCML_1_1 ) ? SYNCML_DTD_VERSION_1_1 : SYNCML_DTD_VERSION_1_2;
+    headerParams.verProto = ( aVersion == SYNCML_1_1 ) ? DS_VERPROTO_1_1 : DS_VERPROTO_1_2;
+    headerParams.sessionID = "1230022352";
+    headerParams.msgID = 3;
+    headerParams.targetDevice = "http://www.example.com/sync";
+    headerParams.sourceDevice = "IMEI:493005100592800";
+    headerParams.meta.maxMsgSize = 16384;
+
+    SyncMLMessage* message = new SyncMLMessage( headerParams, aVersion );
+
+    // Status with anchor, which uses MetInf code page
+    StatusParams alertStatus;
+    alertStatus.cmdId = message->getNextCmdId();
+    alertStatus.msgRef = 2;
+    alertStatus.cmdRef = 1;
+    alertStatus.cmd = SYNCML_ELEMENT_ALERT;
+    alertStatus.targetRef = "./contacts";
+    alertStatus.sourceRef = "./card";
+    alertStatus.data = SUCCESS;
+    alertStatus.nextAnchor = "276";
+    message->addToBody( new SyncMLStatus( alertStatus ) );
+
+    // Item data has markup, entities and non-ASCII characters
+    SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+    SyncMLAdd* add = new SyncMLAdd( message->getNextCmdId() );
+    add->addMimeMetadata( "text/x-vcard" );
+    SyncMLItem* addItem = new SyncMLItem();
+    addItem->insertSource( "1001" );
+    addItem->insertData( QByteArray( ITEM_DATA ) );
+    add->addChild( addItem );
+    sync->addChild( add );
+    message->addToBody( sync );
+
+    // Device information is embedded as a separate document
+    DeviceInfo deviceInfo;
+    deviceInfo.setManufacturer( "FooManufacturer" );
+    deviceInfo.setModel( "FooModel" );
+    deviceInfo.setDeviceID( "IMEI:493005100592800" );
+    deviceInfo.setDeviceType( "phone" );
+
+    MockStorage contacts( "./contacts", "text/x-vcard", "2.1" );
+    QList<StoragePlugin*> storages;
+    storages.append( &contacts );
+
+    if( aVersion == SYNCML_1_1 ) {
+        message->addToBody( new SyncMLResults( message->getNextCmdId(), 2, 6, storages,
+                                               deviceInfo, aVersion, ROLE_SERVER ) );
+    }
+    else {
+        message->addToBody( new SyncMLPut( message->getNextCmdId(), storages, deviceInfo,
+                                           aVersion, ROLE_CLIENT ) );
+    }
+
+    message->addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
+void WbXMLEncoderTest::verifyRoundTrip( ProtocolVersion aVersion )
+{
+    SyncMLMessage* message = createMessage( aVersion );
+
+    WbXMLEncoder encoder;
+    QByteArray wbxml;
+    QVERIFY( encoder.encodeToWbXML( *message, aVersion, wbxml ) );
+    QCOMPARE( wbxml.size(), encoder.encodedSize( *message, aVersion ) );
+
+    delete message;
+    message = NULL;
+
+    QVERIFY( WbXMLMessageDecoder::isSyncMLDocument( wbxml ) );
+
+    // libwbxml2 must be able to decode the document
+    LibWbXML2Encoder libEncoder;
+    QByteArray xml;
+    QVERIFY( libEncoder.decodeFromWbXML( wbxml, xml, false ) );
+
+    QList<Fragment*> fragments;
+    bool lastMessage = false;
+    parseXML( xml, fragments, lastMessage );
+    QVERIFY( lastMessage );
+    verifyFragments( fragments, aVersion );
+    qDeleteAll( fragments );
+
+    // And so must the native decoder
+    WbXMLMessageDecoder decoder;
+    QCOMPARE( decoder.decode( wbxml ), PARSER_ERROR_LAST );
+    QVERIFY( decoder.lastMessageInPackage() );
+    fragments = decoder.takeFragments();
+    verifyFragments( fragments, aVersion );
+    qDeleteAll( fragments );
+}
+
+void WbXMLEncoderTest::parseXML( const QByteArray& aData, QList<Fragment*>& aFragments, bool& aFinal )
+{
+    QByteArray data = aData;
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+
+    SyncMLMessageParser parser;
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    parser.parseResponse( &buffer, true );
+    buffer.close();
+
+    QCOMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    aFinal = parsingSpy.first().first().toBool();
+    aFragments = parser.takeFragments();
+}
+
+void WbXMLEncoderTest::verifyFragments( const QList<Fragment*>& aFragments, ProtocolVersion aVersion )
+{
+    // Header, DevInf, Status and Sync. DevInf fragments are always placed
+    // right after the header
+    QCOMPARE( aFragments.count(), 4 );
+
+    QCOMPARE( aFragments[0]->fragmentType, Fragment::FRAGMENT_HEADER );
+    const HeaderParams* header = static_cast<const HeaderParams*>( aFragments[0] );
+    QCOMPARE( header->sessionID, QString( "1230022352" ) );
+    QCOMPARE( header->msgID, 3 );
+    QCOMPARE( header->meta.maxMsgSize, qint64( 16384 ) );
+
+    const DevInfItemParams* devInf = NULL;
+    if( aVersion == SYNCML_1_1 ) {
+        QCOMPARE( aFragments[1]->fragmentType, Fragment::FRAGMENT_RESULTS );
+        devInf = &static_cast<const ResultsParams*>( aFragments[1] )->devInf;
+    }
+    else {
+        QCOMPARE( aFragments[1]->fragmentType, Fragment::FRAGMENT_PUT );
+        devInf = &static_cast<const PutParams*>( aFragments[1] )->devInf;
+    }
+    QCOMPARE( devInf->devInfo.deviceInfo().getManufacturer(), QString( "FooManufacturer" ) );
+    QCOMPARE( devInf->devInfo.datastores().count(), 1 );
+    QCOMPARE( devInf->devInfo.datastores().first().getSourceURI(), QString( "./contacts" ) );
+
+    QCOMPARE( aFragments[2]->fragmentType, Fragment::FRAGMENT_STATUS );
+    const StatusParams* status = static_cast<const StatusParams*>( aFragments[2] );
+    QCOMPARE( status->items.count(), 1 );
+    QVERIFY( status->items.first().data.toByteArray().contains( "<Next>276</Next>" ) );
+
+    QCOMPARE( aFragments[3]->fragmentType, Fragment::FRAGMENT_SYNC );
+    const SyncParams* sync = static_cast<const SyncParams*>( aFragments[3] );
+    QCOMPARE( sync->commands.count(), 1 );
+    QCOMPARE( sync->commands.first().items.count(), 1 );
+    QCOMPARE( sync->commands.first().items.first().source, QString( "1001" ) );
+    QCOMPARE( sync->commands.first().items.first().data.toByteArray(), QByteArray( ITEM_DATA ) );
+}
+
+QTEST_MAIN(WbXMLEncoderTest)
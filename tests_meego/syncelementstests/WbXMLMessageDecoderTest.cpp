@@ -0,0 +1,586 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "WbXMLMessageDecoderTest.h"
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QBuffer>
+
+#include "WbXMLMessageDecoder.h"
+#include "SyncMLMessageParser.h"
+#include "LibWbXML2Encoder.h"
+#include "SyncMLMessage.h"
+#include "SyncMLStatus.h"
+#include "SyncMLAlert.h"
+#include "SyncMLSync.h"
+#include "SyncMLAdd.h"
+#include "SyncMLReplace.h"
+#include "SyncMLDelete.h"
+#include "SyncMLItem.h"
+#include "SyncMLMap.h"
+#include "SyncMLMapItem.h"
+#include "SyncMLPut.h"
+#include "SyncMLResults.h"
+#include "DeviceInfo.h"
+#include "RemoteDeviceInfo.h"
+#include "TestUtils.h"
+#include "Mock.h"
+
+using namespace DataSync;
+
+void WbXMLMessageDecoderTest::testBasicMessage()
+{
+    QByteArray wbxml;
+    QVERIFY( readFile( "data/basicbasetransport.bin", wbxml ) );
+    QByteArray xml;
+    QVERIFY( readFile( "data/basicbasetransport.txt", xml ) );
+
+    QVERIFY( WbXMLMessageDecoder::isSyncMLDocument( wbxml ) );
+    QVERIFY( !WbXMLMessageDecoder::isSyncMLDocument( xml ) );
+
+    QList<Fragment*> expected;
+    bool expectedFinal = false;
+    parseXML( xml, expected, expectedFinal );
+
+    WbXMLMessageDecoder decoder;
+    QCOMPARE( decoder.decode( wbxml ), PARSER_ERROR_LAST );
+    QList<Fragment*> actual = decoder.takeFragments();
+
+    QCOMPARE( decoder.lastMessageInPackage(), expectedFinal );
+    QCOMPARE( actual.count(), expected.count() );
+    QCOMPARE( actual.count(), 1 );
+
+    const HeaderParams* header = static_cast<const HeaderParams*>( actual.first() );
+    QCOMPARE( header->fragmentType, Fragment::FRAGMENT_HEADER );
+    QCOMPARE( header->verDTD, QString( SYNCML_DTD_VERSION_1_2 ) );
+    QCOMPARE( header->verProto, QString( DS_VERPROTO_1_2 ) );
+    QCOMPARE( header->msgID, 1 );
+    QCOMPARE( header->targetDevice, QString( "targetDevice" ) );
+    QCOMPARE( header->sourceDevice, QString( "sourceDevice" ) );
+
+    compareFragment( *expected.first(), *actual.first() );
+
+    qDeleteAll( expected );
+    qDeleteAll( actual );
+}
+
+void WbXMLMessageDecoderTest::testParity11()
+{
+    verifyParity( SYNCML_1_1 );
+}
+
+void WbXMLMessageDecoderTest::testParity12()
+{
+    verifyParity( SYNCML_1_2 );
+}
+
+void WbXMLMessageDecoderTest::testParserSniffing()
+{
+    QByteArray wbxml;
+    QVERIFY( readFile( "data/basicbasetransport.bin", wbxml ) );
+
+    SyncMLMessageParser parser;
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    QBuffer buffer( &wbxml );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    parser.parseResponse( &buffer, true );
+    buffer.close();
+
+    QCOMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    QList<Fragment*> fragments = parser.takeFragments();
+    QCOMPARE( fragments.count(), 1 );
+    QCOMPARE( fragments.first()->fragmentType, Fragment::FRAGMENT_HEADER );
+    qDeleteAll( fragments );
+}
+
+void WbXMLMessageDecoderTest::testInvalid()
+{
+    QByteArray wbxml;
+    QVERIFY( readFile( "data/basicbasetransport.bin", wbxml ) );
+
+    WbXMLMessageDecoder decoder;
+
+    // Truncated in the middle of SyncHdr
+    QVERIFY( decoder.decode( wbxml.left( wbxml.size() / 2 ) ) != PARSER_ERROR_LAST );
+    qDeleteAll( decoder.takeFragments() );
+
+    // Truncated in the middle of document header
+    QCOMPARE( decoder.decode( wbxml.left( 2 ) ), PARSER_ERROR_INVALID_DATA );
+    QVERIFY( decoder.takeFragments().isEmpty() );
+
+    // Not WbXML at all
+    QVERIFY( !WbXMLMessageDecoder::isSyncMLDocument( QByteArray( "<SyncML/>" ) ) );
+    QVERIFY( !WbXMLMessageDecoder::isSyncMLDocument( QByteArray() ) );
+}
+
+SyncMLMessage* WbXMLMessageDecoderTest::createMessage( ProtocolVersion aVersion )
+{
+    HeaderParams headerParams;
+    headerParams.verDTD = ( aVersion == SYNCML_1_1 ) ? SYNCML_DTD_VERSION_1_1 : SYNCML_DTD_VERSION_1_2;
+    headerParams.verProto = ( aVersion == SYNCML_1_1 ) ? DS_VERPROTO_1_1 : DS_VERPROTO_1_2;
+    headerParams.sessionID = "1230022352";
+    headerParams.msgID = 3;
+    headerParams.targetDevice = "http://www.example.com/sync";
+    headerParams.sourceDevice = "IMEI:493005100592800";
+    headerParams.respURI = "http://www.example.com/sync?s=RYHmRQAA&srv_id=002";
+    headerParams.meta.maxMsgSize = 16384;
+    headerParams.meta.maxObjSize = 500000;
+    headerParams.meta.EMI.append( "emi-value" );
+
+    SyncMLMessage* message = new SyncMLMessage( headerParams, aVersion );
+
+    // Status with challenge
+    StatusParams hdrStatus;
+    hdrStatus.cmdId = message->getNextCmdId();
+    hdrStatus.msgRef = 2;
+    hdrStatus.cmdRef = 0;
+    hdrStatus.cmd = SYNCML_ELEMENT_SYNCHDR;
+    hdrStatus.targetRef = "http://www.example.com/sync";
+    hdrStatus.sourceRef = "IMEI:493005100592800";
+    hdrStatus.data = MISSING_CRED;
+    hdrStatus.chal.meta.type = SYNCML_FORMAT_AUTH_MD5;
+    hdrStatus.chal.meta.format = SYNCML_FORMAT_ENCODING_B64;
+    hdrStatus.chal.meta.nextNonce = "ZG9iZWhhdmUNCg==";
+    message->addToBody( new SyncMLStatus( hdrStatus ) );
+
+    // Status with embedded anchor and items
+    StatusParams alertStatus;
+    alertStatus.cmdId = message->getNextCmdId();
+    alertStatus.msgRef = 2;
+    alertStatus.cmdRef = 1;
+    alertStatus.cmd = SYNCML_ELEMENT_ALERT;
+    alertStatus.targetRef = "./contacts";
+    alertStatus.sourceRef = "./card";
+    alertStatus.data = SUCCESS;
+    alertStatus.nextAnchor = "276";
+    message->addToBody( new SyncMLStatus( alertStatus ) );
+
+    StatusParams itemStatus;
+    itemStatus.cmdId = message->getNextCmdId();
+    itemStatus.msgRef = 2;
+    itemStatus.cmdRef = 5;
+    itemStatus.cmd = SYNCML_ELEMENT_ADD;
+    itemStatus.data = ITEM_ADDED;
+    ItemParams statusItem;
+    statusItem.source = "1000";
+    statusItem.target = "2000";
+    itemStatus.items.append( statusItem );
+    message->addToBody( new SyncMLStatus( itemStatus ) );
+
+    // Alert with anchors
+    CommandParams alert( CommandParams::COMMAND_ALERT );
+    alert.cmdId = message->getNextCmdId();
+    alert.data = QString::number( TWO_WAY_SYNC );
+    ItemParams alertItem;
+    alertItem.target = "./contacts";
+    alertItem.source = "./card";
+    alertItem.meta.anchor.last = "1232366487448";
+    alertItem.meta.anchor.next = "1232981790235";
+    alert.items.append( alertItem );
+    message->addToBody( new SyncMLAlert( alert ) );
+
+    // Sync with changes, item data has markup, entities and non-ASCII characters
+    SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+    sync->addNumberOfChanges( 3 );
+
+    SyncMLAdd* add = new SyncMLAdd( message->getNextCmdId() );
+    add->addMimeMetadata( "text/x-vcard" );
+    SyncMLItem* addItem = new SyncMLItem();
+    addItem->insertSource( "1001" );
+    addItem->insertSourceParent( "10" );
+    addItem->insertData( QString::fromUtf8( "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4;<A&B>\r\nEND:VCARD\r\n" ).toUtf8() );
+    add->addChild( addItem );
+    sync->addChild( add );
+
+    SyncMLReplace* replace = new SyncMLReplace( message->getNextCmdId() );
+    replace->addMimeMetadata( "text/x-vcard" );
+    replace->addSizeMetadata( 4096 );
+    SyncMLItem* replaceItem = new SyncMLItem();
+    replaceItem->insertSource( "1002" );
+    replaceItem->insertTarget( "2002" );
+    replaceItem->insertData( QByteArray( "BEGIN:VCARD\r\nN:Chunk" ) );
+    replaceItem->insertMoreData();
+    replace->addChild( replaceItem );
+    sync->addChild( replace );
+
+    SyncMLDelete* del = new SyncMLDelete( message->getNextCmdId() );
+    SyncMLItem* deleteItem = new SyncMLItem();
+    deleteItem->insertTarget( "2003" );
+    del->addChild( deleteItem );
+    sync->addChild( del );
+
+    message->addToBody( sync );
+
+    // Mappings
+    SyncMLMap* map = new SyncMLMap( message->getNextCmdId(), "./contacts", "./card" );
+    map->addChild( new SyncMLMapItem( "2004", "1004" ) );
+    map->addChild( new SyncMLMapItem( "2005", "1005" ) );
+    message->addToBody( map );
+
+    // Device information
+    DeviceInfo deviceInfo;
+    deviceInfo.setManufacturer( "FooManufacturer" );
+    deviceInfo.setModel( "FooModel" );
+    deviceInfo.setOEM( "FooOEM" );
+    deviceInfo.setFirmwareVersion( "FwVersion" );
+    deviceInfo.setSoftwareVersion( "SwVersion" );
+    deviceInfo.setHardwareVersion( "HwVersion" );
+    deviceInfo.setDeviceID( "IMEI:493005100592800" );
+    deviceInfo.setDeviceType( "phone" );
+
+    MockStorage contacts( "./contacts", "text/x-vcard", "2.1" );
+    MockStorage notes( "./notes", "text/plain", "1.0" );
+    QList<StoragePlugin*> storages;
+    storages.append( &contacts );
+    storages.append( &notes );
+
+    if( aVersion == SYNCML_1_1 ) {
+        message->addToBody( new SyncMLResults( message->getNextCmdId(), 2, 6, storages,
+                                               deviceInfo, aVersion, ROLE_SERVER ) );
+    }
+    else {
+        message->addToBody( new SyncMLPut( message->getNextCmdId(), storages, deviceInfo,
+                                           aVersion, ROLE_CLIENT ) );
+    }
+
+    message->addToBody( new SyncMLCmdObject( SYNCML_ELEMENT_FINAL ) );
+
+    return message;
+}
+
+void WbXMLMessageDecoderTest::verifyParity( ProtocolVersion aVersion )
+{
+    SyncMLMessage* message = createMessage( aVersion );
+
+    LibWbXML2Encoder encoder;
+    QByteArray wbxml;
+    QVERIFY( encoder.encodeToWbXML( *message, aVersion, wbxml ) );
+    delete message;
+    message = NULL;
+
+    QVERIFY( WbXMLMessageDecoder::isSyncMLDocument( wbxml ) );
+
+    // Reference is the existing conversion path: WbXML to XML with
+    // libwbxml2, then parsing with SyncMLMessageParser
+    QByteArray xml;
+    QVERIFY( encoder.decodeFromWbXML( wbxml, xml, false ) );
+
+    QList<Fragment*> expected;
+    bool expectedFinal = false;
+    parseXML( xml, expected, expectedFinal );
+    QVERIFY( expectedFinal );
+
+    WbXMLMessageDecoder decoder;
+    QCOMPARE( decoder.decode( wbxml ), PARSER_ERROR_LAST );
+    QList<Fragment*> actual = decoder.takeFragments();
+    QCOMPARE( decoder.lastMessageInPackage(), expectedFinal );
+
+    QCOMPARE( actual.count(), expected.count() );
+    // Header, DevInf, three Status, Alert, Sync and Map. DevInf fragments are
+    // always placed right after the header
+    QCOMPARE( actual.count(), 8 );
+
+    for( int i = 0; i < expected.count(); ++i ) {
+        compareFragment( *expected[i], *actual[i] );
+    }
+
+    // Spot check some values against what was sent
+    const StatusParams* anchorStatus = static_cast<const StatusParams*>( actual[3] );
+    QCOMPARE( anchorStatus->fragmentType, Fragment::FRAGMENT_STATUS );
+    QCOMPARE( anchorStatus->items.count(), 1 );
+    QVERIFY( anchorStatus->items.first().data.toByteArray().contains( "<Next>276</Next>" ) );
+
+    QCOMPARE( actual[6]->fragmentType, Fragment::FRAGMENT_SYNC );
+    const SyncParams* sync = static_cast<const SyncParams*>( actual[6] );
+    QCOMPARE( sync->commands.count(), 3 );
+    QCOMPARE( sync->commands[0].items.first().data.toByteArray(),
+              QByteArray( "BEGIN:VCARD\r\nN:M\xc3\xa4kel\xc3\xa4;<A&B>\r\nEND:VCARD\r\n" ) );
+    QVERIFY( sync->commands[1].items.first().moreData );
+
+    qDeleteAll( expected );
+    qDeleteAll( actual );
+}
+
+void WbXMLMessageDecoderTest::parseXML( const QByteArray& aData, QList<Fragment*>& aFragments, bool& aFinal )
+{
+    QByteArray data = aData;
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+
+    SyncMLMessageParser parser;
+    QSignalSpy parsingSpy( &parser, SIGNAL(parsingComplete(bool)) );
+    QSignalSpy errorSpy( &parser, SIGNAL(parsingError(DataSync::ParserError)) );
+
+    parser.parseResponse( &buffer, true );
+    buffer.close();
+
+    QCOMPARE( parsingSpy.count(), 1 );
+    QCOMPARE( errorSpy.count(), 0 );
+
+    aFinal = parsingSpy.first().first().toBool();
+    aFragments = parser.takeFragments();
+}
+
+void WbXMLMessageDecoderTest::compareFragment( const Fragment& aExpected, const Fragment& aActual )
+{
+    QCOMPARE( aActual.fragmentType, aExpected.fragmentType );
+
+    switch( aExpected.fragmentType )
+    {
+        case Fragment::FRAGMENT_HEADER:
+            compareHeader( static_cast<const HeaderParams&>( aExpected ),
+                           static_cast<const HeaderParams&>( aActual ) );
+            break;
+        case Fragment::FRAGMENT_STATUS:
+            compareStatus( static_cast<const StatusParams&>( aExpected ),
+                           static_cast<const StatusParams&>( aActual ) );
+            break;
+        case Fragment::FRAGMENT_SYNC:
+            compareSync( static_cast<const SyncParams&>( aExpected ),
+                         static_cast<const SyncParams&>( aActual ) );
+            break;
+        case Fragment::FRAGMENT_MAP:
+            compareMap( static_cast<const MapParams&>( aExpected ),
+                        static_cast<const MapParams&>( aActual ) );
+            break;
+        case Fragment::FRAGMENT_COMMAND:
+            compareCommand( static_cast<const CommandParams&>( aExpected ),
+                            static_cast<const CommandParams&>( aActual ) );
+            break;
+        case Fragment::FRAGMENT_PUT:
+        {
+            const PutParams& expected = static_cast<const PutParams&>( aExpected );
+            const PutParams& actual = static_cast<const PutParams&>( aActual );
+            QCOMPARE( actual.cmdId, expected.cmdId );
+            QCOMPARE( actual.noResp, expected.noResp );
+            compareMeta( expected.meta, actual.meta );
+            compareDevInf( expected.devInf, actual.devInf );
+            break;
+        }
+        case Fragment::FRAGMENT_RESULTS:
+        {
+            const ResultsParams& expected = static_cast<const ResultsParams&>( aExpected );
+            const ResultsParams& actual = static_cast<const ResultsParams&>( aActual );
+            QCOMPARE( actual.cmdId, expected.cmdId );
+            QCOMPARE( actual.msgRef, expected.msgRef );
+            QCOMPARE( actual.cmdRef, expected.cmdRef );
+            QCOMPARE( actual.targetRef, expected.targetRef );
+            QCOMPARE( actual.sourceRef, expected.sourceRef );
+            compareMeta( expected.meta, actual.meta );
+            compareDevInf( expected.devInf, actual.devInf );
+            break;
+        }
+        default:
+            QFAIL( "Unknown fragment type" );
+            break;
+    }
+}
+
+void WbXMLMessageDecoderTest::compareHeader( const HeaderParams& aExpected, const HeaderParams& aActual )
+{
+    QCOMPARE( aActual.verDTD, aExpected.verDTD );
+    QCOMPARE( aActual.verProto, aExpected.verProto );
+    QCOMPARE( aActual.sessionID, aExpected.sessionID );
+    QCOMPARE( aActual.msgID, aExpected.msgID );
+    QCOMPARE( aActual.targetDevice, aExpected.targetDevice );
+    QCOMPARE( aActual.sourceDevice, aExpected.sourceDevice );
+    QCOMPARE( aActual.respURI, aExpected.respURI );
+    QCOMPARE( aActual.noResp, aExpected.noResp );
+    QCOMPARE( aActual.cred.data, aExpected.cred.data );
+    compareMeta( aExpected.cred.meta, aActual.cred.meta );
+    compareMeta( aExpected.meta, aActual.meta );
+}
+
+void WbXMLMessageDecoderTest::compareStatus( const StatusParams& aExpected, const StatusParams& aActual )
+{
+    QCOMPARE( aActual.cmdId, aExpected.cmdId );
+    QCOMPARE( aActual.msgRef, aExpected.msgRef );
+    QCOMPARE( aActual.cmdRef, aExpected.cmdRef );
+    QCOMPARE( aActual.cmd, aExpected.cmd );
+    QCOMPARE( aActual.targetRef, aExpected.targetRef );
+    QCOMPARE( aActual.sourceRef, aExpected.sourceRef );
+    QCOMPARE( aActual.data, aExpected.data );
+    QCOMPARE( aActual.hasChal, aExpected.hasChal );
+    compareMeta( aExpected.chal.meta, aActual.chal.meta );
+    QCOMPARE( aActual.items.count(), aExpected.items.count() );
+
+    for( int i = 0; i < aExpected.items.count(); ++i ) {
+        compareItem( aExpected.items[i], aActual.items[i] );
+    }
+}
+
+void WbXMLMessageDecoderTest::compareSync( const SyncParams& aExpected, const SyncParams& aActual )
+{
+    QCOMPARE( aActual.cmdId, aExpected.cmdId );
+    QCOMPARE( aActual.noResp, aExpected.noResp );
+    QCOMPARE( aActual.target, aExpected.target );
+    QCOMPARE( aActual.source, aExpected.source );
+    QCOMPARE( aActual.numberOfChanges, aExpected.numberOfChanges );
+    compareMeta( aExpected.meta, aActual.meta );
+    QCOMPARE( aActual.commands.count(), aExpected.commands.count() );
+
+    for( int i = 0; i < aExpected.commands.count(); ++i ) {
+        compareCommand( aExpected.commands[i], aActual.commands[i] );
+    }
+}
+
+void WbXMLMessageDecoderTest::compareMap( const MapParams& aExpected, const MapParams& aActual )
+{
+    QCOMPARE( aActual.cmdId, aExpected.cmdId );
+    QCOMPARE( aActual.target, aExpected.target );
+    QCOMPARE( aActual.source, aExpected.source );
+    compareMeta( aExpected.meta, aActual.meta );
+    QCOMPARE( aActual.mapItems.count(), aExpected.mapItems.count() );
+
+    for( int i = 0; i < aExpected.mapItems.count(); ++i ) {
+        QCOMPARE( aActual.mapItems[i].target, aExpected.mapItems[i].target );
+        QCOMPARE( aActual.mapItems[i].source, aExpected.mapItems[i].source );
+    }
+}
+
+void WbXMLMessageDecoderTest::compareCommand( const CommandParams& aExpected, const CommandParams& aActual )
+{
+    QCOMPARE( aActual.commandType, aExpected.commandType );
+    QCOMPARE( aActual.cmdId, aExpected.cmdId );
+    QCOMPARE( aActual.noResp, aExpected.noResp );
+    QCOMPARE( aActual.data, aExpected.data );
+    QCOMPARE( aActual.correlator, aExpected.correlator );
+    compareMeta( aExpected.meta, aActual.meta );
+    QCOMPARE( aActual.items.count(), aExpected.items.count() );
+
+    for( int i = 0; i < aExpected.items.count(); ++i ) {
+        compareItem( aExpected.items[i], aActual.items[i] );
+    }
+
+    QCOMPARE( aActual.subCommands.count(), aExpected.subCommands.count() );
+
+    for( int i = 0; i < aExpected.subCommands.count(); ++i ) {
+        compareCommand( aExpected.subCommands[i], aActual.subCommands[i] );
+    }
+}
+
+void WbXMLMessageDecoderTest::compareItem( const ItemParams& aExpected, const ItemParams& aActual )
+{
+    QCOMPARE( aActual.source, aExpected.source );
+    QCOMPARE( aActual.target, aExpected.target );
+    QCOMPARE( aActual.sourceParent, aExpected.sourceParent );
+    QCOMPARE( aActual.targetParent, aExpected.targetParent );
+    QCOMPARE( aActual.data, aExpected.data );
+    QCOMPARE( aActual.moreData, aExpected.moreData );
+    compareMeta( aExpected.meta, aActual.meta );
+}
+
+void WbXMLMessageDecoderTest::compareMeta( const MetaParams& aExpected, const MetaParams& aActual )
+{
+    QCOMPARE( aActual.anchor.last, aExpected.anchor.last );
+    QCOMPARE( aActual.anchor.next, aExpected.anchor.next );
+    QCOMPARE( aActual.EMI, aExpected.EMI );
+    QCOMPARE( aActual.format, aExpected.format );
+    QCOMPARE( aActual.maxMsgSize, aExpected.maxMsgSize );
+    QCOMPARE( aActual.maxObjSize, aExpected.maxObjSize );
+    QCOMPARE( aActual.nextNonce, aExpected.nextNonce );
+    QCOMPARE( aActual.size, aExpected.size );
+    QCOMPARE( aActual.type, aExpected.type );
+    QCOMPARE( aActual.version, aExpected.version );
+    QCOMPARE( aActual.mark, aExpected.mark );
+}
+
+void WbXMLMessageDecoderTest::compareDevInf( const DevInfItemParams& aExpected, const DevInfItemParams& aActual )
+{
+    QCOMPARE( aActual.source, aExpected.source );
+
+    const DeviceInfo& expectedInfo = aExpected.devInfo.deviceInfo();
+    const DeviceInfo& actualInfo = aActual.devInfo.deviceInfo();
+    QCOMPARE( actualInfo.getManufacturer(), expectedInfo.getManufacturer() );
+    QCOMPARE( actualInfo.getModel(), expectedInfo.getModel() );
+    QCOMPARE( actualInfo.getOEM(), expectedInfo.getOEM() );
+    QCOMPARE( actualInfo.getFirmwareVersion(), expectedInfo.getFirmwareVersion() );
+    QCOMPARE( actualInfo.getSoftwareVersion(), expectedInfo.getSoftwareVersion() );
+    QCOMPARE( actualInfo.getHardwareVersion(), expectedInfo.getHardwareVersion() );
+    QCOMPARE( actualInfo.getDeviceID(), expectedInfo.getDeviceID() );
+    QCOMPARE( actualInfo.getDeviceType(), expectedInfo.getDeviceType() );
+    QCOMPARE( aActual.devInfo.getSupportsUTC(), aExpected.devInfo.getSupportsUTC() );
+    QCOMPARE( aActual.devInfo.getSupportsLargeObjs(), aExpected.devInfo.getSupportsLargeObjs() );
+    QCOMPARE( aActual.devInfo.getSupportsNumberOfChanges(), aExpected.devInfo.getSupportsNumberOfChanges() );
+
+    const QList<Datastore>& expectedStores = aExpected.devInfo.datastores();
+    const QList<Datastore>& actualStores = aActual.devInfo.datastores();
+    QCOMPARE( actualStores.count(), expectedStores.count() );
+
+    for( int i = 0; i < expectedStores.count(); ++i ) {
+        const Datastore& expected = expectedStores[i];
+        const Datastore& actual = actualStores[i];
+
+        QCOMPARE( actual.getSourceURI(), expected.getSourceURI() );
+        QCOMPARE( actual.getSupportsHierarchicalSync(), expected.getSupportsHierarchicalSync() );
+        QCOMPARE( actual.syncCaps(), expected.syncCaps() );
+        QCOMPARE( actual.formatInfo().getPreferredRx().iType, expected.formatInfo().getPreferredRx().iType );
+        QCOMPARE( actual.formatInfo().getPreferredRx().iVersion, expected.formatInfo().getPreferredRx().iVersion );
+        QCOMPARE( actual.formatInfo().getPreferredTx().iType, expected.formatInfo().getPreferredTx().iType );
+        QCOMPARE( actual.formatInfo().getPreferredTx().iVersion, expected.formatInfo().getPreferredTx().iVersion );
+        QCOMPARE( actual.formatInfo().rx().count(), expected.formatInfo().rx().count() );
+        QCOMPARE( actual.formatInfo().tx().count(), expected.formatInfo().tx().count() );
+        QCOMPARE( actual.ctCaps().count(), expected.ctCaps().count() );
+
+        for( int c = 0; c < expected.ctCaps().count(); ++c ) {
+            const CTCap& expectedCap = expected.ctCaps()[c];
+            const CTCap& actualCap = actual.ctCaps()[c];
+
+            QCOMPARE( actualCap.getFormat().iType, expectedCap.getFormat().iType );
+            QCOMPARE( actualCap.getFormat().iVersion, expectedCap.getFormat().iVersion );
+            QCOMPARE( actualCap.properties().count(), expectedCap.properties().count() );
+
+            for( int p = 0; p < expectedCap.properties().count(); ++p ) {
+                const CTCapProperty& expectedProperty = expectedCap.properties()[p];
+                const CTCapProperty& actualProperty = actualCap.properties()[p];
+
+                QCOMPARE( actualProperty.iName, expectedProperty.iName );
+                QCOMPARE( actualProperty.iType, expectedProperty.iType );
+                QCOMPARE( actualProperty.iSize, expectedProperty.iSize );
+                QCOMPARE( actualProperty.iMaxOccur, expectedProperty.iMaxOccur );
+                QCOMPARE( actualProperty.iNoTruncate, expectedProperty.iNoTruncate );
+                QCOMPARE( actualProperty.iDisplayName, expectedProperty.iDisplayName );
+                QCOMPARE( actualProperty.iValues, expectedProperty.iValues );
+                QCOMPARE( actualProperty.iParameters.count(), expectedProperty.iParameters.count() );
+            }
+        }
+    }
+}
+
+QTEST_MAIN(WbXMLMessageDecoderTest)
@@ -0,0 +1,75 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#ifndef WBXMLMESSAGEDECODERTEST_H
+#define WBXMLMESSAGEDECODERTEST_H
+
+#include <QObject>
+
+#include "Fragments.h"
+#include "SyncAgentConsts.h"
+
+namespace DataSync {
+class SyncMLMessage;
+}
+
+class WbXMLMessageDecoderTest : public QObject
+{
+    Q_OBJECT;
+public:
+
+private slots:
+    void testBasicMessage();
+    void testParity11();
+    void testParity12();
+    void testParserSniffing();
+    void testInvalid();
+
+private:
+    DataSync::SyncMLMessage* createMessage( DataSync::ProtocolVersion aVersion );
+    void verifyParity( DataSync::ProtocolVersion aVersion );
+    void parseXML( const QByteArray& aData, QList<DataSync::Fragment*>& aFragments, bool& aFinal );
+
+    void compareFragment( const DataSync::Fragment& aExpected, const DataSync::Fragment& aActual );
+    void compareHeader( const DataSync::HeaderParams& aExpected, const DataSync::HeaderParams& aActual );
+    void compareStatus( const DataSync::StatusParams& aExpected, const DataSync::StatusParams& aActual );
+    void compareSync( const DataSync::SyncParams& aExpected, const DataSync::SyncParams& aActual );
+    void compareMap( const DataSync::MapParams& aExpected, const DataSync::MapParams& aActual );
+    void compareCommand( const DataSync::CommandParams& aExpected, const DataSync::CommandParams& aActual );
+    void compareItem( const DataSync::ItemParams& aExpected, const DataSync::ItemParams& aActual );
+    void compareMeta( const DataSync::MetaParams& aExpected, const DataSync::MetaParams& aActual );
+    void compareDevInf( const DataSync::DevInfItemParams& aExpected, const DataSync::DevInfItemParams& aActual );
+
+};
+#endif // WBXMLMESSAGEDECODERTEST_H
@@ -0,0 +1,176 @@
+/*
+* This file is part of buteo-syncml package
+*
+* Copyright (C) 2010 Nokia Corporation. All rights reserved.
+*
+* Contact: Sateesh Kavuri <sateesh.kavuri@nokia.com>
+*
+* Redistribution and use in source and binary forms, with or without 
+* modification, are permitted provided that the following conditions are met:
+*
+* Redistributions of source code must retain the above copyright notice, 
+* this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, 
+* this list of conditions and the following disclaimer in the documentation 
+* and/or other materials provided with the distribution.
+* Neither the name of Nokia Corporation nor the names of its contributors may 
+* be used to endorse or promote products derived from this software without 
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE 
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+* THE POSSIBILITY OF SUCH DAMAGE.
+* 
+*/
+
+
+#include "WbXMLStringTableTest.h"
+
+#include <QtTest>
+
+#include "WbXMLStringTable.h"
+#include "SyncMLCmdObject.h"
+#include "SyncMLMessage.h"
+#include "SyncMLSync.h"
+#include "SyncMLAdd.h"
+#include "SyncMLItem.h"
+#include "Fragments.h"
+#include "datatypes.h"
+
+using namespace DataSync;
+
+void WbXMLStringTableTest::testEstimatedSavings()
+{
+    SyncMLCmdObject root( "Sync" );
+    for( int i = 0; i < 10; ++i ) {
+        root.addChild( new SyncMLCmdObject( "Type", "text/x-vcard" ) );
+        root.addChild( new SyncMLCmdObject( "CmdID", "1" ) );
+    }
+    root.addChild( new SyncMLCmdObject( "LocURI", "./contacts" ) );
+
+    WbXMLStringTable table;
+    table.addObject( root );
+
+    // 10 * ( 12 + 2 ) inline bytes against 12 + 1 bytes in the table and
+    // 10 references of at most 3 bytes. Single character and unique strings
+    // do not pay off
+    QCOMPARE( table.estimatedSavings(), 10 * 14 - 13 - 10 * 3 );
+}
+
+void WbXMLStringTableTest::testBuild()
+{
+    SyncMLCmdObject root( "Sync" );
+    root.addChild( new SyncMLCmdObject( "LocURI", "./contacts" ) );
+    root.addChild( new SyncMLCmdObject( "Type", "text/x-vcard" ) );
+    root.addChild( new SyncMLCmdObject( "LocURI", "./contacts" ) );
+    root.addChild( new SyncMLCmdObject( "Type", "text/x-vcard" ) );
+    root.addChild( new SyncMLCmdObject( "LocURI", "./unique" ) );
+    root.addChild( new SyncMLCmdObject( "CmdID", "1" ) );
+    root.addChild( new SyncMLCmdObject( "CmdID", "1" ) );
+
+    WbXMLStringTable table;
+    table.addObject( root );
+    table.build();
+
+    // Strings are placed in the order of first occurrence
+    QCOMPARE( table.offset( "./contacts" ), 0 );
+    QCOMPARE( table.offset( "text/x-vcard" ), 11 );
+    QCOMPARE( table.offset( "./unique" ), -1 );
+    QCOMPARE( table.offset( "1" ), -1 );
+    QCOMPARE( table.data(), QByteArray( "./contacts\0text/x-vcard\0", 24 ) );
+}
+
+void WbXMLStringTableTest::testCandidates()
+{
+    QByteArray value;
+
+    SyncMLCmdObject plain( "LocURI", "./contacts" );
+    QVERIFY( WbXMLStringTable::candidateValue( plain, value ) );
+    QCOMPARE( value, QByteArray( "./contacts" ) );
+
+    SyncMLCmdObject utf8( "Data" );
+    utf8.setUtf8Value( "M\xc3\xa4kel\xc3\xa4" );
+    QVERIFY( WbXMLStringTable::candidateValue( utf8, value ) );
+    QCOMPARE( value, QByteArray( "M\xc3\xa4kel\xc3\xa4" ) );
+
+    SyncMLCmdObject cdata( "Data", "./contacts" );
+    cdata.setCDATA( true );
+    QVERIFY( !WbXMLStringTable::candidateValue( cdata, value ) );
+
+    SyncMLCmdObject empty( "Final" );
+    QVERIFY( !WbXMLStringTable::candidateValue( empty, value ) );
+
+    SyncMLCmdObject large( "Data" );
+    large.setUtf8Value( QByteArray( 1024, 'a' ) );
+    QVERIFY( !WbXMLStringTable::candidateValue( large, value ) );
+
+    // Content of embedded DevInf documents is not counted
+    SyncMLCmdObject root( "Data" );
+    SyncMLCmdObject* devInf = new SyncMLCmdObject( "DevInf" );
+    devInf->addAttribute( XML_NAMESPACE, XML_NAMESPACE_VALUE_DEVINF );
+    for( int i = 0; i < 10; ++i ) {
+        devInf->addChild( new SyncMLCmdObject( "CTType", "text/x-vcard" ) );
+    }
+    root.addChild( devInf );
+
+    WbXMLStringTable table;
+    table.addObject( root );
+    QCOMPARE( table.estimatedSavings(), 0 );
+}
+
+void WbXMLStringTableTest::testMessageSize()
+{
+    HeaderParams headerParams;
+    headerParams.verDTD = SYNCML_DTD_VERSION_1_2;
+    headerParams.verProto = DS_VERPROTO_1_2;
+    headerParams.sessionID = "1";
+    headerParams.msgID = 1;
+    headerParams.targetDevice = "http://www.example.com/sync";
+    headerParams.sourceDevice = "IMEI:493005100592800";
+
+    SyncMLMessage plain( headerParams, SYNCML_1_2 );
+    SyncMLMessage tabled( headerParams, SYNCML_1_2 );
+    tabled.enableWbXMLStringTable();
+
+    QVERIFY( !plain.wbxmlStringTableEnabled() );
+    QVERIFY( tabled.wbxmlStringTableEnabled() );
+
+    QList<SyncMLMessage*> messages;
+    messages << &plain << &tabled;
+
+    foreach( SyncMLMessage* message, messages ) {
+
+        // Sync is attached before its commands, like LocalChangesPackage
+        // does, and commands are built before they are attached
+        SyncMLSync* sync = new SyncMLSync( message->getNextCmdId(), "./contacts", "./card" );
+        message->addToBody( sync );
+
+        for( int i = 0; i < 20; ++i ) {
+            SyncMLAdd* add = new SyncMLAdd( message->getNextCmdId() );
+            add->addMimeMetadata( "text/x-vcard" );
+            SyncMLItem* item = new SyncMLItem();
+            item->insertSource( QString::number( 1000 + i ) );
+            item->insertData( QByteArray( "BEGIN:VCARD\r\nEND:VCARD\r\n" ) );
+            add->addChild( item );
+            sync->addChild( add );
+        }
+    }
+
+    // String table does not affect XML, and makes WbXML smaller
+    QCOMPARE( tabled.calculateSize( false, SYNCML_1_2 ), plain.calculateSize( false, SYNCML_1_2 ) );
+    QVERIFY( tabled.calculateSize( true, SYNCML_1_2 ) < plain.calculateSize( true, SYNCML_1_2 ) );
+
+    // Each Add repeats at least the MIME type
+    int savings = plain.calculateSize( true, SYNCML_1_2 ) - tabled.calculateSize( true, SYNCML_1_2 );
+    QVERIFY( savings >= 20 * ( 12 - 1 ) - 13 );
+}
+
+QTEST_MAIN(WbXMLStringTableTest)
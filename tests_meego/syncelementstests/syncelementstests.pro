@@ -1,8 +1,12 @@
 include(../tests_common.pri)
 TEMPLATE = subdirs
 SUBDIRS = \
+    MessageSizerTest.pro \
+    ParserThreadTest.pro \
+    QtEncoderTest.pro \
     SyncMLAddTest.pro \
     SyncMLAlertTest.pro \
+    SyncMLBenchmark.pro \
     SyncMLBodyTest.pro \
     SyncMLCmdObjectTest.pro \
     SyncMLCredTest.pro \
@@ -14,8 +18,12 @@ SUBDIRS = \
     SyncMLMapTest.pro \
     SyncMLMessageParserTest.pro \
     SyncMLMessageTest.pro \
+    SyncMLNodePoolTest.pro \
     SyncMLPutTest.pro \
     SyncMLReplaceTest.pro \
     SyncMLResultsTest.pro \
     SyncMLStatusTest.pro \
     SyncMLSyncTest.pro \
+    WbXMLEncoderTest.pro \
+    WbXMLMessageDecoderTest.pro \
+    WbXMLStringTableTest.pro \
@@ -117,7 +117,59 @@ void BaseTransportTest::testBasicXMLReceive()
 
 }
 
+void BaseTransportTest::testChunkedXMLReceive()
+{
+    TestTransport transport( true );
+
+    QSignalSpy sendEvent( &transport, SIGNAL( sendEvent( DataSync::TransportStatusEvent, const QString& ) ) );
+    QSignalSpy readData( &transport, SIGNAL( readXMLData( QIODevice*, bool ) ) );
+    QSignalSpy readChunk( &transport, SIGNAL( readXMLChunk( const QByteArray&, bool, bool ) ) );
+
+    transport.setWbXml( false );
+    transport.setIncrementalParsing( true );
+
+    transport.iContentType = SYNCML_CONTTYPE_XML;
+    transport.iChunkSize = 16;
+    QVERIFY( readFile( "data/basicbasetransport.txt", transport.iData ) );
+
+    QVERIFY( transport.receive() == true );
+
+    QVERIFY( sendEvent.count() == 0 );
+    QVERIFY( readData.count() == 0 );
+    QCOMPARE( readChunk.count(), ( transport.iData.size() + 15 ) / 16 );
 
+    QByteArray data;
+    for( int i = 0; i < readChunk.count(); ++i ) {
+        data.append( readChunk.at(i).at(0).toByteArray() );
+        QCOMPARE( readChunk.at(i).at(1).toBool(), i == 0 );
+        QCOMPARE( readChunk.at(i).at(2).toBool(), i == readChunk.count() - 1 );
+    }
+
+    QCOMPARE( data, transport.iData );
+
+    // Message that is not received completely is cancelled
+    QSignalSpy cancelled( &transport, SIGNAL( chunksCancelled() ) );
+    readChunk.clear();
+    transport.iCancelAfterChunks = 2;
+
+    QVERIFY( transport.receive() == true );
+
+    QCOMPARE( readChunk.count(), 2 );
+    QCOMPARE( readChunk.at(1).at(2).toBool(), false );
+    QCOMPARE( cancelled.count(), 1 );
+    transport.iCancelAfterChunks = 0;
+
+    // WbXML is never received in chunks
+    readChunk.clear();
+    transport.setWbXml( true );
+    transport.iContentType = SYNCML_CONTTYPE_WBXML;
+    QVERIFY( readFile( "data/basicbasetransport.bin", transport.iData ) );
+
+    QVERIFY( transport.receive() == true );
+
+    QVERIFY( readChunk.count() == 0 );
+    QVERIFY( readData.count() == 1 );
+}
 
 
 void BaseTransportTest::testBasicWbXMLSend()
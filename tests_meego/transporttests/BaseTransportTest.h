@@ -46,6 +46,7 @@ private slots:
 
     void testBasicXMLSend();
     void testBasicXMLReceive();
+    void testChunkedXMLReceive();
 
     void testBasicWbXMLSend();
     void testBasicWbXMLReceive();
@@ -35,6 +35,9 @@
 
 #include "SyncMLMessage.h"
 #include "HTTPTransport.h"
+#include "HTTPContentCoding.h"
+#include "QtEncoder.h"
+#include "datatypes.h"
 #include "SyncAgentConfigProperties.h"
 #include <QNetworkProxy>
 
@@ -45,10 +48,70 @@
 #include "SyncMLLogging.h"
 
 #include <QSignalSpy>
+#include <QTcpSocket>
 #include <QtTest>
 
 Q_DECLARE_METATYPE(QIODevice*);
 
+using namespace DataSync;
+
+HTTPServerStandIn::HTTPServerStandIn() : iSocket( 0 )
+{
+    connect( &iServer, SIGNAL(newConnection()), this, SLOT(newConnection()) );
+}
+
+bool HTTPServerStandIn::listen()
+{
+    return iServer.listen( QHostAddress::LocalHost );
+}
+
+QUrl HTTPServerStandIn::url() const
+{
+    return QUrl( QString( "http://127.0.0.1:%1/sync" ).arg( iServer.serverPort() ) );
+}
+
+void HTTPServerStandIn::newConnection()
+{
+    iSocket = iServer.nextPendingConnection();
+    iBuffer.clear();
+    connect( iSocket, SIGNAL(readyRead()), this, SLOT(readRequest()) );
+}
+
+void HTTPServerStandIn::readRequest()
+{
+    iBuffer.append( iSocket->readAll() );
+
+    int headerEnd = iBuffer.indexOf( "\r\n\r\n" );
+    if( headerEnd < 0 ) {
+        return;
+    }
+
+    QByteArray headers = iBuffer.left( headerEnd + 2 );
+    int contentLength = 0;
+    foreach( const QByteArray& line, headers.split( '\n' ) ) {
+        if( line.toLower().startsWith( "content-length:" ) ) {
+            contentLength = line.mid( 15 ).trimmed().toInt();
+        }
+    }
+
+    if( iBuffer.size() < headerEnd + 4 + contentLength ) {
+        return;
+    }
+
+    iRequestHeaders = headers;
+    iRequestBody = iBuffer.mid( headerEnd + 4, contentLength );
+    iBuffer.clear();
+
+    QByteArray response( "HTTP/1.1 200 OK\r\n" );
+    response.append( iResponseHeaders );
+    response.append( "Content-Length: " + QByteArray::number( iResponseBody.size() ) + "\r\n" );
+    response.append( "Connection: close\r\n\r\n" );
+    response.append( iResponseBody );
+
+    iSocket->write( response );
+    iSocket->disconnectFromHost();
+}
+
 void HTTPTransportTest::initTestCase()
 {
 
@@ -120,4 +183,110 @@ void HTTPTransportTest::testSetProxy()
     QCOMPARE(proxy.port(), port);
 }
 
+void HTTPTransportTest::testContentEncoding_data()
+{
+    QTest::addColumn<QString>( "encoding" );
+
+    QTest::newRow( "gzip" ) << QString( "gzip" );
+    QTest::newRow( "deflate" ) << QString( "deflate" );
+}
+
+void HTTPTransportTest::testContentEncoding()
+{
+    QFETCH( QString, encoding );
+
+    const HTTPContentCoding::Coding coding = HTTPContentCoding::fromName( encoding.toLatin1() );
+    QVERIFY( coding != HTTPContentCoding::CODING_IDENTITY );
+
+    HTTPServerStandIn server;
+    QVERIFY( server.listen() );
+
+    // Server answers with a compressed response
+    QByteArray response( "<?xml version=\"1.0\"?><SyncML><SyncHdr/><SyncBody><Final/></SyncBody></SyncML>" );
+    QVERIFY( HTTPContentCoding::compress( response, coding, server.iResponseBody ) );
+    server.iResponseHeaders = "Content-Type: " SYNCML_CONTTYPE_DS_XML "\r\n"
+                              "Content-Encoding: " + encoding.toLatin1() + "\r\n";
+
+    HTTPTransport transport;
+    QSignalSpy sendEvent( &transport, SIGNAL(sendEvent(DataSync::TransportStatusEvent, const QString&)) );
+    QSignalSpy readData( &transport, SIGNAL(readXMLData(QIODevice*, bool)) );
+
+    transport.setWbXml( false );
+    transport.setProperty( HTTPCONTENTENCODINGPROP, encoding );
+    transport.setRemoteLocURI( server.url().toString() );
+    transport.init();
+
+    HeaderParams params;
+    params.verDTD = SYNCML_DTD_VERSION_1_2;
+    params.verProto = DS_VERPROTO_1_2;
+    params.msgID = 1;
+    params.targetDevice = "targetDevice";
+    params.sourceDevice = "sourceDevice";
+
+    SyncMLMessage* message = new SyncMLMessage( params, SYNCML_1_2 );
+
+    QByteArray expected;
+    QtEncoder encoder;
+    QVERIFY( encoder.encodeToXML( *message, expected, false ) );
+
+    QVERIFY( transport.sendSyncML( message ) );
+    QVERIFY( transport.receive() );
+
+    QVERIFY( readData.wait( 5000 ) );
+    QCOMPARE( sendEvent.count(), 0 );
+
+    // Request was compressed, and compressed responses were asked for
+    const QByteArray headers = server.iRequestHeaders.toLower();
+    QVERIFY( headers.contains( "content-encoding: " + encoding.toLatin1() ) );
+    QVERIFY( headers.contains( "accept-encoding: gzip, deflate" ) );
+
+    HTTPContentDecoder decoder( coding );
+    QByteArray requestBody;
+    QVERIFY( decoder.decode( server.iRequestBody, requestBody ) );
+    QVERIFY( decoder.finished() );
+    QCOMPARE( requestBody, expected );
+
+    // Response was decompressed before passing it on
+    QIODevice* device = qvariant_cast<QIODevice*>( readData.at( 0 ).at( 0 ) );
+    QCOMPARE( device->readAll(), response );
+
+    transport.close();
+}
+
+void HTTPTransportTest::testContentDecoding_data()
+{
+    QTest::addColumn<int>( "coding" );
+    QTest::addColumn<bool>( "wrapped" );
+
+    QTest::newRow( "gzip" ) << int( HTTPContentCoding::CODING_GZIP ) << true;
+    QTest::newRow( "deflate" ) << int( HTTPContentCoding::CODING_DEFLATE ) << true;
+    QTest::newRow( "raw deflate" ) << int( HTTPContentCoding::CODING_DEFLATE ) << false;
+}
+
+void HTTPTransportTest::testContentDecoding()
+{
+    QFETCH( int, coding );
+    QFETCH( bool, wrapped );
+
+    QByteArray body( "<?xml version=\"1.0\"?><SyncML><SyncHdr/><SyncBody><Final/></SyncBody></SyncML>" );
+    QByteArray compressed;
+    QVERIFY( HTTPContentCoding::compress( body, HTTPContentCoding::Coding( coding ), compressed ) );
+
+    if( !wrapped ) {
+        // Strip zlib header and Adler-32 trailer
+        compressed = compressed.mid( 2, compressed.size() - 6 );
+    }
+
+    // Body arrives one byte at a time, so the wrapper header is split
+    HTTPContentDecoder decoder( HTTPContentCoding::Coding( coding ) );
+    QByteArray decoded;
+
+    for( int i = 0; i < compressed.size(); ++i ) {
+        QVERIFY( decoder.decode( compressed.mid( i, 1 ), decoded ) );
+        QCOMPARE( decoder.finished(), i == compressed.size() - 1 );
+    }
+
+    QCOMPARE( decoded, body );
+}
+
 QTEST_MAIN(HTTPTransportTest)
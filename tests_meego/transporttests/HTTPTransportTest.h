@@ -34,6 +34,39 @@
 #define HTTPTRANSPORTTEST_H
 
 #include <QTest>
+#include <QTcpServer>
+#include <QUrl>
+
+class QTcpSocket;
+
+// Local stand-in for a SyncML server, answers each request with a canned
+// response
+class HTTPServerStandIn : public QObject {
+    Q_OBJECT;
+public:
+
+    HTTPServerStandIn();
+
+    bool listen();
+
+    QUrl url() const;
+
+    QByteArray iRequestHeaders;
+    QByteArray iRequestBody;
+    QByteArray iResponseHeaders;
+    QByteArray iResponseBody;
+
+private slots:
+
+    void newConnection();
+    void readRequest();
+
+private:
+
+    QTcpServer  iServer;
+    QTcpSocket* iSocket;
+    QByteArray  iBuffer;
+};
 
 class HTTPTransportTest : public QObject {
     Q_OBJECT;
@@ -47,6 +80,10 @@ private slots:
     void testBasicXMLSend();
     void testSetProperty();
     void testSetProxy();
+    void testContentEncoding_data();
+    void testContentEncoding();
+    void testContentDecoding_data();
+    void testContentDecoding();
 };
 
 #endif  //  HTTPTRANSPORTTEST_H